@@ -17,6 +17,8 @@ CodeGenerator* code_generator_create(SymbolTable* symbol_table) {
     generator->label_counter = 0;
     generator->stack_offset = 0;
     generator->temp_var_counter = 0;
+    generator->checked_arithmetic = false;
+    generator->trap_used = false;
 
     // Initialize all registers as free
     for (int i = 0; i < REGISTER_COUNT; i++) {
@@ -81,6 +83,10 @@ CodeGenResult code_generator_emit_epilogue(CodeGenerator* generator) {
     fprintf(generator->output_file, "    mov     rsp, rbp\n");
     fprintf(generator->output_file, "    pop     rbp\n");
     fprintf(generator->output_file, "    ret\n");
+    if (generator->trap_used) {
+        fprintf(generator->output_file, "_arith_trap:\n");
+        fprintf(generator->output_file, "    ud2\n");
+    }
     fflush(generator->output_file);
 
     return CODEGEN_SUCCESS;
@@ -194,6 +200,50 @@ CodeGenResult code_generator_generate_literal(CodeGenerator* generator, ASTNode*
     return CODEGEN_ERROR_UNSUPPORTED_NODE;
 }
 
+// log2 of an integer literal that is a power of two above 1, otherwise 0
+static int code_generator_shift_amount(ASTNode* node) {
+    if (node->type != NODE_LITERAL || !node->token || node->token->type != TOKEN_INTEGER_LITERAL) return 0;
+
+    int value = node->data.literal.int_value;
+    if (value <= 1 || (value & (value - 1)) != 0) return 0;
+    return __builtin_ctz((unsigned)value);
+}
+
+static bool code_generator_is_nonzero_literal(ASTNode* node) {
+    return node->type == NODE_LITERAL && node->token && node->token->type == TOKEN_INTEGER_LITERAL &&
+           node->data.literal.int_value != 0;
+}
+
+static void code_generator_emit_check(CodeGenerator* generator, const char* jump) {
+    fprintf(generator->output_file, "    %-7s _arith_trap\n", jump);
+    generator->trap_used = true;
+}
+
+// Division and modulo of rbx (left) by rax (right)
+static void code_generator_emit_division(CodeGenerator* generator, ASTNode* node, bool narrow) {
+    ASTNode* divisor = node->data.binary.right;
+    if (generator->checked_arithmetic && !(divisor->range_facts & RANGE_NONZERO) &&
+        !code_generator_is_nonzero_literal(divisor)) {
+        fprintf(generator->output_file, "    test    rax, rax\n");
+        code_generator_emit_check(generator, "jz");
+    }
+
+    // 32-bit division is much cheaper when both operands fit in it
+    if (narrow) {
+        fprintf(generator->output_file, "    mov     ecx, eax\n");
+        fprintf(generator->output_file, "    mov     eax, ebx\n");
+        fprintf(generator->output_file, "    cdq\n");
+        fprintf(generator->output_file, "    idiv    ecx\n");
+        if (node->data.binary.op == OP_MODULO) fprintf(generator->output_file, "    mov     eax, edx\n");
+    } else {
+        fprintf(generator->output_file, "    mov     rcx, rax\n");
+        fprintf(generator->output_file, "    mov     rax, rbx\n");
+        fprintf(generator->output_file, "    cqo\n");
+        fprintf(generator->output_file, "    idiv    rcx\n");
+        if (node->data.binary.op == OP_MODULO) fprintf(generator->output_file, "    mov     rax, rdx\n");
+    }
+}
+
 CodeGenResult code_generator_generate_binary(CodeGenerator* generator, ASTNode* node) {
     if (!generator || !node || !generator->output_file) {
         return CODEGEN_ERROR_NULL_ANALYZER;
@@ -203,31 +253,62 @@ CodeGenResult code_generator_generate_binary(CodeGenerator* generator, ASTNode*
         return CODEGEN_ERROR_UNSUPPORTED_NODE;
     }
 
+    BinaryOperator op = node->data.binary.op;
+    ASTNode* left = node->data.binary.left;
+    ASTNode* right = node->data.binary.right;
+    if (op != OP_ADD && op != OP_SUBTRACT && op != OP_MULTIPLY && op != OP_DIVIDE && op != OP_MODULO) {
+        return CODEGEN_ERROR_UNSUPPORTED_NODE;
+    }
+
+    // A nonnegative dividend divides by a power of two with a shift or a mask
+    int shift = code_generator_shift_amount(right);
+    if ((op == OP_DIVIDE || op == OP_MODULO) && shift > 0 && (left->range_facts & RANGE_NONNEGATIVE)) {
+        CodeGenResult result = code_generator_generate_expression(generator, left);
+        if (result != CODEGEN_SUCCESS) return result;
+
+        if (op == OP_DIVIDE) {
+            fprintf(generator->output_file, "    sar     rax, %d\n", shift);
+        } else {
+            fprintf(generator->output_file, "    and     rax, %d\n", (1 << shift) - 1);
+        }
+        return CODEGEN_SUCCESS;
+    }
+
     // Generate left operand
-    CodeGenResult result = code_generator_generate_expression(generator, node->data.binary.left);
+    CodeGenResult result = code_generator_generate_expression(generator, left);
     if (result != CODEGEN_SUCCESS) return result;
 
     // Save left result
     fprintf(generator->output_file, "    push    rax\n");
 
     // Generate right operand
-    result = code_generator_generate_expression(generator, node->data.binary.right);
+    result = code_generator_generate_expression(generator, right);
     if (result != CODEGEN_SUCCESS) return result;
 
     // Pop left result into rbx
     fprintf(generator->output_file, "    pop     rbx\n");
 
-    // Generate operation based on operator
-    const char* op = node->data.binary.operator;
-    if (strcmp(op, "+") == 0) {
-        fprintf(generator->output_file, "    add     rax, rbx\n");
-    } else if (strcmp(op, "-") == 0) {
-        fprintf(generator->output_file, "    sub     rbx, rax\n");
-        fprintf(generator->output_file, "    mov     rax, rbx\n");
-    } else if (strcmp(op, "*") == 0) {
-        fprintf(generator->output_file, "    imul    rax, rbx\n");
+    // Small operands and results are computed with 32-bit instructions, which
+    // zero the upper half and so leave the same 64-bit value
+    bool narrow = (left->range_facts & right->range_facts & RANGE_SMALL) != 0;
+    if (op == OP_DIVIDE || op == OP_MODULO) {
+        code_generator_emit_division(generator, node, narrow);
+        return CODEGEN_SUCCESS;
+    }
+
+    narrow = narrow && (node->range_facts & RANGE_SMALL);
+    if (op == OP_ADD) {
+        fprintf(generator->output_file, narrow ? "    add     eax, ebx\n" : "    add     rax, rbx\n");
+    } else if (op == OP_SUBTRACT) {
+        fprintf(generator->output_file, narrow ? "    sub     ebx, eax\n" : "    sub     rbx, rax\n");
+        fprintf(generator->output_file, narrow ? "    mov     eax, ebx\n" : "    mov     rax, rbx\n");
     } else {
-        return CODEGEN_ERROR_UNSUPPORTED_NODE;
+        fprintf(generator->output_file, narrow ? "    imul    eax, ebx\n" : "    imul    rax, rbx\n");
+    }
+
+    // A small result cannot have overflowed
+    if (generator->checked_arithmetic && !narrow && !(node->range_facts & RANGE_NO_OVERFLOW)) {
+        code_generator_emit_check(generator, "jo");
     }
 
     return CODEGEN_SUCCESS;
@@ -244,8 +325,9 @@ CodeGenResult code_generator_generate_expression(CodeGenerator* generator, ASTNo
         case NODE_BINARY_EXPRESSION:
             return code_generator_generate_binary(generator, node);
         case NODE_IDENTIFIER:
-            // TODO: Implement identifier generation
-            return CODEGEN_ERROR_UNSUPPORTED_NODE;
+            return code_generator_generate_identifier(generator, node);
+        case NODE_ASSIGNMENT_EXPRESSION:
+            return code_generator_generate_assignment(generator, node);
         case NODE_UNARY_EXPRESSION:
             // TODO: Implement unary expression generation
             return CODEGEN_ERROR_UNSUPPORTED_NODE;
@@ -254,6 +336,57 @@ CodeGenResult code_generator_generate_expression(CodeGenerator* generator, ASTNo
     }
 }
 
+// Globals live in _main's frame in declaration order: global i is at
+// [rbp - 8 * (i + 1)]. Functions are not generated yet, so a variable in a
+// function frame has no location. Returns 0 when node has none.
+static int code_generator_variable_offset(ASTNode* node) {
+    if (node->resolved_slot < 0 || !node->resolved_global) return 0;
+    return 8 * (node->resolved_slot + 1);
+}
+
+CodeGenResult code_generator_generate_identifier(CodeGenerator* generator, ASTNode* node) {
+    if (!generator || !node || !generator->output_file) {
+        return CODEGEN_ERROR_NULL_ANALYZER;
+    }
+
+    if (node->type != NODE_IDENTIFIER) {
+        return CODEGEN_ERROR_UNSUPPORTED_NODE;
+    }
+
+    // Semantic analysis resolved the name to a slot; nothing is looked up here
+    int offset = code_generator_variable_offset(node);
+    if (offset == 0) {
+        code_generator_error(generator, "Unresolved identifier: %s", node->data.identifier_name);
+        return CODEGEN_ERROR_SYMBOL_NOT_FOUND;
+    }
+
+    fprintf(generator->output_file, "    mov     rax, [rbp-%d]\n", offset);
+    return CODEGEN_SUCCESS;
+}
+
+CodeGenResult code_generator_generate_assignment(CodeGenerator* generator, ASTNode* node) {
+    if (!generator || !node || !generator->output_file) {
+        return CODEGEN_ERROR_NULL_ANALYZER;
+    }
+
+    if (node->type != NODE_ASSIGNMENT_EXPRESSION || node->data.binary.left->type != NODE_IDENTIFIER) {
+        return CODEGEN_ERROR_UNSUPPORTED_NODE;
+    }
+
+    int offset = code_generator_variable_offset(node->data.binary.left);
+    if (offset == 0) {
+        code_generator_error(generator, "Unresolved identifier: %s", node->data.binary.left->data.identifier_name);
+        return CODEGEN_ERROR_SYMBOL_NOT_FOUND;
+    }
+
+    // The assigned value stays in rax as the expression's result
+    CodeGenResult result = code_generator_generate_expression(generator, node->data.binary.right);
+    if (result != CODEGEN_SUCCESS) return result;
+
+    fprintf(generator->output_file, "    mov     [rbp-%d], rax\n", offset);
+    return CODEGEN_SUCCESS;
+}
+
 CodeGenResult code_generator_generate_variable_declaration(CodeGenerator* generator, ASTNode* node) {
     if (!generator || !node || !generator->output_file) {
         return CODEGEN_ERROR_NULL_ANALYZER;
@@ -272,13 +405,33 @@ CodeGenResult code_generator_generate_variable_declaration(CodeGenerator* genera
         CodeGenResult result = code_generator_generate_expression(generator, node->data.declaration.initializer);
         if (result != CODEGEN_SUCCESS) return result;
 
-        // Store the value on stack
-        fprintf(generator->output_file, "    mov     [rbp-%d], rax\n", generator->stack_offset);
+        // Store the value in the variable's slot, or the space just reserved
+        // when the declaration was not analyzed
+        int offset = code_generator_variable_offset(node);
+        fprintf(generator->output_file, "    mov     [rbp-%d], rax\n", offset != 0 ? offset : generator->stack_offset);
     }
 
     return CODEGEN_SUCCESS;
 }
 
+// Generates one top-level item of a program (or a standalone node)
+static CodeGenResult code_generator_generate_top_level(CodeGenerator* generator, ASTNode* node) {
+    switch (node->type) {
+        case NODE_VARIABLE_DECLARATION:
+            return code_generator_generate_variable_declaration(generator, node);
+        case NODE_EXPRESSION_STATEMENT:
+            return code_generator_generate_expression(generator, node->data.statement.expression);
+        case NODE_BINARY_EXPRESSION:
+        case NODE_LITERAL:
+        case NODE_IDENTIFIER:
+            // Generate expression directly
+            return code_generator_generate_expression(generator, node);
+        // TODO: Handle other statement types
+        default:
+            return CODEGEN_ERROR_UNSUPPORTED_NODE;
+    }
+}
+
 CodeGenResult code_generator_generate_program(CodeGenerator* generator, ASTNode* node) {
     if (!generator || !node || !generator->output_file) {
         return CODEGEN_ERROR_NULL_ANALYZER;
@@ -288,31 +441,22 @@ CodeGenResult code_generator_generate_program(CodeGenerator* generator, ASTNode*
     if (result != CODEGEN_SUCCESS) return result;
 
     if (node->type == NODE_PROGRAM) {
-        // Generate all children if it's a program node
+        // Parsed programs keep their declarations in an array
+        for (int i = 0; i < node->data.block.statement_count; i++) {
+            result = code_generator_generate_top_level(generator, node->data.block.statements[i]);
+            if (result != CODEGEN_SUCCESS) return result;
+        }
+
+        // Programs assembled with ast_node_add_child use the sibling list
         ASTNode* child = node->first_child;
         while (child) {
-            switch (child->type) {
-                case NODE_VARIABLE_DECLARATION:
-                    result = code_generator_generate_variable_declaration(generator, child);
-                    break;
-                case NODE_BINARY_EXPRESSION:
-                case NODE_LITERAL:
-                case NODE_IDENTIFIER:
-                    // Generate expression directly
-                    result = code_generator_generate_expression(generator, child);
-                    break;
-                // TODO: Handle other statement types
-                default:
-                    result = CODEGEN_ERROR_UNSUPPORTED_NODE;
-                    break;
-            }
-
+            result = code_generator_generate_top_level(generator, child);
             if (result != CODEGEN_SUCCESS) return result;
             child = child->next_sibling;
         }
     } else {
-        // Generate as single expression (for standalone expressions)
-        result = code_generator_generate_expression(generator, node);
+        // Generate a standalone expression or declaration
+        result = code_generator_generate_top_level(generator, node);
         if (result != CODEGEN_SUCCESS) return result;
     }
 
@@ -331,16 +475,31 @@ CodeGenResult code_generator_generate(CodeGenerator* generator, ASTNode* ast, co
     return code_generator_generate_program(generator, ast);
 }
 
-// Stub implementations for functions not yet implemented
-CodeGenResult code_generator_generate_identifier(CodeGenerator* generator, ASTNode* node) {
-    return CODEGEN_ERROR_UNSUPPORTED_NODE;
+CodeGenResult code_generator_begin(CodeGenerator* generator, const char* output_filename) {
+    if (!generator || !output_filename) {
+        return CODEGEN_ERROR_NULL_ANALYZER;
+    }
+
+    CodeGenResult result = code_generator_set_output(generator, output_filename);
+    if (result != CODEGEN_SUCCESS) return result;
+
+    return code_generator_emit_prologue(generator);
 }
 
-CodeGenResult code_generator_generate_unary(CodeGenerator* generator, ASTNode* node) {
-    return CODEGEN_ERROR_UNSUPPORTED_NODE;
+CodeGenResult code_generator_generate_declaration(CodeGenerator* generator, ASTNode* node) {
+    if (!generator || !node || !generator->output_file) {
+        return CODEGEN_ERROR_NULL_ANALYZER;
+    }
+
+    return code_generator_generate_top_level(generator, node);
 }
 
-CodeGenResult code_generator_generate_assignment(CodeGenerator* generator, ASTNode* node) {
+CodeGenResult code_generator_end(CodeGenerator* generator) {
+    return code_generator_emit_epilogue(generator);
+}
+
+// Stub implementations for functions not yet implemented
+CodeGenResult code_generator_generate_unary(CodeGenerator* generator, ASTNode* node) {
     return CODEGEN_ERROR_UNSUPPORTED_NODE;
 }
 
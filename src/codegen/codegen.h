@@ -2,7 +2,9 @@
 #define CODEGEN_H
 
 #include "../semantic/semantic.h"
+#include "../semantic/ranges.h"
 #include "../parser/parser.h"
+#include "../ir/ir.h"
 
 // Code generation result types
 typedef enum {
@@ -36,7 +38,10 @@ typedef enum {
     REGISTER_COUNT
 } Register;
 
-// Code generator structure
+// Code generator structure. With checked_arithmetic, integer overflow and
+// division by zero jump to a trap instead of wrapping or faulting. Facts
+// from ranges_analyze, when it has run, remove checks that cannot fail and
+// select cheaper instructions.
 typedef struct CodeGenerator {
     SymbolTable* symbol_table;
     FILE* output_file;
@@ -46,6 +51,8 @@ typedef struct CodeGenerator {
     int stack_offset;
     Register used_registers[REGISTER_COUNT];
     int temp_var_counter;
+    bool checked_arithmetic;
+    bool trap_used;              // A check jumps to the trap emitted with the epilogue
 } CodeGenerator;
 
 // Main code generator functions
@@ -54,6 +61,20 @@ void code_generator_free(CodeGenerator* generator);
 CodeGenResult code_generator_generate(CodeGenerator* generator, ASTNode* ast, const char* output_filename);
 CodeGenResult code_generator_set_output(CodeGenerator* generator, const char* output_filename);
 
+// Streaming generation: begin, one call per top-level declaration in source
+// order, then end. The output is the same as code_generator_generate on the
+// whole program, and each declaration may be freed as soon as it returns.
+CodeGenResult code_generator_begin(CodeGenerator* generator, const char* output_filename);
+CodeGenResult code_generator_generate_declaration(CodeGenerator* generator, ASTNode* node);
+CodeGenResult code_generator_end(CodeGenerator* generator);
+
+// IR backend (ir_backend.c): generates every function of a lowered module,
+// with the module's globals in order as consecutive quadwords from _g0 in
+// the data section, for the GNU assembler. Honors checked_arithmetic and the
+// range flags lowering put on instructions. Phis must have been translated
+// out of SSA.
+CodeGenResult code_generator_generate_ir(CodeGenerator* generator, const IrModule* module, const char* output_filename);
+
 // Expression code generation
 CodeGenResult code_generator_generate_expression(CodeGenerator* generator, ASTNode* node);
 CodeGenResult code_generator_generate_literal(CodeGenerator* generator, ASTNode* node);
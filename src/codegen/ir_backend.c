@@ -0,0 +1,436 @@
+#include "codegen.h"
+
+// Backend for the IR. Every virtual register has a stack slot: parameters
+// are the caller's pushed arguments at [rbp + 16 + 8 * i], the other
+// registers are below rbp. Calls push their arguments last to first, the
+// caller pops them, and results are returned in rax. Instructions are
+// computed in rax, which also caches the register it last held within a
+// block: a temporary read once, by the next instruction, is passed in rax
+// without a store and reload, and a constant used once as the next
+// instruction's second operand becomes an immediate. A comparison that
+// only feeds the branch after it becomes a conditional jump. Globals live
+// in the data section. The output is Intel syntax for the GNU assembler.
+typedef struct {
+    CodeGenerator* generator;
+    FILE* out;
+    const IrModule* module;
+    const IrFunction* function;
+    int function_index;
+    int* uses;                   // Reads of each register in the function
+    int rax;                     // Register whose value rax holds, IR_NONE if none
+    int immediate;               // Constant register deferred as an immediate, IR_NONE if none
+    int64_t immediate_value;
+    const char* condition;       // Condition code of a comparison deferred to the next branch
+} IrBackend;
+
+static const char* ir_backend_location(IrBackend* backend, int reg, char* buffer, size_t size) {
+    if (reg < backend->function->parameter_count) {
+        snprintf(buffer, size, "[rbp+%d]", 16 + 8 * reg);
+    } else {
+        snprintf(buffer, size, "[rbp-%d]", 8 * (reg - backend->function->parameter_count + 1));
+    }
+    return buffer;
+}
+
+// The second operand of an instruction: its register's slot or the
+// immediate deferred for it
+static const char* ir_backend_operand(IrBackend* backend, int reg, char* buffer, size_t size) {
+    if (reg == backend->immediate) {
+        snprintf(buffer, size, "%lld", (long long)backend->immediate_value);
+        return buffer;
+    }
+    return ir_backend_location(backend, reg, buffer, size);
+}
+
+static void ir_backend_load(IrBackend* backend, int reg) {
+    char location[32];
+    if (reg == backend->rax) return;
+    if (reg == backend->immediate) {
+        fprintf(backend->out, "    mov     rax, %lld\n", (long long)backend->immediate_value);
+    } else {
+        fprintf(backend->out, "    mov     rax, %s\n", ir_backend_location(backend, reg, location, sizeof(location)));
+    }
+    backend->rax = reg;
+}
+
+// The register next computes from in rax, if any
+static int ir_backend_accumulator_operand(const IrInstr* next) {
+    if (next == NULL) return IR_NONE;
+    switch ((IrOpcode)next->op) {
+        case IR_STORE_GLOBAL: return next->b;
+        case IR_CONST:
+        case IR_LOAD_GLOBAL:
+        case IR_CALL:
+        case IR_PHI:
+        case IR_JUMP: return IR_NONE;
+        default: return next->a;
+    }
+}
+
+// Whether a temporary defined by instr is read only by next, from rax
+static bool ir_backend_feeds_next(IrBackend* backend, const IrInstr* instr, const IrInstr* next) {
+    int dest = instr->dest;
+    return dest >= backend->function->variable_count && backend->uses[dest] == 1 &&
+           ir_backend_accumulator_operand(next) == dest;
+}
+
+// Whether instr is a constant read only by next, as an operand it can take
+// as an immediate
+static bool ir_backend_is_immediate(IrBackend* backend, const IrInstr* instr, const IrInstr* next) {
+    if (instr->op != IR_CONST || next == NULL) return false;
+    int dest = instr->dest;
+    int64_t value = backend->function->constants[instr->a];
+    if (dest < backend->function->variable_count || backend->uses[dest] != 1 || value < INT32_MIN ||
+        value > INT32_MAX) {
+        return false;
+    }
+
+    switch ((IrOpcode)next->op) {
+        case IR_STORE_GLOBAL: return next->b == dest;
+        case IR_COPY: return next->a == dest;
+        default:
+            return next->op >= IR_ADD && next->op <= IR_GE && next->b == dest && next->a != dest;
+    }
+}
+
+// Stores rax, holding instr's result, unless next reads it from rax
+static void ir_backend_define(IrBackend* backend, const IrInstr* instr, const IrInstr* next) {
+    char location[32];
+    backend->rax = instr->dest;
+    if (!ir_backend_feeds_next(backend, instr, next)) {
+        fprintf(backend->out, "    mov     %s, rax\n",
+                ir_backend_location(backend, instr->dest, location, sizeof(location)));
+    }
+}
+
+static void ir_backend_check(IrBackend* backend, const char* jump) {
+    fprintf(backend->out, "    %-7s _arith_trap\n", jump);
+    backend->generator->trap_used = true;
+}
+
+static void ir_backend_label(IrBackend* backend, int block, char* buffer, size_t size) {
+    snprintf(buffer, size, ".L%d_%d", backend->function_index, block);
+}
+
+static const char* ir_backend_condition(IrOpcode op) {
+    switch (op) {
+        case IR_EQ: return "e";
+        case IR_NE: return "ne";
+        case IR_LT: return "l";
+        case IR_LE: return "le";
+        case IR_GT: return "g";
+        default: return "ge";
+    }
+}
+
+static const char* ir_backend_negate(const char* condition) {
+    static const char* pairs[][2] = { { "e", "ne" }, { "l", "ge" }, { "le", "g" } };
+    for (int i = 0; i < 3; i++) {
+        if (strcmp(condition, pairs[i][0]) == 0) return pairs[i][1];
+        if (strcmp(condition, pairs[i][1]) == 0) return pairs[i][0];
+    }
+    return condition;
+}
+
+static CodeGenResult ir_backend_binary(IrBackend* backend, const IrInstr* instr, const IrInstr* next) {
+    FILE* out = backend->out;
+    IrOpcode op = (IrOpcode)instr->op;
+    bool narrow = (instr->flags & IR_FLAG_NARROW) != 0;
+    char operand[32];
+    ir_backend_load(backend, instr->a);
+    ir_backend_operand(backend, instr->b, operand, sizeof(operand));
+    const char* accumulator = narrow ? "eax" : "rax";
+
+    switch (op) {
+        case IR_ADD:
+        case IR_SUB:
+            fprintf(out, "    %-7s %s, %s\n", op == IR_ADD ? "add" : "sub", accumulator, operand);
+            break;
+        case IR_MUL:
+            if (instr->b == backend->immediate) {
+                fprintf(out, "    imul    %s, %s, %s\n", accumulator, accumulator, operand);
+            } else {
+                fprintf(out, "    imul    %s, %s\n", accumulator, operand);
+            }
+            break;
+        case IR_DIV:
+        case IR_MOD:
+            // idiv takes no immediate; a constant divisor goes through rcx
+            if (instr->b == backend->immediate) {
+                fprintf(out, "    mov     rcx, %s\n", operand);
+                snprintf(operand, sizeof(operand), narrow ? "ecx" : "rcx");
+            } else if (backend->generator->checked_arithmetic && !(instr->flags & IR_FLAG_NONZERO_DIVISOR)) {
+                fprintf(out, "    cmp     qword ptr %s, 0\n", operand);
+                ir_backend_check(backend, "jz");
+            }
+            fprintf(out, narrow ? "    cdq\n" : "    cqo\n");
+            if (instr->b == backend->immediate) {
+                fprintf(out, "    idiv    %s\n", operand);
+            } else {
+                fprintf(out, "    idiv    %s %s\n", narrow ? "dword ptr" : "qword ptr", operand);
+            }
+            if (op == IR_MOD) fprintf(out, narrow ? "    mov     eax, edx\n" : "    mov     rax, rdx\n");
+            break;
+        case IR_SHL:
+        case IR_SAR:
+            if (instr->b != backend->immediate) {
+                fprintf(out, "    mov     rcx, %s\n", operand);
+                snprintf(operand, sizeof(operand), "cl");
+            }
+            fprintf(out, "    %-7s rax, %s\n", op == IR_SHL ? "shl" : "sar", operand);
+            break;
+        case IR_AND:
+        case IR_OR:
+        case IR_XOR:
+            fprintf(out, "    %-7s rax, %s\n", op == IR_AND ? "and" : op == IR_OR ? "or" : "xor", operand);
+            break;
+        default:
+            // Comparisons; one that only decides the next branch leaves the flags to it
+            fprintf(out, "    cmp     rax, %s\n", operand);
+            if (next != NULL && next->op == IR_BRANCH && next->a == instr->dest &&
+                instr->dest >= backend->function->variable_count && backend->uses[instr->dest] == 1) {
+                backend->condition = ir_backend_condition(op);
+                backend->rax = IR_NONE;
+                return CODEGEN_SUCCESS;
+            }
+            fprintf(out, "    set%-4s al\n", ir_backend_condition(op));
+            fprintf(out, "    movzx   eax, al\n");
+            break;
+    }
+
+    bool overflows = op == IR_ADD || op == IR_SUB || op == IR_MUL;
+    if (backend->generator->checked_arithmetic && overflows && !narrow && !(instr->flags & IR_FLAG_NO_OVERFLOW)) {
+        ir_backend_check(backend, "jo");
+    }
+    ir_backend_define(backend, instr, next);
+    return CODEGEN_SUCCESS;
+}
+
+static void ir_backend_branch(IrBackend* backend, const IrInstr* instr, int block) {
+    char label[32];
+    const char* condition = backend->condition;
+    if (condition == NULL) {
+        ir_backend_load(backend, instr->a);
+        fprintf(backend->out, "    test    rax, rax\n");
+        condition = "ne";
+    }
+    backend->condition = NULL;
+
+    // Fall through to whichever target follows
+    if (instr->b == block + 1) {
+        ir_backend_label(backend, instr->c, label, sizeof(label));
+        fprintf(backend->out, "    j%-6s %s\n", ir_backend_negate(condition), label);
+        return;
+    }
+    ir_backend_label(backend, instr->b, label, sizeof(label));
+    fprintf(backend->out, "    j%-6s %s\n", condition, label);
+    if (instr->c != block + 1) {
+        ir_backend_label(backend, instr->c, label, sizeof(label));
+        fprintf(backend->out, "    jmp     %s\n", label);
+    }
+}
+
+static CodeGenResult ir_backend_instr(IrBackend* backend, const IrInstr* instr, const IrInstr* next, int block) {
+    FILE* out = backend->out;
+    char location[32];
+    char label[32];
+
+    switch ((IrOpcode)instr->op) {
+        case IR_CONST:
+            // A constant not read from rax next is stored as an immediate
+            if (!ir_backend_feeds_next(backend, instr, next) && backend->function->constants[instr->a] >= INT32_MIN &&
+                backend->function->constants[instr->a] <= INT32_MAX) {
+                fprintf(out, "    mov     qword ptr %s, %lld\n",
+                        ir_backend_location(backend, instr->dest, location, sizeof(location)),
+                        (long long)backend->function->constants[instr->a]);
+                if (backend->rax == instr->dest) backend->rax = IR_NONE;
+                break;
+            }
+            fprintf(out, "    mov     rax, %lld\n", (long long)backend->function->constants[instr->a]);
+            ir_backend_define(backend, instr, next);
+            break;
+
+        case IR_COPY:
+            if (instr->a == backend->immediate) {
+                fprintf(out, "    mov     qword ptr %s, %lld\n",
+                        ir_backend_location(backend, instr->dest, location, sizeof(location)),
+                        (long long)backend->immediate_value);
+                if (backend->rax == instr->dest) backend->rax = IR_NONE;
+                break;
+            }
+            ir_backend_load(backend, instr->a);
+            ir_backend_define(backend, instr, next);
+            break;
+
+        case IR_NEG:
+        case IR_BITNOT:
+            ir_backend_load(backend, instr->a);
+            fprintf(out, "    %-7s rax\n", instr->op == IR_NEG ? "neg" : "not");
+            if (instr->op == IR_NEG && backend->generator->checked_arithmetic) ir_backend_check(backend, "jo");
+            ir_backend_define(backend, instr, next);
+            break;
+
+        case IR_NOT:
+            ir_backend_load(backend, instr->a);
+            fprintf(out, "    test    rax, rax\n");
+            fprintf(out, "    sete    al\n");
+            fprintf(out, "    movzx   eax, al\n");
+            ir_backend_define(backend, instr, next);
+            break;
+
+        case IR_LOAD_GLOBAL:
+            fprintf(out, "    mov     rax, [_g%d]\n", instr->a);
+            ir_backend_define(backend, instr, next);
+            break;
+
+        case IR_STORE_GLOBAL:
+            if (instr->b == backend->immediate) {
+                fprintf(out, "    mov     qword ptr [_g%d], %lld\n", instr->a, (long long)backend->immediate_value);
+                break;
+            }
+            ir_backend_load(backend, instr->b);
+            fprintf(out, "    mov     [_g%d], rax\n", instr->a);
+            break;
+
+        case IR_CALL:
+            for (int i = instr->c - 1; i >= 0; i--) {
+                int argument = backend->function->operands[instr->b + i];
+                fprintf(out, "    push    qword ptr %s\n", ir_backend_location(backend, argument, location, sizeof(location)));
+            }
+            fprintf(out, "    call    %s\n", backend->module->functions[instr->a].name);
+            if (instr->c > 0) fprintf(out, "    add     rsp, %d\n", 8 * instr->c);
+            backend->rax = IR_NONE;
+            if (instr->dest != IR_NONE) ir_backend_define(backend, instr, next);
+            break;
+
+        case IR_PHI:
+            code_generator_error(backend->generator, "Phi in %s: translate out of SSA first", backend->function->name);
+            return CODEGEN_ERROR_UNSUPPORTED_NODE;
+
+        case IR_JUMP:
+            if (instr->a != block + 1) {
+                ir_backend_label(backend, instr->a, label, sizeof(label));
+                fprintf(out, "    jmp     %s\n", label);
+            }
+            break;
+
+        case IR_BRANCH:
+            ir_backend_branch(backend, instr, block);
+            break;
+
+        case IR_RETURN:
+            if (instr->a != IR_NONE) ir_backend_load(backend, instr->a);
+            fprintf(out, "    mov     rsp, rbp\n");
+            fprintf(out, "    pop     rbp\n");
+            fprintf(out, "    ret\n");
+            break;
+
+        default:
+            return ir_backend_binary(backend, instr, next);
+    }
+
+    return CODEGEN_SUCCESS;
+}
+
+static CodeGenResult ir_backend_function(IrBackend* backend, int index) {
+    const IrFunction* function = &backend->module->functions[index];
+    FILE* out = backend->out;
+    backend->function = function;
+    backend->function_index = index;
+
+    SAFE_CALLOC(backend->uses, MAX(function->register_count, 1), sizeof(int));
+    int uses[8];
+    for (int i = 0; i < function->instr_count; i++) {
+        const IrInstr* instr = &function->instrs[i];
+        int count = ir_instr_uses(function, instr, uses, 8);
+        for (int u = 0; u < count; u++) {
+            // Only argument and phi lists are longer than the buffer
+            int reg = u < 8 ? uses[u] : function->operands[instr->b + u];
+            if (reg >= 0) backend->uses[reg]++;
+        }
+    }
+
+    // Frame: every register but the parameters, kept 16-byte aligned
+    int frame = 8 * (function->register_count - function->parameter_count);
+    frame = (frame + 15) & ~15;
+    fprintf(out, "    .global %s\n", function->name);
+    fprintf(out, "%s:\n", function->name);
+    fprintf(out, "    push    rbp\n");
+    fprintf(out, "    mov     rbp, rsp\n");
+    if (frame > 0) fprintf(out, "    sub     rsp, %d\n", frame);
+
+    CodeGenResult result = CODEGEN_SUCCESS;
+    for (int b = 0; b < function->block_count && result == CODEGEN_SUCCESS; b++) {
+        const IrBlock* block = &function->blocks[b];
+        if (b > 0) fprintf(out, ".L%d_%d:\n", index, b);
+        backend->rax = IR_NONE;
+        backend->immediate = IR_NONE;
+        backend->condition = NULL;
+        for (int i = 0; i < block->count && result == CODEGEN_SUCCESS; i++) {
+            const IrInstr* instr = &function->instrs[block->first + i];
+            const IrInstr* next = i + 1 < block->count ? instr + 1 : NULL;
+            const IrInstr* after = i + 2 < block->count ? instr + 2 : NULL;
+            if (ir_backend_is_immediate(backend, instr, next)) {
+                backend->immediate = instr->dest;
+                backend->immediate_value = function->constants[instr->a];
+                continue;
+            }
+
+            // A constant deferred as an immediate emits nothing, so the
+            // instruction after it is the one that reads rax next
+            if (next != NULL && ir_backend_is_immediate(backend, next, after)) next = after;
+            result = ir_backend_instr(backend, instr, next, b);
+            backend->immediate = IR_NONE;
+        }
+    }
+
+    free(backend->uses);
+    backend->uses = NULL;
+    return result;
+}
+
+CodeGenResult code_generator_generate_ir(CodeGenerator* generator, const IrModule* module, const char* output_filename) {
+    if (!generator || !module || !output_filename) {
+        return CODEGEN_ERROR_NULL_ANALYZER;
+    }
+    if (module->had_error) {
+        code_generator_error(generator, "%s", module->error);
+        return CODEGEN_ERROR_UNSUPPORTED_NODE;
+    }
+
+    // code_generator_set_output makes the file unbuffered, and a stream that
+    // has been unbuffered cannot get a buffer back; the backend writes far
+    // more lines than the AST generator, so it opens the file itself
+    if (generator->output_file) fclose(generator->output_file);
+    generator->output_file = fopen(output_filename, "w");
+    if (!generator->output_file) {
+        code_generator_error(generator, "Failed to open output file: %s", output_filename);
+        return CODEGEN_ERROR_INVALID_EXPRESSION;
+    }
+
+    CodeGenResult result = CODEGEN_SUCCESS;
+    FILE* out = generator->output_file;
+    fprintf(out, "    .intel_syntax noprefix\n");
+    fprintf(out, "    .section .data\n");
+    for (int i = 0; i < module->global_count; i++) {
+        fprintf(out, "_g%d:\n", i);
+        fprintf(out, "    .quad   0\n");
+    }
+    fprintf(out, "    .section .text\n");
+
+    IrBackend backend = {0};
+    backend.generator = generator;
+    backend.out = out;
+    backend.module = module;
+    for (int i = 0; i < module->function_count && result == CODEGEN_SUCCESS; i++) {
+        result = ir_backend_function(&backend, i);
+    }
+
+    if (generator->trap_used) {
+        fprintf(out, "_arith_trap:\n");
+        fprintf(out, "    ud2\n");
+    }
+    fprintf(out, "    .section .note.GNU-stack,\"\",@progbits\n");
+    fflush(out);
+    return result;
+}
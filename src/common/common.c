@@ -17,19 +17,32 @@ char* strdup_safe(const char* str) {
 char* strndup_safe(const char* str, size_t n) {
     if (str == NULL) return NULL;
 
-    size_t len = strlen(str);
-    if (len > n) len = n;
+    // Only scan the first n bytes; str may be a slice of a much longer buffer
+    size_t len = 0;
+    while (len < n && str[len] != '\0') len++;
 
     char* result = malloc(len + 1);
     if (result == NULL) {
         return NULL;
     }
 
-    strncpy(result, str, len);
+    memcpy(result, str, len);
     result[len] = '\0';
     return result;
 }
 
+uint64_t hash_bytes(const void* data, size_t length) {
+    const unsigned char* bytes = data;
+    uint64_t hash = 14695981039346656037ULL;
+
+    for (size_t i = 0; i < length; i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+
+    return hash;
+}
+
 // Dynamic string buffer
 StringBuffer* string_buffer_create(size_t initial_capacity) {
     StringBuffer* buffer = malloc(sizeof(StringBuffer));
@@ -97,6 +110,76 @@ void string_buffer_free(StringBuffer* buffer) {
     free(buffer);
 }
 
+// Arena allocator
+#define ARENA_ALIGNMENT 16
+
+static ArenaBlock* arena_block_create(size_t size) {
+    ArenaBlock* block;
+    SAFE_MALLOC(block, sizeof(ArenaBlock) + size);
+    block->next = NULL;
+    block->used = 0;
+    block->size = size;
+    return block;
+}
+
+Arena* arena_create(size_t block_size) {
+    Arena* arena = malloc(sizeof(Arena));
+    if (arena == NULL) return NULL;
+
+    arena->block_size = block_size > 0 ? block_size : 64 * 1024;
+    arena->blocks = arena_block_create(arena->block_size);
+    arena->bytes_used = 0;
+
+    return arena;
+}
+
+// Returns the padding needed to align the next allocation in block
+static size_t arena_padding(ArenaBlock* block) {
+    size_t address = (size_t)(block->data + block->used);
+    return (ARENA_ALIGNMENT - (address & (ARENA_ALIGNMENT - 1))) & (ARENA_ALIGNMENT - 1);
+}
+
+void* arena_alloc(Arena* arena, size_t size) {
+    if (arena == NULL) return NULL;
+
+    ArenaBlock* block = arena->blocks;
+    size_t padding = arena_padding(block);
+    if (block->used + padding + size > block->size) {
+        // Oversized requests get a dedicated block
+        block = arena_block_create(MAX(arena->block_size, size + ARENA_ALIGNMENT));
+        block->next = arena->blocks;
+        arena->blocks = block;
+        padding = arena_padding(block);
+    }
+
+    void* result = block->data + block->used + padding;
+    block->used += padding + size;
+    arena->bytes_used += size;
+    return result;
+}
+
+char* arena_strdup(Arena* arena, const char* str) {
+    if (arena == NULL || str == NULL) return NULL;
+
+    size_t len = strlen(str);
+    char* result = arena_alloc(arena, len + 1);
+    memcpy(result, str, len + 1);
+    return result;
+}
+
+void arena_free(Arena* arena) {
+    if (arena == NULL) return;
+
+    ArenaBlock* block = arena->blocks;
+    while (block != NULL) {
+        ArenaBlock* next = block->next;
+        free(block);
+        block = next;
+    }
+
+    free(arena);
+}
+
 // Error handling
 Error* error_create(ErrorCode code, const char* message, int line, int column, const char* file) {
     Error* error = malloc(sizeof(Error));
@@ -5,6 +5,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <ctype.h>
 #include <assert.h>
 
@@ -57,6 +58,9 @@
 char* strdup_safe(const char* str);
 char* strndup_safe(const char* str, size_t n);
 
+// 64-bit FNV-1a hash of a byte range
+uint64_t hash_bytes(const void* data, size_t length);
+
 // Dynamic string buffer
 typedef struct {
     char* data;
@@ -69,6 +73,26 @@ void string_buffer_append(StringBuffer* buffer, const char* str);
 void string_buffer_append_char(StringBuffer* buffer, char c);
 void string_buffer_free(StringBuffer* buffer);
 
+// Arena (bump) allocator: individual allocations are never freed, the whole
+// arena is released at once by arena_free
+typedef struct ArenaBlock {
+    struct ArenaBlock* next;
+    size_t used;
+    size_t size;
+    char data[];
+} ArenaBlock;
+
+typedef struct Arena {
+    ArenaBlock* blocks;      // Most recent block first
+    size_t block_size;
+    size_t bytes_used;
+} Arena;
+
+Arena* arena_create(size_t block_size);
+void* arena_alloc(Arena* arena, size_t size);
+char* arena_strdup(Arena* arena, const char* str);
+void arena_free(Arena* arena);
+
 // Error handling
 typedef enum {
     ERROR_NONE = 0,
@@ -0,0 +1,289 @@
+#include "ir.h"
+
+static void* ir_copy(IrModule* module, const void* data, size_t size) {
+    void* copy = arena_alloc(module->arena, size);
+    if (size > 0) memcpy(copy, data, size);
+    return copy;
+}
+
+void ir_module_free(IrModule* module) {
+    if (module == NULL) return;
+    arena_free(module->arena);
+    free(module);
+}
+
+int ir_function_add_constant(IrModule* module, IrFunction* function, int64_t value) {
+    // The pool doubles like a vector; the arena keeps the old copies
+    if (function->constant_count == function->constant_capacity) {
+        int capacity = MAX(function->constant_capacity * 2, 16);
+        int64_t* constants = arena_alloc(module->arena, sizeof(int64_t) * capacity);
+        if (function->constant_count > 0) {
+            memcpy(constants, function->constants, sizeof(int64_t) * function->constant_count);
+        }
+        function->constants = constants;
+        function->constant_capacity = capacity;
+    }
+
+    function->constants[function->constant_count] = value;
+    return function->constant_count++;
+}
+
+void ir_function_link_blocks(IrModule* module, IrFunction* function) {
+    int* counts;
+    SAFE_CALLOC(counts, function->block_count + 1, sizeof(int));
+
+    for (int i = 0; i < function->block_count; i++) {
+        IrBlock* block = &function->blocks[i];
+        const IrInstr* last = ir_block_terminator(function, i);
+        block->successors[0] = IR_NONE;
+        block->successors[1] = IR_NONE;
+        if (last->op == IR_JUMP) {
+            block->successors[0] = last->a;
+        } else if (last->op == IR_BRANCH) {
+            block->successors[0] = last->b;
+            block->successors[1] = last->c != last->b ? last->c : IR_NONE;
+        }
+        for (int s = 0; s < 2; s++) {
+            if (block->successors[s] != IR_NONE) counts[block->successors[s]]++;
+        }
+    }
+
+    // Predecessors are grouped by block, in the order of the predecessors
+    int total = 0;
+    for (int i = 0; i < function->block_count; i++) {
+        function->blocks[i].first_predecessor = total;
+        function->blocks[i].predecessor_count = 0;
+        total += counts[i];
+    }
+    function->predecessors = arena_alloc(module->arena, sizeof(int) * MAX(total, 1));
+    for (int i = 0; i < function->block_count; i++) {
+        for (int s = 0; s < 2; s++) {
+            int successor = function->blocks[i].successors[s];
+            if (successor == IR_NONE) continue;
+            IrBlock* target = &function->blocks[successor];
+            function->predecessors[target->first_predecessor + target->predecessor_count++] = i;
+        }
+    }
+
+    free(counts);
+}
+
+void ir_function_replace(IrModule* module, IrFunction* function, const IrBlock* blocks, int block_count,
+                         const IrInstr* instrs, int instr_count, const int* operands, int operand_count) {
+    function->blocks = ir_copy(module, blocks, sizeof(IrBlock) * block_count);
+    function->block_count = block_count;
+    function->instrs = ir_copy(module, instrs, sizeof(IrInstr) * instr_count);
+    function->instr_count = instr_count;
+    function->operands = ir_copy(module, operands, sizeof(int) * operand_count);
+    function->operand_count = operand_count;
+    ir_function_link_blocks(module, function);
+}
+
+int ir_instr_uses(const IrFunction* function, const IrInstr* instr, int* uses, int capacity) {
+    int count = 0;
+
+#define IR_USE(reg) \
+    do { \
+        if (count < capacity) uses[count] = (reg); \
+        count++; \
+    } while (0)
+
+    switch ((IrOpcode)instr->op) {
+        case IR_CONST:
+        case IR_LOAD_GLOBAL:
+        case IR_JUMP:
+            break;
+        case IR_COPY:
+        case IR_NEG:
+        case IR_NOT:
+        case IR_BITNOT:
+        case IR_BRANCH:
+            IR_USE(instr->a);
+            break;
+        case IR_RETURN:
+            if (instr->a != IR_NONE) IR_USE(instr->a);
+            break;
+        case IR_STORE_GLOBAL:
+            IR_USE(instr->b);
+            break;
+        case IR_CALL:
+        case IR_PHI:
+            for (int i = 0; i < instr->c; i++) IR_USE(function->operands[instr->b + i]);
+            break;
+        default:
+            IR_USE(instr->a);
+            IR_USE(instr->b);
+            break;
+    }
+
+#undef IR_USE
+    return count;
+}
+
+int ir_instr_use_slots(IrInstr* instr, int* operands, int** slots, int capacity) {
+    int count = 0;
+
+#define IR_USE_SLOT(slot) \
+    do { \
+        if (count < capacity) slots[count] = (slot); \
+        count++; \
+    } while (0)
+
+    switch ((IrOpcode)instr->op) {
+        case IR_CONST:
+        case IR_LOAD_GLOBAL:
+        case IR_JUMP:
+            break;
+        case IR_COPY:
+        case IR_NEG:
+        case IR_NOT:
+        case IR_BITNOT:
+        case IR_BRANCH:
+            IR_USE_SLOT(&instr->a);
+            break;
+        case IR_RETURN:
+            if (instr->a != IR_NONE) IR_USE_SLOT(&instr->a);
+            break;
+        case IR_STORE_GLOBAL:
+            IR_USE_SLOT(&instr->b);
+            break;
+        case IR_CALL:
+        case IR_PHI:
+            for (int i = 0; i < instr->c; i++) IR_USE_SLOT(&operands[instr->b + i]);
+            break;
+        default:
+            IR_USE_SLOT(&instr->a);
+            IR_USE_SLOT(&instr->b);
+            break;
+    }
+
+#undef IR_USE_SLOT
+    return count;
+}
+
+long ir_module_instr_count(const IrModule* module) {
+    long count = 0;
+    for (int i = 0; i < module->function_count; i++) {
+        count += module->functions[i].instr_count;
+    }
+    return count;
+}
+
+// Printing
+static const char* ir_opcode_names[IR_OPCODE_COUNT] = {
+    "const", "copy", "add", "sub", "mul", "div", "mod", "shl", "sar", "and", "or", "xor",
+    "eq", "ne", "lt", "le", "gt", "ge", "neg", "not", "bitnot", "load", "store", "call", "phi",
+    "jump", "branch", "return"
+};
+
+const char* ir_opcode_name(IrOpcode op) {
+    return op < IR_OPCODE_COUNT ? ir_opcode_names[op] : "?";
+}
+
+static void ir_print_global(const IrModule* module, int global, FILE* out) {
+    if (global >= 0 && global < module->global_count && module->global_names[global] != NULL) {
+        fprintf(out, "@%s", module->global_names[global]);
+    } else {
+        fprintf(out, "@g%d", global);
+    }
+}
+
+static void ir_print_list(const IrFunction* function, const IrInstr* instr, FILE* out) {
+    for (int i = 0; i < instr->c; i++) {
+        fprintf(out, "%s%%%d", i > 0 ? ", " : "", function->operands[instr->b + i]);
+    }
+}
+
+// Phi inputs are shown with the predecessor of block they come from
+static void ir_print_instr(const IrModule* module, const IrFunction* function, const IrBlock* block,
+                           const IrInstr* instr, FILE* out) {
+    IrOpcode op = (IrOpcode)instr->op;
+    fprintf(out, "    ");
+    if (instr->dest != IR_NONE) fprintf(out, "%%%d = ", instr->dest);
+    fprintf(out, "%s", ir_opcode_name(op));
+
+    switch (op) {
+        case IR_CONST:
+            fprintf(out, " %lld", (long long)function->constants[instr->a]);
+            break;
+        case IR_LOAD_GLOBAL:
+            fprintf(out, " ");
+            ir_print_global(module, instr->a, out);
+            break;
+        case IR_STORE_GLOBAL:
+            fprintf(out, " ");
+            ir_print_global(module, instr->a, out);
+            fprintf(out, ", %%%d", instr->b);
+            break;
+        case IR_CALL:
+            fprintf(out, " %s(", module->functions[instr->a].name);
+            ir_print_list(function, instr, out);
+            fprintf(out, ")");
+            break;
+        case IR_PHI: {
+            for (int i = 0; i < instr->c; i++) {
+                fprintf(out, "%s[%%%d, ", i > 0 ? ", " : " ", function->operands[instr->b + i]);
+                if (i < block->predecessor_count) {
+                    fprintf(out, "b%d]", function->predecessors[block->first_predecessor + i]);
+                } else {
+                    fprintf(out, "?]");
+                }
+            }
+            break;
+        }
+        case IR_JUMP:
+            fprintf(out, " b%d", instr->a);
+            break;
+        case IR_BRANCH:
+            fprintf(out, " %%%d, b%d, b%d", instr->a, instr->b, instr->c);
+            break;
+        case IR_RETURN:
+            if (instr->a != IR_NONE) fprintf(out, " %%%d", instr->a);
+            break;
+        case IR_COPY:
+        case IR_NEG:
+        case IR_NOT:
+        case IR_BITNOT:
+            fprintf(out, " %%%d", instr->a);
+            break;
+        default:
+            fprintf(out, " %%%d, %%%d", instr->a, instr->b);
+            break;
+    }
+
+    if (instr->flags & IR_FLAG_NO_OVERFLOW) fprintf(out, " nooverflow");
+    if (instr->flags & IR_FLAG_NONZERO_DIVISOR) fprintf(out, " nonzero");
+    if (instr->flags & IR_FLAG_NARROW) fprintf(out, " narrow");
+    fprintf(out, "\n");
+}
+
+void ir_function_print(const IrModule* module, const IrFunction* function, FILE* out) {
+    fprintf(out, "function %s(", function->name);
+    for (int i = 0; i < function->parameter_count; i++) {
+        fprintf(out, "%s%%%d", i > 0 ? ", " : "", i);
+    }
+    fprintf(out, ") {\n");
+
+    for (int b = 0; b < function->block_count; b++) {
+        const IrBlock* block = &function->blocks[b];
+        fprintf(out, "b%d:", b);
+        if (block->predecessor_count > 0) {
+            fprintf(out, "    ; from");
+            for (int p = 0; p < block->predecessor_count; p++) {
+                fprintf(out, " b%d", function->predecessors[block->first_predecessor + p]);
+            }
+        }
+        fprintf(out, "\n");
+        for (int i = 0; i < block->count; i++) {
+            ir_print_instr(module, function, block, &function->instrs[block->first + i], out);
+        }
+    }
+    fprintf(out, "}\n");
+}
+
+void ir_module_print(const IrModule* module, FILE* out) {
+    for (int i = 0; i < module->function_count; i++) {
+        if (i > 0) fprintf(out, "\n");
+        ir_function_print(module, &module->functions[i], out);
+    }
+}
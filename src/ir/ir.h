@@ -0,0 +1,166 @@
+#ifndef IR_H
+#define IR_H
+
+#include "../common/common.h"
+#include "../parser/parser.h"
+#include "../semantic/semantic.h"
+
+// Three-address intermediate representation. A module holds the program's
+// functions, with its top-level code as function 0 ("_main"); each function
+// is a list of basic blocks over virtual registers. Everything is stored by
+// index: a block is a range of the function's instruction array, and an
+// instruction names registers, blocks, functions, globals and constants by
+// number, so a function is a handful of flat arrays. They are allocated
+// exactly sized in the module's arena, which is released at once with the
+// module; a pass that rewrites a function builds new arrays there.
+//
+// Registers 0 .. variable_count - 1 are the function's variables (its
+// frame slots, parameters first) and may be assigned many times; the rest
+// are temporaries. ssa.h puts functions in SSA form and back, and sccp.h
+// propagates constants in that form. Integer, char and bool values are
+// 64-bit integers; floats and strings are not lowered.
+
+#define IR_NONE -1
+
+typedef enum {
+    IR_TYPE_VOID,
+    IR_TYPE_INT,
+    IR_TYPE_BOOL             // 0 or 1
+} IrType;
+
+// Operands of each opcode (a, b and c of IrInstr); dest is the register
+// defined, IR_NONE for the opcodes that define none
+typedef enum {
+    IR_CONST,                // dest = constants[a]
+    IR_COPY,                 // dest = a
+    IR_ADD,                  // dest = a op b, for IR_ADD .. IR_GE
+    IR_SUB,
+    IR_MUL,
+    IR_DIV,
+    IR_MOD,
+    IR_SHL,
+    IR_SAR,                  // Arithmetic shift right
+    IR_AND,
+    IR_OR,
+    IR_XOR,
+    IR_EQ,
+    IR_NE,
+    IR_LT,
+    IR_LE,
+    IR_GT,
+    IR_GE,
+    IR_NEG,                  // dest = -a
+    IR_NOT,                  // dest = a == 0
+    IR_BITNOT,               // dest = ~a
+    IR_LOAD_GLOBAL,          // dest = global a
+    IR_STORE_GLOBAL,         // global a = b; no dest
+    IR_CALL,                 // dest = function a (operands[b .. b + c - 1])
+    IR_PHI,                  // dest = operands[b + i] coming from predecessor i; c inputs
+    IR_JUMP,                 // Terminators: goto block a
+    IR_BRANCH,               // if a != 0 goto block b else goto block c
+    IR_RETURN,               // return a, or nothing if a is IR_NONE
+    IR_OPCODE_COUNT
+} IrOpcode;
+
+// Facts the range analysis proved about an instruction (see ranges.h),
+// which the backend uses to leave out checks and pick cheaper instructions
+typedef enum {
+    IR_FLAG_NO_OVERFLOW = 1 << 0,      // IR_ADD, IR_SUB, IR_MUL
+    IR_FLAG_NONZERO_DIVISOR = 1 << 1,  // IR_DIV, IR_MOD
+    IR_FLAG_NARROW = 1 << 2            // Operands and result are in [0, INT32_MAX]
+} IrFlag;
+
+typedef struct {
+    uint8_t op;              // IrOpcode
+    uint8_t type;            // IrType of dest
+    uint8_t flags;           // IrFlag
+    uint8_t unused;
+    int32_t dest;
+    int32_t a;
+    int32_t b;
+    int32_t c;
+} IrInstr;
+
+typedef struct {
+    int first;               // Index of the first instruction; the last is a terminator
+    int count;
+    int successors[2];       // IR_NONE when absent
+    int first_predecessor;   // Index in predecessors
+    int predecessor_count;
+} IrBlock;
+
+typedef struct {
+    const char* name;
+    int parameter_count;     // Registers 0 .. parameter_count - 1 hold the arguments
+    int variable_count;
+    int register_count;
+    IrType return_type;
+    bool ssa;                // Every register is defined once (see ssa.h)
+    IrBlock* blocks;         // Block 0 is the entry
+    int block_count;
+    IrInstr* instrs;
+    int instr_count;
+    int* operands;           // Call arguments and phi inputs
+    int operand_count;
+    int64_t* constants;
+    int constant_count;
+    int constant_capacity;
+    int* predecessors;
+} IrFunction;
+
+typedef struct {
+    Arena* arena;
+    IrFunction* functions;   // functions[0] is the top-level code
+    int function_count;
+    const char** global_names;
+    int global_count;
+    bool had_error;
+    char error[256];         // First construct that could not be lowered
+} IrModule;
+
+// Lowers a program that analyzer has analyzed without errors (and ranges_analyze,
+// optionally, has annotated). The module is returned even when something could
+// not be lowered, with had_error set; programs using floats or strings are
+// not supported.
+IrModule* ir_lower_program(ASTNode* program, SemanticAnalyzer* analyzer);
+void ir_module_free(IrModule* module);
+
+// Recomputes the successors and predecessors of every block from the
+// terminators, after a pass has changed them
+void ir_function_link_blocks(IrModule* module, IrFunction* function);
+
+// Copies blocks, instrs and operands into the module's arena as the
+// function's new body and links the blocks; used by passes that rewrite a
+// function. Only first and count of each block are read.
+void ir_function_replace(IrModule* module, IrFunction* function, const IrBlock* blocks, int block_count,
+                         const IrInstr* instrs, int instr_count, const int* operands, int operand_count);
+
+// Adds a constant to the function's pool and returns its index
+int ir_function_add_constant(IrModule* module, IrFunction* function, int64_t value);
+
+static inline bool ir_is_terminator(IrOpcode op) {
+    return op == IR_JUMP || op == IR_BRANCH || op == IR_RETURN;
+}
+
+static inline const IrInstr* ir_block_terminator(const IrFunction* function, int block) {
+    const IrBlock* b = &function->blocks[block];
+    return &function->instrs[b->first + b->count - 1];
+}
+
+// Stores in uses the registers an instruction reads, in operand order, and
+// returns how many there are; only the first capacity are stored
+int ir_instr_uses(const IrFunction* function, const IrInstr* instr, int* uses, int capacity);
+
+// Like ir_instr_uses, but stores where the registers are: fields of instr,
+// or entries of operands for call arguments and phi inputs
+int ir_instr_use_slots(IrInstr* instr, int* operands, int** slots, int capacity);
+
+// Textual form, one instruction per line
+const char* ir_opcode_name(IrOpcode op);
+void ir_function_print(const IrModule* module, const IrFunction* function, FILE* out);
+void ir_module_print(const IrModule* module, FILE* out);
+
+// Instructions in all functions of the module
+long ir_module_instr_count(const IrModule* module);
+
+#endif // IR_H
@@ -0,0 +1,709 @@
+#include "ir.h"
+#include "../semantic/ranges.h"
+#include <stdarg.h>
+
+// Lowering from the resolved AST. Control flow is lowered structurally:
+// each if and while creates its blocks up front and fills them in order,
+// so the instructions of a block are contiguous in the scratch array.
+// Blocks are numbered when they are created and may be started out of
+// order; when a function is finished, the blocks reachable from the entry
+// are renumbered in the order they were filled and copied to the arena.
+// The scratch arrays are reused for every function of the program.
+typedef struct {
+    IrModule* module;
+    SemanticAnalyzer* analyzer;
+
+    // Functions of the program by name (module index - 1)
+    ASTNode** function_nodes;
+    uint32_t* function_hashes;
+    int* slots;                  // Open addressing: function index + 1, 0 when empty
+    int slot_capacity;           // Power of two, at least twice the function count
+
+    IrFunction* function;        // Function being lowered
+    IrInstr* instrs;
+    int instr_count;
+    int instr_capacity;
+    IrBlock* blocks;             // first is -1 until the block is started
+    int block_count;
+    int block_capacity;
+    int* started;                // Blocks in the order they were started
+    int started_count;
+    int* operands;
+    int operand_count;
+    int operand_capacity;
+    int64_t* constants;
+    int constant_count;
+    int constant_capacity;
+    int current;                 // Block being filled, IR_NONE after a terminator
+
+    // Scratch for finishing a function, sized like blocks and instrs
+    int* numbers;
+    int* stack;
+    IrBlock* packed_blocks;
+    IrInstr* packed_instrs;
+} IrLowerer;
+
+static void ir_lower_error(IrLowerer* lowerer, ASTNode* node, const char* format, ...) {
+    if (lowerer->module->had_error) return;
+
+    IrModule* module = lowerer->module;
+    int length = snprintf(module->error, sizeof(module->error), "Line %d: ", node != NULL ? node->line : 0);
+    va_list args;
+    va_start(args, format);
+    vsnprintf(module->error + length, sizeof(module->error) - length, format, args);
+    va_end(args);
+    module->had_error = true;
+}
+
+// Types of values: integers, chars and bools are lowered, floats and
+// strings are not
+static bool ir_lower_type(const char* type_name, IrType* type) {
+    const TypeDescriptor* descriptor = type_from_name(type_name);
+    DataType primitive = descriptor != NULL ? descriptor->primitive : TYPE_UNKNOWN;
+    switch (primitive) {
+        case TYPE_INT:
+        case TYPE_CHAR: *type = IR_TYPE_INT; return true;
+        case TYPE_BOOL: *type = IR_TYPE_BOOL; return true;
+        case TYPE_VOID: *type = IR_TYPE_VOID; return true;
+        default: return false;
+    }
+}
+
+// Function index
+static int ir_lower_find_function(IrLowerer* lowerer, const char* name) {
+    uint32_t hash = (uint32_t)hash_bytes(name, strlen(name));
+    uint32_t mask = (uint32_t)lowerer->slot_capacity - 1;
+    uint32_t slot = hash & mask;
+    while (lowerer->slots[slot] != 0) {
+        int index = lowerer->slots[slot] - 1;
+        if (lowerer->function_hashes[index] == hash &&
+            strcmp(lowerer->function_nodes[index]->data.function.name, name) == 0) {
+            return index;
+        }
+        slot = (slot + 1) & mask;
+    }
+    return -1;
+}
+
+// Adds a function unless one of the same name came first; a redeclaration
+// was rejected by analysis and calls mean the first. Returns whether it was added.
+static bool ir_lower_add_function(IrLowerer* lowerer, ASTNode* node, int count) {
+    const char* name = node->data.function.name;
+    if (ir_lower_find_function(lowerer, name) >= 0) return false;
+
+    uint32_t hash = (uint32_t)hash_bytes(name, strlen(name));
+    uint32_t mask = (uint32_t)lowerer->slot_capacity - 1;
+    uint32_t slot = hash & mask;
+    while (lowerer->slots[slot] != 0) slot = (slot + 1) & mask;
+
+    lowerer->function_nodes[count] = node;
+    lowerer->function_hashes[count] = hash;
+    lowerer->slots[slot] = count + 1;
+    return true;
+}
+
+// Blocks and instructions
+static int ir_lower_new_block(IrLowerer* lowerer) {
+    if (lowerer->block_count == lowerer->block_capacity) {
+        lowerer->block_capacity = MAX(lowerer->block_capacity * 2, 64);
+        SAFE_REALLOC(lowerer->blocks, sizeof(IrBlock) * lowerer->block_capacity);
+        SAFE_REALLOC(lowerer->started, sizeof(int) * lowerer->block_capacity);
+        SAFE_REALLOC(lowerer->numbers, sizeof(int) * lowerer->block_capacity);
+        SAFE_REALLOC(lowerer->stack, sizeof(int) * lowerer->block_capacity);
+        SAFE_REALLOC(lowerer->packed_blocks, sizeof(IrBlock) * lowerer->block_capacity);
+    }
+
+    IrBlock* block = &lowerer->blocks[lowerer->block_count];
+    block->first = -1;
+    block->count = 0;
+    return lowerer->block_count++;
+}
+
+static int ir_lower_emit(IrLowerer* lowerer, IrOpcode op, IrType type, int dest, int a, int b, int c, unsigned flags);
+
+// Starts filling block, falling through to it from the current block
+static void ir_lower_start_block(IrLowerer* lowerer, int block) {
+    if (lowerer->current != IR_NONE) ir_lower_emit(lowerer, IR_JUMP, IR_TYPE_VOID, IR_NONE, block, 0, 0, 0);
+
+    lowerer->blocks[block].first = lowerer->instr_count;
+    lowerer->started[lowerer->started_count++] = block;
+    lowerer->current = block;
+}
+
+// Appends an instruction to the current block. Code after a terminator is
+// unreachable and goes to a new block, which finishing drops.
+static int ir_lower_emit(IrLowerer* lowerer, IrOpcode op, IrType type, int dest, int a, int b, int c, unsigned flags) {
+    if (lowerer->current == IR_NONE) ir_lower_start_block(lowerer, ir_lower_new_block(lowerer));
+
+    if (lowerer->instr_count == lowerer->instr_capacity) {
+        lowerer->instr_capacity = MAX(lowerer->instr_capacity * 2, 256);
+        SAFE_REALLOC(lowerer->instrs, sizeof(IrInstr) * lowerer->instr_capacity);
+        SAFE_REALLOC(lowerer->packed_instrs, sizeof(IrInstr) * lowerer->instr_capacity);
+    }
+
+    IrInstr* instr = &lowerer->instrs[lowerer->instr_count++];
+    instr->op = (uint8_t)op;
+    instr->type = (uint8_t)type;
+    instr->flags = (uint8_t)flags;
+    instr->unused = 0;
+    instr->dest = dest;
+    instr->a = a;
+    instr->b = b;
+    instr->c = c;
+    lowerer->blocks[lowerer->current].count++;
+    if (ir_is_terminator(op)) lowerer->current = IR_NONE;
+    return dest;
+}
+
+static int ir_lower_temp(IrLowerer* lowerer) {
+    return lowerer->function->register_count++;
+}
+
+// Constants are pooled in scratch and copied exactly sized when the
+// function is finished
+static int ir_lower_constant(IrLowerer* lowerer, int64_t value) {
+    if (lowerer->constant_count == lowerer->constant_capacity) {
+        lowerer->constant_capacity = MAX(lowerer->constant_capacity * 2, 64);
+        SAFE_REALLOC(lowerer->constants, sizeof(int64_t) * lowerer->constant_capacity);
+    }
+    lowerer->constants[lowerer->constant_count] = value;
+    return lowerer->constant_count++;
+}
+
+static int ir_lower_const(IrLowerer* lowerer, int64_t value, IrType type) {
+    return ir_lower_emit(lowerer, IR_CONST, type, ir_lower_temp(lowerer), ir_lower_constant(lowerer, value), 0, 0, 0);
+}
+
+// Stores value in a variable's register. A temporary the current block has
+// just computed is computed into the variable instead of being copied.
+static void ir_lower_assign(IrLowerer* lowerer, int variable, int value, IrType type) {
+    if (lowerer->current != IR_NONE && lowerer->blocks[lowerer->current].count > 0 &&
+        value >= lowerer->function->variable_count) {
+        IrInstr* last = &lowerer->instrs[lowerer->instr_count - 1];
+        if (last->dest == value) {
+            last->dest = variable;
+            return;
+        }
+    }
+    ir_lower_emit(lowerer, IR_COPY, type, variable, value, 0, 0, 0);
+}
+
+// Expressions
+static int ir_lower_expression(IrLowerer* lowerer, ASTNode* node);
+static void ir_lower_branch(IrLowerer* lowerer, ASTNode* condition, int if_true, int if_false);
+
+static IrType ir_lower_node_type(ASTNode* node) {
+    return node->resolved_type - 1 == TYPE_BOOL ? IR_TYPE_BOOL : IR_TYPE_INT;
+}
+
+static bool ir_lower_is_integer_literal(ASTNode* node, int* value) {
+    if (node->type != NODE_LITERAL || node->token == NULL || node->token->type != TOKEN_INTEGER_LITERAL) return false;
+    *value = node->data.literal.int_value;
+    return true;
+}
+
+static int ir_lower_literal(IrLowerer* lowerer, ASTNode* node) {
+    switch (node->token != NULL ? node->token->type : TOKEN_UNKNOWN) {
+        case TOKEN_INTEGER_LITERAL: return ir_lower_const(lowerer, node->data.literal.int_value, IR_TYPE_INT);
+        case TOKEN_CHAR_LITERAL: return ir_lower_const(lowerer, node->data.literal.char_value, IR_TYPE_INT);
+        case TOKEN_TRUE: return ir_lower_const(lowerer, 1, IR_TYPE_BOOL);
+        case TOKEN_FALSE: return ir_lower_const(lowerer, 0, IR_TYPE_BOOL);
+        default:
+            ir_lower_error(lowerer, node, "unsupported literal '%s'", node->token != NULL ? node->token->lexeme : "");
+            return IR_NONE;
+    }
+}
+
+static bool ir_lower_resolved(IrLowerer* lowerer, ASTNode* node) {
+    if (node->resolved_slot < 0) {
+        ir_lower_error(lowerer, node, "unresolved identifier '%s'", node->data.identifier_name);
+        return false;
+    }
+    return true;
+}
+
+static int ir_lower_identifier(IrLowerer* lowerer, ASTNode* node) {
+    if (!ir_lower_resolved(lowerer, node)) return IR_NONE;
+    if (!node->resolved_global) return node->resolved_slot;
+    return ir_lower_emit(lowerer, IR_LOAD_GLOBAL, ir_lower_node_type(node), ir_lower_temp(lowerer),
+                         node->resolved_slot, 0, 0, 0);
+}
+
+static int ir_lower_assignment(IrLowerer* lowerer, ASTNode* node) {
+    ASTNode* target = node->data.binary.left;
+    if (target->type != NODE_IDENTIFIER) {
+        ir_lower_error(lowerer, node, "unsupported assignment target");
+        return IR_NONE;
+    }
+
+    int value = ir_lower_expression(lowerer, node->data.binary.right);
+    if (!ir_lower_resolved(lowerer, target)) return IR_NONE;
+    IrType type = ir_lower_node_type(target);
+    if (target->resolved_global) {
+        ir_lower_emit(lowerer, IR_STORE_GLOBAL, IR_TYPE_VOID, IR_NONE, target->resolved_slot, value, 0, 0);
+        return value;
+    }
+
+    ir_lower_assign(lowerer, target->resolved_slot, value, type);
+    return target->resolved_slot;
+}
+
+static int ir_lower_call(IrLowerer* lowerer, ASTNode* node) {
+    ASTNode* callee = node->data.call.callee;
+    bool local = callee->type == NODE_IDENTIFIER && callee->resolved_slot >= 0;
+    int index = callee->type == NODE_IDENTIFIER && !local
+        ? ir_lower_find_function(lowerer, callee->data.identifier_name) : -1;
+    if (index < 0) {
+        ir_lower_error(lowerer, node, "call to a function not in the program");
+        return IR_NONE;
+    }
+
+    // Arguments are evaluated in order, then listed together
+    int count = node->data.call.argument_count;
+    int arguments[count > 0 ? count : 1];
+    for (int i = 0; i < count; i++) {
+        arguments[i] = ir_lower_expression(lowerer, node->data.call.arguments[i]);
+    }
+    if (lowerer->operand_count + count > lowerer->operand_capacity) {
+        lowerer->operand_capacity = MAX(lowerer->operand_capacity * 2, lowerer->operand_count + count + 64);
+        SAFE_REALLOC(lowerer->operands, sizeof(int) * lowerer->operand_capacity);
+    }
+    int first = lowerer->operand_count;
+    memcpy(&lowerer->operands[first], arguments, sizeof(int) * count);
+    lowerer->operand_count += count;
+
+    IrFunction* function = &lowerer->module->functions[index + 1];
+    bool returns = function->return_type != IR_TYPE_VOID;
+    return ir_lower_emit(lowerer, IR_CALL, function->return_type, returns ? ir_lower_temp(lowerer) : IR_NONE,
+                         index + 1, first, count, 0);
+}
+
+// A logical operator's value is 1 or 0 stored on either side of a branch
+static int ir_lower_logical(IrLowerer* lowerer, ASTNode* node) {
+    int result = ir_lower_temp(lowerer);
+    int if_true = ir_lower_new_block(lowerer);
+    int if_false = ir_lower_new_block(lowerer);
+    int done = ir_lower_new_block(lowerer);
+
+    ir_lower_branch(lowerer, node, if_true, if_false);
+    ir_lower_start_block(lowerer, if_true);
+    ir_lower_emit(lowerer, IR_CONST, IR_TYPE_BOOL, result,
+                  ir_lower_constant(lowerer, 1), 0, 0, 0);
+    ir_lower_emit(lowerer, IR_JUMP, IR_TYPE_VOID, IR_NONE, done, 0, 0, 0);
+    ir_lower_start_block(lowerer, if_false);
+    ir_lower_emit(lowerer, IR_CONST, IR_TYPE_BOOL, result,
+                  ir_lower_constant(lowerer, 0), 0, 0, 0);
+    ir_lower_start_block(lowerer, done);
+    return result;
+}
+
+static IrOpcode ir_lower_opcode(BinaryOperator op) {
+    switch (op) {
+        case OP_ADD: return IR_ADD;
+        case OP_SUBTRACT: return IR_SUB;
+        case OP_MULTIPLY: return IR_MUL;
+        case OP_DIVIDE: return IR_DIV;
+        case OP_MODULO: return IR_MOD;
+        case OP_SHIFT_LEFT: return IR_SHL;
+        case OP_SHIFT_RIGHT: return IR_SAR;
+        case OP_BITWISE_AND: return IR_AND;
+        case OP_BITWISE_XOR: return IR_XOR;
+        case OP_BITWISE_OR: return IR_OR;
+        case OP_EQUAL: return IR_EQ;
+        case OP_NOT_EQUAL: return IR_NE;
+        case OP_LESS: return IR_LT;
+        case OP_LESS_EQUAL: return IR_LE;
+        case OP_GREATER: return IR_GT;
+        case OP_GREATER_EQUAL: return IR_GE;
+        default: return IR_OPCODE_COUNT;
+    }
+}
+
+// What the range analysis proved about an operator (see ranges.h) becomes
+// flags of its instruction
+static unsigned ir_lower_flags(ASTNode* node) {
+    unsigned left = node->data.binary.left->range_facts;
+    unsigned right = node->data.binary.right->range_facts;
+    unsigned flags = 0;
+    int divisor;
+
+    switch (node->data.binary.op) {
+        case OP_ADD:
+        case OP_SUBTRACT:
+        case OP_MULTIPLY:
+            if (node->range_facts & RANGE_NO_OVERFLOW) flags |= IR_FLAG_NO_OVERFLOW;
+            if (left & right & node->range_facts & RANGE_SMALL) flags |= IR_FLAG_NARROW;
+            break;
+        case OP_DIVIDE:
+        case OP_MODULO:
+            if ((right & RANGE_NONZERO) ||
+                (ir_lower_is_integer_literal(node->data.binary.right, &divisor) && divisor != 0)) {
+                flags |= IR_FLAG_NONZERO_DIVISOR;
+            }
+            if (left & right & RANGE_SMALL) flags |= IR_FLAG_NARROW;
+            break;
+        default:
+            break;
+    }
+    return flags;
+}
+
+static int ir_lower_binary(IrLowerer* lowerer, ASTNode* node) {
+    BinaryOperator op = node->data.binary.op;
+    if (op == OP_LOGICAL_AND || op == OP_LOGICAL_OR) return ir_lower_logical(lowerer, node);
+
+    IrOpcode opcode = ir_lower_opcode(op);
+    if (opcode == IR_OPCODE_COUNT) {
+        ir_lower_error(lowerer, node, "unsupported operator '%s'", node->data.binary.operator);
+        return IR_NONE;
+    }
+
+    // A nonnegative dividend divides by a power of two with a shift or a mask
+    ASTNode* left = node->data.binary.left;
+    int divisor;
+    if ((op == OP_DIVIDE || op == OP_MODULO) && (left->range_facts & RANGE_NONNEGATIVE) &&
+        ir_lower_is_integer_literal(node->data.binary.right, &divisor) && divisor > 1 &&
+        (divisor & (divisor - 1)) == 0) {
+        int value = ir_lower_expression(lowerer, left);
+        int64_t operand = op == OP_DIVIDE ? __builtin_ctz((unsigned)divisor) : divisor - 1;
+        int constant = ir_lower_const(lowerer, operand, IR_TYPE_INT);
+        return ir_lower_emit(lowerer, op == OP_DIVIDE ? IR_SAR : IR_AND, IR_TYPE_INT, ir_lower_temp(lowerer),
+                             value, constant, 0, 0);
+    }
+
+    int a = ir_lower_expression(lowerer, left);
+    int b = ir_lower_expression(lowerer, node->data.binary.right);
+    IrType type = opcode >= IR_EQ ? IR_TYPE_BOOL : IR_TYPE_INT;
+    return ir_lower_emit(lowerer, opcode, type, ir_lower_temp(lowerer), a, b, 0, ir_lower_flags(node));
+}
+
+static int ir_lower_unary(IrLowerer* lowerer, ASTNode* node) {
+    const char* op = node->data.unary.operator;
+    if (op != NULL && strcmp(op, "!") == 0) return ir_lower_logical(lowerer, node);
+
+    IrOpcode opcode = IR_OPCODE_COUNT;
+    if (op != NULL && strcmp(op, "-") == 0) opcode = IR_NEG;
+    if (op != NULL && strcmp(op, "~") == 0) opcode = IR_BITNOT;
+    if (opcode == IR_OPCODE_COUNT) {
+        ir_lower_error(lowerer, node, "unsupported operator '%s'", op != NULL ? op : "");
+        return IR_NONE;
+    }
+
+    int operand = ir_lower_expression(lowerer, node->data.unary.operand);
+    return ir_lower_emit(lowerer, opcode, IR_TYPE_INT, ir_lower_temp(lowerer), operand, 0, 0, 0);
+}
+
+static int ir_lower_expression(IrLowerer* lowerer, ASTNode* node) {
+    DataType type = (DataType)(node->resolved_type - 1);
+    if (node->resolved_type != 0 && (type == TYPE_FLOAT || type == TYPE_STRING)) {
+        ir_lower_error(lowerer, node, "unsupported %s value", type == TYPE_FLOAT ? "float" : "string");
+        return IR_NONE;
+    }
+
+    switch (node->type) {
+        case NODE_LITERAL: return ir_lower_literal(lowerer, node);
+        case NODE_IDENTIFIER: return ir_lower_identifier(lowerer, node);
+        case NODE_ASSIGNMENT_EXPRESSION: return ir_lower_assignment(lowerer, node);
+        case NODE_BINARY_EXPRESSION: return ir_lower_binary(lowerer, node);
+        case NODE_UNARY_EXPRESSION: return ir_lower_unary(lowerer, node);
+        case NODE_CALL_EXPRESSION: return ir_lower_call(lowerer, node);
+        default:
+            ir_lower_error(lowerer, node, "unsupported expression");
+            return IR_NONE;
+    }
+}
+
+// Jumps to if_true or if_false on condition; &&, || and ! become branches
+static void ir_lower_branch(IrLowerer* lowerer, ASTNode* condition, int if_true, int if_false) {
+    if (condition->type == NODE_UNARY_EXPRESSION && condition->data.unary.operator != NULL &&
+        strcmp(condition->data.unary.operator, "!") == 0) {
+        ir_lower_branch(lowerer, condition->data.unary.operand, if_false, if_true);
+        return;
+    }
+
+    if (condition->type == NODE_BINARY_EXPRESSION &&
+        (condition->data.binary.op == OP_LOGICAL_AND || condition->data.binary.op == OP_LOGICAL_OR)) {
+        int right = ir_lower_new_block(lowerer);
+        if (condition->data.binary.op == OP_LOGICAL_AND) {
+            ir_lower_branch(lowerer, condition->data.binary.left, right, if_false);
+        } else {
+            ir_lower_branch(lowerer, condition->data.binary.left, if_true, right);
+        }
+        ir_lower_start_block(lowerer, right);
+        ir_lower_branch(lowerer, condition->data.binary.right, if_true, if_false);
+        return;
+    }
+
+    int value = ir_lower_expression(lowerer, condition);
+    ir_lower_emit(lowerer, IR_BRANCH, IR_TYPE_VOID, IR_NONE, value, if_true, if_false, 0);
+}
+
+// Statements
+static void ir_lower_statement(IrLowerer* lowerer, ASTNode* node);
+
+static void ir_lower_declaration(IrLowerer* lowerer, ASTNode* node) {
+    IrType type;
+    if (!ir_lower_type(node->data.declaration.type_name, &type) || type == IR_TYPE_VOID) {
+        ir_lower_error(lowerer, node, "unsupported type '%s'", node->data.declaration.type_name);
+        return;
+    }
+    if (node->resolved_slot < 0) {
+        ir_lower_error(lowerer, node, "unresolved declaration '%s'", node->data.declaration.name);
+        return;
+    }
+
+    ASTNode* initializer = node->data.declaration.initializer;
+    if (node->resolved_global) {
+        // Globals start as zero
+        if (initializer == NULL) return;
+        int value = ir_lower_expression(lowerer, initializer);
+        ir_lower_emit(lowerer, IR_STORE_GLOBAL, IR_TYPE_VOID, IR_NONE, node->resolved_slot, value, 0, 0);
+        return;
+    }
+
+    int value = initializer != NULL ? ir_lower_expression(lowerer, initializer) : ir_lower_const(lowerer, 0, type);
+    ir_lower_assign(lowerer, node->resolved_slot, value, type);
+}
+
+static void ir_lower_statement(IrLowerer* lowerer, ASTNode* node) {
+    if (node == NULL) return;
+
+    switch (node->type) {
+        case NODE_PROGRAM:
+        case NODE_BLOCK_STATEMENT:
+            for (int i = 0; i < node->data.block.statement_count; i++) {
+                ir_lower_statement(lowerer, node->data.block.statements[i]);
+            }
+            break;
+
+        case NODE_VARIABLE_DECLARATION:
+            ir_lower_declaration(lowerer, node);
+            break;
+
+        case NODE_EXPRESSION_STATEMENT:
+            if (node->data.statement.expression != NULL) {
+                ir_lower_expression(lowerer, node->data.statement.expression);
+            }
+            break;
+
+        case NODE_RETURN_STATEMENT: {
+            int value = node->data.statement.expression != NULL
+                ? ir_lower_expression(lowerer, node->data.statement.expression) : IR_NONE;
+            ir_lower_emit(lowerer, IR_RETURN, IR_TYPE_VOID, IR_NONE, value, 0, 0, 0);
+            break;
+        }
+
+        case NODE_IF_STATEMENT: {
+            int then_block = ir_lower_new_block(lowerer);
+            int else_block = node->data.conditional.else_branch != NULL ? ir_lower_new_block(lowerer) : IR_NONE;
+            int done = ir_lower_new_block(lowerer);
+            ir_lower_branch(lowerer, node->data.conditional.condition, then_block,
+                            else_block != IR_NONE ? else_block : done);
+            ir_lower_start_block(lowerer, then_block);
+            ir_lower_statement(lowerer, node->data.conditional.then_branch);
+            if (else_block != IR_NONE) {
+                if (lowerer->current != IR_NONE) {
+                    ir_lower_emit(lowerer, IR_JUMP, IR_TYPE_VOID, IR_NONE, done, 0, 0, 0);
+                }
+                ir_lower_start_block(lowerer, else_block);
+                ir_lower_statement(lowerer, node->data.conditional.else_branch);
+            }
+            ir_lower_start_block(lowerer, done);
+            break;
+        }
+
+        case NODE_WHILE_STATEMENT: {
+            int head = ir_lower_new_block(lowerer);
+            int body = ir_lower_new_block(lowerer);
+            int done = ir_lower_new_block(lowerer);
+            ir_lower_start_block(lowerer, head);
+            ir_lower_branch(lowerer, node->data.conditional.condition, body, done);
+            ir_lower_start_block(lowerer, body);
+            ir_lower_statement(lowerer, node->data.conditional.then_branch);
+            if (lowerer->current != IR_NONE) {
+                ir_lower_emit(lowerer, IR_JUMP, IR_TYPE_VOID, IR_NONE, head, 0, 0, 0);
+            }
+            ir_lower_start_block(lowerer, done);
+            break;
+        }
+
+        case NODE_FUNCTION_DECLARATION:
+            // Lowered on its own
+            break;
+
+        default:
+            ir_lower_error(lowerer, node, "unsupported statement");
+            break;
+    }
+}
+
+// Functions
+static void ir_lower_begin_function(IrLowerer* lowerer, IrFunction* function) {
+    lowerer->function = function;
+    lowerer->instr_count = 0;
+    lowerer->block_count = 0;
+    lowerer->started_count = 0;
+    lowerer->operand_count = 0;
+    lowerer->constant_count = 0;
+    lowerer->current = IR_NONE;
+    function->register_count = function->variable_count;
+    ir_lower_start_block(lowerer, ir_lower_new_block(lowerer));
+}
+
+// Ends the last block, keeps the blocks reachable from the entry in the
+// order they were filled, and moves the function to the arena
+static void ir_lower_finish_function(IrLowerer* lowerer) {
+    IrFunction* function = lowerer->function;
+    if (lowerer->current != IR_NONE) ir_lower_emit(lowerer, IR_RETURN, IR_TYPE_VOID, IR_NONE, IR_NONE, 0, 0, 0);
+
+    // Reachability, with numbers doubling as the depth-first stack
+    int count = lowerer->block_count;
+    int* number = lowerer->numbers;
+    int* stack = lowerer->stack;
+    for (int i = 0; i < count; i++) number[i] = IR_NONE;
+    int top = 0;
+    stack[top++] = 0;
+    number[0] = 0;
+    while (top > 0) {
+        int block = stack[--top];
+        const IrBlock* b = &lowerer->blocks[block];
+        const IrInstr* last = &lowerer->instrs[b->first + b->count - 1];
+        int targets[2] = { IR_NONE, IR_NONE };
+        if (last->op == IR_JUMP) targets[0] = last->a;
+        if (last->op == IR_BRANCH) {
+            targets[0] = last->b;
+            targets[1] = last->c;
+        }
+        for (int t = 0; t < 2; t++) {
+            if (targets[t] != IR_NONE && number[targets[t]] == IR_NONE) {
+                number[targets[t]] = 0;
+                stack[top++] = targets[t];
+            }
+        }
+    }
+
+    // Renumber in fill order and pack the instructions
+    IrBlock* blocks = lowerer->packed_blocks;
+    IrInstr* instrs = lowerer->packed_instrs;
+    int block_count = 0;
+    for (int i = 0; i < lowerer->started_count; i++) {
+        int block = lowerer->started[i];
+        if (number[block] != IR_NONE) number[block] = block_count++;
+    }
+    int instr_count = 0;
+    for (int i = 0; i < lowerer->started_count; i++) {
+        const IrBlock* old = &lowerer->blocks[lowerer->started[i]];
+        if (number[lowerer->started[i]] == IR_NONE) continue;
+
+        IrBlock* block = &blocks[number[lowerer->started[i]]];
+        block->first = instr_count;
+        block->count = old->count;
+        memcpy(&instrs[instr_count], &lowerer->instrs[old->first], sizeof(IrInstr) * old->count);
+        IrInstr* last = &instrs[instr_count + old->count - 1];
+        if (last->op == IR_JUMP) last->a = number[last->a];
+        if (last->op == IR_BRANCH) {
+            last->b = number[last->b];
+            last->c = number[last->c];
+        }
+        instr_count += old->count;
+    }
+
+    ir_function_replace(lowerer->module, function, blocks, block_count, instrs, instr_count, lowerer->operands,
+                        lowerer->operand_count);
+    function->constant_count = lowerer->constant_count;
+    function->constant_capacity = lowerer->constant_count;
+    function->constants = arena_alloc(lowerer->module->arena, sizeof(int64_t) * MAX(lowerer->constant_count, 1));
+    if (lowerer->constant_count > 0) {
+        memcpy(function->constants, lowerer->constants, sizeof(int64_t) * lowerer->constant_count);
+    }
+}
+
+static void ir_lower_function(IrLowerer* lowerer, IrFunction* function, ASTNode* node) {
+    ir_lower_begin_function(lowerer, function);
+    for (int i = 0; i < node->data.function.parameter_count; i++) {
+        ASTNode* parameter = node->data.function.parameters[i];
+        IrType type;
+        if (!ir_lower_type(parameter->data.declaration.type_name, &type) || type == IR_TYPE_VOID) {
+            ir_lower_error(lowerer, parameter, "unsupported type '%s'", parameter->data.declaration.type_name);
+        }
+    }
+    ir_lower_statement(lowerer, ast_function_body(node));
+    ir_lower_finish_function(lowerer);
+}
+
+IrModule* ir_lower_program(ASTNode* program, SemanticAnalyzer* analyzer) {
+    if (program == NULL || analyzer == NULL || program->type != NODE_PROGRAM) return NULL;
+
+    IrModule* module;
+    SAFE_CALLOC(module, 1, sizeof(IrModule));
+    module->arena = arena_create(256 * 1024);
+
+    IrLowerer lowerer = {0};
+    lowerer.module = module;
+    lowerer.analyzer = analyzer;
+
+    // Functions first, so calls can name any of them
+    int declared = 0;
+    for (int i = 0; i < program->data.block.statement_count; i++) {
+        if (program->data.block.statements[i]->type == NODE_FUNCTION_DECLARATION) declared++;
+    }
+    lowerer.slot_capacity = 16;
+    while (lowerer.slot_capacity < declared * 2) lowerer.slot_capacity *= 2;
+    SAFE_CALLOC(lowerer.slots, lowerer.slot_capacity, sizeof(int));
+    SAFE_MALLOC(lowerer.function_nodes, sizeof(ASTNode*) * MAX(declared, 1));
+    SAFE_MALLOC(lowerer.function_hashes, sizeof(uint32_t) * MAX(declared, 1));
+
+    module->functions = arena_alloc(module->arena, sizeof(IrFunction) * (declared + 1));
+    memset(module->functions, 0, sizeof(IrFunction) * (declared + 1));
+    module->functions[0].name = "_main";
+    module->functions[0].return_type = IR_TYPE_VOID;
+    module->functions[0].variable_count = analyzer->frame_size;
+    int count = 0;
+    for (int i = 0; i < program->data.block.statement_count; i++) {
+        ASTNode* node = program->data.block.statements[i];
+        if (node->type != NODE_FUNCTION_DECLARATION || !ir_lower_add_function(&lowerer, node, count)) continue;
+
+        IrFunction* function = &module->functions[count + 1];
+        function->name = arena_strdup(module->arena, node->data.function.name);
+        function->parameter_count = node->data.function.parameter_count;
+        function->variable_count = MAX(node->resolved_slot, function->parameter_count);
+        if (!ir_lower_type(node->data.function.return_type, &function->return_type)) {
+            ir_lower_error(&lowerer, node, "unsupported return type '%s'", node->data.function.return_type);
+        }
+        count++;
+    }
+    module->function_count = count + 1;
+
+    // Names of globals, for printing and assembly
+    module->global_count = analyzer->global_count;
+    module->global_names = arena_alloc(module->arena, sizeof(char*) * MAX(module->global_count, 1));
+    memset(module->global_names, 0, sizeof(char*) * MAX(module->global_count, 1));
+    for (int i = 0; i < program->data.block.statement_count; i++) {
+        ASTNode* node = program->data.block.statements[i];
+        if (node->type == NODE_VARIABLE_DECLARATION && node->resolved_global && node->resolved_slot >= 0 &&
+            node->resolved_slot < module->global_count) {
+            module->global_names[node->resolved_slot] = arena_strdup(module->arena, node->data.declaration.name);
+        }
+    }
+
+    ir_lower_begin_function(&lowerer, &module->functions[0]);
+    ir_lower_statement(&lowerer, program);
+    ir_lower_finish_function(&lowerer);
+    for (int i = 0; i < count; i++) {
+        ir_lower_function(&lowerer, &module->functions[i + 1], lowerer.function_nodes[i]);
+    }
+
+    free(lowerer.slots);
+    free(lowerer.function_nodes);
+    free(lowerer.function_hashes);
+    free(lowerer.instrs);
+    free(lowerer.blocks);
+    free(lowerer.started);
+    free(lowerer.operands);
+    free(lowerer.constants);
+    free(lowerer.numbers);
+    free(lowerer.stack);
+    free(lowerer.packed_blocks);
+    free(lowerer.packed_instrs);
+    return module;
+}
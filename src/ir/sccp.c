@@ -0,0 +1,493 @@
+#include "sccp.h"
+
+typedef enum {
+    SCCP_UNDEFINED,
+    SCCP_CONSTANT,
+    SCCP_OVERDEFINED
+} SccpState;
+
+typedef struct {
+    const IrFunction* function;
+    uint8_t* state;              // SccpState of each register
+    int64_t* value;              // ... and its value when constant
+    int* instr_block;            // Block of each instruction
+    int* user_first;             // Instructions reading each register: register_count + 1 entries
+    int* users;
+    bool* reachable;             // Blocks
+    bool* executable;            // Edges: successor s of block b is edge 2 * b + s
+    int* edges;                  // Worklists; an edge is added once, a register at most twice
+    int edge_count;
+    int* registers;
+    int register_top;
+    int visits;
+} SccpSolver;
+
+// Folds an operator applied to constants; false when the result is not
+// defined (overflow, division by zero, a shift out of range)
+static bool sccp_fold(IrOpcode op, int64_t a, int64_t b, int64_t* result) {
+    __int128 exact;
+    switch (op) {
+        case IR_ADD: exact = (__int128)a + b; break;
+        case IR_SUB: exact = (__int128)a - b; break;
+        case IR_MUL: exact = (__int128)a * b; break;
+        case IR_DIV:
+        case IR_MOD:
+            if (b == 0 || (a == INT64_MIN && b == -1)) return false;
+            *result = op == IR_DIV ? a / b : a % b;
+            return true;
+        case IR_SHL:
+        case IR_SAR:
+            if (b < 0 || b > 63) return false;
+            *result = op == IR_SHL ? (int64_t)((uint64_t)a << b) : a >> b;
+            return true;
+        case IR_AND: *result = a & b; return true;
+        case IR_OR: *result = a | b; return true;
+        case IR_XOR: *result = a ^ b; return true;
+        case IR_EQ: *result = a == b; return true;
+        case IR_NE: *result = a != b; return true;
+        case IR_LT: *result = a < b; return true;
+        case IR_LE: *result = a <= b; return true;
+        case IR_GT: *result = a > b; return true;
+        case IR_GE: *result = a >= b; return true;
+        case IR_NEG:
+            if (a == INT64_MIN) return false;
+            *result = -a;
+            return true;
+        case IR_NOT: *result = a == 0; return true;
+        case IR_BITNOT: *result = ~a; return true;
+        default: return false;
+    }
+    if (exact < INT64_MIN || exact > INT64_MAX) return false;
+    *result = (int64_t)exact;
+    return true;
+}
+
+static int sccp_edge(const IrFunction* function, int from, int to) {
+    return 2 * from + (function->blocks[from].successors[0] == to ? 0 : 1);
+}
+
+static void sccp_lower(SccpSolver* solver, int reg, SccpState state, int64_t value) {
+    if (state <= solver->state[reg]) return;
+    solver->state[reg] = (uint8_t)state;
+    solver->value[reg] = value;
+    solver->registers[solver->register_top++] = reg;
+}
+
+static void sccp_mark_edge(SccpSolver* solver, int block, int successor) {
+    int edge = 2 * block + successor;
+    if (solver->executable[edge]) return;
+    solver->executable[edge] = true;
+    solver->edges[solver->edge_count++] = edge;
+}
+
+static void sccp_visit(SccpSolver* solver, int index) {
+    const IrFunction* function = solver->function;
+    const IrInstr* instr = &function->instrs[index];
+    int block = solver->instr_block[index];
+    solver->visits++;
+
+    switch ((IrOpcode)instr->op) {
+        case IR_CONST:
+            sccp_lower(solver, instr->dest, SCCP_CONSTANT, function->constants[instr->a]);
+            return;
+        case IR_COPY:
+            sccp_lower(solver, instr->dest, solver->state[instr->a], solver->value[instr->a]);
+            return;
+        case IR_LOAD_GLOBAL:
+        case IR_CALL:
+            sccp_lower(solver, instr->dest, SCCP_OVERDEFINED, 0);
+            return;
+        case IR_STORE_GLOBAL:
+        case IR_RETURN:
+            return;
+        case IR_JUMP:
+            sccp_mark_edge(solver, block, 0);
+            return;
+        case IR_BRANCH: {
+            const IrBlock* b = &function->blocks[block];
+            SccpState state = solver->state[instr->a];
+            if (state == SCCP_UNDEFINED) return;
+            if (state == SCCP_OVERDEFINED || b->successors[1] == IR_NONE) {
+                sccp_mark_edge(solver, block, 0);
+                if (b->successors[1] != IR_NONE) sccp_mark_edge(solver, block, 1);
+                return;
+            }
+            int target = solver->value[instr->a] != 0 ? instr->b : instr->c;
+            sccp_mark_edge(solver, block, b->successors[0] == target ? 0 : 1);
+            return;
+        }
+        case IR_PHI: {
+            // The meet of the inputs over executable edges
+            const IrBlock* b = &function->blocks[block];
+            SccpState state = SCCP_UNDEFINED;
+            int64_t value = 0;
+            for (int p = 0; p < instr->c && state != SCCP_OVERDEFINED; p++) {
+                int predecessor = function->predecessors[b->first_predecessor + p];
+                if (!solver->executable[sccp_edge(function, predecessor, block)]) continue;
+                int reg = function->operands[instr->b + p];
+                SccpState input = solver->state[reg];
+                if (input == SCCP_UNDEFINED) continue;
+                if (state == SCCP_UNDEFINED) {
+                    state = input;
+                    value = solver->value[reg];
+                } else if (input == SCCP_OVERDEFINED || solver->value[reg] != value) {
+                    state = SCCP_OVERDEFINED;
+                }
+            }
+            sccp_lower(solver, instr->dest, state, value);
+            return;
+        }
+        default:
+            break;
+    }
+
+    // Operators: overdefined if an operand is, undefined until all are known
+    bool unary = instr->op == IR_NEG || instr->op == IR_NOT || instr->op == IR_BITNOT;
+    SccpState a = solver->state[instr->a];
+    SccpState b = unary ? SCCP_CONSTANT : solver->state[instr->b];
+    if (a == SCCP_OVERDEFINED || b == SCCP_OVERDEFINED) {
+        sccp_lower(solver, instr->dest, SCCP_OVERDEFINED, 0);
+        return;
+    }
+    if (a == SCCP_UNDEFINED || b == SCCP_UNDEFINED) return;
+    int64_t result;
+    if (sccp_fold((IrOpcode)instr->op, solver->value[instr->a], unary ? 0 : solver->value[instr->b], &result)) {
+        sccp_lower(solver, instr->dest, SCCP_CONSTANT, result);
+    } else {
+        sccp_lower(solver, instr->dest, SCCP_OVERDEFINED, 0);
+    }
+}
+
+static void sccp_solve(SccpSolver* solver) {
+    const IrFunction* function = solver->function;
+    int registers = function->register_count;
+    int instr_count = function->instr_count;
+    int block_count = function->block_count;
+    SAFE_CALLOC(solver->state, MAX(registers, 1), sizeof(uint8_t));
+    SAFE_CALLOC(solver->value, MAX(registers, 1), sizeof(int64_t));
+    SAFE_MALLOC(solver->instr_block, sizeof(int) * MAX(instr_count, 1));
+    SAFE_CALLOC(solver->user_first, registers + 1, sizeof(int));
+    SAFE_CALLOC(solver->reachable, block_count, sizeof(bool));
+    SAFE_CALLOC(solver->executable, 2 * block_count, sizeof(bool));
+    SAFE_MALLOC(solver->edges, sizeof(int) * 2 * block_count);
+    SAFE_MALLOC(solver->registers, sizeof(int) * MAX(2 * registers, 1));
+    for (int i = 0; i < function->parameter_count; i++) solver->state[i] = SCCP_OVERDEFINED;
+
+    // Users of each register, counted, then filled
+    int uses[8];
+    int total = 0;
+    for (int block = 0; block < block_count; block++) {
+        const IrBlock* b = &function->blocks[block];
+        for (int i = 0; i < b->count; i++) {
+            const IrInstr* instr = &function->instrs[b->first + i];
+            solver->instr_block[b->first + i] = block;
+            int count = ir_instr_uses(function, instr, uses, 8);
+            for (int u = 0; u < count; u++) {
+                int reg = u < 8 ? uses[u] : function->operands[instr->b + u];
+                solver->user_first[reg + 1]++;
+            }
+            total += count;
+        }
+    }
+    for (int i = 0; i < registers; i++) solver->user_first[i + 1] += solver->user_first[i];
+    SAFE_MALLOC(solver->users, sizeof(int) * MAX(total, 1));
+    int* fill;
+    SAFE_MALLOC(fill, sizeof(int) * MAX(registers, 1));
+    for (int i = 0; i < registers; i++) fill[i] = solver->user_first[i];
+    for (int block = 0; block < block_count; block++) {
+        const IrBlock* b = &function->blocks[block];
+        for (int i = 0; i < b->count; i++) {
+            const IrInstr* instr = &function->instrs[b->first + i];
+            int count = ir_instr_uses(function, instr, uses, 8);
+            for (int u = 0; u < count; u++) {
+                int reg = u < 8 ? uses[u] : function->operands[instr->b + u];
+                solver->users[fill[reg]++] = b->first + i;
+            }
+        }
+    }
+    free(fill);
+
+    // Edges first, so blocks are found reachable before the values flowing
+    // into them are propagated
+    solver->reachable[0] = true;
+    for (int i = 0; i < function->blocks[0].count; i++) sccp_visit(solver, function->blocks[0].first + i);
+    while (solver->edge_count > 0 || solver->register_top > 0) {
+        if (solver->edge_count > 0) {
+            int edge = solver->edges[--solver->edge_count];
+            int target = function->blocks[edge / 2].successors[edge % 2];
+            const IrBlock* t = &function->blocks[target];
+            if (!solver->reachable[target]) {
+                solver->reachable[target] = true;
+                for (int i = 0; i < t->count; i++) sccp_visit(solver, t->first + i);
+            } else {
+                // Only the phis see the new edge
+                for (int i = 0; i < t->count && function->instrs[t->first + i].op == IR_PHI; i++) {
+                    sccp_visit(solver, t->first + i);
+                }
+            }
+            continue;
+        }
+
+        int reg = solver->registers[--solver->register_top];
+        for (int u = solver->user_first[reg]; u < solver->user_first[reg + 1]; u++) {
+            int user = solver->users[u];
+            if (solver->reachable[solver->instr_block[user]]) sccp_visit(solver, user);
+        }
+    }
+}
+
+static void sccp_solver_free(SccpSolver* solver) {
+    free(solver->state);
+    free(solver->value);
+    free(solver->instr_block);
+    free(solver->user_first);
+    free(solver->users);
+    free(solver->reachable);
+    free(solver->executable);
+    free(solver->edges);
+    free(solver->registers);
+}
+
+static int sccp_resolve(const int* alias, int reg) {
+    while (alias[reg] != reg) reg = alias[reg];
+    return reg;
+}
+
+// Whether an instruction can go once its result is unread: not if it has
+// an effect, or can trap at run time (a division, or arithmetic that checked
+// mode tests for overflow)
+static bool sccp_removable(const IrInstr* instr) {
+    switch ((IrOpcode)instr->op) {
+        case IR_ADD:
+        case IR_SUB:
+        case IR_MUL:
+            return (instr->flags & (IR_FLAG_NO_OVERFLOW | IR_FLAG_NARROW)) != 0;
+        case IR_DIV:
+        case IR_MOD:
+        case IR_NEG:
+        case IR_STORE_GLOBAL:
+        case IR_CALL:
+        case IR_JUMP:
+        case IR_BRANCH:
+        case IR_RETURN:
+            return false;
+        default:
+            return instr->dest != IR_NONE;
+    }
+}
+
+void ir_function_sccp(IrModule* module, IrFunction* function, IrSccpStats* stats) {
+    if (!function->ssa || function->block_count == 0) return;
+
+    SccpSolver solver = {0};
+    solver.function = function;
+    sccp_solve(&solver);
+
+    int block_count = function->block_count;
+    int registers = function->register_count;
+    int* renumber;
+    int* alias;
+    SAFE_MALLOC(renumber, sizeof(int) * block_count);
+    SAFE_MALLOC(alias, sizeof(int) * MAX(registers, 1));
+    int kept = 0;
+    for (int block = 0; block < block_count; block++) renumber[block] = solver.reachable[block] ? kept++ : IR_NONE;
+    for (int i = 0; i < registers; i++) alias[i] = i;
+
+    // A phi that is not constant but has one distinct input over the
+    // executable edges, not counting itself, is replaced by that input
+    int phis_simplified = 0;
+    for (int block = 0; block < block_count; block++) {
+        const IrBlock* b = &function->blocks[block];
+        if (!solver.reachable[block]) continue;
+        for (int i = 0; i < b->count && function->instrs[b->first + i].op == IR_PHI; i++) {
+            const IrInstr* phi = &function->instrs[b->first + i];
+            if (solver.state[phi->dest] == SCCP_CONSTANT) continue;
+            int single = IR_NONE;
+            bool distinct = false;
+            for (int p = 0; p < phi->c && !distinct; p++) {
+                int predecessor = function->predecessors[b->first_predecessor + p];
+                if (!solver.executable[sccp_edge(function, predecessor, block)]) continue;
+                int reg = sccp_resolve(alias, function->operands[phi->b + p]);
+                if (reg == phi->dest) continue;
+                distinct = single != IR_NONE && reg != single;
+                single = reg;
+            }
+            if (!distinct && single != IR_NONE) {
+                alias[phi->dest] = single;
+                phis_simplified++;
+            }
+        }
+    }
+
+    // The new body: each reachable block's remaining phis, the phis found
+    // constant, then its other instructions, with constants for the values
+    // found constant and jumps for the branches that go one way. Inputs of
+    // the remaining phis follow the old operands, with the block each comes
+    // from, as the predecessors are numbered anew.
+    int base = function->operand_count;
+    IrBlock* blocks;
+    IrInstr* instrs;
+    int* operands;
+    int* input_blocks;
+    SAFE_MALLOC(blocks, sizeof(IrBlock) * MAX(kept, 1));
+    SAFE_MALLOC(instrs, sizeof(IrInstr) * MAX(function->instr_count, 1));
+    SAFE_MALLOC(operands, sizeof(int) * MAX(2 * base, 1));
+    SAFE_MALLOC(input_blocks, sizeof(int) * MAX(base, 1));
+    if (base > 0) memcpy(operands, function->operands, sizeof(int) * base);
+    int instr_count = 0;
+    int operand_count = base;
+    int constants = 0;
+    int branches_folded = 0;
+    int* slots[8];
+    for (int block = 0; block < block_count; block++) {
+        const IrBlock* b = &function->blocks[block];
+        if (!solver.reachable[block]) continue;
+        IrBlock* out = &blocks[renumber[block]];
+        out->first = instr_count;
+
+        int phis = 0;
+        while (phis < b->count && function->instrs[b->first + phis].op == IR_PHI) phis++;
+        for (int i = 0; i < phis; i++) {
+            IrInstr phi = function->instrs[b->first + i];
+            if (solver.state[phi.dest] == SCCP_CONSTANT || alias[phi.dest] != phi.dest) continue;
+            int first = operand_count;
+            for (int p = 0; p < phi.c; p++) {
+                int predecessor = function->predecessors[b->first_predecessor + p];
+                if (!solver.executable[sccp_edge(function, predecessor, block)]) continue;
+                operands[operand_count] = sccp_resolve(alias, function->operands[phi.b + p]);
+                input_blocks[operand_count++ - base] = renumber[predecessor];
+            }
+            phi.b = first;
+            phi.c = operand_count - first;
+            instrs[instr_count++] = phi;
+        }
+        for (int i = 0; i < phis; i++) {
+            const IrInstr* phi = &function->instrs[b->first + i];
+            if (solver.state[phi->dest] != SCCP_CONSTANT) continue;
+            int constant = ir_function_add_constant(module, function, solver.value[phi->dest]);
+            instrs[instr_count++] = (IrInstr){ IR_CONST, phi->type, 0, 0, phi->dest, constant, 0, 0 };
+            constants++;
+        }
+
+        for (int i = phis; i < b->count; i++) {
+            IrInstr instr = function->instrs[b->first + i];
+            if (instr.dest != IR_NONE && instr.op != IR_CONST && solver.state[instr.dest] == SCCP_CONSTANT) {
+                int constant = ir_function_add_constant(module, function, solver.value[instr.dest]);
+                instrs[instr_count++] = (IrInstr){ IR_CONST, instr.type, 0, 0, instr.dest, constant, 0, 0 };
+                constants++;
+                continue;
+            }
+
+            int count = ir_instr_use_slots(&instr, operands, slots, 8);
+            for (int u = 0; u < count; u++) {
+                int* slot = u < 8 ? slots[u] : &operands[instr.b + u];
+                *slot = sccp_resolve(alias, *slot);
+            }
+            if (instr.op == IR_JUMP) {
+                instr.a = renumber[instr.a];
+            } else if (instr.op == IR_BRANCH) {
+                bool first = solver.executable[2 * block];
+                bool second = b->successors[1] != IR_NONE && solver.executable[2 * block + 1];
+                if (first && second) {
+                    instr.b = renumber[instr.b];
+                    instr.c = renumber[instr.c];
+                } else {
+                    int target = b->successors[first ? 0 : 1];
+                    instr = (IrInstr){ IR_JUMP, IR_TYPE_VOID, 0, 0, IR_NONE, renumber[target], 0, 0 };
+                    if (b->successors[1] != IR_NONE) branches_folded++;
+                }
+            }
+            instrs[instr_count++] = instr;
+        }
+        out->count = instr_count - out->first;
+    }
+
+    // Instructions left unread go, and with them the last reads of their
+    // operands. A register's definition is found through defined_at.
+    int* use_count;
+    int* defined_at;
+    int* worklist;
+    bool* removed;
+    SAFE_CALLOC(use_count, MAX(registers, 1), sizeof(int));
+    SAFE_MALLOC(defined_at, sizeof(int) * MAX(registers, 1));
+    SAFE_MALLOC(worklist, sizeof(int) * MAX(instr_count, 1));
+    SAFE_CALLOC(removed, MAX(instr_count, 1), sizeof(bool));
+    for (int i = 0; i < registers; i++) defined_at[i] = IR_NONE;
+    for (int i = 0; i < instr_count; i++) {
+        int count = ir_instr_use_slots(&instrs[i], operands, slots, 8);
+        for (int u = 0; u < count; u++) use_count[u < 8 ? *slots[u] : operands[instrs[i].b + u]]++;
+        if (instrs[i].dest != IR_NONE) defined_at[instrs[i].dest] = i;
+    }
+    int top = 0;
+    for (int i = 0; i < instr_count; i++) {
+        if (sccp_removable(&instrs[i]) && use_count[instrs[i].dest] == 0) worklist[top++] = i;
+    }
+    int dead_removed = 0;
+    while (top > 0) {
+        int index = worklist[--top];
+        removed[index] = true;
+        dead_removed++;
+        int count = ir_instr_use_slots(&instrs[index], operands, slots, 8);
+        for (int u = 0; u < count; u++) {
+            int reg = u < 8 ? *slots[u] : operands[instrs[index].b + u];
+            if (--use_count[reg] > 0 || defined_at[reg] == IR_NONE) continue;
+            int definition = defined_at[reg];
+            if (!removed[definition] && sccp_removable(&instrs[definition])) worklist[top++] = definition;
+        }
+    }
+
+    // Closing the gaps; removed phis leave their inputs unused in operands
+    int position = 0;
+    for (int block = 0; block < kept; block++) {
+        int first = blocks[block].first;
+        int end = first + blocks[block].count;
+        blocks[block].first = position;
+        for (int i = first; i < end; i++) {
+            if (!removed[i]) instrs[position++] = instrs[i];
+        }
+        blocks[block].count = position - blocks[block].first;
+    }
+
+    if (stats != NULL) {
+        stats->functions++;
+        stats->visits += solver.visits;
+        stats->constants += constants;
+        stats->phis_simplified += phis_simplified;
+        stats->branches_folded += branches_folded;
+        stats->blocks_removed += block_count - kept;
+        stats->dead_removed += dead_removed;
+    }
+
+    ir_function_replace(module, function, blocks, kept, instrs, position, operands, operand_count);
+
+    // Linking numbered the predecessors anew; the phi inputs are put in
+    // their order
+    for (int block = 0; block < kept; block++) {
+        const IrBlock* b = &function->blocks[block];
+        for (int i = 0; i < b->count && function->instrs[b->first + i].op == IR_PHI; i++) {
+            const IrInstr* phi = &function->instrs[b->first + i];
+            for (int p = 0; p < phi->c; p++) {
+                int predecessor = function->predecessors[b->first_predecessor + p];
+                int input = 0;
+                while (input_blocks[phi->b + input - base] != predecessor) input++;
+                function->operands[phi->b + p] = operands[phi->b + input];
+            }
+        }
+    }
+
+    free(renumber);
+    free(alias);
+    free(blocks);
+    free(instrs);
+    free(operands);
+    free(input_blocks);
+    free(use_count);
+    free(defined_at);
+    free(worklist);
+    free(removed);
+    sccp_solver_free(&solver);
+}
+
+void ir_module_sccp(IrModule* module, IrSccpStats* stats) {
+    for (int i = 0; i < module->function_count; i++) ir_function_sccp(module, &module->functions[i], stats);
+}
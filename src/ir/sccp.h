@@ -0,0 +1,44 @@
+#ifndef SCCP_H
+#define SCCP_H
+
+#include "ir.h"
+
+// Sparse conditional constant propagation (Wegman and Zadeck) over SSA form.
+// Each register's value is a point of a three-level lattice: undefined (not
+// yet seen), a constant, or overdefined. The pass is optimistic: it starts
+// with every register undefined and only the entry reachable, evaluates the
+// instructions of a block once the block is found reachable, and follows
+// just one side of a branch whose condition is a constant. A phi meets only
+// the inputs coming over edges found executable, so a value that is the same
+// on every path taken stays a constant, around loops too. Two worklists
+// drive it, one of flow graph edges found executable and one of registers
+// whose value went down the lattice; a value goes down at most twice, so
+// every instruction is evaluated a bounded number of times.
+//
+// The function is then rewritten: registers found constant are defined by a
+// constant, branches with one executable edge become jumps, blocks never
+// reached are removed, and phis lose the inputs of the edges removed (one
+// left with a single distinct input is replaced by it). Last, instructions
+// whose result is no longer read are removed, unless they can trap at run
+// time: divisions, and checked arithmetic the range analysis has not
+// cleared. Loads of globals and calls are overdefined, and so is arithmetic
+// that overflows or divides by zero, which is left to fail at run time.
+
+typedef struct {
+    int functions;
+    int visits;              // Instructions evaluated, counting reevaluations
+    int constants;           // Instructions and phis replaced by a constant
+    int phis_simplified;     // Phis replaced by their one input
+    int branches_folded;     // Branches turned into jumps
+    int blocks_removed;      // Blocks found unreachable
+    int dead_removed;        // Instructions left unread, removed
+} IrSccpStats;
+
+// Runs on a function in SSA form; other functions are left alone. stats,
+// if given, is added to.
+void ir_function_sccp(IrModule* module, IrFunction* function, IrSccpStats* stats);
+
+// Every function of the module
+void ir_module_sccp(IrModule* module, IrSccpStats* stats);
+
+#endif // SCCP_H
@@ -0,0 +1,821 @@
+#include "ssa.h"
+
+// Dominators
+static int ir_dominators_intersect(const IrDominators* dominators, int a, int b) {
+    while (a != b) {
+        while (dominators->postorder[a] < dominators->postorder[b]) a = dominators->idom[a];
+        while (dominators->postorder[b] < dominators->postorder[a]) b = dominators->idom[b];
+    }
+    return a;
+}
+
+void ir_dominators_compute(const IrFunction* function, IrDominators* dominators) {
+    int count = function->block_count;
+    dominators->block_count = count;
+    SAFE_MALLOC(dominators->idom, sizeof(int) * count);
+    SAFE_MALLOC(dominators->postorder, sizeof(int) * count);
+    SAFE_MALLOC(dominators->preorder, sizeof(int) * count);
+    SAFE_MALLOC(dominators->size, sizeof(int) * count);
+    SAFE_MALLOC(dominators->first_child, sizeof(int) * count);
+    SAFE_MALLOC(dominators->next_sibling, sizeof(int) * count);
+    for (int i = 0; i < count; i++) {
+        dominators->idom[i] = IR_NONE;
+        dominators->postorder[i] = IR_NONE;
+        dominators->preorder[i] = IR_NONE;
+        dominators->size[i] = 0;
+        dominators->first_child[i] = IR_NONE;
+        dominators->next_sibling[i] = IR_NONE;
+    }
+    dominators->iterations = 0;
+    if (count == 0) return;
+
+    // Postorder of the flow graph, with an explicit stack of blocks and the
+    // successor to visit next; order lists the blocks in postorder
+    int* order;
+    int* stack;
+    int* edge;
+    SAFE_MALLOC(order, sizeof(int) * count);
+    SAFE_MALLOC(stack, sizeof(int) * count);
+    SAFE_MALLOC(edge, sizeof(int) * count);
+    int reachable = 0;
+    int top = 0;
+    stack[top] = 0;
+    edge[top++] = 0;
+    dominators->postorder[0] = count;       // Visited, not yet numbered
+    while (top > 0) {
+        int block = stack[top - 1];
+        if (edge[top - 1] < 2) {
+            int successor = function->blocks[block].successors[edge[top - 1]++];
+            if (successor != IR_NONE && dominators->postorder[successor] == IR_NONE) {
+                dominators->postorder[successor] = count;
+                stack[top] = successor;
+                edge[top++] = 0;
+            }
+            continue;
+        }
+        dominators->postorder[block] = reachable;
+        order[reachable++] = block;
+        top--;
+    }
+
+    // Idoms, intersecting the processed predecessors in reverse postorder
+    // until nothing changes
+    dominators->idom[0] = 0;
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        dominators->iterations++;
+        for (int i = reachable - 2; i >= 0; i--) {
+            int block = order[i];
+            const IrBlock* b = &function->blocks[block];
+            int idom = IR_NONE;
+            for (int p = 0; p < b->predecessor_count; p++) {
+                int predecessor = function->predecessors[b->first_predecessor + p];
+                if (dominators->idom[predecessor] == IR_NONE) continue;
+                idom = idom == IR_NONE ? predecessor : ir_dominators_intersect(dominators, predecessor, idom);
+            }
+            if (idom != dominators->idom[block]) {
+                dominators->idom[block] = idom;
+                changed = true;
+            }
+        }
+    }
+
+    // The tree: children in reverse postorder, then a preorder walk, and
+    // subtree sizes summed children first
+    for (int i = 0; i < reachable - 1; i++) {
+        int block = order[i];
+        int parent = dominators->idom[block];
+        dominators->next_sibling[block] = dominators->first_child[parent];
+        dominators->first_child[parent] = block;
+    }
+    int number = 0;
+    top = 0;
+    stack[top++] = 0;
+    while (top > 0) {
+        int block = stack[--top];
+        order[number] = block;
+        dominators->preorder[block] = number++;
+        for (int child = dominators->first_child[block]; child != IR_NONE; child = dominators->next_sibling[child]) {
+            stack[top++] = child;
+        }
+    }
+    for (int i = number - 1; i >= 0; i--) {
+        int block = order[i];
+        dominators->size[block]++;
+        if (block != 0) dominators->size[dominators->idom[block]] += dominators->size[block];
+    }
+
+    free(order);
+    free(stack);
+    free(edge);
+}
+
+void ir_dominators_free(IrDominators* dominators) {
+    if (dominators == NULL) return;
+    free(dominators->idom);
+    free(dominators->postorder);
+    free(dominators->preorder);
+    free(dominators->size);
+    free(dominators->first_child);
+    free(dominators->next_sibling);
+    memset(dominators, 0, sizeof(*dominators));
+}
+
+// Into SSA form
+typedef struct {
+    IrModule* module;
+    IrFunction* function;
+    IrDominators dominators;
+    int block_count;
+    int register_count;          // Before renaming
+
+    // Dominance frontiers, grouped by block
+    int* frontier_first;         // block_count + 1 entries
+    int* frontiers;
+
+    // Blocks defining each register, grouped by register
+    int* definition_first;       // register_count + 1 entries
+    int* definitions;
+    bool* nonlocal;              // Read in a block before any definition there
+    uint8_t* types;
+
+    // Phis placed: their block and register, grouped by block
+    int phi_count;
+    int* phi_first;              // block_count + 1 entries
+    int* phi_registers;
+
+    // Renaming: each register's current name, and the names replaced, to
+    // restore when the walk leaves the block that defined them
+    int* current;
+    bool* named;                 // The register's own number is taken as a name
+    int* log_registers;
+    int* log_names;
+    int log_count;
+    int next_register;
+    int undefined;               // Register holding 0 for reads before assignment
+    int copies_folded;
+} SsaBuilder;
+
+static void ssa_compute_frontiers(SsaBuilder* builder) {
+    const IrFunction* function = builder->function;
+    const int* idom = builder->dominators.idom;
+    int count = builder->block_count;
+    int* mark;
+    SAFE_MALLOC(mark, sizeof(int) * count);
+    SAFE_CALLOC(builder->frontier_first, count + 1, sizeof(int));
+
+    // A join block is in the frontier of each block from its predecessors up
+    // to, not including, its idom. Counted, then filled.
+    for (int pass = 0; pass < 2; pass++) {
+        for (int i = 0; i < count; i++) mark[i] = IR_NONE;
+        for (int block = 0; block < count; block++) {
+            const IrBlock* b = &function->blocks[block];
+            if (b->predecessor_count < 2 || idom[block] == IR_NONE) continue;
+            for (int p = 0; p < b->predecessor_count; p++) {
+                int runner = function->predecessors[b->first_predecessor + p];
+                while (idom[runner] != IR_NONE && runner != idom[block] && mark[runner] != block) {
+                    mark[runner] = block;
+                    if (pass == 0) {
+                        builder->frontier_first[runner + 1]++;
+                    } else {
+                        builder->frontiers[builder->frontier_first[runner]++] = block;
+                    }
+                    runner = idom[runner];
+                }
+            }
+        }
+
+        if (pass == 0) {
+            for (int i = 0; i < count; i++) builder->frontier_first[i + 1] += builder->frontier_first[i];
+            SAFE_MALLOC(builder->frontiers, sizeof(int) * MAX(builder->frontier_first[count], 1));
+        } else {
+            // Filling advanced each start to the next block's
+            for (int i = count; i > 0; i--) builder->frontier_first[i] = builder->frontier_first[i - 1];
+            builder->frontier_first[0] = 0;
+        }
+    }
+
+    free(mark);
+}
+
+// Finds the blocks defining each register and the registers that are not
+// local to a block
+static void ssa_collect_definitions(SsaBuilder* builder) {
+    const IrFunction* function = builder->function;
+    int registers = builder->register_count;
+    int* defined_in;
+    SAFE_MALLOC(defined_in, sizeof(int) * registers);
+    SAFE_CALLOC(builder->nonlocal, registers, sizeof(bool));
+    SAFE_CALLOC(builder->types, registers, sizeof(uint8_t));
+    SAFE_CALLOC(builder->definition_first, registers + 1, sizeof(int));
+
+    // Pairs of register and block, one for each block defining a register;
+    // parameters are defined at the entry
+    int* pair_registers;
+    int* pair_blocks;
+    int capacity = function->instr_count + function->parameter_count;
+    SAFE_MALLOC(pair_registers, sizeof(int) * MAX(capacity, 1));
+    SAFE_MALLOC(pair_blocks, sizeof(int) * MAX(capacity, 1));
+    int pairs = 0;
+    for (int i = 0; i < registers; i++) defined_in[i] = IR_NONE;
+    for (int i = 0; i < function->parameter_count; i++) {
+        builder->types[i] = IR_TYPE_INT;
+        pair_registers[pairs] = i;
+        pair_blocks[pairs++] = 0;
+    }
+
+    int uses[8];
+    for (int block = 0; block < builder->block_count; block++) {
+        const IrBlock* b = &function->blocks[block];
+        for (int i = 0; i < b->count; i++) {
+            const IrInstr* instr = &function->instrs[b->first + i];
+            int count = ir_instr_uses(function, instr, uses, 8);
+            for (int u = 0; u < count; u++) {
+                int reg = u < 8 ? uses[u] : function->operands[instr->b + u];
+                if (defined_in[reg] != block) builder->nonlocal[reg] = true;
+            }
+            int dest = instr->dest;
+            if (dest == IR_NONE) continue;
+            builder->types[dest] = instr->type;
+            if (defined_in[dest] == block) continue;
+            // A parameter's entry definition is already listed
+            defined_in[dest] = block;
+            if (block == 0 && dest < function->parameter_count) continue;
+            pair_registers[pairs] = dest;
+            pair_blocks[pairs++] = block;
+        }
+    }
+
+    for (int i = 0; i < pairs; i++) builder->definition_first[pair_registers[i] + 1]++;
+    for (int i = 0; i < registers; i++) builder->definition_first[i + 1] += builder->definition_first[i];
+    SAFE_MALLOC(builder->definitions, sizeof(int) * MAX(pairs, 1));
+    int* fill = defined_in;
+    for (int i = 0; i < registers; i++) fill[i] = builder->definition_first[i];
+    for (int i = 0; i < pairs; i++) builder->definitions[fill[pair_registers[i]]++] = pair_blocks[i];
+
+    free(defined_in);
+    free(pair_registers);
+    free(pair_blocks);
+}
+
+// Phis go at the iterated dominance frontier of a register's definitions
+static void ssa_place_phis(SsaBuilder* builder) {
+    int count = builder->block_count;
+    int* has_phi;
+    int* queued;
+    int* worklist;
+    int* phi_blocks;
+    int capacity = 256;
+    SAFE_MALLOC(has_phi, sizeof(int) * count);
+    SAFE_MALLOC(queued, sizeof(int) * count);
+    SAFE_MALLOC(worklist, sizeof(int) * count);
+    SAFE_MALLOC(phi_blocks, sizeof(int) * capacity);
+    SAFE_MALLOC(builder->phi_registers, sizeof(int) * capacity);
+    for (int i = 0; i < count; i++) {
+        has_phi[i] = IR_NONE;
+        queued[i] = IR_NONE;
+    }
+
+    builder->phi_count = 0;
+    for (int reg = 0; reg < builder->register_count; reg++) {
+        if (!builder->nonlocal[reg]) continue;
+
+        int top = 0;
+        for (int d = builder->definition_first[reg]; d < builder->definition_first[reg + 1]; d++) {
+            int block = builder->definitions[d];
+            queued[block] = reg;
+            worklist[top++] = block;
+        }
+        while (top > 0) {
+            int block = worklist[--top];
+            for (int f = builder->frontier_first[block]; f < builder->frontier_first[block + 1]; f++) {
+                int join = builder->frontiers[f];
+                if (has_phi[join] == reg) continue;
+
+                has_phi[join] = reg;
+                if (builder->phi_count == capacity) {
+                    capacity *= 2;
+                    SAFE_REALLOC(phi_blocks, sizeof(int) * capacity);
+                    SAFE_REALLOC(builder->phi_registers, sizeof(int) * capacity);
+                }
+                phi_blocks[builder->phi_count] = join;
+                builder->phi_registers[builder->phi_count++] = reg;
+                if (queued[join] != reg) {
+                    queued[join] = reg;
+                    worklist[top++] = join;
+                }
+            }
+        }
+    }
+
+    // Group by block, keeping the order of registers within one
+    SAFE_CALLOC(builder->phi_first, count + 1, sizeof(int));
+    for (int i = 0; i < builder->phi_count; i++) builder->phi_first[phi_blocks[i] + 1]++;
+    for (int i = 0; i < count; i++) builder->phi_first[i + 1] += builder->phi_first[i];
+    int* grouped;
+    SAFE_MALLOC(grouped, sizeof(int) * MAX(builder->phi_count, 1));
+    for (int i = 0; i < count; i++) queued[i] = builder->phi_first[i];
+    for (int i = 0; i < builder->phi_count; i++) grouped[queued[phi_blocks[i]]++] = builder->phi_registers[i];
+    free(builder->phi_registers);
+    builder->phi_registers = grouped;
+
+    free(has_phi);
+    free(queued);
+    free(worklist);
+    free(phi_blocks);
+}
+
+// A new name for a definition of reg; the first keeps the register's number
+static int ssa_define(SsaBuilder* builder, int reg, int name) {
+    if (name == IR_NONE) {
+        if (!builder->named[reg]) {
+            builder->named[reg] = true;
+            name = reg;
+        } else {
+            name = builder->next_register++;
+        }
+    }
+    builder->log_registers[builder->log_count] = reg;
+    builder->log_names[builder->log_count++] = builder->current[reg];
+    builder->current[reg] = name;
+    return name;
+}
+
+static int ssa_lookup(SsaBuilder* builder, int reg) {
+    if (builder->current[reg] != IR_NONE) return builder->current[reg];
+    if (builder->undefined == IR_NONE) builder->undefined = builder->next_register++;
+    return builder->undefined;
+}
+
+void ir_function_to_ssa(IrModule* module, IrFunction* function, IrSsaStats* stats) {
+    if (function->ssa || function->block_count == 0) return;
+
+    SsaBuilder builder = {0};
+    builder.module = module;
+    builder.function = function;
+    builder.block_count = function->block_count;
+    builder.register_count = function->register_count;
+    ir_dominators_compute(function, &builder.dominators);
+    ssa_compute_frontiers(&builder);
+    ssa_collect_definitions(&builder);
+    ssa_place_phis(&builder);
+
+    // Layout of the new body: each block's phis, then its instructions but
+    // copies. Entry slot 0 is kept for the constant 0 that undefined reads
+    // get, and dropped if none needs it. Phi inputs follow the old operands.
+    int block_count = function->block_count;
+    IrBlock* blocks;
+    SAFE_MALLOC(blocks, sizeof(IrBlock) * block_count);
+    int instr_count = 1;
+    int operand_count = function->operand_count;
+    for (int block = 0; block < block_count; block++) {
+        const IrBlock* b = &function->blocks[block];
+        int copies = 0;
+        for (int i = 0; i < b->count; i++) {
+            if (function->instrs[b->first + i].op == IR_COPY) copies++;
+        }
+        int phis = builder.phi_first[block + 1] - builder.phi_first[block];
+        blocks[block].first = instr_count;
+        blocks[block].count = phis + b->count - copies;
+        instr_count += blocks[block].count;
+        operand_count += phis * b->predecessor_count;
+    }
+
+    IrInstr* instrs;
+    int* operands;
+    SAFE_MALLOC(instrs, sizeof(IrInstr) * instr_count);
+    SAFE_MALLOC(operands, sizeof(int) * MAX(operand_count, 1));
+    if (function->operand_count > 0) memcpy(operands, function->operands, sizeof(int) * function->operand_count);
+    operand_count = function->operand_count;
+    for (int block = 0; block < block_count; block++) {
+        int predecessors = function->blocks[block].predecessor_count;
+        for (int p = builder.phi_first[block]; p < builder.phi_first[block + 1]; p++) {
+            IrInstr* phi = &instrs[blocks[block].first + p - builder.phi_first[block]];
+            int reg = builder.phi_registers[p];
+            phi->op = IR_PHI;
+            phi->type = builder.types[reg];
+            phi->flags = 0;
+            phi->unused = 0;
+            phi->dest = IR_NONE;
+            phi->a = 0;
+            phi->b = operand_count;
+            phi->c = predecessors;
+            operand_count += predecessors;
+        }
+    }
+
+    // Renaming, walking the dominator tree in preorder. A stack holds the
+    // blocks being walked with the end of their subtree and of their log.
+    int registers = builder.register_count;
+    int log_capacity = function->instr_count + builder.phi_count + function->parameter_count + 1;
+    SAFE_MALLOC(builder.current, sizeof(int) * registers);
+    SAFE_CALLOC(builder.named, registers, sizeof(bool));
+    SAFE_MALLOC(builder.log_registers, sizeof(int) * log_capacity);
+    SAFE_MALLOC(builder.log_names, sizeof(int) * log_capacity);
+    for (int i = 0; i < registers; i++) builder.current[i] = IR_NONE;
+    builder.next_register = registers;
+    builder.undefined = IR_NONE;
+    for (int i = 0; i < function->parameter_count; i++) ssa_define(&builder, i, IR_NONE);
+
+    int* by_preorder;
+    int* walk_ends;
+    int* walk_logs;
+    SAFE_MALLOC(by_preorder, sizeof(int) * block_count);
+    SAFE_MALLOC(walk_ends, sizeof(int) * block_count);
+    SAFE_MALLOC(walk_logs, sizeof(int) * block_count);
+    int reachable = 0;
+    for (int block = 0; block < block_count; block++) {
+        if (builder.dominators.preorder[block] == IR_NONE) continue;
+        by_preorder[builder.dominators.preorder[block]] = block;
+        reachable++;
+    }
+
+    int depth = 0;
+    int* slots[8];
+    for (int position = 0; position < reachable; position++) {
+        int block = by_preorder[position];
+        while (depth > 0 && walk_ends[depth - 1] <= position) {
+            depth--;
+            while (builder.log_count > walk_logs[depth]) {
+                builder.log_count--;
+                builder.current[builder.log_registers[builder.log_count]] = builder.log_names[builder.log_count];
+            }
+        }
+        walk_ends[depth] = position + builder.dominators.size[block];
+        walk_logs[depth++] = builder.log_count;
+
+        // Phis define their register first
+        const IrBlock* b = &function->blocks[block];
+        int out = blocks[block].first;
+        for (int p = builder.phi_first[block]; p < builder.phi_first[block + 1]; p++) {
+            instrs[out].dest = ssa_define(&builder, builder.phi_registers[p], IR_NONE);
+            out++;
+        }
+
+        for (int i = 0; i < b->count; i++) {
+            IrInstr instr = function->instrs[b->first + i];
+            if (instr.op == IR_COPY) {
+                // The destination becomes another name for the source
+                ssa_define(&builder, instr.dest, ssa_lookup(&builder, instr.a));
+                builder.copies_folded++;
+                continue;
+            }
+
+            int count = ir_instr_use_slots(&instr, operands, slots, 8);
+            for (int u = 0; u < count; u++) {
+                int* slot = u < 8 ? slots[u] : &operands[instr.b + u];
+                *slot = ssa_lookup(&builder, *slot);
+            }
+            if (instr.dest != IR_NONE) instr.dest = ssa_define(&builder, instr.dest, IR_NONE);
+            instrs[out++] = instr;
+        }
+
+        // Inputs of the successors' phis coming from this block
+        for (int s = 0; s < 2; s++) {
+            int successor = b->successors[s];
+            if (successor == IR_NONE) continue;
+            const IrBlock* target = &function->blocks[successor];
+            int index = 0;
+            while (function->predecessors[target->first_predecessor + index] != block) index++;
+            for (int p = builder.phi_first[successor]; p < builder.phi_first[successor + 1]; p++) {
+                const IrInstr* phi = &instrs[blocks[successor].first + p - builder.phi_first[successor]];
+                operands[phi->b + index] = ssa_lookup(&builder, builder.phi_registers[p]);
+            }
+        }
+    }
+
+    // Undefined reads get 0, defined at the entry; otherwise slot 0 goes
+    int first = 1;
+    if (builder.undefined != IR_NONE) {
+        int constant = ir_function_add_constant(module, function, 0);
+        instrs[0] = (IrInstr){ IR_CONST, IR_TYPE_INT, 0, 0, builder.undefined, constant, 0, 0 };
+        blocks[0].first = 0;
+        blocks[0].count++;
+        first = 0;
+    } else {
+        for (int block = 0; block < block_count; block++) blocks[block].first--;
+    }
+
+    if (stats != NULL) {
+        stats->functions++;
+        stats->blocks += block_count;
+        stats->registers_before += registers;
+        stats->registers_after += builder.next_register;
+        stats->phis += builder.phi_count;
+        stats->copies_folded += builder.copies_folded;
+        if (builder.undefined != IR_NONE) stats->undefined++;
+        stats->dominator_iterations += builder.dominators.iterations;
+    }
+
+    function->register_count = builder.next_register;
+    function->ssa = true;
+    ir_function_replace(module, function, blocks, block_count, instrs + first, instr_count - first, operands,
+                        operand_count);
+
+    free(blocks);
+    free(instrs);
+    free(operands);
+    free(by_preorder);
+    free(walk_ends);
+    free(walk_logs);
+    free(builder.current);
+    free(builder.named);
+    free(builder.log_registers);
+    free(builder.log_names);
+    free(builder.frontier_first);
+    free(builder.frontiers);
+    free(builder.definition_first);
+    free(builder.definitions);
+    free(builder.nonlocal);
+    free(builder.types);
+    free(builder.phi_first);
+    free(builder.phi_registers);
+    ir_dominators_free(&builder.dominators);
+}
+
+void ir_module_to_ssa(IrModule* module, IrSsaStats* stats) {
+    for (int i = 0; i < module->function_count; i++) ir_function_to_ssa(module, &module->functions[i], stats);
+}
+
+// Out of SSA form
+typedef struct {
+    IrModule* module;
+    IrFunction* function;
+    IrInstr* instrs;
+    int instr_count;
+    int instr_capacity;
+
+    // Parallel copy sequentialization (Boissinot et al.): where each
+    // source's value is now, and the source each destination wants
+    int* location;
+    int* source;
+    uint8_t* types;
+    int* ready;
+    int* todo;
+    int temporary;               // Register for breaking cycles, once one is needed
+    int copies;
+    int cycles;
+} SsaDestructor;
+
+static void ssa_emit(SsaDestructor* destructor, IrInstr instr) {
+    if (destructor->instr_count == destructor->instr_capacity) {
+        destructor->instr_capacity = MAX(destructor->instr_capacity * 2, 256);
+        SAFE_REALLOC(destructor->instrs, sizeof(IrInstr) * destructor->instr_capacity);
+    }
+    destructor->instrs[destructor->instr_count++] = instr;
+}
+
+static void ssa_emit_copy(SsaDestructor* destructor, int dest, int source, IrType type) {
+    ssa_emit(destructor, (IrInstr){ IR_COPY, (uint8_t)type, 0, 0, dest, source, 0, 0 });
+    destructor->copies++;
+}
+
+// Emits copies doing what the phis of successor do on the edge from its
+// predecessor number index, all at once
+static void ssa_emit_parallel_copy(SsaDestructor* destructor, int successor, int index) {
+    const IrFunction* function = destructor->function;
+    const IrBlock* block = &function->blocks[successor];
+    int* location = destructor->location;
+    int* source = destructor->source;
+    int ready_count = 0;
+    int todo_count = 0;
+
+    int phis = 0;
+    while (phis < block->count && function->instrs[block->first + phis].op == IR_PHI) phis++;
+    for (int i = 0; i < phis; i++) {
+        const IrInstr* phi = &function->instrs[block->first + i];
+        int from = function->operands[phi->b + index];
+        if (from == phi->dest) continue;
+        location[from] = from;
+        source[phi->dest] = from;
+        destructor->types[phi->dest] = phi->type;
+        destructor->todo[todo_count++] = phi->dest;
+    }
+    // Destinations no copy reads can be written right away
+    for (int i = 0; i < todo_count; i++) {
+        int dest = destructor->todo[i];
+        if (location[dest] == IR_NONE) destructor->ready[ready_count++] = dest;
+    }
+
+    while (todo_count > 0) {
+        while (ready_count > 0) {
+            int dest = destructor->ready[--ready_count];
+            int from = source[dest];
+            int current = location[from];
+            ssa_emit_copy(destructor, dest, current, destructor->types[dest]);
+            location[from] = dest;
+            // from's own value has moved out, so from can be written now
+            if (from == current && source[from] != IR_NONE) destructor->ready[ready_count++] = from;
+        }
+
+        // What is left are cycles: one value is set aside to open each
+        int dest = destructor->todo[--todo_count];
+        if (location[dest] == dest) {
+            if (destructor->temporary == IR_NONE) destructor->temporary = destructor->function->register_count++;
+            ssa_emit_copy(destructor, destructor->temporary, dest, destructor->types[dest]);
+            location[dest] = destructor->temporary;
+            destructor->ready[ready_count++] = dest;
+            destructor->cycles++;
+        }
+    }
+
+    // Reset the entries used
+    for (int i = 0; i < phis; i++) {
+        const IrInstr* phi = &function->instrs[block->first + i];
+        location[function->operands[phi->b + index]] = IR_NONE;
+        location[phi->dest] = IR_NONE;
+        source[phi->dest] = IR_NONE;
+    }
+}
+
+static int ssa_phi_count(const IrFunction* function, int block) {
+    const IrBlock* b = &function->blocks[block];
+    int phis = 0;
+    while (phis < b->count && function->instrs[b->first + phis].op == IR_PHI) phis++;
+    return phis;
+}
+
+static int ssa_predecessor_index(const IrFunction* function, int block, int predecessor) {
+    const IrBlock* b = &function->blocks[block];
+    for (int i = 0; i < b->predecessor_count; i++) {
+        if (function->predecessors[b->first_predecessor + i] == predecessor) return i;
+    }
+    return IR_NONE;
+}
+
+void ir_function_from_ssa(IrModule* module, IrFunction* function, IrOutOfSsaStats* stats) {
+    if (!function->ssa) return;
+
+    // The temporary, if needed, is the next register, so the tables have
+    // room for it
+    SsaDestructor destructor = {0};
+    destructor.module = module;
+    destructor.function = function;
+    destructor.temporary = IR_NONE;
+    int registers = function->register_count + 1;
+    SAFE_MALLOC(destructor.location, sizeof(int) * registers);
+    SAFE_MALLOC(destructor.source, sizeof(int) * registers);
+    SAFE_CALLOC(destructor.types, registers, sizeof(uint8_t));
+    SAFE_MALLOC(destructor.ready, sizeof(int) * MAX(function->instr_count, 1));
+    SAFE_MALLOC(destructor.todo, sizeof(int) * MAX(function->instr_count, 1));
+    for (int i = 0; i < registers; i++) {
+        destructor.location[i] = IR_NONE;
+        destructor.source[i] = IR_NONE;
+    }
+
+    // Edges from a block with two successors to one with phis get a block
+    // of their own, appended after the others
+    int block_count = function->block_count;
+    int phi_total = 0;
+    int splits = 0;
+    int* phis;
+    SAFE_MALLOC(phis, sizeof(int) * block_count);
+    for (int block = 0; block < block_count; block++) {
+        phis[block] = ssa_phi_count(function, block);
+        phi_total += phis[block];
+    }
+    for (int block = 0; block < block_count; block++) {
+        const IrBlock* b = &function->blocks[block];
+        if (b->successors[1] == IR_NONE) continue;
+        for (int s = 0; s < 2; s++) splits += phis[b->successors[s]] > 0;
+    }
+
+    IrBlock* blocks;
+    int* split_targets;
+    int* split_sources;
+    SAFE_MALLOC(blocks, sizeof(IrBlock) * (block_count + splits));
+    SAFE_MALLOC(split_targets, sizeof(int) * MAX(splits, 1));
+    SAFE_MALLOC(split_sources, sizeof(int) * MAX(splits, 1));
+    int split_count = 0;
+    for (int block = 0; block < block_count; block++) {
+        const IrBlock* b = &function->blocks[block];
+        blocks[block].first = destructor.instr_count;
+        for (int i = phis[block]; i < b->count - 1; i++) ssa_emit(&destructor, function->instrs[b->first + i]);
+
+        IrInstr terminator = function->instrs[b->first + b->count - 1];
+        if (b->successors[1] == IR_NONE) {
+            int successor = b->successors[0];
+            if (successor != IR_NONE && phis[successor] > 0) {
+                ssa_emit_parallel_copy(&destructor, successor, ssa_predecessor_index(function, successor, block));
+            }
+        } else {
+            for (int s = 0; s < 2; s++) {
+                int successor = b->successors[s];
+                if (phis[successor] == 0) continue;
+                int split = block_count + split_count;
+                split_targets[split_count] = successor;
+                split_sources[split_count++] = block;
+                if (terminator.b == successor) {
+                    terminator.b = split;
+                } else {
+                    terminator.c = split;
+                }
+            }
+        }
+        ssa_emit(&destructor, terminator);
+        blocks[block].count = destructor.instr_count - blocks[block].first;
+    }
+
+    for (int i = 0; i < split_count; i++) {
+        int successor = split_targets[i];
+        blocks[block_count + i].first = destructor.instr_count;
+        ssa_emit_parallel_copy(&destructor, successor, ssa_predecessor_index(function, successor, split_sources[i]));
+        ssa_emit(&destructor, (IrInstr){ IR_JUMP, IR_TYPE_VOID, 0, 0, IR_NONE, successor, 0, 0 });
+        blocks[block_count + i].count = destructor.instr_count - blocks[block_count + i].first;
+    }
+
+    if (stats != NULL) {
+        stats->functions++;
+        stats->phis += phi_total;
+        stats->copies += destructor.copies;
+        stats->cycles += destructor.cycles;
+        stats->edges_split += split_count;
+    }
+
+    // Phi inputs stay in the operands, unused
+    function->ssa = false;
+    ir_function_replace(module, function, blocks, block_count + split_count, destructor.instrs,
+                        destructor.instr_count, function->operands, function->operand_count);
+
+    free(phis);
+    free(blocks);
+    free(split_targets);
+    free(split_sources);
+    free(destructor.instrs);
+    free(destructor.location);
+    free(destructor.source);
+    free(destructor.types);
+    free(destructor.ready);
+    free(destructor.todo);
+}
+
+void ir_module_from_ssa(IrModule* module, IrOutOfSsaStats* stats) {
+    for (int i = 0; i < module->function_count; i++) ir_function_from_ssa(module, &module->functions[i], stats);
+}
+
+// Verification
+bool ir_function_verify_ssa(const IrFunction* function) {
+    int registers = function->register_count;
+    int* defined_in;
+    int* position;
+    SAFE_MALLOC(defined_in, sizeof(int) * MAX(registers, 1));
+    SAFE_MALLOC(position, sizeof(int) * MAX(registers, 1));
+    for (int i = 0; i < registers; i++) defined_in[i] = IR_NONE;
+    for (int i = 0; i < function->parameter_count; i++) {
+        defined_in[i] = 0;
+        position[i] = -1;
+    }
+
+    bool valid = true;
+    for (int block = 0; block < function->block_count && valid; block++) {
+        const IrBlock* b = &function->blocks[block];
+        for (int i = 0; i < b->count; i++) {
+            int dest = function->instrs[b->first + i].dest;
+            if (dest == IR_NONE) continue;
+            if (dest < 0 || dest >= registers || defined_in[dest] != IR_NONE) {
+                valid = false;
+                break;
+            }
+            defined_in[dest] = block;
+            position[dest] = i;
+        }
+    }
+
+    IrDominators dominators;
+    ir_dominators_compute(function, &dominators);
+    int uses[8];
+    for (int block = 0; block < function->block_count && valid; block++) {
+        const IrBlock* b = &function->blocks[block];
+        bool phis = true;
+        for (int i = 0; i < b->count && valid; i++) {
+            const IrInstr* instr = &function->instrs[b->first + i];
+            if (instr->op == IR_PHI) {
+                // Phis come first and have an input from each predecessor,
+                // defined where it dominates the end of the predecessor
+                valid = phis && instr->c == b->predecessor_count;
+                for (int p = 0; p < instr->c && valid; p++) {
+                    int reg = function->operands[instr->b + p];
+                    int predecessor = function->predecessors[b->first_predecessor + p];
+                    valid = reg >= 0 && reg < registers && defined_in[reg] != IR_NONE &&
+                            ir_dominates(&dominators, defined_in[reg], predecessor);
+                }
+                continue;
+            }
+
+            phis = false;
+            int count = ir_instr_uses(function, instr, uses, 8);
+            for (int u = 0; u < count && valid; u++) {
+                int reg = u < 8 ? uses[u] : function->operands[instr->b + u];
+                valid = reg >= 0 && reg < registers && defined_in[reg] != IR_NONE &&
+                        (defined_in[reg] == block ? position[reg] < i
+                                                  : ir_dominates(&dominators, defined_in[reg], block));
+            }
+        }
+    }
+
+    ir_dominators_free(&dominators);
+    free(defined_in);
+    free(position);
+    return valid;
+}
@@ -0,0 +1,88 @@
+#ifndef SSA_H
+#define SSA_H
+
+#include "ir.h"
+
+// Static single assignment form. ir_function_to_ssa gives every register one
+// definition: it computes the dominator tree with the iterative algorithm of
+// Cooper, Harvey and Kennedy (intersecting idoms over blocks in reverse
+// postorder), places phis at the iterated dominance frontiers of the blocks
+// that define a register, and renames registers walking the dominator tree.
+// Phis are placed semi-pruned: only for registers read in a block other than
+// one that defines them first, so the many temporaries that live within a
+// block never get one. Copies are folded away while renaming, so a register
+// assigned from another becomes that register's name.
+//
+// ir_function_from_ssa translates back: each phi becomes a copy at the end of
+// every predecessor. Critical edges (from a block with two successors to one
+// with several predecessors) are split first, so the copies run only on the
+// edge they belong to, and the copies of an edge are a parallel copy,
+// sequentialized so that no copy overwrites a value another still reads;
+// cycles, such as the swap that copy folding turns "t = a; a = b; b = t;"
+// into, are broken with one extra register.
+//
+// Both passes are linear in the size of the function apart from the
+// dominator computation, which settles in a few passes over the blocks for
+// the reducible flow graphs lowering produces.
+
+// Dominator tree of a function's blocks. Block 0 is the root, and its own
+// idom; blocks unreachable from it have idom IR_NONE. Tree order numbers
+// blocks in a preorder of the tree, and a block dominates the blocks whose
+// number is in [preorder, preorder + size).
+typedef struct {
+    int block_count;
+    int* idom;
+    int* postorder;          // Position of each block in a postorder of the flow graph
+    int* preorder;           // Position of each block in a preorder of the tree
+    int* size;               // Blocks in each block's subtree
+    int* first_child;        // Children in the tree, linked through next_sibling
+    int* next_sibling;
+    int iterations;          // Passes over the blocks until the idoms settled
+} IrDominators;
+
+typedef struct {
+    int functions;
+    int blocks;
+    int registers_before;    // Registers of the functions before renaming
+    int registers_after;
+    int phis;                // Phis placed
+    int copies_folded;       // Copy instructions removed by renaming
+    int undefined;           // Functions that read a register before any assignment
+    int dominator_iterations;
+} IrSsaStats;
+
+typedef struct {
+    int functions;
+    int phis;                // Phis removed
+    int copies;              // Copies inserted for them
+    int cycles;              // Parallel copies with a cycle to break
+    int edges_split;
+} IrOutOfSsaStats;
+
+// Computes the dominator tree of function; release it with ir_dominators_free
+void ir_dominators_compute(const IrFunction* function, IrDominators* dominators);
+void ir_dominators_free(IrDominators* dominators);
+
+static inline bool ir_dominates(const IrDominators* dominators, int a, int b) {
+    return dominators->idom[b] != IR_NONE &&
+           (unsigned)(dominators->preorder[b] - dominators->preorder[a]) < (unsigned)dominators->size[a];
+}
+
+// Puts a function that is not in SSA form into it. Every block must be
+// reachable from the entry, as lowering leaves them. A register read on some
+// path before any assignment reads 0, defined at the entry. stats, if
+// given, is added to.
+void ir_function_to_ssa(IrModule* module, IrFunction* function, IrSsaStats* stats);
+
+// Takes a function out of SSA form; it has no phis afterwards
+void ir_function_from_ssa(IrModule* module, IrFunction* function, IrOutOfSsaStats* stats);
+
+// Every function of the module
+void ir_module_to_ssa(IrModule* module, IrSsaStats* stats);
+void ir_module_from_ssa(IrModule* module, IrOutOfSsaStats* stats);
+
+// Whether every register of function is defined once, with the definition
+// dominating its uses (phi inputs at the end of their predecessor); for tests
+bool ir_function_verify_ssa(const IrFunction* function);
+
+#endif // SSA_H
@@ -67,6 +67,25 @@ Token* lexer_next_token(Lexer* lexer) {
     return read_operator(lexer);
 }
 
+// Moves the lexer to the start of a 1-based line so part of the source can
+// be tokenized again. Returns false if the source has fewer lines.
+bool lexer_seek_line(Lexer* lexer, int line) {
+    if (lexer == NULL || lexer->source == NULL || line < 1) return false;
+
+    const char* start = lexer->source;
+    for (int current = 1; current < line; current++) {
+        const char* newline = strchr(start, '\n');
+        if (newline == NULL) return false;
+        start = newline + 1;
+    }
+
+    lexer->position = (int)(start - lexer->source);
+    lexer->line = line;
+    lexer->column = 1;
+    lexer->current_char = *start;
+    return true;
+}
+
 Token* lexer_peek_token(Lexer* lexer) {
     // Save current state
     int saved_position = lexer->position;
@@ -86,6 +105,59 @@ Token* lexer_peek_token(Lexer* lexer) {
     return token;
 }
 
+TokenStream* lexer_tokenize(Lexer* lexer) {
+    if (lexer == NULL) return NULL;
+
+    TokenStream* stream = malloc(sizeof(TokenStream));
+    if (stream == NULL) return NULL;
+
+    // Roughly one token per four source bytes keeps regrowth rare
+    int source_length = lexer->source ? (int)strlen(lexer->source) : 0;
+    stream->capacity = MAX(16, source_length / 4);
+    stream->count = 0;
+    SAFE_MALLOC(stream->tokens, sizeof(Token*) * stream->capacity);
+
+    while (true) {
+        Token* token = lexer_next_token(lexer);
+        if (token == NULL) break;
+
+        if (token->type == TOKEN_NEWLINE) {
+            token_free(token);
+            continue;
+        }
+
+        if (stream->count >= stream->capacity) {
+            stream->capacity *= 2;
+            SAFE_REALLOC(stream->tokens, sizeof(Token*) * stream->capacity);
+        }
+        stream->tokens[stream->count++] = token;
+
+        if (token->type == TOKEN_EOF) break;
+    }
+
+    // Guarantee the EOF terminator even if the lexer bailed out early
+    if (stream->count == 0 || stream->tokens[stream->count - 1]->type != TOKEN_EOF) {
+        if (stream->count >= stream->capacity) {
+            stream->capacity += 1;
+            SAFE_REALLOC(stream->tokens, sizeof(Token*) * stream->capacity);
+        }
+        stream->tokens[stream->count++] = token_create(TOKEN_EOF, "", lexer->line, lexer->column);
+    }
+
+    return stream;
+}
+
+void token_stream_free(TokenStream* stream) {
+    if (stream == NULL) return;
+
+    for (int i = 0; i < stream->count; i++) {
+        token_free(stream->tokens[i]);
+    }
+
+    free(stream->tokens);
+    free(stream);
+}
+
 Error* lexer_get_last_error(Lexer* lexer) {
     return lexer ? lexer->last_error : NULL;
 }
@@ -153,15 +225,14 @@ static Token* read_identifier(Lexer* lexer) {
     int start_line = lexer->line;
     int start_column = lexer->column;
 
-    StringBuffer* buffer = string_buffer_create(32);
+    // Identifiers never span lines, so the lexeme is a slice of the source
+    int start = lexer->position;
     while (lexer->current_char != '\0' &&
            (isalnum(lexer->current_char) || lexer->current_char == '_')) {
-        string_buffer_append_char(buffer, lexer->current_char);
         advance(lexer);
     }
 
-    char* lexeme = strdup(buffer->data);
-    string_buffer_free(buffer);
+    char* lexeme = strndup_safe(lexer->source + start, lexer->position - start);
 
     // Check if it's a keyword
     TokenType type = TOKEN_IDENTIFIER;
@@ -178,15 +249,13 @@ static Token* read_number(Lexer* lexer) {
     int start_line = lexer->line;
     int start_column = lexer->column;
 
-    StringBuffer* buffer = string_buffer_create(32);
+    int start = lexer->position;
     bool has_decimal = false;
 
     while (lexer->current_char != '\0') {
         if (isdigit(lexer->current_char)) {
-            string_buffer_append_char(buffer, lexer->current_char);
             advance(lexer);
         } else if (lexer->current_char == '.' && !has_decimal) {
-            string_buffer_append_char(buffer, lexer->current_char);
             has_decimal = true;
             advance(lexer);
         } else {
@@ -194,8 +263,7 @@ static Token* read_number(Lexer* lexer) {
         }
     }
 
-    char* lexeme = strdup(buffer->data);
-    string_buffer_free(buffer);
+    char* lexeme = strndup_safe(lexer->source + start, lexer->position - start);
 
     TokenType type = has_decimal ? TOKEN_FLOAT_LITERAL : TOKEN_INTEGER_LITERAL;
     Token* token = token_create_with_literal(type, lexeme, start_line, start_column);
@@ -248,6 +316,8 @@ static Token* read_string(Lexer* lexer) {
     Token* token = token_create_with_literal(TOKEN_STRING_LITERAL, lexeme,
                                            start_line, start_column);
     if (token != NULL) {
+        // The unescaped content replaces the copy made from the lexeme
+        free(token->literal.string_value);
         token->literal.string_value = content;
     } else {
         free(content);
@@ -15,6 +15,14 @@ typedef struct Lexer {
     Error* last_error;       // Last error
 } Lexer;
 
+// Pre-tokenized source: every token in order with newlines dropped,
+// always terminated by a TOKEN_EOF token. The stream owns its tokens.
+typedef struct TokenStream {
+    Token** tokens;
+    int count;
+    int capacity;
+} TokenStream;
+
 // Lexer functions
 Lexer* lexer_create(const char* source);
 void lexer_free(Lexer* lexer);
@@ -22,6 +30,9 @@ void lexer_free(Lexer* lexer);
 // Tokenization functions
 Token* lexer_next_token(Lexer* lexer);
 Token* lexer_peek_token(Lexer* lexer);
+TokenStream* lexer_tokenize(Lexer* lexer);
+void token_stream_free(TokenStream* stream);
+bool lexer_seek_line(Lexer* lexer, int line);
 
 // Utility functions
 static void advance(Lexer* lexer);
@@ -0,0 +1,399 @@
+#include "ast_cache.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Growable tables filled while flattening a tree
+typedef struct {
+    AstImageNode* nodes;
+    uint32_t node_count;
+    uint32_t node_capacity;
+    uint32_t* lists;
+    uint32_t list_count;
+    uint32_t list_capacity;
+    uint32_t* string_offsets;
+    uint32_t string_count;
+    uint32_t string_capacity;
+    StringBuffer* strings;
+    uint32_t* intern_slots;  // Open addressing: string id + 1, 0 when empty
+    uint32_t intern_capacity;
+} ImageBuilder;
+
+static uint32_t image_intern(ImageBuilder* builder, const char* str);
+static uint32_t image_add_node(ImageBuilder* builder, ASTNode* node);
+
+static void* image_grow(void* array, uint32_t* capacity, uint32_t needed, size_t element_size) {
+    if (needed <= *capacity) return array;
+
+    uint32_t new_capacity = MAX(*capacity * 2, MAX(needed, 64));
+    SAFE_REALLOC(array, new_capacity * element_size);
+    *capacity = new_capacity;
+    return array;
+}
+
+static void image_intern_rehash(ImageBuilder* builder) {
+    uint32_t capacity = builder->intern_capacity ? builder->intern_capacity * 2 : 256;
+    uint32_t* slots;
+    SAFE_CALLOC(slots, capacity, sizeof(uint32_t));
+
+    for (uint32_t id = 0; id < builder->string_count; id++) {
+        const char* str = builder->strings->data + builder->string_offsets[id];
+        uint32_t slot = (uint32_t)hash_bytes(str, strlen(str)) & (capacity - 1);
+        while (slots[slot] != 0) slot = (slot + 1) & (capacity - 1);
+        slots[slot] = id + 1;
+    }
+
+    free(builder->intern_slots);
+    builder->intern_slots = slots;
+    builder->intern_capacity = capacity;
+}
+
+// Each distinct string is stored once
+static uint32_t image_intern(ImageBuilder* builder, const char* str) {
+    if (str == NULL) return AST_NONE;
+
+    if ((builder->string_count + 1) * 2 > builder->intern_capacity) {
+        image_intern_rehash(builder);
+    }
+
+    size_t length = strlen(str);
+    uint32_t mask = builder->intern_capacity - 1;
+    uint32_t slot = (uint32_t)hash_bytes(str, length) & mask;
+    while (builder->intern_slots[slot] != 0) {
+        uint32_t id = builder->intern_slots[slot] - 1;
+        if (strcmp(builder->strings->data + builder->string_offsets[id], str) == 0) return id;
+        slot = (slot + 1) & mask;
+    }
+
+    uint32_t id = builder->string_count++;
+    builder->string_offsets = image_grow(builder->string_offsets, &builder->string_capacity,
+                                         builder->string_count, sizeof(uint32_t));
+    builder->string_offsets[id] = (uint32_t)builder->strings->length;
+    string_buffer_append(builder->strings, str);
+    string_buffer_append_char(builder->strings, '\0');
+    builder->intern_slots[slot] = id + 1;
+
+    return id;
+}
+
+// Reserves count consecutive entries of the child index table
+static uint32_t image_reserve_list(ImageBuilder* builder, int count) {
+    uint32_t start = builder->list_count;
+    builder->list_count += count;
+    builder->lists = image_grow(builder->lists, &builder->list_capacity,
+                                builder->list_count, sizeof(uint32_t));
+    return start;
+}
+
+static void image_add_list(ImageBuilder* builder, uint32_t index, ASTNode** children, int count) {
+    uint32_t start = image_reserve_list(builder, count);
+
+    // Children may append lists of their own after the reserved range
+    for (int i = 0; i < count; i++) {
+        uint32_t child = image_add_node(builder, children[i]);
+        builder->lists[start + i] = child;
+    }
+
+    builder->nodes[index].child[1] = start;
+    builder->nodes[index].child[2] = count;
+}
+
+// Appends node and its subtree; returns the node's index. The record is
+// re-fetched after each child since the node table may move.
+static uint32_t image_add_node(ImageBuilder* builder, ASTNode* node) {
+    if (node == NULL) return AST_NONE;
+
+    uint32_t index = builder->node_count++;
+    builder->nodes = image_grow(builder->nodes, &builder->node_capacity,
+                                builder->node_count, sizeof(AstImageNode));
+
+    AstImageNode record = {0};
+    record.type = (uint8_t)node->type;
+    record.token_type = node->token ? (uint8_t)node->token->type : 0;
+    record.line = node->line;
+    record.column = (uint16_t)MIN(MAX(node->column, 0), UINT16_MAX);
+    record.lexeme = node->token ? image_intern(builder, node->token->lexeme) : AST_NONE;
+    record.name = AST_NONE;
+    record.type_name = AST_NONE;
+    record.child[0] = record.child[1] = record.child[2] = AST_NONE;
+    builder->nodes[index] = record;
+
+    uint32_t child[3] = { AST_NONE, AST_NONE, AST_NONE };
+    uint32_t name = AST_NONE;
+    uint32_t type_name = AST_NONE;
+    bool has_list = false;
+
+    switch (node->type) {
+        case NODE_BINARY_EXPRESSION:
+        case NODE_ASSIGNMENT_EXPRESSION:
+            name = image_intern(builder, node->data.binary.operator);
+            child[0] = image_add_node(builder, node->data.binary.left);
+            child[1] = image_add_node(builder, node->data.binary.right);
+            break;
+
+        case NODE_UNARY_EXPRESSION:
+            name = image_intern(builder, node->data.unary.operator);
+            child[0] = image_add_node(builder, node->data.unary.operand);
+            break;
+
+        case NODE_CALL_EXPRESSION:
+            child[0] = image_add_node(builder, node->data.call.callee);
+            has_list = true;
+            image_add_list(builder, index, node->data.call.arguments, node->data.call.argument_count);
+            break;
+
+        case NODE_VARIABLE_DECLARATION:
+            name = image_intern(builder, node->data.declaration.name);
+            type_name = image_intern(builder, node->data.declaration.type_name);
+            child[0] = image_add_node(builder, node->data.declaration.initializer);
+            break;
+
+        case NODE_FUNCTION_DECLARATION:
+            name = image_intern(builder, node->data.function.name);
+            type_name = image_intern(builder, node->data.function.return_type);
+            has_list = true;
+            image_add_list(builder, index, node->data.function.parameters, node->data.function.parameter_count);
+            child[0] = image_add_node(builder, ast_function_body(node));
+            break;
+
+        case NODE_PROGRAM:
+        case NODE_BLOCK_STATEMENT:
+            has_list = true;
+            image_add_list(builder, index, node->data.block.statements, node->data.block.statement_count);
+            break;
+
+        case NODE_IF_STATEMENT:
+        case NODE_WHILE_STATEMENT:
+            child[0] = image_add_node(builder, node->data.conditional.condition);
+            child[1] = image_add_node(builder, node->data.conditional.then_branch);
+            child[2] = image_add_node(builder, node->data.conditional.else_branch);
+            break;
+
+        case NODE_RETURN_STATEMENT:
+        case NODE_EXPRESSION_STATEMENT:
+            child[0] = image_add_node(builder, node->data.statement.expression);
+            break;
+
+        case NODE_LITERAL:
+            if (node->token && node->token->type == TOKEN_STRING_LITERAL) {
+                name = image_intern(builder, node->data.literal.string_value);
+            } else {
+                memcpy(&type_name, &node->data.literal, sizeof(uint32_t));
+            }
+            break;
+
+        case NODE_IDENTIFIER:
+            name = image_intern(builder, node->data.identifier_name);
+            break;
+
+        default:
+            break;
+    }
+
+    AstImageNode* record_slot = &builder->nodes[index];
+    record_slot->name = name;
+    record_slot->type_name = type_name;    // Literal bits share this field
+    record_slot->child[0] = child[0];
+    if (!has_list) {
+        record_slot->child[1] = child[1];
+        record_slot->child[2] = child[2];
+    }
+
+    return index;
+}
+
+// Points the image's section pointers into its buffer
+static void ast_image_bind(AstImage* image) {
+    const char* base = image->memory;
+    const AstImageHeader* header = image->memory;
+
+    image->header = header;
+    image->nodes = (const AstImageNode*)(base + sizeof(AstImageHeader));
+    image->lists = (const uint32_t*)(image->nodes + header->node_count);
+    image->string_offsets = image->lists + header->list_count;
+    image->strings = (const char*)(image->string_offsets + header->string_count);
+}
+
+static size_t ast_image_expected_size(const AstImageHeader* header) {
+    return sizeof(AstImageHeader) +
+           (size_t)header->node_count * sizeof(AstImageNode) +
+           (size_t)header->list_count * sizeof(uint32_t) +
+           (size_t)header->string_count * sizeof(uint32_t) +
+           header->string_bytes;
+}
+
+// Flattens program into an in-memory image. Lazily parsed function bodies
+// are parsed first.
+AstImage* ast_image_build(ASTNode* program, uint64_t source_hash) {
+    if (program == NULL) return NULL;
+
+    ImageBuilder builder = {0};
+    builder.strings = string_buffer_create(4096);
+
+    uint32_t root = image_add_node(&builder, program);
+
+    AstImageHeader header = {0};
+    header.magic = AST_CACHE_MAGIC;
+    header.version = AST_CACHE_VERSION;
+    header.source_hash = source_hash;
+    header.node_count = builder.node_count;
+    header.list_count = builder.list_count;
+    header.string_count = builder.string_count;
+    header.string_bytes = (uint32_t)builder.strings->length;
+    header.root = root;
+
+    AstImage* image;
+    SAFE_MALLOC(image, sizeof(AstImage));
+    image->size = ast_image_expected_size(&header);
+    image->mapped = false;
+    SAFE_MALLOC(image->memory, image->size);
+
+    char* cursor = image->memory;
+    memcpy(cursor, &header, sizeof(header));
+    cursor += sizeof(header);
+    memcpy(cursor, builder.nodes, builder.node_count * sizeof(AstImageNode));
+    cursor += builder.node_count * sizeof(AstImageNode);
+    memcpy(cursor, builder.lists, builder.list_count * sizeof(uint32_t));
+    cursor += builder.list_count * sizeof(uint32_t);
+    memcpy(cursor, builder.string_offsets, builder.string_count * sizeof(uint32_t));
+    cursor += builder.string_count * sizeof(uint32_t);
+    memcpy(cursor, builder.strings->data, builder.strings->length);
+
+    ast_image_bind(image);
+
+    free(builder.nodes);
+    free(builder.lists);
+    free(builder.string_offsets);
+    free(builder.intern_slots);
+    string_buffer_free(builder.strings);
+
+    return image;
+}
+
+bool ast_image_write(AstImage* image, const char* path) {
+    if (image == NULL || path == NULL) return false;
+
+    // Write to a temporary name and rename, so readers never see a partial file
+    char temporary[4096];
+    int length = snprintf(temporary, sizeof(temporary), "%s.tmp", path);
+    if (length < 0 || (size_t)length >= sizeof(temporary)) return false;
+
+    FILE* file = fopen(temporary, "wb");
+    if (file == NULL) return false;
+
+    bool written = fwrite(image->memory, 1, image->size, file) == image->size;
+    written = fclose(file) == 0 && written;
+    if (!written || rename(temporary, path) != 0) {
+        remove(temporary);
+        return false;
+    }
+
+    return true;
+}
+
+// Cache files are named after the hash of the source they were parsed from
+bool ast_cache_path(char* buffer, size_t size, const char* directory, uint64_t source_hash) {
+    int length = snprintf(buffer, size, "%s/%016llx.ast", directory, (unsigned long long)source_hash);
+    return length >= 0 && (size_t)length < size;
+}
+
+AstImage* ast_image_open(const char* path, uint64_t source_hash) {
+    if (path == NULL) return NULL;
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return NULL;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(AstImageHeader)) {
+        close(fd);
+        return NULL;
+    }
+
+    size_t size = (size_t)info.st_size;
+    void* memory = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (memory == MAP_FAILED) return NULL;
+
+    const AstImageHeader* header = memory;
+    bool valid = header->magic == AST_CACHE_MAGIC &&
+                 header->version == AST_CACHE_VERSION &&
+                 header->source_hash == source_hash &&
+                 ast_image_expected_size(header) == size &&
+                 header->root < header->node_count;
+
+    // Strings are read in place, so the table must end in a terminator
+    if (valid && header->string_bytes > 0) {
+        valid = ((const char*)memory)[size - 1] == '\0';
+    }
+
+    if (!valid) {
+        munmap(memory, size);
+        return NULL;
+    }
+
+    AstImage* image;
+    SAFE_MALLOC(image, sizeof(AstImage));
+    image->memory = memory;
+    image->size = size;
+    image->mapped = true;
+    ast_image_bind(image);
+
+    return image;
+}
+
+void ast_image_free(AstImage* image) {
+    if (image == NULL) return;
+
+    if (image->mapped) {
+        munmap(image->memory, image->size);
+    } else {
+        free(image->memory);
+    }
+    free(image);
+}
+
+// Accessors bounds-check every index, so a corrupt file cannot read outside
+// the mapping
+const AstImageNode* ast_image_root(AstImage* image) {
+    return image ? ast_image_node(image, image->header->root) : NULL;
+}
+
+const AstImageNode* ast_image_node(AstImage* image, uint32_t index) {
+    if (image == NULL || index >= image->header->node_count) return NULL;
+    return &image->nodes[index];
+}
+
+bool ast_image_has_list(const AstImageNode* node) {
+    if (node == NULL) return false;
+
+    switch (node->type) {
+        case NODE_CALL_EXPRESSION:
+        case NODE_FUNCTION_DECLARATION:
+        case NODE_PROGRAM:
+        case NODE_BLOCK_STATEMENT:
+            return true;
+        default:
+            return false;
+    }
+}
+
+uint32_t ast_image_list_count(const AstImageNode* node) {
+    return ast_image_has_list(node) ? node->child[2] : 0;
+}
+
+const AstImageNode* ast_image_list_node(AstImage* image, const AstImageNode* node, uint32_t position) {
+    if (image == NULL || position >= ast_image_list_count(node)) return NULL;
+
+    uint32_t entry = node->child[1] + position;
+    if (entry < node->child[1] || entry >= image->header->list_count) return NULL;
+    return ast_image_node(image, image->lists[entry]);
+}
+
+const char* ast_image_string(AstImage* image, uint32_t id) {
+    if (image == NULL || id >= image->header->string_count) return NULL;
+
+    uint32_t offset = image->string_offsets[id];
+    if (offset >= image->header->string_bytes) return NULL;
+    return image->strings + offset;
+}
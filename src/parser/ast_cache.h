@@ -0,0 +1,84 @@
+#ifndef AST_CACHE_H
+#define AST_CACHE_H
+
+#include "parser.h"
+
+// Binary AST images. A parsed program is flattened into a single buffer of
+// fixed-size node records, a child index table and an interned string table.
+// Every reference is an index, so the file can be mmapped and read in place
+// without rebuilding ASTNode trees. Images are keyed by a hash of the source
+// they were parsed from and are rejected when it no longer matches.
+
+#define AST_CACHE_MAGIC 0x54534143u   // "CAST"
+#define AST_CACHE_VERSION 1
+#define AST_NONE UINT32_MAX           // Absent child, string or token
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t source_hash;
+    uint32_t node_count;
+    uint32_t list_count;     // Entries in the child index table
+    uint32_t string_count;
+    uint32_t string_bytes;
+    uint32_t root;
+    uint32_t reserved;
+} AstImageHeader;
+
+// One 32-byte node. Which fields are used depends on type:
+//   binary/assignment  child[0] left, child[1] right, name operator
+//   unary              child[0] operand, name operator
+//   call               child[0] callee, list arguments
+//   variable decl      name, type_name, child[0] initializer
+//   function           name, type_name return type, list parameters, child[0] body
+//   program/block      list statements
+//   if/while           child[0] condition, child[1] then/body, child[2] else
+//   return/expression  child[0] expression
+//   literal            value (int or float bits), name string value
+//   identifier         name
+// Nodes with a list keep its start in the child index table in child[1] and
+// its length in child[2]; use ast_image_list_count and ast_image_list_node.
+typedef struct {
+    uint8_t type;            // NodeType
+    uint8_t token_type;      // TokenType of the node's token
+    uint16_t column;         // Saturates at UINT16_MAX
+    int32_t line;
+    uint32_t lexeme;         // String id of the token lexeme, AST_NONE without a token
+    uint32_t name;
+    union {
+        uint32_t type_name;
+        uint32_t value;
+    };
+    uint32_t child[3];
+} AstImageNode;
+
+// A validated image, either mmapped from a file or built in memory
+typedef struct {
+    const AstImageHeader* header;
+    const AstImageNode* nodes;
+    const uint32_t* lists;
+    const uint32_t* string_offsets;
+    const char* strings;
+    void* memory;
+    size_t size;
+    bool mapped;
+} AstImage;
+
+// Writing
+AstImage* ast_image_build(ASTNode* program, uint64_t source_hash);
+bool ast_image_write(AstImage* image, const char* path);
+bool ast_cache_path(char* buffer, size_t size, const char* directory, uint64_t source_hash);
+
+// Reading (NULL if missing, malformed, another version or a different source)
+AstImage* ast_image_open(const char* path, uint64_t source_hash);
+void ast_image_free(AstImage* image);
+
+// Access in place
+const AstImageNode* ast_image_root(AstImage* image);
+const AstImageNode* ast_image_node(AstImage* image, uint32_t index);
+bool ast_image_has_list(const AstImageNode* node);
+uint32_t ast_image_list_count(const AstImageNode* node);
+const AstImageNode* ast_image_list_node(AstImage* image, const AstImageNode* node, uint32_t position);
+const char* ast_image_string(AstImage* image, uint32_t id);
+
+#endif // AST_CACHE_H
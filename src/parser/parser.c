@@ -1,14 +1,58 @@
 #include "parser.h"
 #include <stdbool.h>
+#include <pthread.h>
 
-// Minimal parser implementation for testing
+// Recursive descent parser over a pre-tokenized stream
+
+// Arena that AST allocations on the current thread go to; NULL means malloc.
+// Parallel parsing workers each install their own.
+static _Thread_local Arena* ast_arena = NULL;
 
 // Forward declarations
+static void parser_advance(Parser* parser);
+static bool parser_check(Parser* parser, TokenType type);
+static Token* parser_previous_token(Parser* parser);
+static bool parser_match(Parser* parser, TokenType type);
+static ASTNode* parser_error(Parser* parser, Token* token, const char* message);
+static void parser_synchronize(Parser* parser);
+static ASTNode* parser_parse_recovering(Parser* parser, bool top_level);
+static ASTNode* parser_recover(Parser* parser, int start, ASTNode* node);
+static void parser_seek(Parser* parser, int position);
+static bool parser_is_type_keyword(TokenType type);
+static void parser_scratch_push(Parser* parser, ASTNode* node);
+static ASTNode** parser_scratch_take(Parser* parser, int mark, int* count);
+static void parser_scratch_discard(Parser* parser, int mark);
+static ASTNode* parser_parse_declaration(Parser* parser);
+static bool parser_at_function_definition(Parser* parser);
+static ASTNode* parser_parse_function(Parser* parser, Token* type_token, Token* name_token);
+static ASTNode* parser_parse_function_signature(Parser* parser, Token* type_token, Token* name_token);
+static ASTNode* parser_parse_function_body(Parser* parser, ASTNode* function);
+static ASTNode* parser_parse_body_block(Parser* parser, ASTNode* function);
+static int parser_skim_block(Parser* parser);
+static ASTNode* parser_parse_variable_declaration(Parser* parser, bool require_semicolon);
+static ASTNode* parser_parse_statement(Parser* parser);
+static ASTNode* parser_parse_block(Parser* parser);
+static ASTNode* parser_parse_if(Parser* parser);
+static ASTNode* parser_parse_while(Parser* parser);
+static ASTNode* parser_parse_return(Parser* parser);
+static ASTNode* parser_parse_expression_statement(Parser* parser);
 static ASTNode* parser_parse_expression(Parser* parser);
+static ASTNode* parser_parse_assignment(Parser* parser);
 static ASTNode* parser_parse_expression_precedence(Parser* parser, int precedence);
+static ASTNode* parser_parse_unary(Parser* parser);
+static ASTNode* parser_parse_call(Parser* parser, ASTNode* callee);
 static ASTNode* parser_parse_primary(Parser* parser);
 static bool parser_is_binary_operator(TokenType type);
 static int parser_get_precedence(TokenType type);
+static void* ast_alloc(size_t size);
+static char* ast_strdup(const char* str);
+static ASTNode* parser_hash_cons(Parser* parser, ASTNode* node);
+static void parser_declare_local(Parser* parser, ASTNode* declaration);
+static void expr_table_free(ExprTable* table);
+static void expr_map_init(ExprMap* map);
+static void expr_table_retire_body(ExprTable* table);
+static ASTNode* parser_fold_binary(Token* op, ASTNode* left, ASTNode* right);
+static ASTNode* parser_fold_unary(Token* op, ASTNode* operand);
 
 Parser* parser_create(Lexer* lexer) {
     if (lexer == NULL) return NULL;
@@ -16,67 +60,1722 @@ Parser* parser_create(Lexer* lexer) {
     Parser* parser = malloc(sizeof(Parser));
     if (parser == NULL) return NULL;
 
+    parser->stream = lexer_tokenize(lexer);
+    if (parser->stream == NULL) {
+        free(parser);
+        return NULL;
+    }
+
     parser->lexer = lexer;
-    parser->current_token = NULL;
-    parser->peek_token = NULL;
+    parser->position = 0;
+    parser->current_token = parser->stream->tokens[0];
+    parser->peek_token = parser->stream->tokens[MIN(1, parser->stream->count - 1)];
     parser->had_error = false;
     parser->last_error = NULL;
+    parser->diagnostics = NULL;
+    parser->diagnostic_count = 0;
+    parser->suppressed_error_count = 0;
+    parser->panic_mode = false;
+    parser->scratch = NULL;
+    parser->scratch_count = 0;
+    parser->scratch_capacity = 0;
+    parser->arenas = NULL;
+    parser->arena_count = 0;
+    parser->expr_table = NULL;
+    parser->locals = NULL;
+    parser->local_count = 0;
+    parser->local_capacity = 0;
+    parser->scope_depth = 0;
+    parser->in_body = false;
+    parser->fold_constants = false;
+    parser->generation = 0;
+
+    return parser;
+}
+
+void parser_free(Parser* parser) {
+    if (parser == NULL) return;
+
+    parser_clear_error(parser);
+    expr_table_free(parser->expr_table);   // Reads the tokens of shared literals
+    token_stream_free(parser->stream);
+    free(parser->scratch);
+    free(parser->locals);
+    for (int i = 0; i < parser->arena_count; i++) {
+        arena_free(parser->arenas[i]);
+    }
+    free(parser->arenas);
+    free(parser);
+}
+
+// Shares structurally equal pure expressions in everything parsed from now
+// on. Shared nodes are owned by the parser, so this cannot be undone.
+void parser_enable_hash_consing(Parser* parser) {
+    if (parser == NULL || parser->expr_table != NULL) return;
+
+    SAFE_MALLOC(parser->expr_table, sizeof(ExprTable));
+    expr_map_init(&parser->expr_table->top_level);
+    expr_map_init(&parser->expr_table->body);
+    parser->expr_table->retired = NULL;
+    parser->expr_table->retired_count = 0;
+    parser->expr_table->retired_capacity = 0;
+    parser->expr_table->count = 0;
+    parser->expr_table->hits = 0;
+}
+
+// Evaluates operators whose operands are all literals while parsing, so
+// 5 + 3 is built as the literal 8. Operations that would trap or are
+// undefined at run time (division by zero, INT_MIN / -1, out of range
+// shifts) are left for the program to perform.
+void parser_enable_constant_folding(Parser* parser) {
+    if (parser == NULL) return;
+    parser->fold_constants = true;
+}
+
+ASTNode* parser_parse(Parser* parser) {
+    if (parser == NULL) return NULL;
+
+    if (parser->current_token == NULL || parser->current_token->type == TOKEN_EOF) {
+        return ast_node_create(NODE_ERROR, NULL);
+    }
+
+    // A single declaration or expression; the trailing ';' is optional here
+    if (parser_is_type_keyword(parser->current_token->type)) {
+        return parser_parse_variable_declaration(parser, false);
+    }
+
+    return parser_parse_expression(parser);
+}
+
+ASTNode* parser_parse_program(Parser* parser) {
+    if (parser == NULL) return NULL;
+
+    ASTNode* program = ast_node_create_program();
+    if (program == NULL) return NULL;
+
+    // Syntax errors leave NODE_ERROR placeholders and parsing continues to EOF
+    int mark = parser->scratch_count;
+    while (!parser_check(parser, TOKEN_EOF)) {
+        if (parser_match(parser, TOKEN_SEMICOLON)) continue;
+
+        parser_scratch_push(parser, parser_parse_recovering(parser, true));
+    }
+
+    program->data.block.statements = parser_scratch_take(parser, mark, &program->data.block.statement_count);
+    return program;
+}
+
+// Parses the program one top-level declaration at a time, handing each to
+// callback instead of collecting them, so later phases can start on a
+// declaration (and free it) while the rest is still being parsed. Returns
+// false if the callback stopped the parse; syntax errors are reported
+// through the diagnostics as usual.
+bool parser_parse_program_streaming(Parser* parser, DeclarationCallback callback, void* context) {
+    if (parser == NULL || callback == NULL) return false;
+
+    while (!parser_check(parser, TOKEN_EOF)) {
+        if (parser_match(parser, TOKEN_SEMICOLON)) continue;
+
+        ASTNode* declaration = parser_parse_recovering(parser, true);
+        if (declaration != NULL && !callback(declaration, context)) return false;
+    }
+    return true;
+}
+
+// Bounded queue between the parsing thread and the consumer thread of a
+// pipelined parse
+typedef struct {
+    ASTNode** items;
+    int capacity;
+    int head;
+    int count;
+    bool finished;           // Producer has pushed its last declaration
+    bool stopped;            // Callback asked to stop
+    DeclarationCallback callback;
+    void* context;
+    pthread_mutex_t lock;
+    pthread_cond_t not_empty;
+    pthread_cond_t not_full;
+} DeclarationQueue;
+
+static void* parser_declaration_consumer(void* argument) {
+    DeclarationQueue* queue = argument;
+
+    while (true) {
+        pthread_mutex_lock(&queue->lock);
+        while (queue->count == 0 && !queue->finished) {
+            pthread_cond_wait(&queue->not_empty, &queue->lock);
+        }
+        if (queue->count == 0) {
+            pthread_mutex_unlock(&queue->lock);
+            return NULL;
+        }
+
+        ASTNode* declaration = queue->items[queue->head];
+        queue->head = (queue->head + 1) % queue->capacity;
+        queue->count--;
+        pthread_cond_signal(&queue->not_full);
+        pthread_mutex_unlock(&queue->lock);
+
+        if (!queue->callback(declaration, queue->context)) {
+            pthread_mutex_lock(&queue->lock);
+            queue->stopped = true;
+            pthread_cond_signal(&queue->not_full);
+            pthread_mutex_unlock(&queue->lock);
+            return NULL;
+        }
+    }
+}
+
+// Queues a declaration for the consumer, waiting while the queue is full.
+// Returns false, freeing the declaration, once the consumer has stopped.
+static bool parser_declaration_push(DeclarationQueue* queue, ASTNode* declaration) {
+    pthread_mutex_lock(&queue->lock);
+    while (queue->count == queue->capacity && !queue->stopped) {
+        pthread_cond_wait(&queue->not_full, &queue->lock);
+    }
+    if (queue->stopped) {
+        pthread_mutex_unlock(&queue->lock);
+        ast_node_free(declaration);
+        return false;
+    }
+
+    queue->items[(queue->head + queue->count) % queue->capacity] = declaration;
+    queue->count++;
+    pthread_cond_signal(&queue->not_empty);
+    pthread_mutex_unlock(&queue->lock);
+    return true;
+}
+
+// Streaming parse whose callback runs on a second thread. At most
+// queue_capacity parsed declarations wait for it, which bounds the AST
+// memory in flight. Falls back to running the callback on this thread if
+// the consumer cannot be started.
+bool parser_parse_program_pipelined(Parser* parser, DeclarationCallback callback, void* context,
+                                    int queue_capacity) {
+    if (parser == NULL || callback == NULL) return false;
+
+    DeclarationQueue queue;
+    memset(&queue, 0, sizeof(queue));
+    queue.capacity = MAX(1, queue_capacity);
+    queue.callback = callback;
+    queue.context = context;
+    SAFE_MALLOC(queue.items, sizeof(ASTNode*) * queue.capacity);
+    pthread_mutex_init(&queue.lock, NULL);
+    pthread_cond_init(&queue.not_empty, NULL);
+    pthread_cond_init(&queue.not_full, NULL);
+
+    pthread_t consumer;
+    bool completed;
+    if (pthread_create(&consumer, NULL, parser_declaration_consumer, &queue) != 0) {
+        completed = parser_parse_program_streaming(parser, callback, context);
+    } else {
+        completed = true;
+        while (!parser_check(parser, TOKEN_EOF)) {
+            if (parser_match(parser, TOKEN_SEMICOLON)) continue;
+
+            ASTNode* declaration = parser_parse_recovering(parser, true);
+            if (declaration != NULL && !parser_declaration_push(&queue, declaration)) {
+                completed = false;
+                break;
+            }
+        }
+
+        pthread_mutex_lock(&queue.lock);
+        queue.finished = true;
+        pthread_cond_signal(&queue.not_empty);
+        pthread_mutex_unlock(&queue.lock);
+        pthread_join(consumer, NULL);
+
+        // Declarations still queued when the callback stopped are never seen
+        completed = completed && !queue.stopped;
+        for (int i = 0; i < queue.count; i++) {
+            ast_node_free(queue.items[(queue.head + i) % queue.capacity]);
+        }
+    }
+
+    pthread_cond_destroy(&queue.not_full);
+    pthread_cond_destroy(&queue.not_empty);
+    pthread_mutex_destroy(&queue.lock);
+    free(queue.items);
+    return completed;
+}
+
+// Parses everything except function bodies, which are skimmed by brace
+// matching and left for ast_function_body to parse on first use
+ASTNode* parser_parse_program_lazy(Parser* parser) {
+    if (parser == NULL) return NULL;
+
+    ASTNode* program = ast_node_create_program();
+    if (program == NULL) return NULL;
+
+    int mark = parser->scratch_count;
+    while (!parser_check(parser, TOKEN_EOF)) {
+        if (parser_match(parser, TOKEN_SEMICOLON)) continue;
+
+        if (!parser_at_function_definition(parser)) {
+            parser_scratch_push(parser, parser_parse_recovering(parser, true));
+            continue;
+        }
+
+        int start = parser->position;
+        Token* type_token = parser->current_token;
+        Token* name_token = parser->peek_token;
+        parser_advance(parser);
+        parser_advance(parser);
+
+        ASTNode* function = parser_parse_function_signature(parser, type_token, name_token);
+        int end = function != NULL && function->type != NODE_ERROR ? parser_skim_block(parser) : -1;
+        if (end < 0) {
+            // Bad signature or unbalanced braces: finish this one eagerly
+            if (function != NULL && function->type != NODE_ERROR) {
+                function = parser_parse_function_body(parser, function);
+            }
+            ASTNode* node = parser_recover(parser, start, function);
+            if (node != NULL) {
+                node->first_token = parser->stream->tokens[start];
+                node->last_token = parser_previous_token(parser);
+            }
+            parser_scratch_push(parser, node);
+            continue;
+        }
+
+        function->data.function.body_parser = parser;
+        function->data.function.body_start = parser->position;
+        function->data.function.body_end = end;
+        function->first_token = parser->stream->tokens[start];
+        function->last_token = parser->stream->tokens[end];
+
+        parser_scratch_push(parser, function);
+        parser_seek(parser, end + 1);
+    }
+
+    program->data.block.statements = parser_scratch_take(parser, mark, &program->data.block.statement_count);
+    return program;
+}
+
+// A parser sharing owner's token stream with its own cursor, scratch stack
+// and diagnostics
+static void parser_view_init(Parser* view, Parser* owner) {
+    memset(view, 0, sizeof(Parser));
+    view->lexer = owner->lexer;
+    view->stream = owner->stream;
+    view->fold_constants = owner->fold_constants;
+}
+
+// Appends a view's diagnostics to owner's, keeping owner's bound
+static void parser_absorb_diagnostics(Parser* owner, Parser* view) {
+    owner->had_error = owner->had_error || view->had_error;
+    owner->suppressed_error_count += view->suppressed_error_count;
+
+    for (int i = 0; i < view->diagnostic_count; i++) {
+        if (owner->diagnostic_count >= PARSER_MAX_DIAGNOSTICS) {
+            owner->suppressed_error_count++;
+            error_free(view->diagnostics[i]);
+            continue;
+        }
+
+        if (owner->diagnostics == NULL) {
+            SAFE_MALLOC(owner->diagnostics, sizeof(Error*) * PARSER_MAX_DIAGNOSTICS);
+        }
+        owner->diagnostics[owner->diagnostic_count++] = view->diagnostics[i];
+        owner->last_error = view->diagnostics[i];
+    }
+
+    free(view->diagnostics);
+    view->diagnostics = NULL;
+    view->diagnostic_count = 0;
+}
+
+// Returns the function's body, parsing and caching it first if it was
+// deferred by parser_parse_program_lazy. Syntax errors in the body are added
+// to the parser's diagnostics when it is parsed.
+ASTNode* ast_function_body(ASTNode* function) {
+    if (function == NULL || function->type != NODE_FUNCTION_DECLARATION) return NULL;
+
+    Parser* owner = function->data.function.body_parser;
+    if (owner == NULL) return function->data.function.body;
+
+    Parser view;
+    parser_view_init(&view, owner);
+    view.expr_table = owner->expr_table;
+    parser_seek(&view, function->data.function.body_start);
+
+    function->data.function.body = parser_parse_body_block(&view, function);
+    function->data.function.body_parser = NULL;
+
+    parser_absorb_diagnostics(owner, &view);
+    free(view.scratch);
+    free(view.locals);
+
+    return function->data.function.body;
+}
+
+// Parallel parsing. The lazy pass parses everything except function bodies,
+// which are then handed out as jobs. Workers
+// parse the bodies into per-thread arenas through private parser views over
+// the shared, read-only token stream, and the bodies are stitched back into
+// their functions in source order. The result is the same tree and the same
+// diagnostics as parser_parse_program.
+typedef struct {
+    ASTNode* function;
+    int start;               // Stream index of the body's '{'
+    int end;                 // Stream index of the matching '}'
+    ASTNode* body;
+    bool matched;            // The body parse ended exactly at end
+} BodyJob;
+
+typedef struct {
+    Parser* parser;
+    BodyJob* jobs;
+    int job_count;
+    int next_job;            // Claimed with an atomic fetch-and-add
+} BodyQueue;
+
+typedef struct {
+    BodyQueue* queue;
+    Arena* arena;
+    Parser view;             // Private cursor, scratch stack and diagnostics
+} BodyWorker;
+
+static void* parser_body_worker(void* argument) {
+    BodyWorker* worker = argument;
+    BodyQueue* queue = worker->queue;
+    Parser* view = &worker->view;
+
+    ast_arena = worker->arena;
+
+    int index;
+    while ((index = __atomic_fetch_add(&queue->next_job, 1, __ATOMIC_RELAXED)) < queue->job_count) {
+        BodyJob* job = &queue->jobs[index];
+
+        parser_seek(view, job->start);
+        job->body = parser_parse_block(view);
+        job->matched = job->body != NULL && job->body->type != NODE_ERROR &&
+                       !view->panic_mode && view->position == job->end + 1;
+    }
+
+    ast_arena = NULL;
+    return NULL;
+}
+
+typedef struct {
+    Error* error;
+    int order;
+} PendingDiagnostic;
+
+static int parser_compare_diagnostics(const void* a, const void* b) {
+    const PendingDiagnostic* left = a;
+    const PendingDiagnostic* right = b;
+
+    if (left->error->line != right->error->line) return left->error->line - right->error->line;
+    if (left->error->column != right->error->column) return left->error->column - right->error->column;
+    return left->order - right->order;
+}
+
+// Merges worker diagnostics into the parser's in source order, keeping the
+// first PARSER_MAX_DIAGNOSTICS and counting the rest
+static void parser_merge_diagnostics(Parser* parser, BodyWorker* workers, int worker_count) {
+    int total = parser->diagnostic_count;
+    for (int i = 0; i < worker_count; i++) {
+        total += workers[i].view.diagnostic_count;
+        parser->suppressed_error_count += workers[i].view.suppressed_error_count;
+        parser->had_error = parser->had_error || workers[i].view.had_error;
+    }
+    if (total == parser->diagnostic_count) return;
+
+    PendingDiagnostic* pending;
+    SAFE_MALLOC(pending, sizeof(PendingDiagnostic) * total);
+
+    int count = 0;
+    for (int i = 0; i < parser->diagnostic_count; i++) {
+        pending[count] = (PendingDiagnostic){ parser->diagnostics[i], count };
+        count++;
+    }
+    for (int i = 0; i < worker_count; i++) {
+        Parser* view = &workers[i].view;
+        for (int j = 0; j < view->diagnostic_count; j++) {
+            pending[count] = (PendingDiagnostic){ view->diagnostics[j], count };
+            count++;
+        }
+        free(view->diagnostics);
+        view->diagnostics = NULL;
+        view->diagnostic_count = 0;
+    }
+
+    qsort(pending, total, sizeof(PendingDiagnostic), parser_compare_diagnostics);
+
+    if (parser->diagnostics == NULL) {
+        SAFE_MALLOC(parser->diagnostics, sizeof(Error*) * PARSER_MAX_DIAGNOSTICS);
+    }
+
+    int kept = MIN(total, PARSER_MAX_DIAGNOSTICS);
+    for (int i = 0; i < total; i++) {
+        if (i < kept) {
+            parser->diagnostics[i] = pending[i].error;
+        } else {
+            error_free(pending[i].error);
+        }
+    }
+    parser->diagnostic_count = kept;
+    parser->suppressed_error_count += total - kept;
+    parser->last_error = parser->diagnostics[kept - 1];
+
+    free(pending);
+}
+
+ASTNode* parser_parse_program_parallel(Parser* parser, int thread_count) {
+    if (parser == NULL) return NULL;
+    if (thread_count < 1) thread_count = 1;
+
+    int start_position = parser->position;
+    ASTNode* program = parser_parse_program_lazy(parser);
+    if (program == NULL) return NULL;
+
+    int job_count = 0;
+    BodyJob* jobs;
+    SAFE_MALLOC(jobs, sizeof(BodyJob) * MAX(1, program->data.block.statement_count));
+
+    for (int i = 0; i < program->data.block.statement_count; i++) {
+        ASTNode* function = program->data.block.statements[i];
+        if (function->type != NODE_FUNCTION_DECLARATION || function->data.function.body_parser == NULL) continue;
+
+        jobs[job_count++] = (BodyJob){ function, function->data.function.body_start,
+                                       function->data.function.body_end, NULL, false };
+    }
+
+    int worker_count = MAX(1, MIN(thread_count, job_count));
+    BodyQueue queue = { parser, jobs, job_count, 0 };
+    BodyWorker* workers;
+    SAFE_MALLOC(workers, sizeof(BodyWorker) * worker_count);
+
+    Arena** arenas = realloc(parser->arenas, sizeof(Arena*) * (parser->arena_count + worker_count));
+    if (arenas == NULL) {
+        fprintf(stderr, "Memory allocation failed: %zu bytes at %s:%d\n",
+                sizeof(Arena*) * (parser->arena_count + worker_count), __FILE__, __LINE__);
+        exit(EXIT_FAILURE);
+    }
+    parser->arenas = arenas;
+
+    for (int i = 0; i < worker_count; i++) {
+        workers[i].queue = &queue;
+        workers[i].arena = arena_create(0);
+        parser->arenas[parser->arena_count++] = workers[i].arena;
+        parser_view_init(&workers[i].view, parser);
+    }
+
+    // The calling thread works too, so one thread never spawns anything
+    pthread_t* threads;
+    SAFE_MALLOC(threads, sizeof(pthread_t) * worker_count);
+    int spawned = 1;
+    for (; spawned < worker_count; spawned++) {
+        if (pthread_create(&threads[spawned], NULL, parser_body_worker, &workers[spawned]) != 0) break;
+    }
+    parser_body_worker(&workers[0]);
+    for (int i = 1; i < spawned; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    // Workers that failed to start leave their jobs to the ones that did
+    for (int i = spawned; i < worker_count; i++) {
+        parser_body_worker(&workers[i]);
+    }
+    free(threads);
+
+    bool matched = true;
+    for (int i = 0; i < job_count; i++) {
+        jobs[i].function->data.function.body = jobs[i].body;
+        jobs[i].function->data.function.body_parser = NULL;
+        matched = matched && jobs[i].matched;
+    }
+
+    parser_merge_diagnostics(parser, workers, worker_count);
+    for (int i = 0; i < worker_count; i++) {
+        free(workers[i].view.diagnostics);
+        free(workers[i].view.scratch);
+    }
+    free(workers);
+    free(jobs);
+
+    // A body the workers could not parse to its skimmed '}' would have shifted
+    // what follows, so start over sequentially
+    if (!matched) {
+        ast_node_free(program);
+        parser_clear_error(parser);
+        parser_seek(parser, start_position);
+        return parser_parse_program(parser);
+    }
+
+    return program;
+}
+
+// Incremental reparsing. The edit is widened to whole lines and to the
+// smallest statement list (a block, or the program) whose items can be
+// replaced without touching its braces. Only the tokens on those lines are
+// lexed again and only the items on them are parsed again; every other
+// subtree and token is kept. Anything the fast path cannot prove equivalent
+// to a fresh parse (syntax errors, unbalanced braces, a lexer state that
+// spills past the region) falls back to parsing the whole buffer.
+typedef struct {
+    Parser* parser;
+    Lexer* lexer;
+    const TextEdit* edit;
+    int line_delta;          // Lines added (negative: removed) by the edit
+    int token_delta;         // Tokens added or removed by the edit
+    int first_shifted;       // Stream index from which tokens moved
+} Reparse;
+
+static int ast_first_line(ASTNode* node) {
+    return node->first_token ? node->first_token->line : node->line;
+}
+
+static int ast_last_line(ASTNode* node) {
+    return node->last_token ? node->last_token->line : node->line;
+}
+
+// Moves a reused subtree below the edit to its new lines. Lazily parsed
+// bodies also move in the token stream.
+static void ast_node_shift(ASTNode* node, Reparse* reparse) {
+    if (node == NULL) return;
+
+    node->line += reparse->line_delta;
+
+    switch (node->type) {
+        case NODE_BINARY_EXPRESSION:
+        case NODE_ASSIGNMENT_EXPRESSION:
+            ast_node_shift(node->data.binary.left, reparse);
+            ast_node_shift(node->data.binary.right, reparse);
+            break;
+        case NODE_UNARY_EXPRESSION:
+            ast_node_shift(node->data.unary.operand, reparse);
+            break;
+        case NODE_CALL_EXPRESSION:
+            ast_node_shift(node->data.call.callee, reparse);
+            for (int i = 0; i < node->data.call.argument_count; i++) {
+                ast_node_shift(node->data.call.arguments[i], reparse);
+            }
+            break;
+        case NODE_VARIABLE_DECLARATION:
+            ast_node_shift(node->data.declaration.initializer, reparse);
+            break;
+        case NODE_FUNCTION_DECLARATION:
+            for (int i = 0; i < node->data.function.parameter_count; i++) {
+                ast_node_shift(node->data.function.parameters[i], reparse);
+            }
+            ast_node_shift(node->data.function.body, reparse);
+            if (node->data.function.body_parser != NULL) {
+                node->data.function.body_start += reparse->token_delta;
+                node->data.function.body_end += reparse->token_delta;
+            }
+            break;
+        case NODE_PROGRAM:
+        case NODE_BLOCK_STATEMENT:
+            for (int i = 0; i < node->data.block.statement_count; i++) {
+                ast_node_shift(node->data.block.statements[i], reparse);
+            }
+            break;
+        case NODE_IF_STATEMENT:
+        case NODE_WHILE_STATEMENT:
+            ast_node_shift(node->data.conditional.condition, reparse);
+            ast_node_shift(node->data.conditional.then_branch, reparse);
+            ast_node_shift(node->data.conditional.else_branch, reparse);
+            break;
+        case NODE_RETURN_STATEMENT:
+        case NODE_EXPRESSION_STATEMENT:
+            ast_node_shift(node->data.statement.expression, reparse);
+            break;
+        default:
+            break;
+    }
+}
+
+// Only lines and lazy token ranges move; nothing needs doing for an edit
+// that keeps both
+static void ast_node_shift_after_edit(ASTNode* node, Reparse* reparse) {
+    if (reparse->line_delta == 0 && reparse->token_delta == 0) return;
+
+    if (reparse->line_delta == 0) {
+        // Just the token ranges of lazily parsed bodies
+        if (node->type == NODE_FUNCTION_DECLARATION && node->data.function.body_parser != NULL) {
+            node->data.function.body_start += reparse->token_delta;
+            node->data.function.body_end += reparse->token_delta;
+        }
+        return;
+    }
+
+    ast_node_shift(node, reparse);
+}
+
+// First stream index whose token is on or after line
+static int parser_first_token_on_line(Parser* parser, int line) {
+    int low = 0;
+    int high = parser->stream->count - 1;   // EOF is past every line
+
+    while (low < high) {
+        int middle = (low + high) / 2;
+        if (parser->stream->tokens[middle]->line < line) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+// Relexes new lines first_line..last_line into a fresh EOF-terminated stream.
+// Fails unless the token after them is the old token at resume, moved by
+// the edit, which shows the lexer is back in step with the old stream.
+static TokenStream* parser_relex_lines(Reparse* reparse, int first_line, int last_line, int resume) {
+    Lexer* lexer = reparse->lexer;
+    if (!lexer_seek_line(lexer, first_line)) return NULL;
+
+    TokenStream* region;
+    SAFE_MALLOC(region, sizeof(TokenStream));
+    region->count = 0;
+    region->capacity = 16;
+    SAFE_MALLOC(region->tokens, sizeof(Token*) * region->capacity);
+
+    Token* next = NULL;
+    while (true) {
+        Token* token = lexer_next_token(lexer);
+        if (token == NULL) {
+            token_stream_free(region);
+            return NULL;
+        }
+        if (token->type == TOKEN_NEWLINE) {
+            token_free(token);
+            continue;
+        }
+        if (token->type == TOKEN_EOF || token->line > last_line) {
+            next = token;
+            break;
+        }
+
+        if (region->count + 1 >= region->capacity) {
+            region->capacity *= 2;
+            SAFE_REALLOC(region->tokens, sizeof(Token*) * region->capacity);
+        }
+        region->tokens[region->count++] = token;
+    }
+
+    Token* old = reparse->parser->stream->tokens[resume];
+    bool in_step = next->type == old->type &&
+                   next->line == old->line + reparse->line_delta &&
+                   next->column == old->column &&
+                   strcmp(next->lexeme, old->lexeme) == 0;
+    if (!in_step) {
+        token_free(next);
+        token_stream_free(region);
+        return NULL;
+    }
+
+    // The token after the region doubles as its EOF so the parser stops there
+    token_free(next);
+    region->tokens[region->count++] = token_create(TOKEN_EOF, "", last_line + 1, 1);
+    return region;
+}
+
+// Replaces items first..last of list (lines first_line..last_line) with a
+// parse of the edited lines. Returns false, changing nothing, if that cannot
+// be done exactly.
+static bool parser_reparse_items(Reparse* reparse, ASTNode* list, int first, int last,
+                                 int first_line, int last_line) {
+    Parser* parser = reparse->parser;
+    bool top_level = list->type == NODE_PROGRAM;
+
+    int old_start = parser_first_token_on_line(parser, first_line);
+    int old_end = parser_first_token_on_line(parser, last_line + 1);
+
+    TokenStream* region = parser_relex_lines(reparse, first_line, last_line + reparse->line_delta, old_end);
+    if (region == NULL) return false;
+
+    Parser view;
+    parser_view_init(&view, parser);
+    view.stream = region;
+    parser_seek(&view, 0);
+
+    int mark = view.scratch_count;
+    while (!parser_check(&view, TOKEN_EOF) && (top_level || !parser_check(&view, TOKEN_RIGHT_BRACE))) {
+        if (parser_match(&view, TOKEN_SEMICOLON)) continue;
+        parser_scratch_push(&view, parser_parse_recovering(&view, top_level));
+    }
+
+    int new_count = 0;
+    ASTNode** items = parser_scratch_take(&view, mark, &new_count);
+    bool clean = !view.had_error && parser_check(&view, TOKEN_EOF);
+
+    if (!clean) {
+        for (int i = 0; i < new_count; i++) {
+            ast_node_free(items[i]);
+        }
+        free(items);
+        parser_clear_error(&view);
+        free(view.scratch);
+        token_stream_free(region);
+        return false;
+    }
+    free(view.scratch);
+
+    // Swap the items
+    int old_count = list->data.block.statement_count;
+    int removed = last - first + 1;
+    int count = old_count - removed + new_count;
+    ASTNode** statements = NULL;
+    if (count > 0) {
+        SAFE_MALLOC(statements, sizeof(ASTNode*) * count);
+        memcpy(statements, list->data.block.statements, sizeof(ASTNode*) * first);
+        memcpy(statements + first, items, sizeof(ASTNode*) * new_count);
+        memcpy(statements + first + new_count, list->data.block.statements + last + 1,
+               sizeof(ASTNode*) * (old_count - last - 1));
+    }
+    for (int i = first; i <= last; i++) {
+        ast_node_free(list->data.block.statements[i]);
+    }
+    free(list->data.block.statements);
+    free(items);
+    list->data.block.statements = statements;
+    list->data.block.statement_count = count;
+
+    // Swap the tokens; the region's EOF stand-in is dropped
+    TokenStream* stream = parser->stream;
+    int region_count = region->count - 1;
+    token_free(region->tokens[region_count]);
+    for (int i = old_start; i < old_end; i++) {
+        token_free(stream->tokens[i]);
+    }
+
+    reparse->token_delta = region_count - (old_end - old_start);
+    int total = stream->count + reparse->token_delta;
+    if (total > stream->capacity) {
+        stream->capacity = total;
+        SAFE_REALLOC(stream->tokens, sizeof(Token*) * stream->capacity);
+    }
+    memmove(stream->tokens + old_start + region_count, stream->tokens + old_end,
+            sizeof(Token*) * (stream->count - old_end));
+    memcpy(stream->tokens + old_start, region->tokens, sizeof(Token*) * region_count);
+    stream->count = total;
+
+    free(region->tokens);
+    free(region);
+
+    reparse->first_shifted = old_start + region_count;
+    if (reparse->line_delta != 0) {
+        for (int i = reparse->first_shifted; i < stream->count; i++) {
+            stream->tokens[i]->line += reparse->line_delta;
+        }
+    }
+
+    for (int i = first + new_count; i < count; i++) {
+        ast_node_shift_after_edit(statements[i], reparse);
+    }
+    return true;
+}
+
+// The block nested in item that strictly contains the edited lines, if any
+static ASTNode* parser_reparse_inner_block(ASTNode* item, const TextEdit* edit, ASTNode** after) {
+    ASTNode* candidates[2] = { NULL, NULL };
+    *after = NULL;
+
+    switch (item->type) {
+        case NODE_BLOCK_STATEMENT:
+            candidates[0] = item;
+            break;
+        case NODE_FUNCTION_DECLARATION:
+            candidates[0] = ast_function_body(item);
+            break;
+        case NODE_IF_STATEMENT:
+        case NODE_WHILE_STATEMENT:
+            candidates[0] = item->data.conditional.then_branch;
+            candidates[1] = item->data.conditional.else_branch;
+            break;
+        default:
+            break;
+    }
+
+    for (int i = 0; i < 2; i++) {
+        ASTNode* block = candidates[i];
+        if (block == NULL || block->type != NODE_BLOCK_STATEMENT || block->first_token == NULL) continue;
+
+        if (ast_first_line(block) < edit->start_line && edit->old_end_line < ast_last_line(block)) {
+            // An else branch after the block moves with the edit
+            if (i == 0) *after = candidates[1];
+            return block;
+        }
+    }
+    return NULL;
+}
+
+// Applies the edit inside list, descending into the innermost block that
+// contains it. Returns false if list's own braces would have to be reparsed.
+static bool parser_reparse_list(Reparse* reparse, ASTNode* list) {
+    const TextEdit* edit = reparse->edit;
+    ASTNode** items = list->data.block.statements;
+    int count = list->data.block.statement_count;
+
+    // first: first item ending on or after the edit; last: last item
+    // starting on or before its end (last < first when it falls between items)
+    int low = 0, high = count;
+    while (low < high) {
+        int middle = (low + high) / 2;
+        if (ast_last_line(items[middle]) < edit->start_line) low = middle + 1; else high = middle;
+    }
+    int first = low;
+
+    low = first;
+    high = count;
+    while (low < high) {
+        int middle = (low + high) / 2;
+        if (ast_first_line(items[middle]) <= edit->old_end_line) low = middle + 1; else high = middle;
+    }
+    int last = low - 1;
+
+    if (first == last) {
+        ASTNode* after = NULL;
+        ASTNode* inner = parser_reparse_inner_block(items[first], edit, &after);
+        if (inner != NULL && parser_reparse_list(reparse, inner)) {
+            if (after != NULL) ast_node_shift_after_edit(after, reparse);
+            for (int i = first + 1; i < count; i++) {
+                ast_node_shift_after_edit(items[i], reparse);
+            }
+            return true;
+        }
+    }
+
+    // Widen to whole lines, taking in items that share a line with the range
+    int first_line = edit->start_line;
+    int last_line = edit->old_end_line;
+    if (first <= last) {
+        first_line = MIN(first_line, ast_first_line(items[first]));
+        last_line = MAX(last_line, ast_last_line(items[last]));
+    }
+    while (first > 0 && ast_last_line(items[first - 1]) >= first_line) {
+        first--;
+        first_line = MIN(first_line, ast_first_line(items[first]));
+    }
+    while (last < count - 1 && ast_first_line(items[last + 1]) <= last_line) {
+        last++;
+        last_line = MAX(last_line, ast_last_line(items[last]));
+    }
+
+    if (list->type == NODE_BLOCK_STATEMENT &&
+        (first_line <= ast_first_line(list) || last_line >= ast_last_line(list))) {
+        return false;
+    }
+
+    return parser_reparse_items(reparse, list, first, last, first_line, last_line);
+}
+
+// Parses the whole buffer again, keeping the parser's mode
+static ASTNode* parser_reparse_all(Parser* parser, ASTNode* program, Lexer* lexer) {
+    ast_node_free(program);
+
+    bool hash_consing = parser->expr_table != NULL;
+    expr_table_free(parser->expr_table);
+    parser->expr_table = NULL;
+    for (int i = 0; i < parser->arena_count; i++) {
+        arena_free(parser->arenas[i]);
+    }
+    free(parser->arenas);
+    parser->arenas = NULL;
+    parser->arena_count = 0;
+
+    parser_clear_error(parser);
+    token_stream_free(parser->stream);
+    parser->generation++;
+
+    lexer_seek_line(lexer, 1);
+    parser->lexer = lexer;
+    parser->stream = lexer_tokenize(lexer);
+    parser->scratch_count = 0;
+    parser_seek(parser, 0);
+
+    if (hash_consing) parser_enable_hash_consing(parser);
+    return parser_parse_program(parser);
+}
+
+// Brings program, parsed by parser, up to date with an edit. lexer holds the
+// whole edited source and replaces the parser's lexer. Returns the updated
+// program, which is program itself unless the whole buffer was reparsed;
+// either way the result equals a fresh parse of the edited source.
+ASTNode* parser_reparse(Parser* parser, ASTNode* program, Lexer* lexer, const TextEdit* edit) {
+    if (parser == NULL || lexer == NULL || edit == NULL) return NULL;
+
+    // Error recovery, shared nodes and arenas make reuse unsafe
+    bool reusable = program != NULL && program->type == NODE_PROGRAM &&
+                    !parser->had_error && parser->expr_table == NULL && parser->arena_count == 0 &&
+                    edit->start_line >= 1 && edit->old_end_line >= edit->start_line &&
+                    edit->new_end_line >= edit->start_line - 1;
+
+    if (reusable) {
+        Reparse reparse = { parser, lexer, edit, edit->new_end_line - edit->old_end_line, 0, 0 };
+        if (parser_reparse_list(&reparse, program)) {
+            parser->lexer = lexer;
+            parser_seek(parser, parser->stream->count - 1);
+            return program;
+        }
+    }
+
+    return parser_reparse_all(parser, program, lexer);
+}
+
+Error* parser_get_last_error(Parser* parser) {
+    return parser ? parser->last_error : NULL;
+}
+
+Error* parser_get_diagnostic(Parser* parser, int index) {
+    if (parser == NULL || index < 0 || index >= parser->diagnostic_count) return NULL;
+    return parser->diagnostics[index];
+}
+
+int parser_get_diagnostic_count(Parser* parser) {
+    return parser ? parser->diagnostic_count : 0;
+}
+
+// Total number of syntax errors, including those past PARSER_MAX_DIAGNOSTICS
+int parser_get_error_count(Parser* parser) {
+    return parser ? parser->diagnostic_count + parser->suppressed_error_count : 0;
+}
+
+bool parser_had_error(Parser* parser) {
+    return parser ? parser->had_error : false;
+}
+
+void parser_clear_error(Parser* parser) {
+    if (parser) {
+        for (int i = 0; i < parser->diagnostic_count; i++) {
+            error_free(parser->diagnostics[i]);
+        }
+        free(parser->diagnostics);
+
+        parser->diagnostics = NULL;
+        parser->diagnostic_count = 0;
+        parser->suppressed_error_count = 0;
+        parser->panic_mode = false;
+        parser->had_error = false;
+        parser->last_error = NULL;
+    }
+}
+
+// Token stream helpers
+static void parser_seek(Parser* parser, int position) {
+    TokenStream* stream = parser->stream;
+    parser->position = MIN(position, stream->count - 1);
+    parser->current_token = stream->tokens[parser->position];
+    parser->peek_token = stream->tokens[MIN(parser->position + 1, stream->count - 1)];
+}
+
+static void parser_advance(Parser* parser) {
+    TokenStream* stream = parser->stream;
+    if (parser->position < stream->count - 1) {
+        parser->position++;
+    }
+
+    parser->current_token = stream->tokens[parser->position];
+    parser->peek_token = stream->tokens[MIN(parser->position + 1, stream->count - 1)];
+}
+
+static bool parser_check(Parser* parser, TokenType type) {
+    return parser->current_token != NULL && parser->current_token->type == type;
+}
+
+// A missing ';' is reported after the token it should have followed
+static Token* parser_previous_token(Parser* parser) {
+    return parser->stream->tokens[MAX(parser->position - 1, 0)];
+}
+
+static bool parser_match(Parser* parser, TokenType type) {
+    if (!parser_check(parser, type)) return false;
+
+    parser_advance(parser);
+    return true;
+}
+
+// Records a syntax error at token and returns an error node for it. While in
+// panic mode follow-on errors are dropped; past PARSER_MAX_DIAGNOSTICS they are
+// only counted, so diagnostic memory stays bounded however broken the input.
+static ASTNode* parser_error(Parser* parser, Token* token, const char* message) {
+    parser->had_error = true;
+
+    if (!parser->panic_mode) {
+        parser->panic_mode = true;
+
+        if (parser->diagnostic_count < PARSER_MAX_DIAGNOSTICS) {
+            if (parser->diagnostics == NULL) {
+                SAFE_MALLOC(parser->diagnostics, sizeof(Error*) * PARSER_MAX_DIAGNOSTICS);
+            }
+
+            Error* error = error_create(ERROR_SYNTAX, message,
+                                        token ? token->line : 0,
+                                        token ? token->column : 0,
+                                        token ? token->lexeme : NULL);
+            parser->diagnostics[parser->diagnostic_count++] = error;
+            parser->last_error = error;
+        } else {
+            parser->suppressed_error_count++;
+        }
+    }
+
+    return ast_node_create(NODE_ERROR, token);
+}
+
+// Panic-mode recovery: skip past the next ';' or stop before a '}' or a token
+// that starts a statement or declaration
+static void parser_synchronize(Parser* parser) {
+    parser->panic_mode = false;
+
+    while (!parser_check(parser, TOKEN_EOF)) {
+        if (parser_match(parser, TOKEN_SEMICOLON)) return;
+
+        switch (parser->current_token->type) {
+            case TOKEN_RIGHT_BRACE:
+            case TOKEN_LEFT_BRACE:
+            case TOKEN_IF:
+            case TOKEN_WHILE:
+            case TOKEN_FOR:
+            case TOKEN_RETURN:
+                return;
+            default:
+                if (parser_is_type_keyword(parser->current_token->type)) return;
+                parser_advance(parser);
+                break;
+        }
+    }
+}
+
+// Parses a declaration (top level) or statement. On a syntax error the error
+// node stands in for it and the parser resynchronizes. At least one token is
+// consumed per failure, which keeps recovery linear in the input size.
+static ASTNode* parser_parse_recovering(Parser* parser, bool top_level) {
+    int start = parser->position;
+    int locals = parser->local_count;
+
+    ASTNode* node = parser_recover(parser, start,
+                                   top_level ? parser_parse_declaration(parser) : parser_parse_statement(parser));
+    if (node != NULL && node->type == NODE_ERROR) {
+        parser->local_count = locals;   // Declarations in it were freed with it
+    }
+    if (node != NULL) {
+        node->first_token = parser->stream->tokens[start];
+        node->last_token = parser_previous_token(parser);
+    }
+    return node;
+}
+
+// Resynchronizes after a failed parse that began at stream index start
+static ASTNode* parser_recover(Parser* parser, int start, ASTNode* node) {
+    if (node != NULL && node->type != NODE_ERROR) {
+        return node;
+    }
+
+    if (node == NULL) {
+        node = ast_node_create(NODE_ERROR, parser->current_token);
+    }
+
+    if (parser->position == start) {
+        parser_advance(parser);
+    }
+    parser_synchronize(parser);
+
+    return node;
+}
+
+static bool parser_is_type_keyword(TokenType type) {
+    switch (type) {
+        case TOKEN_INT:
+        case TOKEN_FLOAT:
+        case TOKEN_CHAR:
+        case TOKEN_BOOL:
+        case TOKEN_VOID:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Children are collected on a shared stack and copied out once their count is
+// known, so every block and argument list gets an exactly-sized array without
+// per-child reallocation or sibling links.
+static void parser_scratch_push(Parser* parser, ASTNode* node) {
+    if (parser->scratch_count >= parser->scratch_capacity) {
+        int new_capacity = parser->scratch_capacity > 0 ? parser->scratch_capacity * 2 : 64;
+        SAFE_REALLOC(parser->scratch, sizeof(ASTNode*) * new_capacity);
+        parser->scratch_capacity = new_capacity;
+    }
+
+    parser->scratch[parser->scratch_count++] = node;
+}
+
+static ASTNode** parser_scratch_take(Parser* parser, int mark, int* count) {
+    int taken = parser->scratch_count - mark;
+    parser->scratch_count = mark;
+    *count = taken;
+
+    if (taken <= 0) {
+        *count = 0;
+        return NULL;
+    }
+
+    ASTNode** nodes = ast_alloc(sizeof(ASTNode*) * taken);
+    memcpy(nodes, parser->scratch + mark, sizeof(ASTNode*) * taken);
+    return nodes;
+}
+
+static void parser_scratch_discard(Parser* parser, int mark) {
+    for (int i = mark; i < parser->scratch_count; i++) {
+        ast_node_free(parser->scratch[i]);
+    }
+    parser->scratch_count = mark;
+}
+
+// Declarations and statements
+static ASTNode* parser_parse_declaration(Parser* parser) {
+    if (parser_at_function_definition(parser)) {
+        Token* type_token = parser->current_token;
+        Token* name_token = parser->peek_token;
+        parser_advance(parser);
+        parser_advance(parser);
+        return parser_parse_function(parser, type_token, name_token);
+    }
+
+    return parser_parse_statement(parser);
+}
+
+// type name '(' starts a function definition
+static bool parser_at_function_definition(Parser* parser) {
+    if (!parser_is_type_keyword(parser->current_token->type) ||
+        parser->peek_token->type != TOKEN_IDENTIFIER) {
+        return false;
+    }
+
+    int next = MIN(parser->position + 2, parser->stream->count - 1);
+    return parser->stream->tokens[next]->type == TOKEN_LEFT_PAREN;
+}
+
+static ASTNode* parser_parse_function(Parser* parser, Token* type_token, Token* name_token) {
+    ASTNode* function = parser_parse_function_signature(parser, type_token, name_token);
+    if (function == NULL || function->type == NODE_ERROR) {
+        return function;
+    }
+
+    return parser_parse_function_body(parser, function);
+}
+
+// Parses the body of a function whose signature has been parsed. On failure
+// the function is released and the error node returned in its place.
+static ASTNode* parser_parse_function_body(Parser* parser, ASTNode* function) {
+    ASTNode* body = parser_parse_body_block(parser, function);
+    if (body == NULL || body->type == NODE_ERROR) {
+        ast_node_free(function);
+        return body;
+    }
+
+    function->data.function.body = body;
+    return function;
+}
+
+// Parses a function's body block. While hash-consing, the parameters are in
+// scope for it and its expressions are shared among themselves only.
+static ASTNode* parser_parse_body_block(Parser* parser, ASTNode* function) {
+    if (parser->expr_table == NULL) return parser_parse_block(parser);
+
+    int locals = parser->local_count;
+    for (int i = 0; i < function->data.function.parameter_count; i++) {
+        parser_declare_local(parser, function->data.function.parameters[i]);
+    }
+
+    parser->in_body = true;
+    ASTNode* body = parser_parse_block(parser);
+    parser->in_body = false;
+    parser->local_count = locals;
+    expr_table_retire_body(parser->expr_table);
+    return body;
+}
+
+// Parses the parameter list and stops at the body's '{'. The returned
+// function node has no body yet.
+static ASTNode* parser_parse_function_signature(Parser* parser, Token* type_token, Token* name_token) {
+    if (!parser_match(parser, TOKEN_LEFT_PAREN)) {
+        return parser_error(parser, parser->current_token, "Expected '(' after function name");
+    }
+
+    int mark = parser->scratch_count;
+
+    // (void) is an empty parameter list
+    if (parser_check(parser, TOKEN_VOID) && parser->peek_token->type == TOKEN_RIGHT_PAREN) {
+        parser_advance(parser);
+    }
+
+    if (!parser_check(parser, TOKEN_RIGHT_PAREN)) {
+        do {
+            Token* param_type = parser->current_token;
+            if (!parser_is_type_keyword(param_type->type)) {
+                parser_scratch_discard(parser, mark);
+                return parser_error(parser, param_type, "Expected parameter type");
+            }
+            parser_advance(parser);
+
+            Token* param_name = parser->current_token;
+            if (param_name->type != TOKEN_IDENTIFIER) {
+                parser_scratch_discard(parser, mark);
+                return parser_error(parser, param_name, "Expected parameter name");
+            }
+            parser_advance(parser);
+
+            parser_scratch_push(parser, ast_node_create_variable_declaration(
+                param_name, param_type->lexeme, param_name->lexeme, NULL));
+        } while (parser_match(parser, TOKEN_COMMA));
+    }
+
+    if (!parser_match(parser, TOKEN_RIGHT_PAREN)) {
+        parser_scratch_discard(parser, mark);
+        return parser_error(parser, parser->current_token, "Expected ')' after parameters");
+    }
+
+    if (!parser_check(parser, TOKEN_LEFT_BRACE)) {
+        parser_scratch_discard(parser, mark);
+        return parser_error(parser, parser->current_token, "Expected '{' before function body");
+    }
+
+    int parameter_count = 0;
+    ASTNode** parameters = parser_scratch_take(parser, mark, &parameter_count);
+
+    return ast_node_create_function(name_token, type_token->lexeme, name_token->lexeme,
+                                    parameters, parameter_count, NULL);
+}
+
+// Finds the '}' matching the '{' at the current position without building
+// any nodes. Returns its stream index, or -1 if the braces are unbalanced.
+static int parser_skim_block(Parser* parser) {
+    Token** tokens = parser->stream->tokens;
+    int depth = 0;
+
+    for (int i = parser->position; i < parser->stream->count; i++) {
+        switch (tokens[i]->type) {
+            case TOKEN_LEFT_BRACE:
+                depth++;
+                break;
+            case TOKEN_RIGHT_BRACE:
+                if (--depth == 0) return i;
+                break;
+            default:
+                break;
+        }
+    }
+
+    return -1;
+}
+
+static ASTNode* parser_parse_variable_declaration(Parser* parser, bool require_semicolon) {
+    Token* type_token = parser->current_token;
+    parser_advance(parser);
+
+    Token* name_token = parser->current_token;
+    if (name_token->type != TOKEN_IDENTIFIER) {
+        return parser_error(parser, name_token, "Expected variable name");
+    }
+    parser_advance(parser);
+
+    ASTNode* initializer = NULL;
+    if (parser_match(parser, TOKEN_ASSIGN)) {
+        initializer = parser_parse_expression(parser);
+        if (initializer == NULL || initializer->type == NODE_ERROR) {
+            return initializer;
+        }
+    }
+
+    if (!parser_match(parser, TOKEN_SEMICOLON) && require_semicolon) {
+        ast_node_free(initializer);
+        return parser_error(parser, parser_previous_token(parser), "Expected ';' after variable declaration");
+    }
+
+    // In scope from here on: the initializer cannot see the variable
+    ASTNode* declaration = ast_node_create_variable_declaration(name_token, type_token->lexeme,
+                                                                name_token->lexeme, initializer);
+    if (parser->expr_table != NULL && parser->scope_depth > 0) {
+        parser_declare_local(parser, declaration);
+    }
+    return declaration;
+}
+
+static ASTNode* parser_parse_statement(Parser* parser) {
+    switch (parser->current_token->type) {
+        case TOKEN_LEFT_BRACE:
+            return parser_parse_block(parser);
+        case TOKEN_IF:
+            return parser_parse_if(parser);
+        case TOKEN_WHILE:
+            return parser_parse_while(parser);
+        case TOKEN_RETURN:
+            return parser_parse_return(parser);
+        default:
+            if (parser_is_type_keyword(parser->current_token->type)) {
+                return parser_parse_variable_declaration(parser, true);
+            }
+            return parser_parse_expression_statement(parser);
+    }
+}
+
+static ASTNode* parser_parse_block(Parser* parser) {
+    Token* brace = parser->current_token;
+    if (!parser_match(parser, TOKEN_LEFT_BRACE)) {
+        return parser_error(parser, brace, "Expected '{'");
+    }
+
+    int mark = parser->scratch_count;
+    int locals = parser->local_count;
+    parser->scope_depth++;
+    while (!parser_check(parser, TOKEN_RIGHT_BRACE)) {
+        if (parser_check(parser, TOKEN_EOF)) {
+            // Keep what was parsed; panic mode stays set so enclosing
+            // blocks don't report the same missing '}' again
+            ast_node_free(parser_error(parser, parser->current_token, "Expected '}' to close block"));
+            break;
+        }
+
+        if (parser_match(parser, TOKEN_SEMICOLON)) continue;
+
+        parser_scratch_push(parser, parser_parse_recovering(parser, false));
+    }
+    parser_match(parser, TOKEN_RIGHT_BRACE);
+    parser->local_count = locals;
+    parser->scope_depth--;
+
+    int count = 0;
+    ASTNode** statements = parser_scratch_take(parser, mark, &count);
+    ASTNode* block = ast_node_create_block(brace, statements, count);
+    block->first_token = brace;
+    block->last_token = parser_previous_token(parser);
+    return block;
+}
+
+// Parses '(' expression ')' for if/while headers
+static ASTNode* parser_parse_condition(Parser* parser, const char* context) {
+    if (!parser_match(parser, TOKEN_LEFT_PAREN)) {
+        return parser_error(parser, parser->current_token, context);
+    }
+
+    ASTNode* condition = parser_parse_expression(parser);
+    if (condition == NULL || condition->type == NODE_ERROR) {
+        return condition;
+    }
+
+    if (!parser_match(parser, TOKEN_RIGHT_PAREN)) {
+        ast_node_free(condition);
+        return parser_error(parser, parser->current_token, "Expected ')' after condition");
+    }
+
+    return condition;
+}
+
+static ASTNode* parser_parse_if(Parser* parser) {
+    Token* if_token = parser->current_token;
+    parser_advance(parser);
+
+    ASTNode* condition = parser_parse_condition(parser, "Expected '(' after 'if'");
+    if (condition == NULL || condition->type == NODE_ERROR) {
+        return condition;
+    }
+
+    ASTNode* then_branch = parser_parse_statement(parser);
+    if (then_branch == NULL || then_branch->type == NODE_ERROR) {
+        ast_node_free(condition);
+        return then_branch;
+    }
+
+    ASTNode* else_branch = NULL;
+    if (parser_match(parser, TOKEN_ELSE)) {
+        else_branch = parser_parse_statement(parser);
+        if (else_branch == NULL || else_branch->type == NODE_ERROR) {
+            ast_node_free(condition);
+            ast_node_free(then_branch);
+            return else_branch;
+        }
+    }
+
+    return ast_node_create_if(if_token, condition, then_branch, else_branch);
+}
+
+static ASTNode* parser_parse_while(Parser* parser) {
+    Token* while_token = parser->current_token;
+    parser_advance(parser);
+
+    ASTNode* condition = parser_parse_condition(parser, "Expected '(' after 'while'");
+    if (condition == NULL || condition->type == NODE_ERROR) {
+        return condition;
+    }
+
+    ASTNode* body = parser_parse_statement(parser);
+    if (body == NULL || body->type == NODE_ERROR) {
+        ast_node_free(condition);
+        return body;
+    }
+
+    return ast_node_create_while(while_token, condition, body);
+}
+
+static ASTNode* parser_parse_return(Parser* parser) {
+    Token* return_token = parser->current_token;
+    parser_advance(parser);
+
+    ASTNode* value = NULL;
+    if (!parser_check(parser, TOKEN_SEMICOLON)) {
+        value = parser_parse_expression(parser);
+        if (value == NULL || value->type == NODE_ERROR) {
+            return value;
+        }
+    }
+
+    if (!parser_match(parser, TOKEN_SEMICOLON)) {
+        ast_node_free(value);
+        return parser_error(parser, parser_previous_token(parser), "Expected ';' after return statement");
+    }
+
+    return ast_node_create_return(return_token, value);
+}
+
+static ASTNode* parser_parse_expression_statement(Parser* parser) {
+    Token* start = parser->current_token;
+
+    ASTNode* expression = parser_parse_expression(parser);
+    if (expression == NULL || expression->type == NODE_ERROR) {
+        return expression;
+    }
+
+    if (!parser_match(parser, TOKEN_SEMICOLON)) {
+        ast_node_free(expression);
+        return parser_error(parser, parser_previous_token(parser), "Expected ';' after expression");
+    }
+
+    return ast_node_create_expression_statement(start, expression);
+}
+
+// AST Node functions
+// Hash-consing. Only nodes whose operands are already shared qualify, so
+// comparing operands by pointer compares them structurally.
+static const char* expr_key_text(ASTNode* node) {
+    switch (node->type) {
+        case NODE_BINARY_EXPRESSION: return node->data.binary.operator;
+        case NODE_UNARY_EXPRESSION: return node->data.unary.operator;
+        case NODE_IDENTIFIER: return node->data.identifier_name;
+        default: return node->token ? node->token->lexeme : "";
+    }
+}
+
+static ASTNode* expr_key_operand(ASTNode* node, int index) {
+    switch (node->type) {
+        case NODE_BINARY_EXPRESSION:
+            return index == 0 ? node->data.binary.left : node->data.binary.right;
+        case NODE_UNARY_EXPRESSION:
+            return index == 0 ? node->data.unary.operand : NULL;
+        default:
+            return NULL;
+    }
+}
+
+static uint64_t expr_hash(const ExprEntry* entry) {
+    ASTNode* node = entry->node;
+    const char* text = expr_key_text(node);
+    uint64_t hash = hash_bytes(text, strlen(text));
+
+    uintptr_t key[5] = {
+        (uintptr_t)node->type,
+        node->token ? (uintptr_t)node->token->type : 0,
+        (uintptr_t)expr_key_operand(node, 0),
+        (uintptr_t)expr_key_operand(node, 1),
+        (uintptr_t)entry->declaration
+    };
+
+    // Whole words are mixed at once; the shift brings pointer bits down to
+    // the low bits that pick the slot
+    for (int i = 0; i < 5; i++) {
+        hash = (hash ^ key[i]) * 0x9E3779B97F4A7C15ULL;
+        hash ^= hash >> 32;
+    }
+    return hash;
+}
+
+static bool expr_equal(const ExprEntry* a, const ExprEntry* b) {
+    if (a->hash != b->hash || a->declaration != b->declaration) return false;
+    if (a->node->type != b->node->type) return false;
+    if ((a->node->token ? a->node->token->type : 0) != (b->node->token ? b->node->token->type : 0)) return false;
+
+    return expr_key_operand(a->node, 0) == expr_key_operand(b->node, 0) &&
+           expr_key_operand(a->node, 1) == expr_key_operand(b->node, 1) &&
+           strcmp(expr_key_text(a->node), expr_key_text(b->node)) == 0;
+}
+
+#define EXPR_MAP_CAPACITY 64
+
+static void expr_map_init(ExprMap* map) {
+    map->count = 0;
+    map->capacity = EXPR_MAP_CAPACITY;
+    SAFE_CALLOC(map->slots, map->capacity, sizeof(ExprEntry));
+}
+
+static void expr_map_grow(ExprMap* map) {
+    int capacity = map->capacity * 2;
+    ExprEntry* slots;
+    SAFE_CALLOC(slots, capacity, sizeof(ExprEntry));
+
+    for (int i = 0; i < map->capacity; i++) {
+        if (map->slots[i].node == NULL) continue;
+
+        int slot = (int)(map->slots[i].hash & (uint64_t)(capacity - 1));
+        while (slots[slot].node != NULL) slot = (slot + 1) & (capacity - 1);
+        slots[slot] = map->slots[i];
+    }
+
+    free(map->slots);
+    map->slots = slots;
+    map->capacity = capacity;
+}
+
+// Moves the nodes of the body just parsed out of the lookup map; nothing
+// later can be equal to them
+static void expr_table_retire_body(ExprTable* table) {
+    ExprMap* body = &table->body;
+    if (table->retired_count + body->count > table->retired_capacity) {
+        int new_capacity = MAX(table->retired_capacity * 2, table->retired_count + body->count);
+        SAFE_REALLOC(table->retired, sizeof(ASTNode*) * new_capacity);
+        table->retired_capacity = new_capacity;
+    }
+
+    for (int i = 0; i < body->capacity; i++) {
+        if (body->slots[i].node != NULL) table->retired[table->retired_count++] = body->slots[i].node;
+    }
+
+    // A large body leaves the map at its initial size for the next one
+    if (body->capacity > EXPR_MAP_CAPACITY) {
+        free(body->slots);
+        expr_map_init(body);
+    } else {
+        memset(body->slots, 0, sizeof(ExprEntry) * body->capacity);
+        body->count = 0;
+    }
+}
 
-    return parser;
+static bool expr_is_pure(ASTNode* node) {
+    switch (node->type) {
+        case NODE_LITERAL:
+        case NODE_IDENTIFIER:
+            return true;
+        case NODE_UNARY_EXPRESSION:
+            return node->data.unary.operand->hash_consed;
+        case NODE_BINARY_EXPRESSION:
+            return node->data.binary.left->hash_consed && node->data.binary.right->hash_consed;
+        default:
+            return false;
+    }
 }
 
-void parser_free(Parser* parser) {
-    if (parser == NULL) return;
+// Puts a parameter or block-level variable in scope until its block closes
+static void parser_declare_local(Parser* parser, ASTNode* declaration) {
+    if (parser->local_count >= parser->local_capacity) {
+        int new_capacity = parser->local_capacity > 0 ? parser->local_capacity * 2 : 16;
+        SAFE_REALLOC(parser->locals, sizeof(ASTNode*) * new_capacity);
+        parser->local_capacity = new_capacity;
+    }
 
-    token_free(parser->current_token);
-    token_free(parser->peek_token);
-    error_free(parser->last_error);
-    free(parser);
+    parser->locals[parser->local_count++] = declaration;
 }
 
-ASTNode* parser_parse(Parser* parser) {
-    if (parser == NULL) return NULL;
+// The innermost local declaration of name in scope, or NULL for a global
+static ASTNode* parser_find_local(Parser* parser, const char* name) {
+    for (int i = parser->local_count - 1; i >= 0; i--) {
+        if (strcmp(parser->locals[i]->data.declaration.name, name) == 0) return parser->locals[i];
+    }
+    return NULL;
+}
+
+// Returns the shared node structurally equal to the freshly built node,
+// releasing node if one exists and registering node otherwise
+static ASTNode* parser_hash_cons(Parser* parser, ASTNode* node) {
+    ExprTable* table = parser->expr_table;
+    if (table == NULL || node == NULL || !expr_is_pure(node)) return node;
 
-    // Get first token from lexer
-    if (parser->current_token == NULL) {
-        parser->current_token = lexer_next_token(parser->lexer);
+    ExprMap* map = parser->in_body ? &table->body : &table->top_level;
+    if ((map->count + 1) * 2 > map->capacity) {
+        expr_map_grow(map);
     }
 
-    if (parser->current_token == NULL || parser->current_token->type == TOKEN_EOF) {
-        return ast_node_create(NODE_ERROR, NULL);
+    ExprEntry entry = { node, NULL, 0 };
+    if (node->type == NODE_IDENTIFIER) {
+        entry.declaration = parser_find_local(parser, node->data.identifier_name);
+    }
+    entry.hash = expr_hash(&entry);
+
+    int mask = map->capacity - 1;
+    int slot = (int)(entry.hash & (uint64_t)mask);
+    while (map->slots[slot].node != NULL) {
+        ASTNode* existing = map->slots[slot].node;
+        if (expr_equal(&map->slots[slot], &entry)) {
+            table->hits++;
+            ast_node_free(node);   // Its operands are shared and stay
+            return existing;
+        }
+        slot = (slot + 1) & mask;
     }
 
-    return parser_parse_expression(parser);
+    node->hash_consed = true;
+    map->slots[slot] = entry;
+    map->count++;
+    table->count++;
+    return node;
 }
 
-ASTNode* parser_parse_program(Parser* parser) {
-    if (parser == NULL) return NULL;
-
-    ASTNode* program = ast_node_create(NODE_PROGRAM, NULL);
-    if (program == NULL) return NULL;
-
-    return program;
+// Operands are table entries too, so each node is freed on its own
+static void expr_node_free(ASTNode* node) {
+    switch (node->type) {
+        case NODE_BINARY_EXPRESSION: free(node->data.binary.operator); break;
+        case NODE_UNARY_EXPRESSION: free(node->data.unary.operator); break;
+        case NODE_IDENTIFIER: free(node->data.identifier_name); break;
+        case NODE_LITERAL:
+            if (node->token && node->token->type == TOKEN_STRING_LITERAL) {
+                free(node->data.literal.string_value);
+            }
+            break;
+        default:
+            break;
+    }
+    if (node->owns_token) free(node->token);   // Lexeme shares the allocation
+    free(node);
 }
 
-Error* parser_get_last_error(Parser* parser) {
-    return parser ? parser->last_error : NULL;
+static void expr_map_free(ExprMap* map) {
+    for (int i = 0; i < map->capacity; i++) {
+        if (map->slots[i].node != NULL) expr_node_free(map->slots[i].node);
+    }
+    free(map->slots);
 }
 
-bool parser_had_error(Parser* parser) {
-    return parser ? parser->had_error : false;
+static void expr_table_free(ExprTable* table) {
+    if (table == NULL) return;
+
+    expr_map_free(&table->top_level);
+    expr_map_free(&table->body);
+    for (int i = 0; i < table->retired_count; i++) {
+        expr_node_free(table->retired[i]);
+    }
+    free(table->retired);
+    free(table);
 }
 
-void parser_clear_error(Parser* parser) {
-    if (parser) {
-        parser->had_error = false;
-        error_free(parser->last_error);
-        parser->last_error = NULL;
+// AST memory comes from the thread's arena when one is installed
+static void* ast_alloc(size_t size) {
+    if (ast_arena != NULL) {
+        return arena_alloc(ast_arena, size);
     }
+
+    void* memory;
+    SAFE_MALLOC(memory, size);
+    return memory;
+}
+
+static char* ast_strdup(const char* str) {
+    return ast_arena != NULL ? arena_strdup(ast_arena, str) : strdup_safe(str);
 }
 
-// AST Node functions
 ASTNode* ast_node_create(NodeType type, Token* token) {
-    ASTNode* node = malloc(sizeof(ASTNode));
+    ASTNode* node = ast_alloc(sizeof(ASTNode));
     if (node == NULL) return NULL;
 
     node->type = type;
@@ -90,6 +1789,16 @@ ASTNode* ast_node_create(NodeType type, Token* token) {
     node->last_child = NULL;
     node->next_sibling = NULL;
     node->prev_sibling = NULL;
+    node->first_token = NULL;
+    node->last_token = NULL;
+    node->arena_allocated = ast_arena != NULL;
+    node->hash_consed = false;
+    node->owns_token = false;
+    node->resolved_type = 0;
+    node->resolved_symbol = NULL;
+    node->resolved_slot = -1;
+    node->resolved_global = false;
+    node->range_facts = 0;
 
     // Initialize all fields in union to NULL/0
     memset(&node->data, 0, sizeof(node->data));
@@ -100,9 +1809,13 @@ ASTNode* ast_node_create(NodeType type, Token* token) {
 void ast_node_free(ASTNode* node) {
     if (node == NULL) return;
 
+    // Arena subtrees and shared expressions are released with their parser
+    if (node->arena_allocated || node->hash_consed) return;
+
     // Free based on node type
     switch (node->type) {
         case NODE_BINARY_EXPRESSION:
+        case NODE_ASSIGNMENT_EXPRESSION:
             ast_node_free(node->data.binary.left);
             ast_node_free(node->data.binary.right);
             free(node->data.binary.operator);
@@ -113,6 +1826,50 @@ void ast_node_free(ASTNode* node) {
             free(node->data.unary.operator);
             break;
 
+        case NODE_CALL_EXPRESSION:
+            ast_node_free(node->data.call.callee);
+            for (int i = 0; i < node->data.call.argument_count; i++) {
+                ast_node_free(node->data.call.arguments[i]);
+            }
+            free(node->data.call.arguments);
+            break;
+
+        case NODE_VARIABLE_DECLARATION:
+            free(node->data.declaration.name);
+            free(node->data.declaration.type_name);
+            ast_node_free(node->data.declaration.initializer);
+            break;
+
+        case NODE_FUNCTION_DECLARATION:
+            free(node->data.function.name);
+            free(node->data.function.return_type);
+            for (int i = 0; i < node->data.function.parameter_count; i++) {
+                ast_node_free(node->data.function.parameters[i]);
+            }
+            free(node->data.function.parameters);
+            ast_node_free(node->data.function.body);
+            break;
+
+        case NODE_PROGRAM:
+        case NODE_BLOCK_STATEMENT:
+            for (int i = 0; i < node->data.block.statement_count; i++) {
+                ast_node_free(node->data.block.statements[i]);
+            }
+            free(node->data.block.statements);
+            break;
+
+        case NODE_IF_STATEMENT:
+        case NODE_WHILE_STATEMENT:
+            ast_node_free(node->data.conditional.condition);
+            ast_node_free(node->data.conditional.then_branch);
+            ast_node_free(node->data.conditional.else_branch);
+            break;
+
+        case NODE_RETURN_STATEMENT:
+        case NODE_EXPRESSION_STATEMENT:
+            ast_node_free(node->data.statement.expression);
+            break;
+
         case NODE_LITERAL:
             if (node->token && node->token->type == TOKEN_STRING_LITERAL) {
                 free(node->data.literal.string_value);
@@ -127,7 +1884,8 @@ void ast_node_free(ASTNode* node) {
             break;
     }
 
-    token_free(node->token);
+    // Tokens are borrowed from the parser's token stream, except folded ones
+    if (node->owns_token) free(node->token);   // Lexeme shares the allocation
     free(node);
 }
 
@@ -137,17 +1895,41 @@ ASTNode* ast_node_create_binary(Token* token, ASTNode* left, ASTNode* right, con
 
     node->data.binary.left = left;
     node->data.binary.right = right;
-    node->data.binary.operator = strdup_safe(operator);
+    node->data.binary.operator = ast_strdup(operator);
+    node->data.binary.op = binary_operator_from_string(operator);
 
     return node;
 }
 
+BinaryOperator binary_operator_from_string(const char* op) {
+    if (op == NULL || op[0] == '\0') return OP_INVALID;
+
+    // Operators are at most two characters, so look at both at once
+    char second = op[1];
+    if (second != '\0' && op[2] != '\0') return OP_INVALID;
+    switch (op[0]) {
+        case '+': return second ? OP_INVALID : OP_ADD;
+        case '-': return second ? OP_INVALID : OP_SUBTRACT;
+        case '*': return second ? OP_INVALID : OP_MULTIPLY;
+        case '/': return second ? OP_INVALID : OP_DIVIDE;
+        case '%': return second ? OP_INVALID : OP_MODULO;
+        case '^': return second ? OP_INVALID : OP_BITWISE_XOR;
+        case '&': return second == '&' ? OP_LOGICAL_AND : second ? OP_INVALID : OP_BITWISE_AND;
+        case '|': return second == '|' ? OP_LOGICAL_OR : second ? OP_INVALID : OP_BITWISE_OR;
+        case '=': return second == '=' ? OP_EQUAL : OP_INVALID;
+        case '!': return second == '=' ? OP_NOT_EQUAL : OP_INVALID;
+        case '<': return second == '<' ? OP_SHIFT_LEFT : second == '=' ? OP_LESS_EQUAL : second ? OP_INVALID : OP_LESS;
+        case '>': return second == '>' ? OP_SHIFT_RIGHT : second == '=' ? OP_GREATER_EQUAL : second ? OP_INVALID : OP_GREATER;
+        default: return OP_INVALID;
+    }
+}
+
 ASTNode* ast_node_create_unary(Token* token, ASTNode* operand, const char* operator) {
     ASTNode* node = ast_node_create(NODE_UNARY_EXPRESSION, token);
     if (node == NULL) return NULL;
 
     node->data.unary.operand = operand;
-    node->data.unary.operator = strdup_safe(operator);
+    node->data.unary.operator = ast_strdup(operator);
 
     return node;
 }
@@ -172,7 +1954,7 @@ ASTNode* ast_node_create_literal_string(Token* token, const char* value) {
     ASTNode* node = ast_node_create(NODE_LITERAL, token);
     if (node == NULL) return NULL;
 
-    node->data.literal.string_value = strdup_safe(value);
+    node->data.literal.string_value = ast_strdup(value);
     return node;
 }
 
@@ -180,17 +1962,111 @@ ASTNode* ast_node_create_identifier(Token* token, const char* name) {
     ASTNode* node = ast_node_create(NODE_IDENTIFIER, token);
     if (node == NULL) return NULL;
 
-    node->data.identifier_name = strdup_safe(name);
+    node->data.identifier_name = ast_strdup(name);
     return node;
 }
 
+static bool ast_token_equal(Token* a, Token* b) {
+    if (a == NULL || b == NULL) return a == b;
+    return a->type == b->type && strcmp(a->lexeme, b->lexeme) == 0;
+}
+
+static bool ast_string_equal(const char* a, const char* b) {
+    if (a == NULL || b == NULL) return a == b;
+    return strcmp(a, b) == 0;
+}
+
+static bool ast_node_array_equal(ASTNode** a, int a_count, ASTNode** b, int b_count) {
+    if (a_count != b_count) return false;
+
+    for (int i = 0; i < a_count; i++) {
+        if (!ast_node_equal(a[i], b[i])) return false;
+    }
+    return true;
+}
+
+bool ast_node_equal(ASTNode* a, ASTNode* b) {
+    if (a == NULL || b == NULL) return a == b;
+    if (a->type != b->type || a->line != b->line || a->column != b->column) return false;
+    if (!ast_token_equal(a->token, b->token)) return false;
+
+    switch (a->type) {
+        case NODE_BINARY_EXPRESSION:
+        case NODE_ASSIGNMENT_EXPRESSION:
+            return ast_string_equal(a->data.binary.operator, b->data.binary.operator) &&
+                   ast_node_equal(a->data.binary.left, b->data.binary.left) &&
+                   ast_node_equal(a->data.binary.right, b->data.binary.right);
+
+        case NODE_UNARY_EXPRESSION:
+            return ast_string_equal(a->data.unary.operator, b->data.unary.operator) &&
+                   ast_node_equal(a->data.unary.operand, b->data.unary.operand);
+
+        case NODE_CALL_EXPRESSION:
+            return ast_node_equal(a->data.call.callee, b->data.call.callee) &&
+                   ast_node_array_equal(a->data.call.arguments, a->data.call.argument_count,
+                                        b->data.call.arguments, b->data.call.argument_count);
+
+        case NODE_VARIABLE_DECLARATION:
+            return ast_string_equal(a->data.declaration.name, b->data.declaration.name) &&
+                   ast_string_equal(a->data.declaration.type_name, b->data.declaration.type_name) &&
+                   a->data.declaration.is_mutable == b->data.declaration.is_mutable &&
+                   ast_node_equal(a->data.declaration.initializer, b->data.declaration.initializer);
+
+        case NODE_FUNCTION_DECLARATION:
+            return ast_string_equal(a->data.function.name, b->data.function.name) &&
+                   ast_string_equal(a->data.function.return_type, b->data.function.return_type) &&
+                   ast_node_array_equal(a->data.function.parameters, a->data.function.parameter_count,
+                                        b->data.function.parameters, b->data.function.parameter_count) &&
+                   ast_node_equal(a->data.function.body, b->data.function.body);
+
+        case NODE_PROGRAM:
+        case NODE_BLOCK_STATEMENT:
+            return ast_node_array_equal(a->data.block.statements, a->data.block.statement_count,
+                                        b->data.block.statements, b->data.block.statement_count);
+
+        case NODE_IF_STATEMENT:
+        case NODE_WHILE_STATEMENT:
+            return ast_node_equal(a->data.conditional.condition, b->data.conditional.condition) &&
+                   ast_node_equal(a->data.conditional.then_branch, b->data.conditional.then_branch) &&
+                   ast_node_equal(a->data.conditional.else_branch, b->data.conditional.else_branch);
+
+        case NODE_RETURN_STATEMENT:
+        case NODE_EXPRESSION_STATEMENT:
+            return ast_node_equal(a->data.statement.expression, b->data.statement.expression);
+
+        case NODE_LITERAL:
+            // The token lexeme already fixed the value
+            if (a->token && a->token->type == TOKEN_STRING_LITERAL) {
+                return ast_string_equal(a->data.literal.string_value, b->data.literal.string_value);
+            }
+            return a->data.literal.int_value == b->data.literal.int_value;
+
+        case NODE_IDENTIFIER:
+            return ast_string_equal(a->data.identifier_name, b->data.identifier_name);
+
+        default:
+            return true;
+    }
+}
+
 // Debug functions
 const char* node_type_to_string(NodeType type) {
     switch (type) {
         case NODE_PROGRAM: return "PROGRAM";
+        case NODE_FUNCTION_DECLARATION: return "FUNCTION_DECLARATION";
+        case NODE_VARIABLE_DECLARATION: return "VARIABLE_DECLARATION";
+        case NODE_PARAMETER_LIST: return "PARAMETER_LIST";
+        case NODE_BLOCK_STATEMENT: return "BLOCK_STATEMENT";
+        case NODE_EXPRESSION_STATEMENT: return "EXPRESSION_STATEMENT";
+        case NODE_RETURN_STATEMENT: return "RETURN_STATEMENT";
+        case NODE_IF_STATEMENT: return "IF_STATEMENT";
+        case NODE_WHILE_STATEMENT: return "WHILE_STATEMENT";
+        case NODE_ASSIGNMENT_EXPRESSION: return "ASSIGNMENT_EXPRESSION";
+        case NODE_BINARY_EXPRESSION: return "BINARY_EXPRESSION";
+        case NODE_UNARY_EXPRESSION: return "UNARY_EXPRESSION";
+        case NODE_CALL_EXPRESSION: return "CALL_EXPRESSION";
         case NODE_LITERAL: return "LITERAL";
         case NODE_IDENTIFIER: return "IDENTIFIER";
-        case NODE_BINARY_EXPRESSION: return "BINARY_EXPRESSION";
         case NODE_ERROR: return "ERROR";
         default: return "UNKNOWN";
     }
@@ -214,11 +2090,69 @@ void ast_node_print(ASTNode* node, int depth) {
         case NODE_IDENTIFIER:
             printf(" (%s)", node->data.identifier_name);
             break;
+        case NODE_BINARY_EXPRESSION:
+        case NODE_ASSIGNMENT_EXPRESSION:
+            printf(" (%s)", node->data.binary.operator);
+            break;
+        case NODE_UNARY_EXPRESSION:
+            printf(" (%s)", node->data.unary.operator);
+            break;
+        case NODE_VARIABLE_DECLARATION:
+            printf(" (%s %s)", node->data.declaration.type_name, node->data.declaration.name);
+            break;
+        case NODE_FUNCTION_DECLARATION:
+            printf(" (%s %s)", node->data.function.return_type, node->data.function.name);
+            break;
         default:
             break;
     }
 
     printf("\n");
+
+    // Print children based on node type
+    switch (node->type) {
+        case NODE_BINARY_EXPRESSION:
+        case NODE_ASSIGNMENT_EXPRESSION:
+            ast_node_print(node->data.binary.left, depth + 1);
+            ast_node_print(node->data.binary.right, depth + 1);
+            break;
+        case NODE_UNARY_EXPRESSION:
+            ast_node_print(node->data.unary.operand, depth + 1);
+            break;
+        case NODE_CALL_EXPRESSION:
+            ast_node_print(node->data.call.callee, depth + 1);
+            for (int i = 0; i < node->data.call.argument_count; i++) {
+                ast_node_print(node->data.call.arguments[i], depth + 1);
+            }
+            break;
+        case NODE_VARIABLE_DECLARATION:
+            ast_node_print(node->data.declaration.initializer, depth + 1);
+            break;
+        case NODE_FUNCTION_DECLARATION:
+            for (int i = 0; i < node->data.function.parameter_count; i++) {
+                ast_node_print(node->data.function.parameters[i], depth + 1);
+            }
+            ast_node_print(ast_function_body(node), depth + 1);
+            break;
+        case NODE_PROGRAM:
+        case NODE_BLOCK_STATEMENT:
+            for (int i = 0; i < node->data.block.statement_count; i++) {
+                ast_node_print(node->data.block.statements[i], depth + 1);
+            }
+            break;
+        case NODE_IF_STATEMENT:
+        case NODE_WHILE_STATEMENT:
+            ast_node_print(node->data.conditional.condition, depth + 1);
+            ast_node_print(node->data.conditional.then_branch, depth + 1);
+            ast_node_print(node->data.conditional.else_branch, depth + 1);
+            break;
+        case NODE_RETURN_STATEMENT:
+        case NODE_EXPRESSION_STATEMENT:
+            ast_node_print(node->data.statement.expression, depth + 1);
+            break;
+        default:
+            break;
+    }
 }
 
 // Expression parsing with proper operator precedence
@@ -227,8 +2161,34 @@ static ASTNode* parser_parse_expression(Parser* parser) {
         return ast_node_create(NODE_ERROR, NULL);
     }
 
-    // Parse at the lowest precedence level (addition/subtraction)
-    return parser_parse_expression_precedence(parser, 1);
+    return parser_parse_assignment(parser);
+}
+
+// Assignment is right-associative and binds loosest
+static ASTNode* parser_parse_assignment(Parser* parser) {
+    ASTNode* target = parser_parse_expression_precedence(parser, 1);
+    if (target == NULL || target->type == NODE_ERROR) {
+        return target;
+    }
+
+    if (!parser_check(parser, TOKEN_ASSIGN)) {
+        return target;
+    }
+
+    Token* assign_token = parser->current_token;
+    if (target->type != NODE_IDENTIFIER) {
+        ast_node_free(target);
+        return parser_error(parser, assign_token, "Invalid assignment target");
+    }
+    parser_advance(parser);
+
+    ASTNode* value = parser_parse_assignment(parser);
+    if (value == NULL || value->type == NODE_ERROR) {
+        ast_node_free(target);
+        return value;
+    }
+
+    return ast_node_create_assignment(assign_token, target, value);
 }
 
 // Parse expression at specific precedence level
@@ -237,7 +2197,7 @@ static ASTNode* parser_parse_expression_precedence(Parser* parser, int precedenc
         return ast_node_create(NODE_ERROR, NULL);
     }
 
-    ASTNode* left = parser_parse_primary(parser);
+    ASTNode* left = parser_parse_unary(parser);
     if (left == NULL || left->type == NODE_ERROR) {
         return left;
     }
@@ -254,28 +2214,86 @@ static ASTNode* parser_parse_expression_precedence(Parser* parser, int precedenc
         }
 
         Token* op_token = token;
-        char* operator = strdup_safe(op_token->lexeme);
 
         // Consume the operator
-        parser->current_token = lexer_next_token(parser->lexer);
+        parser_advance(parser);
 
         // Parse right side with higher precedence
         ASTNode* right = parser_parse_expression_precedence(parser, token_precedence + 1);
         if (right == NULL || right->type == NODE_ERROR) {
-            free(operator);
+            ast_node_free(left);
             return right;
         }
 
-        // Create binary expression node
-        ASTNode* binary = ast_node_create_binary(op_token, left, right, operator);
-        free(operator);
+        ASTNode* folded = parser->fold_constants ? parser_fold_binary(op_token, left, right) : NULL;
+        if (folded != NULL) {
+            ast_node_free(left);
+            ast_node_free(right);
+            left = parser_hash_cons(parser, folded);
+            continue;
+        }
 
-        left = binary;
+        // Create binary expression node
+        left = parser_hash_cons(parser, ast_node_create_binary(op_token, left, right, op_token->lexeme));
     }
 
     return left;
 }
 
+// Prefix operators: -x, !x, ~x
+static ASTNode* parser_parse_unary(Parser* parser) {
+    Token* token = parser->current_token;
+
+    if (token->type == TOKEN_MINUS || token->type == TOKEN_LOGICAL_NOT ||
+        token->type == TOKEN_BITWISE_NOT) {
+        parser_advance(parser);
+
+        ASTNode* operand = parser_parse_unary(parser);
+        if (operand == NULL || operand->type == NODE_ERROR) {
+            return operand;
+        }
+
+        ASTNode* folded = parser->fold_constants ? parser_fold_unary(token, operand) : NULL;
+        if (folded != NULL) {
+            ast_node_free(operand);
+            return parser_hash_cons(parser, folded);
+        }
+
+        return parser_hash_cons(parser, ast_node_create_unary(token, operand, token->lexeme));
+    }
+
+    return parser_parse_primary(parser);
+}
+
+// Parses the argument list of callee '(' ... ')'
+static ASTNode* parser_parse_call(Parser* parser, ASTNode* callee) {
+    Token* paren = parser->current_token;
+    parser_advance(parser); // consume '('
+
+    int mark = parser->scratch_count;
+    if (!parser_check(parser, TOKEN_RIGHT_PAREN)) {
+        do {
+            ASTNode* argument = parser_parse_expression(parser);
+            if (argument == NULL || argument->type == NODE_ERROR) {
+                parser_scratch_discard(parser, mark);
+                ast_node_free(callee);
+                return argument;
+            }
+            parser_scratch_push(parser, argument);
+        } while (parser_match(parser, TOKEN_COMMA));
+    }
+
+    if (!parser_match(parser, TOKEN_RIGHT_PAREN)) {
+        parser_scratch_discard(parser, mark);
+        ast_node_free(callee);
+        return parser_error(parser, parser->current_token, "Expected ')' after arguments");
+    }
+
+    int count = 0;
+    ASTNode** arguments = parser_scratch_take(parser, mark, &count);
+    return ast_node_create_call(paren, callee, arguments, count);
+}
+
 // Get operator precedence (higher number = higher precedence)
 static int parser_get_precedence(TokenType type) {
     switch (type) {
@@ -347,7 +2365,7 @@ static ASTNode* parser_parse_primary(Parser* parser) {
     // Handle parenthesized expressions
     if (token->type == TOKEN_LEFT_PAREN) {
         // Consume '('
-        parser->current_token = lexer_next_token(parser->lexer);
+        parser_advance(parser);
 
         // Parse the expression inside parentheses
         ASTNode* expr = parser_parse_expression(parser);
@@ -356,78 +2374,224 @@ static ASTNode* parser_parse_primary(Parser* parser) {
         }
 
         // Expect and consume ')'
-        Token* closing_paren = parser->current_token;
-        if (closing_paren == NULL || closing_paren->type != TOKEN_RIGHT_PAREN) {
-            parser->had_error = true;
-            parser->last_error = error_create(ERROR_SYNTAX, "Expected closing parenthesis",
-                                             closing_paren ? closing_paren->line : 0,
-                                             closing_paren ? closing_paren->column : 0,
-                                             closing_paren ? closing_paren->lexeme : NULL);
-            return ast_node_create(NODE_ERROR, closing_paren);
-        }
-
-        // Consume ')'
-        parser->current_token = lexer_next_token(parser->lexer);
+        if (!parser_match(parser, TOKEN_RIGHT_PAREN)) {
+            ast_node_free(expr);
+            return parser_error(parser, parser->current_token, "Expected closing parenthesis");
+        }
+
         return expr;
     }
 
+    ASTNode* node = NULL;
     switch (token->type) {
         case TOKEN_INTEGER_LITERAL:
-            {
-                ASTNode* node = ast_node_create_literal_int(token, token->literal.int_value);
-                // Advance to next token
-                parser->current_token = lexer_next_token(parser->lexer);
-                return node;
-            }
+            node = ast_node_create_literal_int(token, token->literal.int_value);
+            break;
 
         case TOKEN_FLOAT_LITERAL:
-            {
-                ASTNode* node = ast_node_create_literal_float(token, token->literal.float_value);
-                // Advance to next token
-                parser->current_token = lexer_next_token(parser->lexer);
-                return node;
-            }
+            node = ast_node_create_literal_float(token, token->literal.float_value);
+            break;
 
         case TOKEN_STRING_LITERAL:
-            {
-                ASTNode* node = ast_node_create_literal_string(token, token->literal.string_value);
-                // Advance to next token
-                parser->current_token = lexer_next_token(parser->lexer);
-                return node;
-            }
+            node = ast_node_create_literal_string(token, token->literal.string_value);
+            break;
+
+        case TOKEN_CHAR_LITERAL:
+            node = ast_node_create(NODE_LITERAL, token);
+            if (node) node->data.literal.char_value = token->literal.char_value;
+            break;
 
         case TOKEN_IDENTIFIER:
-            {
-                ASTNode* node = ast_node_create_identifier(token, token->lexeme);
-                // Advance to next token
-                parser->current_token = lexer_next_token(parser->lexer);
-                return node;
+            node = parser_hash_cons(parser, ast_node_create_identifier(token, token->lexeme));
+            parser_advance(parser);
+            if (parser_check(parser, TOKEN_LEFT_PAREN)) {
+                return parser_parse_call(parser, node);
             }
+            return node;
 
         case TOKEN_TRUE:
-            {
-                ASTNode* node = ast_node_create_literal_int(token, 1); // true = 1
-                // Advance to next token
-                parser->current_token = lexer_next_token(parser->lexer);
-                return node;
-            }
+            node = ast_node_create_literal_int(token, 1); // true = 1
+            break;
 
         case TOKEN_FALSE:
-            {
-                ASTNode* node = ast_node_create_literal_int(token, 0); // false = 0
-                // Advance to next token
-                parser->current_token = lexer_next_token(parser->lexer);
-                return node;
-            }
+            node = ast_node_create_literal_int(token, 0); // false = 0
+            break;
+
+        default:
+            return parser_error(parser, token, "Unexpected token in expression");
+    }
+
+    // Advance to next token
+    parser_advance(parser);
+    return parser_hash_cons(parser, node);
+}
+
+
+// Constant folding. Literal kinds follow their tokens: integer and float
+// literals, and true/false as booleans. Generated code computes integers
+// in 64 bits, but a literal holds an int, so an integer operation is only
+// folded when its exact result fits 32 bits; floats are single precision
+// with IEEE results, including infinities and NaN.
+typedef enum {
+    CONSTANT_NONE,
+    CONSTANT_INT,
+    CONSTANT_FLOAT,
+    CONSTANT_BOOL
+} ConstantKind;
+
+static ConstantKind constant_kind(ASTNode* node) {
+    if (node->type != NODE_LITERAL || node->token == NULL) return CONSTANT_NONE;
+
+    switch (node->token->type) {
+        case TOKEN_INTEGER_LITERAL: return CONSTANT_INT;
+        case TOKEN_FLOAT_LITERAL: return CONSTANT_FLOAT;
+        case TOKEN_TRUE:
+        case TOKEN_FALSE: return CONSTANT_BOOL;
+        default: return CONSTANT_NONE;
+    }
+}
+
+// Writes value in decimal to the end of a buffer, returning its start
+static char* format_int(char* end, int value) {
+    uint32_t magnitude = value < 0 ? 0u - (uint32_t)value : (uint32_t)value;
+    char* text = end;
+    *text = '\0';
+    do {
+        *--text = (char)('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude != 0);
+    if (value < 0) *--text = '-';
+    return text;
+}
 
+// Literal holding a folded value, at the operator's position. Its token
+// (with the lexeme in the same allocation) is not in the stream, so the
+// node owns it unless it lives in an arena.
+static ASTNode* ast_node_create_folded(Token* op, ConstantKind kind, int int_value, float float_value) {
+    char buffer[32];
+    const char* text;
+    TokenType type;
+    switch (kind) {
+        case CONSTANT_INT:
+            type = TOKEN_INTEGER_LITERAL;
+            text = format_int(buffer + sizeof(buffer) - 1, int_value);
+            break;
+        case CONSTANT_FLOAT:
+            type = TOKEN_FLOAT_LITERAL;
+            snprintf(buffer, sizeof(buffer), "%.9g", float_value);   // Round-trips a float
+            text = buffer;
+            break;
         default:
-            parser->had_error = true;
-            parser->last_error = error_create(ERROR_SYNTAX, "Unexpected token in expression",
-                                             token->line, token->column, token->lexeme);
-            return ast_node_create(NODE_ERROR, token);
+            type = int_value ? TOKEN_TRUE : TOKEN_FALSE;
+            text = int_value ? "true" : "false";
+            break;
+    }
+
+    size_t length = strlen(text);
+    Token* token = ast_alloc(sizeof(Token) + length + 1);
+    token->type = type;
+    token->lexeme = memcpy((char*)(token + 1), text, length + 1);
+    token->line = op->line;
+    token->column = op->column;
+
+    ASTNode* node = ast_node_create(NODE_LITERAL, token);
+    node->owns_token = !node->arena_allocated;
+    if (kind == CONSTANT_FLOAT) {
+        token->literal.float_value = float_value;
+        node->data.literal.float_value = float_value;
+    } else {
+        token->literal.int_value = int_value;
+        node->data.literal.int_value = int_value;
+    }
+    return node;
+}
+
+static ASTNode* parser_fold_int(Token* op, int64_t value) {
+    if (value < INT32_MIN || value > INT32_MAX) return NULL;
+    return ast_node_create_folded(op, CONSTANT_INT, (int32_t)value, 0);
+}
+
+static ASTNode* parser_fold_binary(Token* op, ASTNode* left, ASTNode* right) {
+    ConstantKind kind = constant_kind(left);
+    if (kind == CONSTANT_NONE || kind != constant_kind(right)) return NULL;
+
+    if (kind == CONSTANT_INT) {
+        // Exact in 64 bits: the operands are 32-bit
+        int64_t a = left->data.literal.int_value;
+        int64_t b = right->data.literal.int_value;
+
+        switch (op->type) {
+            case TOKEN_PLUS: return parser_fold_int(op, a + b);
+            case TOKEN_MINUS: return parser_fold_int(op, a - b);
+            case TOKEN_MULTIPLY: return parser_fold_int(op, a * b);
+            case TOKEN_DIVIDE:
+            case TOKEN_MODULO:
+                if (b == 0) return NULL;
+                return parser_fold_int(op, op->type == TOKEN_DIVIDE ? a / b : a % b);
+            case TOKEN_BITWISE_AND: return parser_fold_int(op, a & b);
+            case TOKEN_BITWISE_OR: return parser_fold_int(op, a | b);
+            case TOKEN_BITWISE_XOR: return parser_fold_int(op, a ^ b);
+            case TOKEN_LEFT_SHIFT:
+            case TOKEN_RIGHT_SHIFT:
+                if (b < 0 || b >= 32) return NULL;
+                return parser_fold_int(op, op->type == TOKEN_LEFT_SHIFT ? a * ((int64_t)1 << b) : a >> b);
+            case TOKEN_EQUAL: return ast_node_create_folded(op, CONSTANT_BOOL, a == b, 0);
+            case TOKEN_NOT_EQUAL: return ast_node_create_folded(op, CONSTANT_BOOL, a != b, 0);
+            case TOKEN_LESS: return ast_node_create_folded(op, CONSTANT_BOOL, a < b, 0);
+            case TOKEN_LESS_EQUAL: return ast_node_create_folded(op, CONSTANT_BOOL, a <= b, 0);
+            case TOKEN_GREATER: return ast_node_create_folded(op, CONSTANT_BOOL, a > b, 0);
+            case TOKEN_GREATER_EQUAL: return ast_node_create_folded(op, CONSTANT_BOOL, a >= b, 0);
+            default: return NULL;
+        }
+    }
+
+    if (kind == CONSTANT_FLOAT) {
+        float a = left->data.literal.float_value;
+        float b = right->data.literal.float_value;
+
+        switch (op->type) {
+            case TOKEN_PLUS: return ast_node_create_folded(op, kind, 0, a + b);
+            case TOKEN_MINUS: return ast_node_create_folded(op, kind, 0, a - b);
+            case TOKEN_MULTIPLY: return ast_node_create_folded(op, kind, 0, a * b);
+            case TOKEN_DIVIDE: return ast_node_create_folded(op, kind, 0, a / b);
+            case TOKEN_EQUAL: return ast_node_create_folded(op, CONSTANT_BOOL, a == b, 0);
+            case TOKEN_NOT_EQUAL: return ast_node_create_folded(op, CONSTANT_BOOL, a != b, 0);
+            case TOKEN_LESS: return ast_node_create_folded(op, CONSTANT_BOOL, a < b, 0);
+            case TOKEN_LESS_EQUAL: return ast_node_create_folded(op, CONSTANT_BOOL, a <= b, 0);
+            case TOKEN_GREATER: return ast_node_create_folded(op, CONSTANT_BOOL, a > b, 0);
+            case TOKEN_GREATER_EQUAL: return ast_node_create_folded(op, CONSTANT_BOOL, a >= b, 0);
+            default: return NULL;
+        }
+    }
+
+    bool a = left->data.literal.int_value != 0;
+    bool b = right->data.literal.int_value != 0;
+    switch (op->type) {
+        case TOKEN_LOGICAL_AND: return ast_node_create_folded(op, kind, a && b, 0);
+        case TOKEN_LOGICAL_OR: return ast_node_create_folded(op, kind, a || b, 0);
+        case TOKEN_EQUAL: return ast_node_create_folded(op, kind, a == b, 0);
+        case TOKEN_NOT_EQUAL: return ast_node_create_folded(op, kind, a != b, 0);
+        default: return NULL;
     }
 }
 
+static ASTNode* parser_fold_unary(Token* op, ASTNode* operand) {
+    ConstantKind kind = constant_kind(operand);
+
+    if (kind == CONSTANT_INT && op->type == TOKEN_MINUS) {
+        return parser_fold_int(op, -(int64_t)operand->data.literal.int_value);
+    }
+    if (kind == CONSTANT_INT && op->type == TOKEN_BITWISE_NOT) {
+        return ast_node_create_folded(op, kind, ~operand->data.literal.int_value, 0);
+    }
+    if (kind == CONSTANT_FLOAT && op->type == TOKEN_MINUS) {
+        return ast_node_create_folded(op, kind, 0, -operand->data.literal.float_value);
+    }
+    if (kind == CONSTANT_BOOL && op->type == TOKEN_LOGICAL_NOT) {
+        return ast_node_create_folded(op, kind, !operand->data.literal.int_value, 0);
+    }
+    return NULL;
+}
 
 // Check if token type is a binary operator
 static bool parser_is_binary_operator(TokenType type) {
@@ -460,14 +2624,98 @@ ASTNode* ast_node_create_variable_declaration(Token* token, const char* type_nam
     ASTNode* node = ast_node_create(NODE_VARIABLE_DECLARATION, token);
     if (node == NULL) return NULL;
 
-    node->data.declaration.type_name = strdup_safe(type_name);
-    node->data.declaration.name = strdup_safe(var_name);
+    node->data.declaration.type_name = ast_strdup(type_name);
+    node->data.declaration.name = ast_strdup(var_name);
     node->data.declaration.initializer = initializer;
     node->data.declaration.is_mutable = true; // Default to mutable
 
     return node;
 }
 
+ASTNode* ast_node_create_function(Token* token, const char* return_type, const char* name,
+                                  ASTNode** parameters, int parameter_count, ASTNode* body) {
+    ASTNode* node = ast_node_create(NODE_FUNCTION_DECLARATION, token);
+    if (node == NULL) return NULL;
+
+    node->data.function.return_type = ast_strdup(return_type);
+    node->data.function.name = ast_strdup(name);
+    node->data.function.parameters = parameters;
+    node->data.function.parameter_count = parameter_count;
+    node->data.function.body = body;
+
+    return node;
+}
+
+ASTNode* ast_node_create_block(Token* token, ASTNode** statements, int statement_count) {
+    ASTNode* node = ast_node_create(NODE_BLOCK_STATEMENT, token);
+    if (node == NULL) return NULL;
+
+    node->data.block.statements = statements;
+    node->data.block.statement_count = statement_count;
+
+    return node;
+}
+
+ASTNode* ast_node_create_if(Token* token, ASTNode* condition, ASTNode* then_branch, ASTNode* else_branch) {
+    ASTNode* node = ast_node_create(NODE_IF_STATEMENT, token);
+    if (node == NULL) return NULL;
+
+    node->data.conditional.condition = condition;
+    node->data.conditional.then_branch = then_branch;
+    node->data.conditional.else_branch = else_branch;
+
+    return node;
+}
+
+ASTNode* ast_node_create_while(Token* token, ASTNode* condition, ASTNode* body) {
+    ASTNode* node = ast_node_create(NODE_WHILE_STATEMENT, token);
+    if (node == NULL) return NULL;
+
+    node->data.conditional.condition = condition;
+    node->data.conditional.then_branch = body;
+
+    return node;
+}
+
+ASTNode* ast_node_create_return(Token* token, ASTNode* value) {
+    ASTNode* node = ast_node_create(NODE_RETURN_STATEMENT, token);
+    if (node == NULL) return NULL;
+
+    node->data.statement.expression = value;
+    return node;
+}
+
+ASTNode* ast_node_create_expression_statement(Token* token, ASTNode* expression) {
+    ASTNode* node = ast_node_create(NODE_EXPRESSION_STATEMENT, token);
+    if (node == NULL) return NULL;
+
+    node->data.statement.expression = expression;
+    return node;
+}
+
+ASTNode* ast_node_create_assignment(Token* token, ASTNode* target, ASTNode* value) {
+    ASTNode* node = ast_node_create(NODE_ASSIGNMENT_EXPRESSION, token);
+    if (node == NULL) return NULL;
+
+    node->data.binary.left = target;
+    node->data.binary.right = value;
+    node->data.binary.operator = ast_strdup("=");
+    node->data.binary.op = OP_INVALID;
+
+    return node;
+}
+
+ASTNode* ast_node_create_call(Token* token, ASTNode* callee, ASTNode** arguments, int argument_count) {
+    ASTNode* node = ast_node_create(NODE_CALL_EXPRESSION, token);
+    if (node == NULL) return NULL;
+
+    node->data.call.callee = callee;
+    node->data.call.arguments = arguments;
+    node->data.call.argument_count = argument_count;
+
+    return node;
+}
+
 ASTNode* ast_node_create_program(void) {
     ASTNode* node = ast_node_create(NODE_PROGRAM, NULL);
     if (node == NULL) return NULL;
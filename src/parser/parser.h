@@ -25,6 +25,35 @@ typedef enum {
     NODE_ERROR
 } NodeType;
 
+// Binary operators. The semantic analyzer indexes its operator rule table
+// with them, in this order.
+typedef enum {
+    OP_ADD,
+    OP_SUBTRACT,
+    OP_MULTIPLY,
+    OP_DIVIDE,
+    OP_MODULO,
+    OP_SHIFT_LEFT,
+    OP_SHIFT_RIGHT,
+    OP_BITWISE_AND,
+    OP_BITWISE_XOR,
+    OP_BITWISE_OR,
+    OP_EQUAL,
+    OP_NOT_EQUAL,
+    OP_LESS,
+    OP_LESS_EQUAL,
+    OP_GREATER,
+    OP_GREATER_EQUAL,
+    OP_LOGICAL_AND,
+    OP_LOGICAL_OR,
+    OP_INVALID
+} BinaryOperator;
+
+#define BINARY_OPERATOR_COUNT OP_INVALID
+
+struct Parser;
+struct Symbol;
+
 // AST Node structure
 typedef struct ASTNode {
     NodeType type;
@@ -40,6 +69,7 @@ typedef struct ASTNode {
             struct ASTNode* left;
             struct ASTNode* right;
             char* operator;
+            BinaryOperator op;   // operator parsed once; OP_INVALID for assignments
         } binary;
 
         // For unary expressions
@@ -63,12 +93,31 @@ typedef struct ASTNode {
             bool is_mutable;
         } declaration;
 
-        // For statements
+        // For function declarations (parameters are variable declarations).
+        // A lazily parsed body is NULL with body_parser set until
+        // ast_function_body parses the token range body_start..body_end.
+        struct {
+            char* name;
+            char* return_type;
+            struct ASTNode** parameters;
+            int parameter_count;
+            struct ASTNode* body;
+            struct Parser* body_parser;
+            int body_start;
+            int body_end;
+        } function;
+
+        // For blocks and the program (exactly-sized child array)
         struct {
             struct ASTNode** statements;
             int statement_count;
         } block;
 
+        // For return and expression statements
+        struct {
+            struct ASTNode* expression;
+        } statement;
+
         // For conditionals
         struct {
             struct ASTNode* condition;
@@ -91,27 +140,121 @@ typedef struct ASTNode {
     } data;
     int line;
     int column;
+    Token* first_token;      // Token span of statements, declarations and blocks
+    Token* last_token;
+    bool arena_allocated;    // Memory belongs to a parser arena, not malloc
+    bool hash_consed;        // Shared expression owned by the parser's ExprTable
+    bool owns_token;         // Token was made by constant folding and is freed with the node
+    int resolved_type;       // DataType + 1 once semantic analysis has typed the node, 0 before
+    struct Symbol* resolved_symbol;  // Declaration an identifier resolved to; valid while its scope is open
+    int resolved_slot;       // Storage of the variable an identifier or declaration names (-1 if
+                             // unresolved); frame slot count for function declarations
+    bool resolved_global;    // resolved_slot is a global index rather than a frame slot
+    uint8_t range_facts;     // RangeFact flags proven by ranges_analyze, 0 before
 } ASTNode;
 
+// Hash-consing table for pure expressions (literals, identifiers, and unary
+// and binary operators over hash-consed operands). Structurally equal
+// subexpressions become one shared node, so within a function body, or
+// within the top-level code, pointer equality means structural equality. An
+// identifier is keyed on the local declaration it names, as the analyzer
+// will resolve it, so a shared node gets the same slot and type wherever it
+// appears. A body's nodes are shared only within it: its map is emptied
+// when the body ends, which keeps lookups in a small map and keeps each node
+// to the thread analyzing its function. A shared node keeps the position of
+// its first occurrence, and all shared nodes live until the parser is freed.
+typedef struct {
+    ASTNode* node;           // NULL when the slot is empty
+    ASTNode* declaration;    // Identifiers: local declaration named, NULL for globals
+    uint64_t hash;
+} ExprEntry;
+
+typedef struct {
+    ExprEntry* slots;        // Open addressing
+    int count;
+    int capacity;
+} ExprMap;
+
+typedef struct {
+    ExprMap top_level;       // Nodes outside function bodies
+    ExprMap body;            // Nodes of the function body being parsed
+    ASTNode** retired;       // Nodes of bodies already parsed
+    int retired_count;
+    int retired_capacity;
+    int count;               // Distinct shared nodes
+    int hits;                // Lookups answered by an existing node
+} ExprTable;
+
+// An edit to the source, in 1-based lines: old lines start_line..old_end_line
+// were replaced by new lines start_line..new_end_line (start_line - 1 when
+// the lines were deleted)
+typedef struct {
+    int start_line;
+    int old_end_line;
+    int new_end_line;
+} TextEdit;
+
+// Receives each top-level declaration of a streaming parse as soon as it is
+// complete, in source order, and owns it from then on. Returning false stops
+// the parse.
+typedef bool (*DeclarationCallback)(ASTNode* declaration, void* context);
+
+// At most this many syntax errors are kept; later ones are only counted
+#define PARSER_MAX_DIAGNOSTICS 100
+
 // Parser structure
+// The parser tokenizes its input up front and parses in a single forward pass
+// over the token stream. AST nodes borrow their tokens from the stream, so a
+// tree must be freed before the parser that produced it.
 typedef struct Parser {
     Lexer* lexer;
     Token* current_token;
     Token* peek_token;
     bool had_error;
-    Error* last_error;
+    Error* last_error;       // Most recent entry of diagnostics
+    Error** diagnostics;     // Recorded syntax errors, in source order
+    int diagnostic_count;
+    int suppressed_error_count;
+    bool panic_mode;         // Suppresses cascading errors until resynchronized
+    TokenStream* stream;     // Owns every token
+    int position;            // Index of current_token in stream
+    ASTNode** scratch;       // Child stack used to build exactly-sized arrays
+    int scratch_count;
+    int scratch_capacity;
+    Arena** arenas;          // Per-thread arenas from parallel parsing
+    int arena_count;
+    ExprTable* expr_table;   // NULL unless hash-consing is enabled
+    ASTNode** locals;        // While hash-consing: local declarations in scope, innermost last
+    int local_count;
+    int local_capacity;
+    int scope_depth;         // Blocks open; declarations at depth 0 are globals
+    bool in_body;            // Parsing a function body (see ExprTable)
+    bool fold_constants;     // Operators on literals become literals
+    int generation;          // Advanced when parser_reparse rebuilds the whole tree
 } Parser;
 
 // Parser creation and destruction
 Parser* parser_create(Lexer* lexer);
 void parser_free(Parser* parser);
+void parser_enable_hash_consing(Parser* parser);
+void parser_enable_constant_folding(Parser* parser);
 
 // Main parsing functions
 ASTNode* parser_parse(Parser* parser);
 ASTNode* parser_parse_program(Parser* parser);
+ASTNode* parser_parse_program_lazy(Parser* parser);
+ASTNode* parser_parse_program_parallel(Parser* parser, int thread_count);
+bool parser_parse_program_streaming(Parser* parser, DeclarationCallback callback, void* context);
+bool parser_parse_program_pipelined(Parser* parser, DeclarationCallback callback, void* context,
+                                    int queue_capacity);
+ASTNode* ast_function_body(ASTNode* function);
+ASTNode* parser_reparse(Parser* parser, ASTNode* program, Lexer* lexer, const TextEdit* edit);
 
 // Error handling
 Error* parser_get_last_error(Parser* parser);
+Error* parser_get_diagnostic(Parser* parser, int index);
+int parser_get_diagnostic_count(Parser* parser);
+int parser_get_error_count(Parser* parser);
 bool parser_had_error(Parser* parser);
 void parser_clear_error(Parser* parser);
 
@@ -119,15 +262,28 @@ void parser_clear_error(Parser* parser);
 ASTNode* ast_node_create(NodeType type, Token* token);
 void ast_node_free(ASTNode* node);
 ASTNode* ast_node_create_binary(Token* token, ASTNode* left, ASTNode* right, const char* operator);
+BinaryOperator binary_operator_from_string(const char* op);
 ASTNode* ast_node_create_unary(Token* token, ASTNode* operand, const char* operator);
 ASTNode* ast_node_create_literal_int(Token* token, int value);
 ASTNode* ast_node_create_literal_float(Token* token, float value);
 ASTNode* ast_node_create_literal_string(Token* token, const char* value);
 ASTNode* ast_node_create_identifier(Token* token, const char* name);
 ASTNode* ast_node_create_variable_declaration(Token* token, const char* type_name, const char* var_name, ASTNode* initializer);
+ASTNode* ast_node_create_function(Token* token, const char* return_type, const char* name,
+                                  ASTNode** parameters, int parameter_count, ASTNode* body);
+ASTNode* ast_node_create_block(Token* token, ASTNode** statements, int statement_count);
+ASTNode* ast_node_create_if(Token* token, ASTNode* condition, ASTNode* then_branch, ASTNode* else_branch);
+ASTNode* ast_node_create_while(Token* token, ASTNode* condition, ASTNode* body);
+ASTNode* ast_node_create_return(Token* token, ASTNode* value);
+ASTNode* ast_node_create_expression_statement(Token* token, ASTNode* expression);
+ASTNode* ast_node_create_assignment(Token* token, ASTNode* target, ASTNode* value);
+ASTNode* ast_node_create_call(Token* token, ASTNode* callee, ASTNode** arguments, int argument_count);
 ASTNode* ast_node_create_program(void);
 void ast_node_add_child(ASTNode* parent, ASTNode* child);
 
+// Structural comparison (node kinds, positions, names, values and children)
+bool ast_node_equal(ASTNode* a, ASTNode* b);
+
 // Debug functions
 const char* node_type_to_string(NodeType type);
 void ast_node_print(ASTNode* node, int depth);
@@ -0,0 +1,790 @@
+#include "dataflow.h"
+
+// Events of a statement in evaluation order. A declaration without an
+// initializer undefines its slot: a variable declared in a loop starts
+// unassigned on every iteration. An assignment in the right operand of &&
+// or || may not run; branch conditions are split into blocks at those
+// operators (see cfg_build_condition), so only the ones elsewhere are
+// may-definitions, which neither assign a slot nor kill its definitions.
+typedef enum {
+    CFG_EVENT_USE,
+    CFG_EVENT_DEFINE,
+    CFG_EVENT_MAY_DEFINE,
+    CFG_EVENT_UNDEFINE
+} CfgEventKind;
+
+typedef void (*CfgEventHandler)(void* context, CfgEventKind kind, int slot, ASTNode* node);
+
+static bool cfg_is_local(ASTNode* node) {
+    return node->type == NODE_IDENTIFIER && !node->resolved_global && node->resolved_slot >= 0;
+}
+
+static bool cfg_is_short_circuit(ASTNode* node) {
+    return node->type == NODE_BINARY_EXPRESSION &&
+           (node->data.binary.op == OP_LOGICAL_AND || node->data.binary.op == OP_LOGICAL_OR);
+}
+
+// may is set under the right operand of && or ||
+static void cfg_walk(ASTNode* node, bool may, CfgEventHandler handler, void* context) {
+    if (node == NULL) return;
+
+    switch (node->type) {
+        case NODE_IDENTIFIER:
+            if (cfg_is_local(node)) handler(context, CFG_EVENT_USE, node->resolved_slot, node);
+            break;
+
+        case NODE_ASSIGNMENT_EXPRESSION: {
+            // The value is computed before the target is written
+            ASTNode* target = node->data.binary.left;
+            cfg_walk(node->data.binary.right, may, handler, context);
+            if (cfg_is_local(target)) {
+                handler(context, may ? CFG_EVENT_MAY_DEFINE : CFG_EVENT_DEFINE, target->resolved_slot, node);
+            } else {
+                cfg_walk(target, may, handler, context);
+            }
+            break;
+        }
+
+        case NODE_BINARY_EXPRESSION:
+            cfg_walk(node->data.binary.left, may, handler, context);
+            cfg_walk(node->data.binary.right, may || cfg_is_short_circuit(node), handler, context);
+            break;
+
+        case NODE_UNARY_EXPRESSION:
+            cfg_walk(node->data.unary.operand, may, handler, context);
+            break;
+
+        case NODE_CALL_EXPRESSION:
+            cfg_walk(node->data.call.callee, may, handler, context);
+            for (int i = 0; i < node->data.call.argument_count; i++) {
+                cfg_walk(node->data.call.arguments[i], may, handler, context);
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+static void cfg_walk_expression(ASTNode* node, CfgEventHandler handler, void* context) {
+    cfg_walk(node, false, handler, context);
+}
+
+static void cfg_walk_item(ASTNode* item, CfgEventHandler handler, void* context) {
+    switch (item->type) {
+        case NODE_VARIABLE_DECLARATION: {
+            ASTNode* initializer = item->data.declaration.initializer;
+            cfg_walk_expression(initializer, handler, context);
+            if (item->resolved_slot >= 0 && !item->resolved_global) {
+                handler(context, initializer ? CFG_EVENT_DEFINE : CFG_EVENT_UNDEFINE, item->resolved_slot, item);
+            }
+            break;
+        }
+
+        case NODE_EXPRESSION_STATEMENT:
+        case NODE_RETURN_STATEMENT:
+            cfg_walk_expression(item->data.statement.expression, handler, context);
+            break;
+
+        default:
+            // Branch conditions
+            cfg_walk_expression(item, handler, context);
+            break;
+    }
+}
+
+// Building. Statements are always appended to the newest block, so each
+// block's items (and definitions) are a contiguous run.
+typedef struct {
+    ControlFlowGraph* cfg;
+    int current;
+} CfgBuilder;
+
+static void cfg_add_definition(ControlFlowGraph* cfg, ASTNode* node, int slot) {
+    if (cfg->definition_count == cfg->definition_capacity) {
+        cfg->definition_capacity = MAX(cfg->definition_capacity * 2, 64);
+        SAFE_REALLOC(cfg->definitions, sizeof(ASTNode*) * cfg->definition_capacity);
+        SAFE_REALLOC(cfg->definition_slots, sizeof(int) * cfg->definition_capacity);
+    }
+    cfg->definitions[cfg->definition_count] = node;
+    cfg->definition_slots[cfg->definition_count++] = slot;
+    cfg->variable_count = MAX(cfg->variable_count, slot + 1);
+}
+
+static void cfg_collect_event(void* context, CfgEventKind kind, int slot, ASTNode* node) {
+    ControlFlowGraph* cfg = context;
+    if (kind == CFG_EVENT_DEFINE || kind == CFG_EVENT_MAY_DEFINE) {
+        cfg_add_definition(cfg, node, slot);
+    } else {
+        cfg->variable_count = MAX(cfg->variable_count, slot + 1);
+    }
+}
+
+static int cfg_new_block(ControlFlowGraph* cfg) {
+    if (cfg->block_count == cfg->block_capacity) {
+        cfg->block_capacity = MAX(cfg->block_capacity * 2, 16);
+        SAFE_REALLOC(cfg->blocks, sizeof(CfgBlock) * cfg->block_capacity);
+    }
+
+    CfgBlock* block = &cfg->blocks[cfg->block_count];
+    block->first_item = cfg->item_count;
+    block->item_count = 0;
+    block->first_definition = cfg->definition_count;
+    block->successors[0] = CFG_NONE;
+    block->successors[1] = CFG_NONE;
+    block->first_predecessor = 0;
+    block->predecessor_count = 0;
+    return cfg->block_count++;
+}
+
+static void cfg_add_edge(ControlFlowGraph* cfg, int from, int to) {
+    CfgBlock* block = &cfg->blocks[from];
+    block->successors[block->successors[0] == CFG_NONE ? 0 : 1] = to;
+}
+
+// Starts a new block reached from block from (or from nothing)
+static void cfg_start_block(CfgBuilder* builder, int from) {
+    int block = cfg_new_block(builder->cfg);
+    if (from != CFG_NONE) cfg_add_edge(builder->cfg, from, block);
+    builder->current = block;
+}
+
+static void cfg_append(CfgBuilder* builder, ASTNode* item) {
+    ControlFlowGraph* cfg = builder->cfg;
+    if (cfg->item_count == cfg->item_capacity) {
+        cfg->item_capacity = MAX(cfg->item_capacity * 2, 64);
+        SAFE_REALLOC(cfg->items, sizeof(ASTNode*) * cfg->item_capacity);
+    }
+
+    cfg->items[cfg->item_count++] = item;
+    cfg->blocks[builder->current].item_count++;
+    cfg_walk_item(item, cfg_collect_event, cfg);
+}
+
+// Blocks that leave a branch condition one way
+typedef struct {
+    int* blocks;
+    int count;
+    int capacity;
+} CfgExits;
+
+static void cfg_add_exit(CfgExits* exits, int block) {
+    if (exits->count == exits->capacity) {
+        exits->capacity = MAX(exits->capacity * 2, 4);
+        SAFE_REALLOC(exits->blocks, sizeof(int) * exits->capacity);
+    }
+    exits->blocks[exits->count++] = block;
+}
+
+// Starts a new block reached from every block of exits, and empties them
+static void cfg_start_block_after(CfgBuilder* builder, CfgExits* exits) {
+    cfg_start_block(builder, CFG_NONE);
+    for (int i = 0; i < exits->count; i++) {
+        cfg_add_edge(builder->cfg, exits->blocks[i], builder->current);
+    }
+    exits->count = 0;
+}
+
+// Appends a branch condition from the current block. As in ir_lower_branch,
+// && and || are split: the right operand starts a block reached only when
+// the left one does not decide, and ! swaps the ways out. The blocks that
+// leave when the condition is true are added to if_true, the others to
+// if_false; each ends with a part of the condition.
+static void cfg_build_condition(CfgBuilder* builder, ASTNode* condition, CfgExits* if_true, CfgExits* if_false) {
+    if (condition->type == NODE_UNARY_EXPRESSION && strcmp(condition->data.unary.operator, "!") == 0) {
+        cfg_build_condition(builder, condition->data.unary.operand, if_false, if_true);
+        return;
+    }
+    if (!cfg_is_short_circuit(condition)) {
+        cfg_append(builder, condition);
+        cfg_add_exit(if_true, builder->current);
+        cfg_add_exit(if_false, builder->current);
+        return;
+    }
+
+    // The left operand decides && when false and || when true
+    bool and = condition->data.binary.op == OP_LOGICAL_AND;
+    CfgExits rest = {0};
+    cfg_build_condition(builder, condition->data.binary.left, and ? &rest : if_true, and ? if_false : &rest);
+    cfg_start_block_after(builder, &rest);
+    free(rest.blocks);
+    cfg_build_condition(builder, condition->data.binary.right, if_true, if_false);
+}
+
+static void cfg_build_statement(CfgBuilder* builder, ASTNode* node) {
+    if (node == NULL) return;
+    ControlFlowGraph* cfg = builder->cfg;
+
+    switch (node->type) {
+        case NODE_BLOCK_STATEMENT:
+            for (int i = 0; i < node->data.block.statement_count; i++) {
+                cfg_build_statement(builder, node->data.block.statements[i]);
+            }
+            break;
+
+        case NODE_IF_STATEMENT: {
+            CfgExits if_true = {0};
+            CfgExits if_false = {0};
+            cfg_build_condition(builder, node->data.conditional.condition, &if_true, &if_false);
+
+            cfg_start_block_after(builder, &if_true);
+            cfg_build_statement(builder, node->data.conditional.then_branch);
+            int then_end = builder->current;
+
+            if (node->data.conditional.else_branch != NULL) {
+                cfg_start_block_after(builder, &if_false);
+                cfg_build_statement(builder, node->data.conditional.else_branch);
+                cfg_add_exit(&if_false, builder->current);
+            }
+
+            cfg_start_block_after(builder, &if_false);
+            cfg_add_edge(cfg, then_end, builder->current);
+            free(if_true.blocks);
+            free(if_false.blocks);
+            break;
+        }
+
+        case NODE_WHILE_STATEMENT: {
+            cfg_start_block(builder, builder->current);
+            int header = builder->current;
+            CfgExits if_true = {0};
+            CfgExits if_false = {0};
+            cfg_build_condition(builder, node->data.conditional.condition, &if_true, &if_false);
+
+            cfg_start_block_after(builder, &if_true);
+            cfg_build_statement(builder, node->data.conditional.then_branch);
+            cfg_add_edge(cfg, builder->current, header);
+
+            cfg_start_block_after(builder, &if_false);
+            free(if_true.blocks);
+            free(if_false.blocks);
+            break;
+        }
+
+        case NODE_RETURN_STATEMENT:
+            // Whatever follows is unreachable and gets a block of its own
+            cfg_append(builder, node);
+            cfg_add_edge(cfg, builder->current, CFG_EXIT);
+            cfg_start_block(builder, CFG_NONE);
+            break;
+
+        default:
+            cfg_append(builder, node);
+            break;
+    }
+}
+
+// Predecessor lists, stored back to back in block order
+static void cfg_link_predecessors(ControlFlowGraph* cfg) {
+    int edge_count = 0;
+    for (int b = 0; b < cfg->block_count; b++) {
+        for (int s = 0; s < 2; s++) {
+            int successor = cfg->blocks[b].successors[s];
+            if (successor == CFG_NONE) continue;
+            cfg->blocks[successor].predecessor_count++;
+            edge_count++;
+        }
+    }
+
+    int next = 0;
+    for (int b = 0; b < cfg->block_count; b++) {
+        cfg->blocks[b].first_predecessor = next;
+        next += cfg->blocks[b].predecessor_count;
+        cfg->blocks[b].predecessor_count = 0;
+    }
+
+    SAFE_MALLOC(cfg->predecessors, sizeof(int) * MAX(1, edge_count));
+    for (int b = 0; b < cfg->block_count; b++) {
+        for (int s = 0; s < 2; s++) {
+            int successor = cfg->blocks[b].successors[s];
+            if (successor == CFG_NONE) continue;
+            CfgBlock* target = &cfg->blocks[successor];
+            cfg->predecessors[target->first_predecessor + target->predecessor_count++] = b;
+        }
+    }
+}
+
+ControlFlowGraph* cfg_build(ASTNode* function) {
+    if (function == NULL || function->type != NODE_FUNCTION_DECLARATION) return NULL;
+
+    ControlFlowGraph* cfg;
+    SAFE_CALLOC(cfg, 1, sizeof(ControlFlowGraph));
+    cfg->function = function;
+    cfg->variable_count = MAX(0, function->resolved_slot);
+
+    CfgBuilder builder = { cfg, CFG_NONE };
+    cfg_start_block(&builder, CFG_NONE);
+    cfg_new_block(cfg);
+
+    // Parameters are defined on entry
+    for (int i = 0; i < function->data.function.parameter_count; i++) {
+        ASTNode* parameter = function->data.function.parameters[i];
+        if (parameter->resolved_slot >= 0) cfg_add_definition(cfg, parameter, parameter->resolved_slot);
+    }
+
+    cfg_build_statement(&builder, ast_function_body(function));
+    cfg_add_edge(cfg, builder.current, CFG_EXIT);
+    cfg_link_predecessors(cfg);
+    return cfg;
+}
+
+void cfg_free(ControlFlowGraph* cfg) {
+    if (cfg == NULL) return;
+
+    free(cfg->blocks);
+    free(cfg->items);
+    free(cfg->predecessors);
+    free(cfg->definitions);
+    free(cfg->definition_slots);
+    free(cfg);
+}
+
+const CfgBlock* cfg_block(const ControlFlowGraph* cfg, int block) {
+    if (cfg == NULL || block < 0 || block >= cfg->block_count) return NULL;
+    return &cfg->blocks[block];
+}
+
+const int* cfg_block_predecessors(const ControlFlowGraph* cfg, int block) {
+    const CfgBlock* b = cfg_block(cfg, block);
+    return b ? &cfg->predecessors[b->first_predecessor] : NULL;
+}
+
+// Bit sets. The loops work a word at a time over plain arrays so the
+// compiler can vectorize them.
+bool bitset_test(const BitWord* set, int bit) {
+    return (set[bit >> 6] >> (bit & 63)) & 1;
+}
+
+void bitset_set(BitWord* set, int bit) {
+    set[bit >> 6] |= (BitWord)1 << (bit & 63);
+}
+
+void bitset_clear(BitWord* set, int bit) {
+    set[bit >> 6] &= ~((BitWord)1 << (bit & 63));
+}
+
+int bitset_count(const BitWord* set, int word_count) {
+    int count = 0;
+    for (int i = 0; i < word_count; i++) {
+        count += __builtin_popcountll(set[i]);
+    }
+    return count;
+}
+
+static void bitset_fill(BitWord* set, int word_count, int bit_count) {
+    for (int i = 0; i < word_count; i++) {
+        set[i] = ~(BitWord)0;
+    }
+    if (bit_count % 64 != 0) set[word_count - 1] = ((BitWord)1 << (bit_count % 64)) - 1;
+}
+
+static void bitset_union(BitWord* restrict target, const BitWord* restrict source, int word_count) {
+    for (int i = 0; i < word_count; i++) {
+        target[i] |= source[i];
+    }
+}
+
+static void bitset_intersect(BitWord* restrict target, const BitWord* restrict source, int word_count) {
+    for (int i = 0; i < word_count; i++) {
+        target[i] &= source[i];
+    }
+}
+
+// target = gen | (source & ~kill); true if target changed
+static bool bitset_transfer(BitWord* restrict target, const BitWord* restrict source, const BitWord* restrict gen,
+                            const BitWord* restrict kill, int word_count) {
+    BitWord changed = 0;
+    for (int i = 0; i < word_count; i++) {
+        BitWord value = gen[i] | (source[i] & ~kill[i]);
+        changed |= value ^ target[i];
+        target[i] = value;
+    }
+    return changed != 0;
+}
+
+// Solver
+DataflowProblem* dataflow_problem_create(const ControlFlowGraph* cfg, DataflowDirection direction,
+                                         DataflowMeet meet, int bit_count) {
+    if (cfg == NULL || bit_count < 0) return NULL;
+
+    size_t words = (size_t)BITSET_WORDS(bit_count);
+    DataflowProblem* problem;
+    SAFE_MALLOC(problem, sizeof(DataflowProblem));
+    problem->direction = direction;
+    problem->meet = meet;
+    problem->bit_count = bit_count;
+    SAFE_CALLOC(problem->gen, MAX(1, words * cfg->block_count), sizeof(BitWord));
+    SAFE_CALLOC(problem->kill, MAX(1, words * cfg->block_count), sizeof(BitWord));
+    SAFE_CALLOC(problem->boundary, MAX(1, words), sizeof(BitWord));
+    return problem;
+}
+
+void dataflow_problem_free(DataflowProblem* problem) {
+    if (problem == NULL) return;
+
+    free(problem->gen);
+    free(problem->kill);
+    free(problem->boundary);
+    free(problem);
+}
+
+// Reverse postorder from the entry, then blocks the entry cannot reach.
+// Forward problems settle fastest visiting blocks in this order, backward
+// problems in its reverse.
+static int* dataflow_block_order(const ControlFlowGraph* cfg) {
+    int count = cfg->block_count;
+    int* order;
+    int* stack;
+    int* next_successor;
+    bool* seen;
+    SAFE_MALLOC(order, sizeof(int) * count);
+    SAFE_MALLOC(stack, sizeof(int) * count);
+    SAFE_CALLOC(next_successor, count, sizeof(int));
+    SAFE_CALLOC(seen, count, sizeof(bool));
+
+    int position = count;
+    int depth = 0;
+    stack[depth++] = CFG_ENTRY;
+    seen[CFG_ENTRY] = true;
+    while (depth > 0) {
+        int block = stack[depth - 1];
+        if (next_successor[block] < 2) {
+            int successor = cfg->blocks[block].successors[next_successor[block]++];
+            if (successor != CFG_NONE && !seen[successor]) {
+                seen[successor] = true;
+                stack[depth++] = successor;
+            }
+            continue;
+        }
+        order[--position] = block;
+        depth--;
+    }
+
+    // Unreachable blocks go after the reachable ones
+    int reachable = count - position;
+    memmove(order, order + position, sizeof(int) * reachable);
+    for (int b = 0; b < count; b++) {
+        if (!seen[b]) order[reachable++] = b;
+    }
+
+    free(stack);
+    free(next_successor);
+    free(seen);
+    return order;
+}
+
+DataflowResult* dataflow_solve(const ControlFlowGraph* cfg, const DataflowProblem* problem) {
+    if (cfg == NULL || problem == NULL) return NULL;
+
+    int count = cfg->block_count;
+    int words = BITSET_WORDS(problem->bit_count);
+    bool forward = problem->direction == DATAFLOW_FORWARD;
+    bool intersect = problem->meet == DATAFLOW_INTERSECTION;
+
+    DataflowResult* result;
+    SAFE_MALLOC(result, sizeof(DataflowResult));
+    result->bit_count = problem->bit_count;
+    result->word_count = words;
+    result->block_count = count;
+    result->block_visits = 0;
+    SAFE_CALLOC(result->in, MAX(1, (size_t)words * count), sizeof(BitWord));
+    SAFE_CALLOC(result->out, MAX(1, (size_t)words * count), sizeof(BitWord));
+    if (words == 0) return result;
+
+    // Facts flow from "before" to "after": in to out going forward, out to
+    // in going backward. Must analyses start from the full set.
+    BitWord* before = forward ? result->in : result->out;
+    BitWord* after = forward ? result->out : result->in;
+    BitWord* universe;
+    SAFE_MALLOC(universe, sizeof(BitWord) * words);
+    bitset_fill(universe, words, problem->bit_count);
+    if (intersect) {
+        for (int b = 0; b < count; b++) {
+            memcpy(&after[(size_t)b * words], universe, sizeof(BitWord) * words);
+        }
+    }
+
+    // The worklist is a bit per position in visiting order. Blocks are taken
+    // in that order, sweeping from the last one taken and wrapping around, so
+    // a change flows through the rest of the function in the same sweep
+    // instead of waiting a full lap as it would in a FIFO queue.
+    int* order = dataflow_block_order(cfg);
+    int* position;
+    BitWord* pending;
+    int pending_words = BITSET_WORDS(count);
+    SAFE_MALLOC(position, sizeof(int) * count);
+    SAFE_MALLOC(pending, sizeof(BitWord) * pending_words);
+    if (!forward) {
+        for (int i = 0; i < count / 2; i++) {
+            int swap = order[i];
+            order[i] = order[count - 1 - i];
+            order[count - 1 - i] = swap;
+        }
+    }
+    for (int i = 0; i < count; i++) {
+        position[order[i]] = i;
+    }
+    bitset_fill(pending, pending_words, count);
+    int pending_count = count;
+    int cursor = 0;
+    int boundary_block = forward ? CFG_ENTRY : CFG_EXIT;
+
+    while (pending_count > 0) {
+        // Next pending position at or after the cursor, wrapping to the start
+        int word = cursor / 64;
+        BitWord bits = pending[word] & (~(BitWord)0 << (cursor % 64));
+        while (bits == 0) {
+            word = (word + 1) % pending_words;
+            bits = pending[word];
+        }
+        int next = word * 64 + __builtin_ctzll(bits);
+        pending[word] &= ~((BitWord)1 << (next % 64));
+        pending_count--;
+        cursor = next + 1 < count ? next + 1 : 0;
+        int block = order[next];
+        result->block_visits++;
+
+        const CfgBlock* b = &cfg->blocks[block];
+        BitWord* meet = &before[(size_t)block * words];
+        const int* sources = forward ? &cfg->predecessors[b->first_predecessor] : b->successors;
+        int source_count = forward ? b->predecessor_count : 2;
+
+        // Meet over the blocks facts come from; with none, the meet's identity
+        bool first = true;
+        if (block == boundary_block) {
+            memcpy(meet, problem->boundary, sizeof(BitWord) * words);
+            first = false;
+        }
+        for (int i = 0; i < source_count; i++) {
+            int source = sources[i];
+            if (source == CFG_NONE) continue;
+            const BitWord* facts = &after[(size_t)source * words];
+            if (first) {
+                memcpy(meet, facts, sizeof(BitWord) * words);
+                first = false;
+            } else if (intersect) {
+                bitset_intersect(meet, facts, words);
+            } else {
+                bitset_union(meet, facts, words);
+            }
+        }
+        if (first) {
+            if (intersect) {
+                memcpy(meet, universe, sizeof(BitWord) * words);
+            } else {
+                memset(meet, 0, sizeof(BitWord) * words);
+            }
+        }
+
+        if (!bitset_transfer(&after[(size_t)block * words], meet, &problem->gen[(size_t)block * words],
+                             &problem->kill[(size_t)block * words], words)) {
+            continue;
+        }
+
+        // The blocks that read this one's facts need another look
+        const int* targets = forward ? b->successors : &cfg->predecessors[b->first_predecessor];
+        int target_count = forward ? 2 : b->predecessor_count;
+        for (int i = 0; i < target_count; i++) {
+            int target = targets[i];
+            if (target == CFG_NONE || bitset_test(pending, position[target])) continue;
+            bitset_set(pending, position[target]);
+            pending_count++;
+        }
+    }
+
+    free(universe);
+    free(order);
+    free(position);
+    free(pending);
+    return result;
+}
+
+void dataflow_result_free(DataflowResult* result) {
+    if (result == NULL) return;
+
+    free(result->in);
+    free(result->out);
+    free(result);
+}
+
+const BitWord* dataflow_in(const DataflowResult* result, int block) {
+    if (result == NULL || block < 0 || block >= result->block_count) return NULL;
+    return &result->in[(size_t)block * result->word_count];
+}
+
+const BitWord* dataflow_out(const DataflowResult* result, int block) {
+    if (result == NULL || block < 0 || block >= result->block_count) return NULL;
+    return &result->out[(size_t)block * result->word_count];
+}
+
+// Analyses. Each summarizes every block into gen and kill sets by replaying
+// its events in order, then hands the problem to the solver.
+typedef struct {
+    BitWord* gen;
+    BitWord* kill;
+    int words;
+    int definition;          // Number of the next definition in the block
+    const BitWord* slot_definitions;  // Per slot, the definitions of that slot
+} BlockSummary;
+
+static void dataflow_summarize(const ControlFlowGraph* cfg, DataflowProblem* problem, CfgEventHandler handler,
+                               BlockSummary* summary) {
+    int words = BITSET_WORDS(problem->bit_count);
+    for (int block = 0; block < cfg->block_count; block++) {
+        const CfgBlock* b = &cfg->blocks[block];
+        summary->gen = &problem->gen[(size_t)block * words];
+        summary->kill = &problem->kill[(size_t)block * words];
+        summary->words = words;
+        summary->definition = b->first_definition;
+
+        if (block == CFG_ENTRY) {
+            for (int i = 0; i < cfg->function->data.function.parameter_count; i++) {
+                ASTNode* parameter = cfg->function->data.function.parameters[i];
+                if (parameter->resolved_slot >= 0) {
+                    handler(summary, CFG_EVENT_DEFINE, parameter->resolved_slot, parameter);
+                }
+            }
+        }
+        for (int i = 0; i < b->item_count; i++) {
+            cfg_walk_item(cfg->items[b->first_item + i], handler, summary);
+        }
+    }
+}
+
+// Live: read later on some path before being written
+static void liveness_event(void* context, CfgEventKind kind, int slot, ASTNode* node) {
+    (void)node;
+    BlockSummary* summary = context;
+    if (kind == CFG_EVENT_USE) {
+        if (!bitset_test(summary->kill, slot)) bitset_set(summary->gen, slot);
+    } else if (kind != CFG_EVENT_MAY_DEFINE) {
+        bitset_set(summary->kill, slot);
+    }
+}
+
+DataflowResult* dataflow_liveness(const ControlFlowGraph* cfg) {
+    if (cfg == NULL) return NULL;
+
+    DataflowProblem* problem = dataflow_problem_create(cfg, DATAFLOW_BACKWARD, DATAFLOW_UNION, cfg->variable_count);
+    BlockSummary summary = { 0 };
+    dataflow_summarize(cfg, problem, liveness_event, &summary);
+
+    DataflowResult* result = dataflow_solve(cfg, problem);
+    dataflow_problem_free(problem);
+    return result;
+}
+
+// A definition reaches a point if some path gets there without redefining its slot
+static void reaching_event(void* context, CfgEventKind kind, int slot, ASTNode* node) {
+    (void)node;
+    BlockSummary* summary = context;
+    if (kind == CFG_EVENT_USE) return;
+    if (kind == CFG_EVENT_MAY_DEFINE) {
+        bitset_set(summary->gen, summary->definition++);
+        return;
+    }
+
+    const BitWord* same_slot = &summary->slot_definitions[(size_t)slot * summary->words];
+    for (int i = 0; i < summary->words; i++) {
+        summary->kill[i] |= same_slot[i];
+        summary->gen[i] &= ~same_slot[i];
+    }
+    if (kind == CFG_EVENT_DEFINE) bitset_set(summary->gen, summary->definition++);
+}
+
+DataflowResult* dataflow_reaching_definitions(const ControlFlowGraph* cfg) {
+    if (cfg == NULL) return NULL;
+
+    DataflowProblem* problem = dataflow_problem_create(cfg, DATAFLOW_FORWARD, DATAFLOW_UNION,
+                                                       cfg->definition_count);
+    int words = BITSET_WORDS(cfg->definition_count);
+    BitWord* slot_definitions;
+    SAFE_CALLOC(slot_definitions, MAX(1, (size_t)words * cfg->variable_count), sizeof(BitWord));
+    for (int d = 0; d < cfg->definition_count; d++) {
+        bitset_set(&slot_definitions[(size_t)cfg->definition_slots[d] * words], d);
+    }
+
+    BlockSummary summary = { 0 };
+    summary.slot_definitions = slot_definitions;
+    dataflow_summarize(cfg, problem, reaching_event, &summary);
+
+    DataflowResult* result = dataflow_solve(cfg, problem);
+    free(slot_definitions);
+    dataflow_problem_free(problem);
+    return result;
+}
+
+// Assigned: written on every path, with no declaration since
+static void assignment_event(void* context, CfgEventKind kind, int slot, ASTNode* node) {
+    (void)node;
+    BlockSummary* summary = context;
+    if (kind == CFG_EVENT_DEFINE) {
+        bitset_set(summary->gen, slot);
+        bitset_clear(summary->kill, slot);
+    } else if (kind == CFG_EVENT_UNDEFINE) {
+        bitset_set(summary->kill, slot);
+        bitset_clear(summary->gen, slot);
+    }
+}
+
+DataflowResult* dataflow_definite_assignment(const ControlFlowGraph* cfg) {
+    if (cfg == NULL) return NULL;
+
+    DataflowProblem* problem = dataflow_problem_create(cfg, DATAFLOW_FORWARD, DATAFLOW_INTERSECTION,
+                                                       cfg->variable_count);
+    BlockSummary summary = { 0 };
+    dataflow_summarize(cfg, problem, assignment_event, &summary);
+
+    DataflowResult* result = dataflow_solve(cfg, problem);
+    dataflow_problem_free(problem);
+    return result;
+}
+
+// Diagnostics: replay each block from its incoming assigned set
+typedef struct {
+    BitWord* assigned;
+    SemanticAnalyzer* analyzer;
+    int reported;
+} AssignmentCheck;
+
+static void assignment_check_event(void* context, CfgEventKind kind, int slot, ASTNode* node) {
+    AssignmentCheck* check = context;
+    if (kind == CFG_EVENT_DEFINE) {
+        bitset_set(check->assigned, slot);
+    } else if (kind == CFG_EVENT_UNDEFINE) {
+        bitset_clear(check->assigned, slot);
+    } else if (kind == CFG_EVENT_USE && !bitset_test(check->assigned, slot)) {
+        semantic_analyzer_error(check->analyzer, node, "Variable '%s' may be used before it is assigned",
+                                node->data.identifier_name);
+        check->reported++;
+        // One report per variable and path
+        bitset_set(check->assigned, slot);
+    }
+}
+
+int dataflow_check_definite_assignment(const ControlFlowGraph* cfg, SemanticAnalyzer* analyzer) {
+    if (cfg == NULL || analyzer == NULL) return 0;
+
+    DataflowResult* result = dataflow_definite_assignment(cfg);
+    int words = result->word_count;
+    AssignmentCheck check = { NULL, analyzer, 0 };
+    SAFE_CALLOC(check.assigned, MAX(1, words), sizeof(BitWord));
+
+    for (int block = 0; block < cfg->block_count; block++) {
+        const CfgBlock* b = &cfg->blocks[block];
+        if (words > 0) memcpy(check.assigned, dataflow_in(result, block), sizeof(BitWord) * words);
+        if (block == CFG_ENTRY) {
+            for (int i = 0; i < cfg->function->data.function.parameter_count; i++) {
+                ASTNode* parameter = cfg->function->data.function.parameters[i];
+                if (parameter->resolved_slot >= 0) bitset_set(check.assigned, parameter->resolved_slot);
+            }
+        }
+        for (int i = 0; i < b->item_count; i++) {
+            cfg_walk_item(cfg->items[b->first_item + i], assignment_check_event, &check);
+        }
+    }
+
+    free(check.assigned);
+    dataflow_result_free(result);
+    return check.reported;
+}
@@ -0,0 +1,118 @@
+#ifndef DATAFLOW_H
+#define DATAFLOW_H
+
+#include "semantic.h"
+
+// Control-flow graphs of function bodies and a bit-vector dataflow solver.
+// Graphs are built from resolved functions (see semantic_resolve): a
+// variable is identified by its frame slot, so only locals and parameters
+// take part and globals are ignored. Blocks, their statements and their
+// predecessors are stored in flat arrays indexed by block number, and every
+// dataflow set is a row of 64-bit words in one contiguous array.
+
+#define CFG_ENTRY 0
+#define CFG_EXIT 1
+#define CFG_NONE -1
+
+typedef uint64_t BitWord;
+
+#define BITSET_WORDS(bits) (((bits) + 63) / 64)
+
+typedef struct {
+    int first_item;          // Index in items
+    int item_count;
+    int first_definition;    // Index of the first definition made in the block
+    int successors[2];       // CFG_NONE when absent
+    int first_predecessor;   // Index in predecessors
+    int predecessor_count;
+} CfgBlock;
+
+// Items are the statements of a block in order: declarations, expression
+// and return statements, and last the condition of an if or while that ends
+// the block. Conditions are split at && and ||, so that item may be one of
+// their operands. Definitions are numbered in the order they execute within a
+// block, blocks in order: parameters first (in the entry block), then
+// declarations with an initializer and assignments to locals.
+typedef struct {
+    ASTNode* function;
+    CfgBlock* blocks;
+    int block_count;
+    int block_capacity;
+    ASTNode** items;
+    int item_count;
+    int item_capacity;
+    int* predecessors;
+    ASTNode** definitions;   // Parameter, declaration or assignment node
+    int* definition_slots;
+    int definition_count;
+    int definition_capacity;
+    int variable_count;      // Frame slots of the function
+} ControlFlowGraph;
+
+typedef enum {
+    DATAFLOW_FORWARD,
+    DATAFLOW_BACKWARD
+} DataflowDirection;
+
+typedef enum {
+    DATAFLOW_UNION,          // May analyses: a fact holds if it holds on some path
+    DATAFLOW_INTERSECTION    // Must analyses: a fact holds if it holds on every path
+} DataflowMeet;
+
+// A gen/kill problem. Each block transfers its incoming set to
+// gen | (incoming & ~kill); boundary is the set entering the entry block
+// (forward) or leaving the exit block (backward). gen and kill have
+// BITSET_WORDS(bit_count) words per block.
+typedef struct {
+    DataflowDirection direction;
+    DataflowMeet meet;
+    int bit_count;
+    BitWord* gen;
+    BitWord* kill;
+    BitWord* boundary;
+} DataflowProblem;
+
+// in and out are the sets at the start and end of each block in program
+// order, whichever the direction of the problem
+typedef struct {
+    int bit_count;
+    int word_count;          // Words per set
+    int block_count;
+    BitWord* in;
+    BitWord* out;
+    long block_visits;       // Transfer functions applied until the sets settled
+} DataflowResult;
+
+// Graphs
+ControlFlowGraph* cfg_build(ASTNode* function);
+void cfg_free(ControlFlowGraph* cfg);
+const CfgBlock* cfg_block(const ControlFlowGraph* cfg, int block);
+const int* cfg_block_predecessors(const ControlFlowGraph* cfg, int block);
+
+// Solver. dataflow_problem_create gives zeroed gen, kill and boundary sets.
+DataflowProblem* dataflow_problem_create(const ControlFlowGraph* cfg, DataflowDirection direction,
+                                         DataflowMeet meet, int bit_count);
+void dataflow_problem_free(DataflowProblem* problem);
+DataflowResult* dataflow_solve(const ControlFlowGraph* cfg, const DataflowProblem* problem);
+void dataflow_result_free(DataflowResult* result);
+const BitWord* dataflow_in(const DataflowResult* result, int block);
+const BitWord* dataflow_out(const DataflowResult* result, int block);
+
+// Analyses. Liveness and definite assignment have one bit per frame slot,
+// reaching definitions one bit per entry of cfg->definitions.
+DataflowResult* dataflow_liveness(const ControlFlowGraph* cfg);
+DataflowResult* dataflow_reaching_definitions(const ControlFlowGraph* cfg);
+DataflowResult* dataflow_definite_assignment(const ControlFlowGraph* cfg);
+
+// Reports every read of a local that is not assigned on all paths leading
+// to it. Errors go to the analyzer as for any semantic error; returns how
+// many reads were reported.
+int dataflow_check_definite_assignment(const ControlFlowGraph* cfg, SemanticAnalyzer* analyzer);
+
+// Bit sets
+bool bitset_test(const BitWord* set, int bit);
+void bitset_set(BitWord* set, int bit);
+void bitset_clear(BitWord* set, int bit);
+int bitset_count(const BitWord* set, int word_count);
+
+#endif // DATAFLOW_H
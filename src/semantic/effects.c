@@ -0,0 +1,416 @@
+#include "effects.h"
+
+// A function of the program being summarized. effects holds the effects of
+// its own body and of the components it calls outside its own until its
+// component is complete, and then the component's summary.
+typedef struct {
+    ASTNode* node;
+    Symbol* symbol;              // NULL if the declaration was rejected
+    uint32_t hash;
+    unsigned effects;
+    int first_call;              // Index in calls
+    int call_count;
+    int cursor;                  // Next call to follow in the component search
+    int index;                   // Visit order in the component search, -1 before
+    int low;                     // Smallest index reachable within the open components
+    bool on_stack;
+    bool calls_itself;
+} EffectsFunction;
+
+// While summarizing, functions is set and calls to the program's functions
+// are recorded as edges. Afterwards calls take their effects from the
+// function symbols.
+typedef struct {
+    SymbolTable* globals;
+    EffectsFunction* functions;
+    int function_count;
+    int* slots;                  // Open addressing: function index + 1, 0 when empty
+    int slot_capacity;           // Power of two, at least twice function_count
+    int* calls;                  // Callee of every call edge, grouped by caller
+    int call_count;
+    int call_capacity;
+    int unknown_call_count;
+} EffectsContext;
+
+static int effects_find(EffectsContext* context, const char* name, uint32_t hash) {
+    uint32_t mask = (uint32_t)context->slot_capacity - 1;
+    uint32_t slot = hash & mask;
+    while (context->slots[slot] != 0) {
+        EffectsFunction* function = &context->functions[context->slots[slot] - 1];
+        if (function->hash == hash && strcmp(function->node->data.function.name, name) == 0) {
+            return context->slots[slot] - 1;
+        }
+        slot = (slot + 1) & mask;
+    }
+    return -1;
+}
+
+// Adds a function unless one of the same name came first; a redeclaration
+// was rejected by analysis and calls mean the first
+static void effects_add_function(EffectsContext* context, ASTNode* node) {
+    const char* name = node->data.function.name;
+    uint32_t hash = (uint32_t)hash_bytes(name, strlen(name));
+    if (effects_find(context, name, hash) >= 0) return;
+
+    uint32_t mask = (uint32_t)context->slot_capacity - 1;
+    uint32_t slot = hash & mask;
+    while (context->slots[slot] != 0) slot = (slot + 1) & mask;
+
+    Symbol* symbol = symbol_table_lookup(context->globals, name);
+    EffectsFunction* function = &context->functions[context->function_count];
+    function->node = node;
+    function->symbol = symbol != NULL && symbol->type == SYMBOL_FUNCTION ? symbol : NULL;
+    function->hash = hash;
+    function->effects = 0;
+    function->first_call = 0;
+    function->call_count = 0;
+    function->cursor = 0;
+    function->index = -1;
+    function->low = -1;
+    function->on_stack = false;
+    function->calls_itself = false;
+    context->slots[slot] = ++context->function_count;
+}
+
+// Whether an identifier names a global variable
+static bool effects_names_global(ASTNode* node) {
+    return node->resolved_global && node->resolved_slot >= 0;
+}
+
+static unsigned effects_walk(EffectsContext* context, ASTNode* node);
+
+static unsigned effects_call(EffectsContext* context, ASTNode* callee) {
+    bool local = callee->resolved_slot >= 0 && !callee->resolved_global;
+    if (callee->type == NODE_IDENTIFIER && !local) {
+        const char* name = callee->data.identifier_name;
+        if (context->functions != NULL) {
+            int index = effects_find(context, name, (uint32_t)hash_bytes(name, strlen(name)));
+            if (index >= 0) {
+                if (context->call_count == context->call_capacity) {
+                    context->call_capacity = MAX(context->call_capacity * 2, 64);
+                    SAFE_REALLOC(context->calls, sizeof(int) * context->call_capacity);
+                }
+                context->calls[context->call_count++] = index;
+                return 0;
+            }
+        } else {
+            Symbol* symbol = symbol_table_lookup(context->globals, name);
+            if (symbol != NULL && symbol->type == SYMBOL_FUNCTION) return symbol->data.function.effects;
+        }
+    }
+
+    context->unknown_call_count++;
+    return EFFECT_ALL | effects_walk(context, callee);
+}
+
+static unsigned effects_walk_statements(EffectsContext* context, ASTNode** statements, int count) {
+    unsigned effects = 0;
+    for (int i = 0; i < count; i++) {
+        effects |= effects_walk(context, statements[i]);
+    }
+    return effects;
+}
+
+static unsigned effects_walk(EffectsContext* context, ASTNode* node) {
+    if (node == NULL) return 0;
+
+    switch (node->type) {
+        case NODE_LITERAL:
+        case NODE_FUNCTION_DECLARATION:
+            return 0;
+
+        case NODE_IDENTIFIER:
+            return effects_names_global(node) ? EFFECT_READS_GLOBALS : 0;
+
+        case NODE_ASSIGNMENT_EXPRESSION: {
+            ASTNode* target = node->data.binary.left;
+            unsigned effects = effects_walk(context, node->data.binary.right);
+            if (target->type != NODE_IDENTIFIER) return effects | EFFECT_ALL;
+            return effects | (effects_names_global(target) ? EFFECT_WRITES_GLOBALS : 0);
+        }
+
+        case NODE_BINARY_EXPRESSION:
+            return effects_walk(context, node->data.binary.left) | effects_walk(context, node->data.binary.right);
+
+        case NODE_UNARY_EXPRESSION:
+            return effects_walk(context, node->data.unary.operand);
+
+        case NODE_CALL_EXPRESSION: {
+            unsigned effects = 0;
+            for (int i = 0; i < node->data.call.argument_count; i++) {
+                effects |= effects_walk(context, node->data.call.arguments[i]);
+            }
+            return effects | effects_call(context, node->data.call.callee);
+        }
+
+        case NODE_VARIABLE_DECLARATION: {
+            // A global declaration initializes its variable
+            unsigned effects = effects_walk(context, node->data.declaration.initializer);
+            return effects | (node->resolved_global ? EFFECT_WRITES_GLOBALS : 0);
+        }
+
+        case NODE_EXPRESSION_STATEMENT:
+        case NODE_RETURN_STATEMENT:
+            return effects_walk(context, node->data.statement.expression);
+
+        case NODE_IF_STATEMENT:
+            return effects_walk(context, node->data.conditional.condition) |
+                   effects_walk(context, node->data.conditional.then_branch) |
+                   effects_walk(context, node->data.conditional.else_branch);
+
+        case NODE_WHILE_STATEMENT:
+            // Termination is not analyzed
+            return EFFECT_MAY_NOT_RETURN | effects_walk(context, node->data.conditional.condition) |
+                   effects_walk(context, node->data.conditional.then_branch);
+
+        case NODE_PROGRAM:
+        case NODE_BLOCK_STATEMENT:
+            return effects_walk_statements(context, node->data.block.statements, node->data.block.statement_count);
+
+        default:
+            return EFFECT_ALL;
+    }
+}
+
+// Pops the component rooted at root off stack and gives its members their
+// shared summary
+static void effects_close_component(EffectsContext* context, int root, int* stack, int* stack_count,
+                                    EffectsSummary* summary) {
+    EffectsFunction* functions = context->functions;
+    int first = *stack_count;
+    do {
+        first--;
+    } while (stack[first] != root);
+
+    int size = *stack_count - first;
+    unsigned effects = 0;
+    for (int i = first; i < *stack_count; i++) {
+        effects |= functions[stack[i]].effects;
+    }
+    if (size > 1 || functions[root].calls_itself) {
+        effects |= EFFECT_MAY_NOT_RETURN;
+        summary->recursive_count += size;
+    }
+
+    for (int i = first; i < *stack_count; i++) {
+        functions[stack[i]].effects = effects;
+        functions[stack[i]].on_stack = false;
+    }
+    *stack_count = first;
+    summary->component_count++;
+}
+
+// Tarjan's algorithm with an explicit path, so deep call chains do not
+// exhaust the native stack. A component is closed only after every
+// component it calls, so callee summaries are final when they are merged.
+static void effects_components(EffectsContext* context, EffectsSummary* summary) {
+    EffectsFunction* functions = context->functions;
+    int* stack;
+    int* path;
+    SAFE_MALLOC(stack, sizeof(int) * MAX(context->function_count, 1));
+    SAFE_MALLOC(path, sizeof(int) * MAX(context->function_count, 1));
+    int stack_count = 0;
+    int visited = 0;
+
+    for (int root = 0; root < context->function_count; root++) {
+        if (functions[root].index >= 0) continue;
+
+        int path_count = 0;
+        path[path_count++] = root;
+        functions[root].index = functions[root].low = visited++;
+        functions[root].on_stack = true;
+        stack[stack_count++] = root;
+
+        while (path_count > 0) {
+            int caller = path[path_count - 1];
+            EffectsFunction* function = &functions[caller];
+
+            if (function->cursor < function->call_count) {
+                int callee = context->calls[function->first_call + function->cursor++];
+                EffectsFunction* target = &functions[callee];
+                if (callee == caller) {
+                    function->calls_itself = true;
+                } else if (target->index < 0) {
+                    target->index = target->low = visited++;
+                    target->on_stack = true;
+                    stack[stack_count++] = callee;
+                    path[path_count++] = callee;
+                } else if (target->on_stack) {
+                    function->low = MIN(function->low, target->index);
+                } else {
+                    function->effects |= target->effects;
+                }
+                continue;
+            }
+
+            path_count--;
+            if (function->low == function->index) {
+                effects_close_component(context, caller, stack, &stack_count, summary);
+            }
+            if (path_count > 0) {
+                EffectsFunction* parent = &functions[path[path_count - 1]];
+                if (function->on_stack) {
+                    parent->low = MIN(parent->low, function->low);
+                } else {
+                    parent->effects |= function->effects;
+                }
+            }
+        }
+    }
+
+    free(stack);
+    free(path);
+}
+
+bool effects_summarize(ASTNode* program, SemanticAnalyzer* analyzer, EffectsSummary* summary) {
+    if (program == NULL || analyzer == NULL || program->type != NODE_PROGRAM) return false;
+
+    EffectsSummary counts = {0};
+    EffectsContext context = {0};
+    context.globals = analyzer->scope_stack[0];
+
+    int count = 0;
+    for (int i = 0; i < program->data.block.statement_count; i++) {
+        count += program->data.block.statements[i]->type == NODE_FUNCTION_DECLARATION;
+    }
+    context.slot_capacity = 16;
+    while (context.slot_capacity < count * 2) context.slot_capacity *= 2;
+    SAFE_CALLOC(context.slots, context.slot_capacity, sizeof(int));
+    SAFE_MALLOC(context.functions, sizeof(EffectsFunction) * MAX(count, 1));
+
+    for (int i = 0; i < program->data.block.statement_count; i++) {
+        ASTNode* node = program->data.block.statements[i];
+        if (node->type == NODE_FUNCTION_DECLARATION) effects_add_function(&context, node);
+    }
+
+    // Each body's calls form one run of the edge array
+    for (int i = 0; i < context.function_count; i++) {
+        EffectsFunction* function = &context.functions[i];
+        function->first_call = context.call_count;
+        function->effects = effects_walk(&context, ast_function_body(function->node));
+        function->call_count = context.call_count - function->first_call;
+    }
+
+    effects_components(&context, &counts);
+
+    for (int i = 0; i < context.function_count; i++) {
+        EffectsFunction* function = &context.functions[i];
+        if (function->symbol != NULL) function->symbol->data.function.effects = function->effects;
+        counts.pure_count += EFFECTS_PURE(function->effects);
+    }
+    counts.function_count = context.function_count;
+    counts.call_count = context.call_count;
+    counts.unknown_call_count = context.unknown_call_count;
+    if (summary != NULL) *summary = counts;
+
+    free(context.slots);
+    free(context.functions);
+    free(context.calls);
+    return true;
+}
+
+unsigned effects_of(ASTNode* node, SemanticAnalyzer* analyzer) {
+    if (analyzer == NULL) return EFFECT_ALL;
+
+    EffectsContext context = {0};
+    context.globals = analyzer->scope_stack[0];
+    return effects_walk(&context, node);
+}
+
+static int effects_count_calls(ASTNode* node) {
+    if (node == NULL) return 0;
+
+    switch (node->type) {
+        case NODE_ASSIGNMENT_EXPRESSION:
+        case NODE_BINARY_EXPRESSION:
+            return effects_count_calls(node->data.binary.left) + effects_count_calls(node->data.binary.right);
+
+        case NODE_UNARY_EXPRESSION:
+            return effects_count_calls(node->data.unary.operand);
+
+        case NODE_CALL_EXPRESSION: {
+            int count = 1 + effects_count_calls(node->data.call.callee);
+            for (int i = 0; i < node->data.call.argument_count; i++) {
+                count += effects_count_calls(node->data.call.arguments[i]);
+            }
+            return count;
+        }
+
+        default:
+            return 0;
+    }
+}
+
+// Whether an expression assigns a variable. A write to a local is no effect
+// of the function, but a statement making one is not dead.
+static bool effects_assigns(ASTNode* node) {
+    if (node == NULL) return false;
+
+    switch (node->type) {
+        case NODE_ASSIGNMENT_EXPRESSION:
+            return true;
+
+        case NODE_BINARY_EXPRESSION:
+            return effects_assigns(node->data.binary.left) || effects_assigns(node->data.binary.right);
+
+        case NODE_UNARY_EXPRESSION:
+            return effects_assigns(node->data.unary.operand);
+
+        case NODE_CALL_EXPRESSION:
+            for (int i = 0; i < node->data.call.argument_count; i++) {
+                if (effects_assigns(node->data.call.arguments[i])) return true;
+            }
+            return false;
+
+        default:
+            return false;
+    }
+}
+
+static int effects_remove_in(EffectsContext* context, ASTNode* node) {
+    if (node == NULL) return 0;
+
+    switch (node->type) {
+        case NODE_PROGRAM:
+        case NODE_BLOCK_STATEMENT: {
+            // Kept statements slide down over removed ones
+            int removed = 0;
+            int kept = 0;
+            for (int i = 0; i < node->data.block.statement_count; i++) {
+                ASTNode* statement = node->data.block.statements[i];
+                if (statement->type == NODE_EXPRESSION_STATEMENT) {
+                    ASTNode* expression = statement->data.statement.expression;
+                    int calls = effects_count_calls(expression);
+                    if (calls > 0 && !effects_assigns(expression) && EFFECTS_PURE(effects_walk(context, expression))) {
+                        removed += calls;
+                        ast_node_free(statement);
+                        continue;
+                    }
+                }
+                removed += effects_remove_in(context, statement);
+                node->data.block.statements[kept++] = statement;
+            }
+            node->data.block.statement_count = kept;
+            return removed;
+        }
+
+        case NODE_FUNCTION_DECLARATION:
+            return effects_remove_in(context, ast_function_body(node));
+
+        case NODE_IF_STATEMENT:
+        case NODE_WHILE_STATEMENT:
+            return effects_remove_in(context, node->data.conditional.then_branch) +
+                   effects_remove_in(context, node->data.conditional.else_branch);
+
+        default:
+            return 0;
+    }
+}
+
+int effects_remove_dead_calls(ASTNode* program, SemanticAnalyzer* analyzer) {
+    if (program == NULL || analyzer == NULL) return 0;
+
+    EffectsContext context = {0};
+    context.globals = analyzer->scope_stack[0];
+    return effects_remove_in(&context, program);
+}
@@ -0,0 +1,50 @@
+#ifndef EFFECTS_H
+#define EFFECTS_H
+
+#include "semantic.h"
+
+// Interprocedural side-effect summaries. After a program has been analyzed,
+// effects_summarize gives every function symbol the effects a call to it
+// may have (Effect flags): reading globals, writing globals, and not
+// returning. A function has the effects of its own body and of everything
+// it calls. The call graph is condensed into strongly connected components,
+// which are visited callees first, so each component is summarized once
+// with its callees' summaries final; the members of a component share one
+// summary, the union of theirs, which is the fixpoint for recursion.
+//
+// The analysis is conservative. Any while loop and any recursion may not
+// return; a call through anything but the name of a function of the
+// program has every effect, as do functions effects_summarize has not
+// seen (imported ones, for instance). Summaries describe the tree they were
+// computed from and must be computed again after it is edited.
+
+// A function is pure when calling it writes no global and always returns:
+// a call whose result is unused can be dropped, and calls with equal
+// arguments and no global write between them give the same result.
+#define EFFECTS_PURE(effects) (((effects) & (EFFECT_WRITES_GLOBALS | EFFECT_MAY_NOT_RETURN)) == 0)
+
+typedef struct {
+    int function_count;
+    int call_count;          // Calls to functions of the program
+    int unknown_call_count;  // Calls through anything else
+    int component_count;     // Strongly connected components of the call graph
+    int recursive_count;     // Functions in a cycle of calls
+    int pure_count;
+} EffectsSummary;
+
+// Summarizes every top-level function of program, which analyzer has
+// analyzed and is still at global scope. Returns false if program is not a
+// program; summary, if given, receives the counts.
+bool effects_summarize(ASTNode* program, SemanticAnalyzer* analyzer, EffectsSummary* summary);
+
+// Effects of evaluating an expression or executing a statement, with calls
+// taken from the function summaries
+unsigned effects_of(ASTNode* node, SemanticAnalyzer* analyzer);
+
+// Dead-call elimination: removes the expression statements of program that
+// call functions, assign no variable and are pure (their value is unused,
+// so the calls can only cost time), in function bodies and at the top
+// level. Returns the number of calls removed.
+int effects_remove_dead_calls(ASTNode* program, SemanticAnalyzer* analyzer);
+
+#endif // EFFECTS_H
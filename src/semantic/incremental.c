@@ -0,0 +1,378 @@
+#include "incremental.h"
+
+// Dependency index: global name to the declarations that looked it up
+static void incremental_rehash(IncrementalAnalysis* analysis) {
+    int capacity = analysis->slot_capacity ? analysis->slot_capacity * 2 : 64;
+    int* slots;
+    SAFE_CALLOC(slots, capacity, sizeof(int));
+
+    for (int i = 0; i < analysis->entry_count; i++) {
+        uint32_t slot = analysis->entries[i].hash & (capacity - 1);
+        while (slots[slot] != 0) slot = (slot + 1) & (capacity - 1);
+        slots[slot] = i + 1;
+    }
+
+    free(analysis->entry_slots);
+    analysis->entry_slots = slots;
+    analysis->slot_capacity = capacity;
+}
+
+// Index of name's entry; with create set, a missing name gets one, otherwise -1
+static int incremental_entry(IncrementalAnalysis* analysis, const char* name, bool create) {
+    if ((analysis->entry_count + 1) * 2 > analysis->slot_capacity) {
+        incremental_rehash(analysis);
+    }
+
+    uint32_t hash = (uint32_t)hash_bytes(name, strlen(name));
+    uint32_t mask = analysis->slot_capacity - 1;
+    uint32_t slot = hash & mask;
+    while (analysis->entry_slots[slot] != 0) {
+        int index = analysis->entry_slots[slot] - 1;
+        if (analysis->entries[index].hash == hash && strcmp(analysis->entries[index].name, name) == 0) {
+            return index;
+        }
+        slot = (slot + 1) & mask;
+    }
+    if (!create) return -1;
+
+    if (analysis->entry_count == analysis->entry_capacity) {
+        analysis->entry_capacity = MAX(64, analysis->entry_capacity * 2);
+        SAFE_REALLOC(analysis->entries, sizeof(DependencyEntry) * analysis->entry_capacity);
+    }
+    int index = analysis->entry_count++;
+    DependencyEntry* entry = &analysis->entries[index];
+    entry->name = strdup_safe(name);
+    entry->hash = hash;
+    entry->dependents = NULL;
+    entry->dependent_count = 0;
+    entry->dependent_capacity = 0;
+    analysis->entry_slots[slot] = index + 1;
+    return index;
+}
+
+// Lookup hook: adds the name to the dependencies of the declaration being
+// checked. Its lookups are recorded one after the other, so a repeated name
+// finds the declaration already last among the entry's dependents.
+static void incremental_record_lookup(SemanticAnalyzer* analyzer, const char* name, void* context) {
+    (void)analyzer;
+    IncrementalAnalysis* analysis = context;
+    int declaration = analysis->recording;
+    if (declaration < 0) return;
+
+    int index = incremental_entry(analysis, name, true);
+    DependencyEntry* entry = &analysis->entries[index];
+    if (entry->dependent_count > 0 && entry->dependents[entry->dependent_count - 1].index == declaration) return;
+
+    DeclarationRecord* record = &analysis->declarations[declaration];
+    if (entry->dependent_count == entry->dependent_capacity) {
+        entry->dependent_capacity = MAX(4, entry->dependent_capacity * 2);
+        SAFE_REALLOC(entry->dependents, sizeof(DependencyLink) * entry->dependent_capacity);
+    }
+    if (record->dependency_count == record->dependency_capacity) {
+        record->dependency_capacity = MAX(4, record->dependency_capacity * 2);
+        SAFE_REALLOC(record->dependencies, sizeof(DependencyLink) * record->dependency_capacity);
+    }
+    entry->dependents[entry->dependent_count] = (DependencyLink){ declaration, record->dependency_count };
+    record->dependencies[record->dependency_count] = (DependencyLink){ index, entry->dependent_count };
+    entry->dependent_count++;
+    record->dependency_count++;
+}
+
+// Takes a declaration out of the entries it depends on before it is checked
+// again. The last dependent of an entry fills the hole, and its declaration
+// learns the new position.
+static void incremental_forget_dependencies(IncrementalAnalysis* analysis, int declaration) {
+    DeclarationRecord* record = &analysis->declarations[declaration];
+    for (int i = 0; i < record->dependency_count; i++) {
+        DependencyEntry* entry = &analysis->entries[record->dependencies[i].index];
+        int position = record->dependencies[i].position;
+        DependencyLink moved = entry->dependents[--entry->dependent_count];
+        entry->dependents[position] = moved;
+        analysis->declarations[moved.index].dependencies[moved.position].position = position;
+    }
+    record->dependency_count = 0;
+}
+
+static uint64_t incremental_hash_type(uint64_t hash, const char* type_name) {
+    const TypeDescriptor* type = type_from_name(type_name);
+    const char* spelling = type ? type->name : "";
+    return (hash ^ hash_bytes(spelling, strlen(spelling))) * 1099511628211ULL;
+}
+
+// What other declarations can see of a declaration: its name and types
+static uint64_t incremental_signature(ASTNode* node) {
+    if (node->type == NODE_FUNCTION_DECLARATION) {
+        const char* name = node->data.function.name;
+        uint64_t hash = hash_bytes(name, strlen(name));
+        hash = incremental_hash_type(hash, node->data.function.return_type);
+        for (int i = 0; i < node->data.function.parameter_count; i++) {
+            hash = incremental_hash_type(hash, node->data.function.parameters[i]->data.declaration.type_name);
+        }
+        return hash;
+    }
+    if (node->type == NODE_VARIABLE_DECLARATION) {
+        const char* name = node->data.declaration.name;
+        return incremental_hash_type(hash_bytes(name, strlen(name)), node->data.declaration.type_name);
+    }
+    return 0;
+}
+
+static const char* incremental_declared_name(ASTNode* node) {
+    if (node->type == NODE_FUNCTION_DECLARATION) return node->data.function.name;
+    if (node->type == NODE_VARIABLE_DECLARATION) return node->data.declaration.name;
+    return NULL;
+}
+
+// The global symbol a top-level declaration introduced, or NULL if it was
+// rejected (a redeclaration binds the name to the earlier declaration)
+static Symbol* incremental_declared_symbol(SemanticAnalyzer* analyzer, ASTNode* node) {
+    const char* name = incremental_declared_name(node);
+    if (name == NULL) return NULL;
+
+    Symbol* symbol = symbol_table_lookup_local(analyzer->scope_stack[0], name);
+    if (symbol == NULL || symbol->line != node->line || symbol->column != node->column) return NULL;
+    return symbol;
+}
+
+static void incremental_reset(IncrementalAnalysis* analysis) {
+    for (int i = 0; i < analysis->declaration_count; i++) {
+        free(analysis->declarations[i].dependencies);
+        error_free(analysis->declarations[i].error);
+    }
+    for (int i = 0; i < analysis->entry_count; i++) {
+        free(analysis->entries[i].name);
+        free(analysis->entries[i].dependents);
+    }
+    free(analysis->declarations);
+    free(analysis->entries);
+    free(analysis->entry_slots);
+    free(analysis->worklist);
+    semantic_analyzer_free(analysis->analyzer);
+
+    analysis->analyzer = NULL;
+    analysis->declarations = NULL;
+    analysis->declaration_count = 0;
+    analysis->entries = NULL;
+    analysis->entry_count = 0;
+    analysis->entry_capacity = 0;
+    analysis->entry_slots = NULL;
+    analysis->slot_capacity = 0;
+    analysis->worklist = NULL;
+    analysis->failed_count = 0;
+}
+
+// Analysis in order, one top-level statement at a time so that each one's
+// lookups and error are its own
+static bool incremental_analyze_all(IncrementalAnalysis* analysis, Parser* parser, ASTNode* program) {
+    incremental_reset(analysis);
+    ast_node_clear_types(program);
+    analysis->program = program;
+    analysis->parser_generation = parser ? parser->generation : 0;
+    analysis->full_analysis = true;
+
+    SemanticAnalyzer* analyzer = semantic_analyzer_create();
+    if (analyzer == NULL) return false;
+    analyzer->lookup_hook = incremental_record_lookup;
+    analyzer->lookup_context = analysis;
+    analysis->analyzer = analyzer;
+
+    int count = program->data.block.statement_count;
+    SAFE_CALLOC(analysis->declarations, MAX(1, count), sizeof(DeclarationRecord));
+    // Edited declarations, then dependents; a declaration can be both
+    SAFE_MALLOC(analysis->worklist, sizeof(int) * MAX(1, 2 * count));
+    analysis->declaration_count = count;
+
+    for (int i = 0; i < count; i++) {
+        ASTNode* statement = program->data.block.statements[i];
+        DeclarationRecord* record = &analysis->declarations[i];
+
+        analysis->recording = i;
+        record->node = statement;
+        record->ok = semantic_resolve(statement, analyzer);
+        record->error = analyzer->last_error;
+        analyzer->last_error = NULL;
+        record->symbol = incremental_declared_symbol(analyzer, statement);
+        record->signature = incremental_signature(statement);
+        if (!record->ok) analysis->failed_count++;
+    }
+    analysis->recording = -1;
+    analysis->checked_count = count;
+    ast_node_get_type(program, analyzer);
+    analyzer->had_error = analysis->failed_count > 0;
+
+    return analysis->failed_count == 0;
+}
+
+IncrementalAnalysis* incremental_analysis_create(Parser* parser, ASTNode* program) {
+    if (program == NULL || program->type != NODE_PROGRAM) return NULL;
+
+    IncrementalAnalysis* analysis;
+    SAFE_CALLOC(analysis, 1, sizeof(IncrementalAnalysis));
+    analysis->recording = -1;
+    incremental_analyze_all(analysis, parser, program);
+    if (analysis->analyzer == NULL) {
+        incremental_analysis_free(analysis);
+        return NULL;
+    }
+    return analysis;
+}
+
+void incremental_analysis_free(IncrementalAnalysis* analysis) {
+    if (analysis == NULL) return;
+
+    incremental_reset(analysis);
+    free(analysis);
+}
+
+static void incremental_check(IncrementalAnalysis* analysis, int declaration) {
+    DeclarationRecord* record = &analysis->declarations[declaration];
+    SemanticAnalyzer* analyzer = analysis->analyzer;
+
+    incremental_forget_dependencies(analysis, declaration);
+    error_free(record->error);
+    analysis->recording = declaration;
+    bool ok = semantic_reanalyze_declaration(record->node, record->symbol, analyzer);
+    analysis->recording = -1;
+
+    record->error = analyzer->last_error;
+    analyzer->last_error = NULL;
+    if (ok != record->ok) analysis->failed_count += ok ? -1 : 1;
+    record->ok = ok;
+    record->signature = incremental_signature(record->node);
+    analysis->checked_count++;
+}
+
+static void incremental_mark_edited(IncrementalAnalysis* analysis, int declaration, int* edited_count) {
+    DeclarationRecord* record = &analysis->declarations[declaration];
+    if (record->edited == analysis->update) return;
+
+    record->edited = analysis->update;
+    analysis->worklist[(*edited_count)++] = declaration;
+}
+
+// First top-level statement that ends on or after line
+static int incremental_first_ending_after(ASTNode* program, int line) {
+    int low = 0;
+    int high = program->data.block.statement_count;
+    while (low < high) {
+        int middle = (low + high) / 2;
+        Token* last = program->data.block.statements[middle]->last_token;
+        if (last != NULL && last->line < line) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+bool incremental_analysis_update(IncrementalAnalysis* analysis, Parser* parser, ASTNode* program,
+                                 const TextEdit* edit) {
+    if (analysis == NULL || program == NULL || program->type != NODE_PROGRAM) return false;
+
+    analysis->update++;
+    analysis->checked_count = 0;
+    analysis->full_analysis = false;
+
+    // A rebuilt tree, syntax errors or a different set of declarations move
+    // global slots and visibility; only edits within declarations are kept
+    int count = program->data.block.statement_count;
+    bool rebuild = edit == NULL || parser == NULL || program != analysis->program ||
+                   parser->generation != analysis->parser_generation || parser_had_error(parser) ||
+                   count != analysis->declaration_count;
+
+    // Edited declarations: those whose lines overlap the edit. parser_reparse
+    // only replaces statements sharing a line with the edit, and a function
+    // whose body was edited keeps its node, so nothing else is looked at.
+    int edited_count = 0;
+    int first_after = count;
+    if (!rebuild) {
+        // A deletion leaves no lines; the declarations around it are checked
+        int low = edit->new_end_line < edit->start_line ? edit->start_line - 1 : edit->start_line;
+        int high = MAX(edit->start_line, edit->new_end_line);
+        int i = incremental_first_ending_after(program, low);
+        for (; i < count; i++) {
+            Token* first = program->data.block.statements[i]->first_token;
+            if (first == NULL || first->line > high) break;
+            incremental_mark_edited(analysis, i, &edited_count);
+        }
+        first_after = i;
+
+        for (int k = 0; k < edited_count && !rebuild; k++) {
+            DeclarationRecord* record = &analysis->declarations[analysis->worklist[k]];
+            ASTNode* node = program->data.block.statements[analysis->worklist[k]];
+            const char* name = incremental_declared_name(node);
+            SymbolType kind = node->type == NODE_FUNCTION_DECLARATION ? SYMBOL_FUNCTION : SYMBOL_VARIABLE;
+            rebuild = record->symbol == NULL || name == NULL || record->symbol->type != kind ||
+                      strcmp(record->symbol->name, name) != 0;
+            record->node = node;
+        }
+    }
+
+    if (rebuild) {
+        incremental_analyze_all(analysis, parser, program);
+        return incremental_analysis_ok(analysis);
+    }
+
+    // Declarations after the edit moved with it. Their symbols' positions
+    // decide what is visible to earlier declarations checked again.
+    int shift = edit->new_end_line - edit->old_end_line;
+    if (shift != 0) {
+        for (int i = first_after; i < count; i++) {
+            DeclarationRecord* record = &analysis->declarations[i];
+            if (record->edited == analysis->update) continue;
+            if (record->symbol != NULL) {
+                record->symbol->line = record->node->line;
+                record->symbol->column = record->node->column;
+            }
+            if (record->error != NULL) record->error->line += shift;
+        }
+    }
+
+    // Edited declarations first, then whatever depends on a name whose
+    // signature changed. Only edited declarations can change a signature.
+    int tail = edited_count;
+    for (int k = 0; k < edited_count; k++) {
+        int declaration = analysis->worklist[k];
+        DeclarationRecord* record = &analysis->declarations[declaration];
+        uint64_t signature = record->signature;
+        incremental_check(analysis, declaration);
+        if (record->signature == signature) continue;
+
+        int index = incremental_entry(analysis, record->symbol->name, false);
+        if (index < 0) continue;
+        DependencyEntry* entry = &analysis->entries[index];
+        for (int j = 0; j < entry->dependent_count; j++) {
+            DeclarationRecord* dependent = &analysis->declarations[entry->dependents[j].index];
+            if (dependent->queued == analysis->update) continue;
+            dependent->queued = analysis->update;
+            analysis->worklist[tail++] = entry->dependents[j].index;
+        }
+    }
+    for (int k = edited_count; k < tail; k++) {
+        // A rejected redeclaration has no symbol to check against
+        if (analysis->declarations[analysis->worklist[k]].symbol == NULL) {
+            incremental_analyze_all(analysis, parser, program);
+            return incremental_analysis_ok(analysis);
+        }
+    }
+    for (int k = edited_count; k < tail; k++) {
+        incremental_check(analysis, analysis->worklist[k]);
+    }
+
+    analysis->analyzer->had_error = analysis->failed_count > 0;
+    return incremental_analysis_ok(analysis);
+}
+
+bool incremental_analysis_ok(const IncrementalAnalysis* analysis) {
+    return analysis != NULL && analysis->analyzer != NULL && analysis->failed_count == 0;
+}
+
+Error* incremental_analysis_last_error(const IncrementalAnalysis* analysis) {
+    if (analysis == NULL || analysis->failed_count == 0) return NULL;
+
+    for (int i = analysis->declaration_count - 1; i >= 0; i--) {
+        if (analysis->declarations[i].error != NULL) return analysis->declarations[i].error;
+    }
+    return NULL;
+}
@@ -0,0 +1,84 @@
+#ifndef INCREMENTAL_H
+#define INCREMENTAL_H
+
+#include "semantic.h"
+
+// Incremental semantic analysis. Every top-level declaration of a program is
+// checked on its own and remembers which global names its checks looked up
+// (see SemanticLookupHook) and a signature: what other declarations can see
+// of it, a function's return and parameter types or a variable's type. After
+// an edit that parser_reparse applied to the tree, only the declarations the
+// edit touched are checked again, and then the declarations that depend on a
+// name whose signature changed. An edit inside a function body therefore
+// costs one function, however large the program. Edits that add, remove or
+// rename top-level declarations, or leave the tree with syntax errors, fall
+// back to analyzing the whole program, since they move global slots. The
+// outcome, the reported error and every annotation match semantic_analyze
+// on the edited program.
+
+// One edge between a declaration and a name, stored on both sides. Each
+// side keeps where the other side stores it, so checking a declaration
+// again drops its edges in constant time each.
+typedef struct {
+    int index;                   // Declaration, or entry of the dependency index
+    int position;                // Position of the edge in that one's list
+} DependencyLink;
+
+// A global name and the declarations whose checks looked it up
+typedef struct {
+    char* name;
+    uint32_t hash;
+    DependencyLink* dependents;  // Each declaration at most once
+    int dependent_count;
+    int dependent_capacity;
+} DependencyEntry;
+
+typedef struct {
+    ASTNode* node;
+    Symbol* symbol;              // Global it declares; NULL if it was rejected
+    uint64_t signature;
+    DependencyLink* dependencies;  // Entries of the dependency index
+    int dependency_count;
+    int dependency_capacity;
+    Error* error;                // Last error from checking it
+    bool ok;
+    int edited;                  // Last update that found it edited
+    int queued;                  // Last update that queued it as a dependent
+} DeclarationRecord;
+
+typedef struct {
+    SemanticAnalyzer* analyzer;
+    ASTNode* program;
+    int parser_generation;       // Parser generation the records belong to
+    DeclarationRecord* declarations;   // One per top-level statement
+    int declaration_count;
+    DependencyEntry* entries;
+    int entry_count;
+    int entry_capacity;
+    int* entry_slots;            // Open addressing: entry index + 1, 0 when empty
+    int slot_capacity;           // Power of two, at least twice entry_count
+    int recording;               // Declaration whose lookups are recorded, -1 if none
+    int* worklist;
+    int failed_count;            // Declarations whose checks failed
+    int update;                  // Updates applied so far
+    int checked_count;           // Declarations checked by the last update
+    bool full_analysis;          // The last update analyzed the whole program
+} IncrementalAnalysis;
+
+// Analyzes program, parsed by parser, as semantic_analyze would and records
+// its dependencies. The tree must outlive the analysis.
+IncrementalAnalysis* incremental_analysis_create(Parser* parser, ASTNode* program);
+void incremental_analysis_free(IncrementalAnalysis* analysis);
+
+// Brings the analysis up to date after parser_reparse applied edit to the
+// tree; program is what parser_reparse returned and parser the parser that
+// produced it. Returns what semantic_analyze would on the edited program.
+bool incremental_analysis_update(IncrementalAnalysis* analysis, Parser* parser, ASTNode* program,
+                                 const TextEdit* edit);
+
+// Results: whether every declaration checked out, and the error analysis in
+// order would report last (NULL if none)
+bool incremental_analysis_ok(const IncrementalAnalysis* analysis);
+Error* incremental_analysis_last_error(const IncrementalAnalysis* analysis);
+
+#endif // INCREMENTAL_H
@@ -0,0 +1,432 @@
+#include "module.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Growable tables filled while exporting a module
+typedef struct {
+    ModuleEntry* entries;
+    uint32_t entry_count;
+    uint32_t entry_capacity;
+    ModuleParameter* parameters;
+    uint32_t parameter_count;
+    uint32_t parameter_capacity;
+    uint32_t* string_offsets;
+    uint32_t string_count;
+    uint32_t string_capacity;
+    StringBuffer* strings;
+    uint32_t* intern_slots;  // Open addressing: string id + 1, 0 when empty
+    uint32_t intern_capacity;
+} InterfaceBuilder;
+
+static void* interface_grow(void* array, uint32_t* capacity, uint32_t needed, size_t element_size) {
+    if (needed <= *capacity) return array;
+
+    uint32_t new_capacity = MAX(*capacity * 2, MAX(needed, 16));
+    SAFE_REALLOC(array, new_capacity * element_size);
+    *capacity = new_capacity;
+    return array;
+}
+
+static void interface_intern_rehash(InterfaceBuilder* builder) {
+    uint32_t capacity = builder->intern_capacity ? builder->intern_capacity * 2 : 64;
+    uint32_t* slots;
+    SAFE_CALLOC(slots, capacity, sizeof(uint32_t));
+
+    for (uint32_t id = 0; id < builder->string_count; id++) {
+        const char* str = builder->strings->data + builder->string_offsets[id];
+        uint32_t slot = (uint32_t)hash_bytes(str, strlen(str)) & (capacity - 1);
+        while (slots[slot] != 0) slot = (slot + 1) & (capacity - 1);
+        slots[slot] = id + 1;
+    }
+
+    free(builder->intern_slots);
+    builder->intern_slots = slots;
+    builder->intern_capacity = capacity;
+}
+
+// Each distinct string is stored once
+static uint32_t interface_intern(InterfaceBuilder* builder, const char* str) {
+    if (str == NULL) return MODULE_NONE;
+
+    if ((builder->string_count + 1) * 2 > builder->intern_capacity) {
+        interface_intern_rehash(builder);
+    }
+
+    size_t length = strlen(str);
+    uint32_t mask = builder->intern_capacity - 1;
+    uint32_t slot = (uint32_t)hash_bytes(str, length) & mask;
+    while (builder->intern_slots[slot] != 0) {
+        uint32_t id = builder->intern_slots[slot] - 1;
+        if (strcmp(builder->strings->data + builder->string_offsets[id], str) == 0) return id;
+        slot = (slot + 1) & mask;
+    }
+
+    uint32_t id = builder->string_count++;
+    builder->string_offsets = interface_grow(builder->string_offsets, &builder->string_capacity,
+                                             builder->string_count, sizeof(uint32_t));
+    builder->string_offsets[id] = (uint32_t)builder->strings->length;
+    string_buffer_append(builder->strings, str);
+    string_buffer_append_char(builder->strings, '\0');
+    builder->intern_slots[slot] = id + 1;
+
+    return id;
+}
+
+// Canonical spelling of a type name, so "int" and "int " export the same
+static uint32_t interface_intern_type(InterfaceBuilder* builder, const char* type_name) {
+    const TypeDescriptor* type = type_from_name(type_name);
+    return interface_intern(builder, type ? type->name : NULL);
+}
+
+static ModuleEntry* interface_add_entry(InterfaceBuilder* builder, ModuleEntryKind kind, const char* name) {
+    uint32_t index = builder->entry_count++;
+    builder->entries = interface_grow(builder->entries, &builder->entry_capacity,
+                                      builder->entry_count, sizeof(ModuleEntry));
+
+    ModuleEntry entry = {0};
+    entry.kind = (uint8_t)kind;
+    entry.name = interface_intern(builder, name);
+    entry.first_parameter = builder->parameter_count;
+    entry.value_type = TYPE_UNKNOWN;
+    builder->entries[index] = entry;
+    return &builder->entries[index];
+}
+
+// The global symbol a top-level declaration introduced, or NULL if it was
+// rejected (a redeclaration binds the name to the earlier declaration)
+static Symbol* interface_declared_symbol(SemanticAnalyzer* analyzer, ASTNode* node, const char* name,
+                                         SymbolType type) {
+    Symbol* symbol = symbol_table_lookup_local(analyzer->scope_stack[0], name);
+    if (symbol == NULL || symbol->type != type) return NULL;
+    if (symbol->line != node->line || symbol->column != node->column) return NULL;
+    return symbol;
+}
+
+static void interface_add_function(InterfaceBuilder* builder, SemanticAnalyzer* analyzer, ASTNode* node) {
+    Symbol* symbol = interface_declared_symbol(analyzer, node, node->data.function.name, SYMBOL_FUNCTION);
+    if (symbol == NULL) return;
+
+    // Parameters are interned first, since interning may move the entries
+    int count = node->data.function.parameter_count;
+    uint32_t first = builder->parameter_count;
+    builder->parameter_count += count;
+    builder->parameters = interface_grow(builder->parameters, &builder->parameter_capacity,
+                                         builder->parameter_count, sizeof(ModuleParameter));
+    for (int i = 0; i < count; i++) {
+        ASTNode* parameter = node->data.function.parameters[i];
+        builder->parameters[first + i].name = interface_intern(builder, parameter->data.declaration.name);
+        builder->parameters[first + i].type = interface_intern_type(builder, parameter->data.declaration.type_name);
+    }
+    uint32_t type = interface_intern(builder, symbol->data.function.return_type);
+
+    ModuleEntry* entry = interface_add_entry(builder, MODULE_ENTRY_FUNCTION, symbol->name);
+    entry->type = type;
+    entry->first_parameter = first;
+    entry->parameter_count = (uint32_t)count;
+}
+
+static void interface_add_variable(InterfaceBuilder* builder, SemanticAnalyzer* analyzer, ASTNode* node) {
+    Symbol* symbol = interface_declared_symbol(analyzer, node, node->data.declaration.name, SYMBOL_VARIABLE);
+    if (symbol == NULL) return;
+
+    uint32_t type = interface_intern(builder, symbol->data.variable.type_name);
+    ASTNode* initializer = node->data.declaration.initializer;
+    bool constant = initializer != NULL && initializer->type == NODE_LITERAL && initializer->token != NULL;
+    DataType value_type = constant ? ast_node_get_type(initializer, analyzer) : TYPE_UNKNOWN;
+    uint64_t value = 0;
+    switch (value_type) {
+        case TYPE_INT:
+            value = (uint64_t)(int64_t)initializer->data.literal.int_value;
+            break;
+        case TYPE_FLOAT: {
+            uint32_t bits;
+            memcpy(&bits, &initializer->data.literal.float_value, sizeof(bits));
+            value = bits;
+            break;
+        }
+        case TYPE_BOOL:
+            value = initializer->token->type == TOKEN_TRUE;
+            break;
+        case TYPE_STRING:
+            value = interface_intern(builder, initializer->data.literal.string_value);
+            break;
+        default:
+            constant = false;
+            break;
+    }
+
+    ModuleEntry* entry = interface_add_entry(builder, MODULE_ENTRY_VARIABLE, symbol->name);
+    entry->type = type;
+    entry->is_mutable = symbol->data.variable.is_mutable;
+    entry->constant = constant;
+    entry->value_type = constant ? (uint8_t)value_type : TYPE_UNKNOWN;
+    entry->value = constant ? value : 0;
+}
+
+// Points the interface's section pointers into its buffer
+static void module_interface_bind(ModuleInterface* interface) {
+    const char* base = interface->memory;
+    const ModuleInterfaceHeader* header = interface->memory;
+
+    interface->header = header;
+    interface->entries = (const ModuleEntry*)(base + sizeof(ModuleInterfaceHeader));
+    interface->parameters = (const ModuleParameter*)(interface->entries + header->entry_count);
+    interface->string_offsets = (const uint32_t*)(interface->parameters + header->parameter_count);
+    interface->strings = (const char*)(interface->string_offsets + header->string_count);
+}
+
+static size_t module_interface_expected_size(const ModuleInterfaceHeader* header) {
+    return sizeof(ModuleInterfaceHeader) +
+           (size_t)header->entry_count * sizeof(ModuleEntry) +
+           (size_t)header->parameter_count * sizeof(ModuleParameter) +
+           (size_t)header->string_count * sizeof(uint32_t) +
+           header->string_bytes;
+}
+
+ModuleInterface* module_interface_build(ASTNode* program, SemanticAnalyzer* analyzer, uint64_t source_hash) {
+    if (program == NULL || analyzer == NULL || program->type != NODE_PROGRAM) return NULL;
+
+    InterfaceBuilder builder = {0};
+    builder.strings = string_buffer_create(1024);
+
+    for (int i = 0; i < program->data.block.statement_count; i++) {
+        ASTNode* statement = program->data.block.statements[i];
+        if (statement->type == NODE_FUNCTION_DECLARATION) {
+            interface_add_function(&builder, analyzer, statement);
+        } else if (statement->type == NODE_VARIABLE_DECLARATION) {
+            interface_add_variable(&builder, analyzer, statement);
+        }
+    }
+
+    ModuleInterfaceHeader header = {0};
+    header.magic = MODULE_INTERFACE_MAGIC;
+    header.version = MODULE_INTERFACE_VERSION;
+    header.source_hash = source_hash;
+    header.entry_count = builder.entry_count;
+    header.parameter_count = builder.parameter_count;
+    header.string_count = builder.string_count;
+    header.string_bytes = (uint32_t)builder.strings->length;
+
+    ModuleInterface* interface;
+    SAFE_MALLOC(interface, sizeof(ModuleInterface));
+    interface->size = module_interface_expected_size(&header);
+    interface->mapped = false;
+    SAFE_MALLOC(interface->memory, interface->size);
+
+    char* cursor = (char*)interface->memory + sizeof(header);
+    memcpy(cursor, builder.entries, builder.entry_count * sizeof(ModuleEntry));
+    cursor += builder.entry_count * sizeof(ModuleEntry);
+    memcpy(cursor, builder.parameters, builder.parameter_count * sizeof(ModuleParameter));
+    cursor += builder.parameter_count * sizeof(ModuleParameter);
+    memcpy(cursor, builder.string_offsets, builder.string_count * sizeof(uint32_t));
+    cursor += builder.string_count * sizeof(uint32_t);
+    memcpy(cursor, builder.strings->data, builder.strings->length);
+
+    // Everything is exported in source order, so equal declarations give
+    // equal bytes and the same hash
+    header.interface_hash = hash_bytes((char*)interface->memory + sizeof(header),
+                                       interface->size - sizeof(header));
+    memcpy(interface->memory, &header, sizeof(header));
+    module_interface_bind(interface);
+
+    free(builder.entries);
+    free(builder.parameters);
+    free(builder.string_offsets);
+    free(builder.intern_slots);
+    string_buffer_free(builder.strings);
+
+    return interface;
+}
+
+bool module_interface_write(ModuleInterface* interface, const char* path) {
+    if (interface == NULL || path == NULL) return false;
+
+    // Write to a temporary name and rename, so readers never see a partial file
+    char temporary[4096];
+    int length = snprintf(temporary, sizeof(temporary), "%s.tmp", path);
+    if (length < 0 || (size_t)length >= sizeof(temporary)) return false;
+
+    FILE* file = fopen(temporary, "wb");
+    if (file == NULL) return false;
+
+    bool written = fwrite(interface->memory, 1, interface->size, file) == interface->size;
+    written = fclose(file) == 0 && written;
+    if (!written || rename(temporary, path) != 0) {
+        remove(temporary);
+        return false;
+    }
+
+    return true;
+}
+
+// Interface files are named after their module, so a dependent finds the
+// file without knowing the hash it has to match
+bool module_interface_path(char* buffer, size_t size, const char* directory, const char* module_name) {
+    if (buffer == NULL || directory == NULL || module_name == NULL) return false;
+
+    int length = snprintf(buffer, size, "%s/%s.cmi", directory, module_name);
+    return length >= 0 && (size_t)length < size;
+}
+
+ModuleInterface* module_interface_open(const char* path, uint64_t source_hash) {
+    if (path == NULL) return NULL;
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return NULL;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(ModuleInterfaceHeader)) {
+        close(fd);
+        return NULL;
+    }
+
+    size_t size = (size_t)info.st_size;
+    void* memory = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (memory == MAP_FAILED) return NULL;
+
+    const ModuleInterfaceHeader* header = memory;
+    bool valid = header->magic == MODULE_INTERFACE_MAGIC &&
+                 header->version == MODULE_INTERFACE_VERSION &&
+                 header->source_hash == source_hash &&
+                 module_interface_expected_size(header) == size;
+
+    // Strings are read in place, so the table must end in a terminator, and
+    // the content must be what was hashed when the file was written
+    if (valid && header->string_bytes > 0) {
+        valid = ((const char*)memory)[size - 1] == '\0';
+    }
+    if (valid) {
+        valid = hash_bytes((const char*)memory + sizeof(ModuleInterfaceHeader),
+                           size - sizeof(ModuleInterfaceHeader)) == header->interface_hash;
+    }
+
+    if (!valid) {
+        munmap(memory, size);
+        return NULL;
+    }
+
+    ModuleInterface* interface;
+    SAFE_MALLOC(interface, sizeof(ModuleInterface));
+    interface->memory = memory;
+    interface->size = size;
+    interface->mapped = true;
+    module_interface_bind(interface);
+
+    return interface;
+}
+
+void module_interface_free(ModuleInterface* interface) {
+    if (interface == NULL) return;
+
+    if (interface->mapped) {
+        munmap(interface->memory, interface->size);
+    } else {
+        free(interface->memory);
+    }
+    free(interface);
+}
+
+// Accessors bounds-check every index, so a corrupt file cannot read outside
+// the mapping
+uint64_t module_interface_hash(const ModuleInterface* interface) {
+    return interface ? interface->header->interface_hash : 0;
+}
+
+uint32_t module_interface_entry_count(const ModuleInterface* interface) {
+    return interface ? interface->header->entry_count : 0;
+}
+
+const ModuleEntry* module_interface_entry(const ModuleInterface* interface, uint32_t index) {
+    if (interface == NULL || index >= interface->header->entry_count) return NULL;
+    return &interface->entries[index];
+}
+
+const ModuleParameter* module_interface_parameter(const ModuleInterface* interface, const ModuleEntry* entry,
+                                                  uint32_t position) {
+    if (interface == NULL || entry == NULL || position >= entry->parameter_count) return NULL;
+
+    uint32_t index = entry->first_parameter + position;
+    if (index < entry->first_parameter || index >= interface->header->parameter_count) return NULL;
+    return &interface->parameters[index];
+}
+
+const char* module_interface_string(const ModuleInterface* interface, uint32_t id) {
+    if (interface == NULL || id >= interface->header->string_count) return NULL;
+
+    uint32_t offset = interface->string_offsets[id];
+    if (offset >= interface->header->string_bytes) return NULL;
+    return interface->strings + offset;
+}
+
+// Imported declarations have no position in the importing source
+static void module_import_error(SemanticAnalyzer* analyzer, const char* name) {
+    char message[256];
+    snprintf(message, sizeof(message), "Redeclaration of imported '%s'", name);
+
+    error_free(analyzer->last_error);
+    analyzer->last_error = error_create(ERROR_SEMANTIC, message, 0, 0, NULL);
+    analyzer->had_error = true;
+}
+
+static Symbol* module_import_function(const ModuleInterface* interface, const ModuleEntry* entry,
+                                      const char* name) {
+    Symbol* symbol = symbol_create_function(name, module_interface_string(interface, entry->type), 0, 0);
+    if (symbol == NULL || entry->parameter_count == 0) return symbol;
+
+    symbol->data.function.parameters = malloc(sizeof(Symbol*) * entry->parameter_count);
+    if (symbol->data.function.parameters == NULL) {
+        symbol_free(symbol);
+        return NULL;
+    }
+    for (uint32_t i = 0; i < entry->parameter_count; i++) {
+        const ModuleParameter* parameter = module_interface_parameter(interface, entry, i);
+        Symbol* symbol_parameter = parameter == NULL ? NULL :
+            symbol_create_parameter(module_interface_string(interface, parameter->name),
+                                    module_interface_string(interface, parameter->type), (int)i, 0, 0);
+        if (symbol_parameter == NULL) {
+            symbol_free(symbol);
+            return NULL;
+        }
+        symbol->data.function.parameters[symbol->data.function.parameter_count++] = symbol_parameter;
+    }
+    return symbol;
+}
+
+bool module_interface_import(const ModuleInterface* interface, SemanticAnalyzer* analyzer) {
+    if (interface == NULL || analyzer == NULL) return false;
+    if (analyzer->current_scope == NULL || analyzer->current_scope->scope_level != 0) return false;
+
+    bool ok = true;
+    for (uint32_t i = 0; i < interface->header->entry_count; i++) {
+        const ModuleEntry* entry = &interface->entries[i];
+        const char* name = module_interface_string(interface, entry->name);
+        if (name == NULL) {
+            ok = false;
+            continue;
+        }
+        if (symbol_table_lookup_local(analyzer->current_scope, name) != NULL) {
+            module_import_error(analyzer, name);
+            ok = false;
+            continue;
+        }
+
+        Symbol* symbol = NULL;
+        if (entry->kind == MODULE_ENTRY_FUNCTION) {
+            symbol = module_import_function(interface, entry, name);
+        } else if (entry->kind == MODULE_ENTRY_VARIABLE) {
+            symbol = symbol_create_variable(name, module_interface_string(interface, entry->type),
+                                            entry->is_mutable, 0, 0);
+        }
+        if (symbol == NULL) {
+            ok = false;
+            continue;
+        }
+
+        symbol_table_add(analyzer->current_scope, symbol);
+        if (symbol->type == SYMBOL_VARIABLE) symbol->slot = analyzer->global_count++;
+    }
+    return ok;
+}
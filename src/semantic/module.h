@@ -0,0 +1,97 @@
+#ifndef MODULE_H
+#define MODULE_H
+
+#include "semantic.h"
+
+// Module interface files. After a module is analyzed, its top-level
+// declarations are exported as a compact binary interface: function
+// signatures, global variable types and the values of globals initialized
+// with a literal. A module that depends on it imports the interface into
+// its analyzer instead of parsing and analyzing the dependency's source.
+// An interface is keyed by the hash of the source it was built from and is
+// rejected when that no longer matches. Its own interface_hash covers only
+// what it exports, so dependents need to be analyzed again only when it
+// changes, not on every edit to a function body.
+
+#define MODULE_INTERFACE_MAGIC 0x46494d43u   // "CMIF"
+#define MODULE_INTERFACE_VERSION 1
+#define MODULE_NONE UINT32_MAX               // Absent string
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t source_hash;
+    uint64_t interface_hash;                 // Hash of everything after the header
+    uint32_t entry_count;
+    uint32_t parameter_count;
+    uint32_t string_count;
+    uint32_t string_bytes;
+} ModuleInterfaceHeader;
+
+typedef enum {
+    MODULE_ENTRY_FUNCTION,
+    MODULE_ENTRY_VARIABLE
+} ModuleEntryKind;
+
+// One exported declaration, in source order. Types are stored as the
+// canonical spelling of their descriptor (see type_from_name). A variable
+// with a literal initializer is a constant: value_type is the literal's
+// DataType and value holds an int or bool, the bits of a float or the
+// string id of a string.
+typedef struct {
+    uint8_t kind;                            // ModuleEntryKind
+    uint8_t is_mutable;
+    uint8_t constant;
+    uint8_t value_type;                      // DataType
+    uint32_t name;
+    uint32_t type;                           // Variable type or function return type
+    uint32_t first_parameter;                // Index in the parameter table
+    uint32_t parameter_count;
+    uint32_t reserved;
+    uint64_t value;
+} ModuleEntry;
+
+typedef struct {
+    uint32_t name;
+    uint32_t type;
+} ModuleParameter;
+
+// A validated interface, either mmapped from a file or built in memory
+typedef struct {
+    const ModuleInterfaceHeader* header;
+    const ModuleEntry* entries;
+    const ModuleParameter* parameters;
+    const uint32_t* string_offsets;
+    const char* strings;
+    void* memory;
+    size_t size;
+    bool mapped;
+} ModuleInterface;
+
+// Writing. program must have been analyzed by analyzer without errors;
+// declarations that did not resolve are left out.
+ModuleInterface* module_interface_build(ASTNode* program, SemanticAnalyzer* analyzer, uint64_t source_hash);
+bool module_interface_write(ModuleInterface* interface, const char* path);
+bool module_interface_path(char* buffer, size_t size, const char* directory, const char* module_name);
+
+// Reading (NULL if missing, malformed, another version or a different source)
+ModuleInterface* module_interface_open(const char* path, uint64_t source_hash);
+void module_interface_free(ModuleInterface* interface);
+
+// Access in place
+uint64_t module_interface_hash(const ModuleInterface* interface);
+uint32_t module_interface_entry_count(const ModuleInterface* interface);
+const ModuleEntry* module_interface_entry(const ModuleInterface* interface, uint32_t index);
+const ModuleParameter* module_interface_parameter(const ModuleInterface* interface, const ModuleEntry* entry,
+                                                  uint32_t position);
+const char* module_interface_string(const ModuleInterface* interface, uint32_t id);
+
+// Declares every entry in the analyzer's global scope, as if the module's
+// declarations preceded the program about to be analyzed. Imported
+// variables take global slots like any other global. Must be called at
+// global scope; a name that is already declared is reported as a
+// redeclaration and the rest of the interface is still imported. Returns
+// false if anything was reported.
+bool module_interface_import(const ModuleInterface* interface, SemanticAnalyzer* analyzer);
+
+#endif // MODULE_H
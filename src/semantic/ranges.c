@@ -0,0 +1,648 @@
+#include "ranges.h"
+#include "effects.h"
+
+#define RANGE_TOP ((Range){ INT64_MIN, INT64_MAX })
+
+// Values of the tracked variables at one program point. An unreachable
+// state holds no values.
+typedef struct {
+    Range* values;
+    bool reachable;
+} RangeState;
+
+typedef struct {
+    SemanticAnalyzer* analyzer;
+    bool globals;                // Tracks global slots (top-level code) rather than frame slots
+    int variable_count;
+    bool annotate;               // Record facts; off while loop heads settle
+    bool peek;                   // Evaluate without changing the state (branch conditions)
+    RangeStats stats;
+} RangeContext;
+
+unsigned range_facts(Range range) {
+    unsigned facts = 0;
+    if (range.min > 0 || range.max < 0) facts |= RANGE_NONZERO;
+    if (range.min >= 0) facts |= RANGE_NONNEGATIVE;
+    if (range.min >= 0 && range.max <= INT32_MAX) facts |= RANGE_SMALL;
+    return facts;
+}
+
+// Exact bounds, which wrap when they leave 64 bits
+static Range range_from_exact(__int128 min, __int128 max, bool* overflows) {
+    *overflows = min < INT64_MIN || max > INT64_MAX;
+    if (*overflows) return RANGE_TOP;
+    return (Range){ (int64_t)min, (int64_t)max };
+}
+
+static Range range_join(Range a, Range b) {
+    return (Range){ MIN(a.min, b.min), MAX(a.max, b.max) };
+}
+
+// Bounds still moving after an iteration become unbounded
+static Range range_widen(Range old, Range next) {
+    return (Range){ next.min < old.min ? INT64_MIN : old.min, next.max > old.max ? INT64_MAX : old.max };
+}
+
+// States
+static RangeState range_state_create(RangeContext* context) {
+    RangeState state;
+    SAFE_MALLOC(state.values, sizeof(Range) * MAX(context->variable_count, 1));
+    for (int i = 0; i < context->variable_count; i++) {
+        state.values[i] = RANGE_TOP;
+    }
+    state.reachable = true;
+    return state;
+}
+
+static void range_state_copy(RangeContext* context, RangeState* to, const RangeState* from) {
+    memcpy(to->values, from->values, sizeof(Range) * context->variable_count);
+    to->reachable = from->reachable;
+}
+
+static RangeState range_state_clone(RangeContext* context, const RangeState* from) {
+    RangeState state = range_state_create(context);
+    range_state_copy(context, &state, from);
+    return state;
+}
+
+static void range_state_join(RangeContext* context, RangeState* into, const RangeState* other) {
+    if (!other->reachable) return;
+    if (!into->reachable) {
+        range_state_copy(context, into, other);
+        return;
+    }
+    for (int i = 0; i < context->variable_count; i++) {
+        into->values[i] = range_join(into->values[i], other->values[i]);
+    }
+}
+
+static bool range_state_equal(RangeContext* context, const RangeState* a, const RangeState* b) {
+    if (a->reachable != b->reachable) return false;
+    if (!a->reachable) return true;
+    return memcmp(a->values, b->values, sizeof(Range) * context->variable_count) == 0;
+}
+
+// Slot of a variable the context tracks, or -1
+static int range_slot(RangeContext* context, ASTNode* node) {
+    if (node->resolved_slot < 0 || node->resolved_global != context->globals) return -1;
+    return node->resolved_slot < context->variable_count ? node->resolved_slot : -1;
+}
+
+// Expressions
+static Range range_eval(RangeContext* context, ASTNode* node, RangeState* state);
+
+static Range range_divide(Range a, Range b, bool* overflows) {
+    // Truncating division is extreme at the corners of each sign of divisor
+    __int128 min = INT64_MAX;
+    __int128 max = INT64_MIN;
+    Range parts[2] = { { b.min, MIN(b.max, -1) }, { MAX(b.min, 1), b.max } };
+    for (int p = 0; p < 2; p++) {
+        if (parts[p].min > parts[p].max) continue;
+        int64_t dividends[2] = { a.min, a.max };
+        int64_t divisors[2] = { parts[p].min, parts[p].max };
+        for (int i = 0; i < 2; i++) {
+            for (int j = 0; j < 2; j++) {
+                __int128 quotient = (__int128)dividends[i] / divisors[j];
+                min = MIN(min, quotient);
+                max = MAX(max, quotient);
+            }
+        }
+    }
+    if (min > max) {
+        // The divisor is always zero: no value comes out
+        *overflows = false;
+        return RANGE_TOP;
+    }
+    return range_from_exact(min, max, overflows);
+}
+
+static Range range_modulo(Range a, Range b) {
+    // The remainder has the dividend's sign and is smaller than the divisor
+    __int128 limit = MAX(-(__int128)b.min, (__int128)b.max) - 1;
+    if (limit < 0) return RANGE_TOP;
+    __int128 min = a.min >= 0 ? 0 : MAX(-limit, (__int128)a.min);
+    __int128 max = a.max <= 0 ? 0 : MIN(limit, (__int128)a.max);
+    return (Range){ (int64_t)min, (int64_t)max };
+}
+
+static bool range_is_power_of_two(ASTNode* node) {
+    if (node->type != NODE_LITERAL || node->token == NULL || node->token->type != TOKEN_INTEGER_LITERAL) return false;
+    int value = node->data.literal.int_value;
+    return value > 1 && (value & (value - 1)) == 0;
+}
+
+static void range_refine(RangeContext* context, ASTNode* condition, bool truth, RangeState* state);
+
+// The right operand of && runs only where the left is true, that of || only
+// where it is false; the state after either joins those paths with the one
+// where the left decided
+static Range range_eval_logical(RangeContext* context, ASTNode* node, RangeState* state) {
+    bool and = node->data.binary.op == OP_LOGICAL_AND;
+    range_eval(context, node->data.binary.left, state);
+    if (context->peek) {
+        range_eval(context, node->data.binary.right, state);
+        return (Range){ 0, 1 };
+    }
+
+    RangeState rest = range_state_clone(context, state);
+    range_refine(context, node->data.binary.left, and, &rest);
+    if (rest.reachable) {
+        range_eval(context, node->data.binary.right, &rest);
+    } else if (context->annotate) {
+        // Never runs, so its facts must hold for any values
+        RangeState anything = range_state_create(context);
+        range_eval(context, node->data.binary.right, &anything);
+        free(anything.values);
+    }
+    range_refine(context, node->data.binary.left, !and, state);
+    range_state_join(context, state, &rest);
+    free(rest.values);
+    return (Range){ 0, 1 };
+}
+
+static Range range_eval_binary(RangeContext* context, ASTNode* node, RangeState* state) {
+    if (node->data.binary.op == OP_LOGICAL_AND || node->data.binary.op == OP_LOGICAL_OR) {
+        Range result = range_eval_logical(context, node, state);
+        if (context->annotate) node->range_facts = (uint8_t)range_facts(result);
+        return result;
+    }
+
+    Range a = range_eval(context, node->data.binary.left, state);
+    Range b = range_eval(context, node->data.binary.right, state);
+    unsigned left = range_facts(a);
+    unsigned right = range_facts(b);
+    bool overflows = false;
+    Range result;
+
+    switch (node->data.binary.op) {
+        case OP_ADD:
+            result = range_from_exact((__int128)a.min + b.min, (__int128)a.max + b.max, &overflows);
+            break;
+
+        case OP_SUBTRACT:
+            result = range_from_exact((__int128)a.min - b.max, (__int128)a.max - b.min, &overflows);
+            break;
+
+        case OP_MULTIPLY: {
+            __int128 products[4] = { (__int128)a.min * b.min, (__int128)a.min * b.max,
+                                     (__int128)a.max * b.min, (__int128)a.max * b.max };
+            __int128 min = products[0];
+            __int128 max = products[0];
+            for (int i = 1; i < 4; i++) {
+                min = MIN(min, products[i]);
+                max = MAX(max, products[i]);
+            }
+            result = range_from_exact(min, max, &overflows);
+            break;
+        }
+
+        case OP_DIVIDE:
+            result = range_divide(a, b, &overflows);
+            break;
+
+        case OP_MODULO:
+            // idiv computes both, so the remainder faults where the quotient overflows
+            range_divide(a, b, &overflows);
+            result = range_modulo(a, b);
+            break;
+
+        case OP_BITWISE_AND:
+            // Masking with a nonnegative value bounds the result by it
+            result = RANGE_TOP;
+            if (a.min >= 0) result = (Range){ 0, a.max };
+            if (b.min >= 0) result = (Range){ 0, a.min >= 0 ? MIN(a.max, b.max) : b.max };
+            break;
+
+        case OP_EQUAL:
+        case OP_NOT_EQUAL:
+        case OP_LESS:
+        case OP_LESS_EQUAL:
+        case OP_GREATER:
+        case OP_GREATER_EQUAL:
+            result = (Range){ 0, 1 };
+            break;
+
+        default:
+            result = RANGE_TOP;
+            break;
+    }
+
+    if (context->annotate) {
+        unsigned facts = range_facts(result);
+        switch (node->data.binary.op) {
+            case OP_ADD:
+            case OP_SUBTRACT:
+            case OP_MULTIPLY:
+                context->stats.arithmetic++;
+                if (!overflows) {
+                    facts |= RANGE_NO_OVERFLOW;
+                    context->stats.overflow_checks_removed++;
+                }
+                if ((facts & left & right & RANGE_SMALL) != 0) context->stats.narrowed++;
+                break;
+
+            case OP_DIVIDE:
+            case OP_MODULO:
+                // Only the most negative value divided by -1 overflows
+                if (!overflows) facts |= RANGE_NO_OVERFLOW;
+                context->stats.divisions++;
+                if (right & RANGE_NONZERO) context->stats.zero_checks_removed++;
+                if ((left & RANGE_NONNEGATIVE) && range_is_power_of_two(node->data.binary.right)) {
+                    context->stats.shift_divisions++;
+                }
+                break;
+
+            default:
+                break;
+        }
+        node->range_facts = (uint8_t)facts;
+    }
+    return result;
+}
+
+static Range range_eval_call(RangeContext* context, ASTNode* node, RangeState* state) {
+    for (int i = 0; i < node->data.call.argument_count; i++) {
+        range_eval(context, node->data.call.arguments[i], state);
+    }
+
+    // Calls cannot reach a frame, but may assign the globals of top-level code
+    if (context->globals && !context->peek && (effects_of(node, context->analyzer) & EFFECT_WRITES_GLOBALS)) {
+        for (int i = 0; i < context->variable_count; i++) {
+            state->values[i] = RANGE_TOP;
+        }
+    }
+    return RANGE_TOP;
+}
+
+static Range range_eval_node(RangeContext* context, ASTNode* node, RangeState* state) {
+    if (node == NULL) return RANGE_TOP;
+
+    Range result = RANGE_TOP;
+    switch (node->type) {
+        case NODE_LITERAL:
+            if (node->token != NULL && node->token->type == TOKEN_INTEGER_LITERAL) {
+                result = (Range){ node->data.literal.int_value, node->data.literal.int_value };
+            } else if (node->token != NULL && (node->token->type == TOKEN_TRUE || node->token->type == TOKEN_FALSE)) {
+                result = (Range){ node->data.literal.bool_value, node->data.literal.bool_value };
+            }
+            break;
+
+        case NODE_IDENTIFIER: {
+            int slot = range_slot(context, node);
+            if (slot >= 0) result = state->values[slot];
+            break;
+        }
+
+        case NODE_ASSIGNMENT_EXPRESSION: {
+            result = range_eval(context, node->data.binary.right, state);
+            int slot = range_slot(context, node->data.binary.left);
+            if (slot >= 0 && !context->peek) state->values[slot] = result;
+            break;
+        }
+
+        case NODE_BINARY_EXPRESSION:
+            result = range_eval_binary(context, node, state);
+            break;
+
+        case NODE_UNARY_EXPRESSION: {
+            Range operand = range_eval(context, node->data.unary.operand, state);
+            const char* op = node->data.unary.operator;
+            bool overflows;
+            if (op != NULL && strcmp(op, "-") == 0) {
+                result = range_from_exact(-(__int128)operand.max, -(__int128)operand.min, &overflows);
+            } else if (op != NULL && strcmp(op, "!") == 0) {
+                result = (Range){ 0, 1 };
+            }
+            break;
+        }
+
+        case NODE_CALL_EXPRESSION:
+            result = range_eval_call(context, node, state);
+            break;
+
+        default:
+            break;
+    }
+
+    // Floats are not tracked
+    if (node->resolved_type == TYPE_FLOAT + 1) result = RANGE_TOP;
+    if (context->annotate && node->type != NODE_BINARY_EXPRESSION) {
+        node->range_facts = node->resolved_type == TYPE_FLOAT + 1 ? 0 : (uint8_t)range_facts(result);
+    }
+    return result;
+}
+
+// Whether an expression reads no variable
+static bool range_is_constant(ASTNode* node) {
+    switch (node->type) {
+        case NODE_LITERAL:
+            return true;
+        case NODE_UNARY_EXPRESSION:
+            return range_is_constant(node->data.unary.operand);
+        case NODE_BINARY_EXPRESSION:
+            return range_is_constant(node->data.binary.left) && range_is_constant(node->data.binary.right);
+        default:
+            return false;
+    }
+}
+
+// A hash-consed expression over variables stands for every place it is
+// used, and the facts of one place need not hold at another, so it gets none
+static Range range_eval(RangeContext* context, ASTNode* node, RangeState* state) {
+    if (node == NULL || !context->annotate || !node->hash_consed || range_is_constant(node)) {
+        return range_eval_node(context, node, state);
+    }
+
+    context->annotate = false;
+    Range result = range_eval_node(context, node, state);
+    context->annotate = true;
+    return result;
+}
+
+// Value of an expression in state, without assignments or annotations
+static Range range_peek(RangeContext* context, ASTNode* node, RangeState* state) {
+    bool annotate = context->annotate;
+    bool peek = context->peek;
+    context->annotate = false;
+    context->peek = true;
+    Range result = range_eval(context, node, state);
+    context->annotate = annotate;
+    context->peek = peek;
+    return result;
+}
+
+// Conditions
+static BinaryOperator range_negate(BinaryOperator op) {
+    switch (op) {
+        case OP_LESS: return OP_GREATER_EQUAL;
+        case OP_LESS_EQUAL: return OP_GREATER;
+        case OP_GREATER: return OP_LESS_EQUAL;
+        case OP_GREATER_EQUAL: return OP_LESS;
+        case OP_EQUAL: return OP_NOT_EQUAL;
+        case OP_NOT_EQUAL: return OP_EQUAL;
+        default: return OP_INVALID;
+    }
+}
+
+static BinaryOperator range_mirror(BinaryOperator op) {
+    switch (op) {
+        case OP_LESS: return OP_GREATER;
+        case OP_LESS_EQUAL: return OP_GREATER_EQUAL;
+        case OP_GREATER: return OP_LESS;
+        case OP_GREATER_EQUAL: return OP_LESS_EQUAL;
+        default: return op;
+    }
+}
+
+// Narrows the variable in slot to the values for which "variable op bound" holds
+static void range_restrict(RangeState* state, int slot, BinaryOperator op, Range bound) {
+    Range value = state->values[slot];
+    __int128 min = value.min;
+    __int128 max = value.max;
+
+    switch (op) {
+        case OP_LESS: max = MIN(max, (__int128)bound.max - 1); break;
+        case OP_LESS_EQUAL: max = MIN(max, (__int128)bound.max); break;
+        case OP_GREATER: min = MAX(min, (__int128)bound.min + 1); break;
+        case OP_GREATER_EQUAL: min = MAX(min, (__int128)bound.min); break;
+        case OP_EQUAL:
+            min = MAX(min, (__int128)bound.min);
+            max = MIN(max, (__int128)bound.max);
+            break;
+        case OP_NOT_EQUAL:
+            if (bound.min == bound.max && bound.min == value.min) min++;
+            if (bound.min == bound.max && bound.max == value.max) max--;
+            break;
+        default:
+            return;
+    }
+
+    if (min > max) {
+        state->reachable = false;
+        return;
+    }
+    state->values[slot] = (Range){ (int64_t)min, (int64_t)max };
+}
+
+// Whether evaluating node may change a tracked variable: an assignment, or
+// in top-level code a call that writes globals
+static bool range_assigns(RangeContext* context, ASTNode* node) {
+    if (node == NULL) return false;
+    switch (node->type) {
+        case NODE_ASSIGNMENT_EXPRESSION:
+            return true;
+        case NODE_BINARY_EXPRESSION:
+            return range_assigns(context, node->data.binary.left) || range_assigns(context, node->data.binary.right);
+        case NODE_UNARY_EXPRESSION:
+            return range_assigns(context, node->data.unary.operand);
+        case NODE_CALL_EXPRESSION:
+            if (context->globals && (effects_of(node, context->analyzer) & EFFECT_WRITES_GLOBALS)) return true;
+            for (int i = 0; i < node->data.call.argument_count; i++) {
+                if (range_assigns(context, node->data.call.arguments[i])) return true;
+            }
+            return false;
+        default:
+            return false;
+    }
+}
+
+// Narrows state to where condition, already evaluated in it, is truth. What
+// the left operand said about a variable no longer holds once the right one
+// may have assigned it.
+static void range_refine(RangeContext* context, ASTNode* condition, bool truth, RangeState* state) {
+    if (condition == NULL || !state->reachable) return;
+
+    if (condition->type == NODE_UNARY_EXPRESSION && condition->data.unary.operator != NULL &&
+        strcmp(condition->data.unary.operator, "!") == 0) {
+        range_refine(context, condition->data.unary.operand, !truth, state);
+        return;
+    }
+
+    if (condition->type == NODE_IDENTIFIER) {
+        int slot = range_slot(context, condition);
+        if (slot >= 0) range_restrict(state, slot, truth ? OP_NOT_EQUAL : OP_EQUAL, (Range){ 0, 0 });
+        return;
+    }
+
+    if (condition->type != NODE_BINARY_EXPRESSION) return;
+    BinaryOperator op = condition->data.binary.op;
+    ASTNode* left = condition->data.binary.left;
+    ASTNode* right = condition->data.binary.right;
+
+    if (op == OP_LOGICAL_AND || op == OP_LOGICAL_OR) {
+        // Both operands hold when && is true, neither when || is false
+        if (truth == (op == OP_LOGICAL_AND)) {
+            if (!range_assigns(context, right)) range_refine(context, left, truth, state);
+            range_refine(context, right, truth, state);
+        }
+        return;
+    }
+
+    if (!truth) op = range_negate(op);
+    if (op == OP_INVALID) return;
+
+    int slot = range_assigns(context, right) ? -1 : range_slot(context, left);
+    if (slot >= 0) range_restrict(state, slot, op, range_peek(context, right, state));
+    slot = range_slot(context, right);
+    if (slot >= 0 && state->reachable) {
+        range_restrict(state, slot, range_mirror(op), range_peek(context, left, state));
+    }
+}
+
+// Statements
+static void range_exec(RangeContext* context, ASTNode* node, RangeState* state);
+
+static void range_exec_while(RangeContext* context, ASTNode* node, RangeState* state) {
+    ASTNode* condition = node->data.conditional.condition;
+    ASTNode* body = node->data.conditional.then_branch;
+    RangeState head = range_state_clone(context, state);
+    RangeState next = range_state_create(context);
+    RangeState pass = range_state_create(context);
+    bool annotate = context->annotate;
+    context->annotate = false;
+
+    // The head is what enters the loop joined with what comes back around.
+    // After the first iteration moving bounds are widened, then one more
+    // round without widening takes back what the test bounds.
+    for (int iteration = 0;; iteration++) {
+        range_state_copy(context, &pass, &head);
+        range_eval(context, condition, &pass);
+        range_refine(context, condition, true, &pass);
+        range_exec(context, body, &pass);
+        range_state_copy(context, &next, state);
+        range_state_join(context, &next, &pass);
+        context->stats.loop_iterations++;
+
+        if (iteration > 0 && next.reachable && head.reachable) {
+            for (int i = 0; i < context->variable_count; i++) {
+                next.values[i] = range_widen(head.values[i], next.values[i]);
+            }
+        }
+        if (range_state_equal(context, &next, &head)) break;
+        range_state_copy(context, &head, &next);
+    }
+
+    range_state_copy(context, &pass, &head);
+    range_eval(context, condition, &pass);
+    range_refine(context, condition, true, &pass);
+    range_exec(context, body, &pass);
+    range_state_copy(context, &next, state);
+    range_state_join(context, &next, &pass);
+    range_state_copy(context, &head, &next);
+
+    // The settled head holds on every iteration, so facts found from it hold
+    context->annotate = annotate;
+    range_state_copy(context, state, &head);
+    range_eval(context, condition, state);
+    if (annotate) {
+        range_state_copy(context, &pass, state);
+        range_refine(context, condition, true, &pass);
+        range_exec(context, body, &pass);
+    }
+    range_refine(context, condition, false, state);
+
+    free(head.values);
+    free(next.values);
+    free(pass.values);
+}
+
+static void range_exec(RangeContext* context, ASTNode* node, RangeState* state) {
+    if (node == NULL) return;
+
+    // Unreachable code changes nothing, but its facts are replaced with
+    // ones that hold for any values
+    if (!state->reachable) {
+        if (context->annotate) {
+            RangeState anything = range_state_create(context);
+            range_exec(context, node, &anything);
+            free(anything.values);
+        }
+        return;
+    }
+
+    switch (node->type) {
+        case NODE_PROGRAM:
+        case NODE_BLOCK_STATEMENT:
+            for (int i = 0; i < node->data.block.statement_count; i++) {
+                range_exec(context, node->data.block.statements[i], state);
+            }
+            break;
+
+        case NODE_VARIABLE_DECLARATION: {
+            ASTNode* initializer = node->data.declaration.initializer;
+            Range value = initializer != NULL ? range_eval(context, initializer, state) : RANGE_TOP;
+            int slot = range_slot(context, node);
+            if (slot >= 0) state->values[slot] = value;
+            break;
+        }
+
+        case NODE_EXPRESSION_STATEMENT:
+            range_eval(context, node->data.statement.expression, state);
+            break;
+
+        case NODE_RETURN_STATEMENT:
+            range_eval(context, node->data.statement.expression, state);
+            state->reachable = false;
+            break;
+
+        case NODE_IF_STATEMENT: {
+            ASTNode* condition = node->data.conditional.condition;
+            range_eval(context, condition, state);
+            RangeState other = range_state_clone(context, state);
+            range_refine(context, condition, true, state);
+            range_exec(context, node->data.conditional.then_branch, state);
+            range_refine(context, condition, false, &other);
+            range_exec(context, node->data.conditional.else_branch, &other);
+            range_state_join(context, state, &other);
+            free(other.values);
+            break;
+        }
+
+        case NODE_WHILE_STATEMENT:
+            range_exec_while(context, node, state);
+            break;
+
+        case NODE_FUNCTION_DECLARATION:
+            // Analyzed on its own
+            break;
+
+        default:
+            range_eval(context, node, state);
+            break;
+    }
+}
+
+static void range_analyze_function(RangeContext* context, ASTNode* function) {
+    context->globals = false;
+    context->variable_count = MAX(function->resolved_slot, 0);
+    RangeState state = range_state_create(context);
+    range_exec(context, ast_function_body(function), &state);
+    free(state.values);
+}
+
+bool ranges_analyze(ASTNode* node, SemanticAnalyzer* analyzer, RangeStats* stats) {
+    if (node == NULL || analyzer == NULL) return false;
+    if (node->type != NODE_PROGRAM && node->type != NODE_FUNCTION_DECLARATION) return false;
+
+    RangeContext context = {0};
+    context.analyzer = analyzer;
+    context.annotate = true;
+
+    if (node->type == NODE_FUNCTION_DECLARATION) {
+        range_analyze_function(&context, node);
+    } else {
+        context.globals = true;
+        context.variable_count = analyzer->global_count;
+        RangeState state = range_state_create(&context);
+        range_exec(&context, node, &state);
+        free(state.values);
+
+        for (int i = 0; i < node->data.block.statement_count; i++) {
+            ASTNode* statement = node->data.block.statements[i];
+            if (statement->type == NODE_FUNCTION_DECLARATION) range_analyze_function(&context, statement);
+        }
+    }
+
+    if (stats != NULL) *stats = context.stats;
+    return true;
+}
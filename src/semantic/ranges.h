@@ -0,0 +1,51 @@
+#ifndef RANGES_H
+#define RANGES_H
+
+#include "semantic.h"
+
+// Integer range analysis. Every integer expression of a resolved program is
+// given an interval of the values it can take, and what the code generator
+// can use of it is recorded on the node (ASTNode.range_facts). Variables are
+// tracked by slot: frame slots within a function, global slots in the
+// top-level code, which runs in order in one frame. Control flow is followed
+// structurally. Branch conditions that compare a variable narrow it on each
+// arm, and the state at a loop head is iterated until it settles, widening
+// bounds that keep moving to unbounded and then narrowing once, so
+// "while (i < n) i = i + 1;" keeps i's lower bound and the bound the test
+// gives it. Values are 64-bit, as generated code computes them.
+
+// Facts proven about a node's value
+typedef enum {
+    RANGE_NONZERO = 1 << 0,
+    RANGE_NONNEGATIVE = 1 << 1,
+    RANGE_SMALL = 1 << 2,            // In [0, INT32_MAX], so 32-bit instructions compute it exactly
+    RANGE_NO_OVERFLOW = 1 << 3       // An arithmetic operator whose result never overflows
+} RangeFact;
+
+// An interval of 64-bit values; INT64_MIN and INT64_MAX bounds are unbounded
+typedef struct {
+    int64_t min;
+    int64_t max;
+} Range;
+
+typedef struct {
+    int arithmetic;              // +, - and * operators
+    int overflow_checks_removed; // ... proven not to overflow
+    int narrowed;                // ... with small operands and result
+    int divisions;               // / and % operators
+    int zero_checks_removed;     // ... with a divisor proven nonzero
+    int shift_divisions;         // ... of a nonnegative dividend by a power of two
+    int loop_iterations;         // Loop bodies evaluated until their heads settled
+} RangeStats;
+
+// Analyzes a program (its top-level code and every function) or a single
+// function, which analyzer has resolved and left at global scope. Facts of
+// earlier runs are replaced; hash-consed expressions over variables, which
+// stand for several places, get none. Returns false if node is neither;
+// stats, if given, receives the counts of the operators analyzed.
+bool ranges_analyze(ASTNode* node, SemanticAnalyzer* analyzer, RangeStats* stats);
+
+// The facts a value in range satisfies
+unsigned range_facts(Range range);
+
+#endif // RANGES_H
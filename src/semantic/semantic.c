@@ -1,4 +1,173 @@
 #include "semantic.h"
+#include <limits.h>
+#include <pthread.h>
+#include <stdarg.h>
+
+// Type descriptors. Primitives are fixed; everything else is interned in a
+// chained hash table shared by all analyzers and threads. Programs declare
+// few distinct types, so the table never grows.
+static TypeDescriptor primitive_types[] = {
+    [TYPE_INT] = { TYPE_KIND_PRIMITIVE, TYPE_INT, "int", NULL, 0, NULL, 0, 0, NULL },
+    [TYPE_FLOAT] = { TYPE_KIND_PRIMITIVE, TYPE_FLOAT, "float", NULL, 0, NULL, 0, 0, NULL },
+    [TYPE_STRING] = { TYPE_KIND_PRIMITIVE, TYPE_STRING, "string", NULL, 0, NULL, 0, 0, NULL },
+    [TYPE_CHAR] = { TYPE_KIND_PRIMITIVE, TYPE_CHAR, "char", NULL, 0, NULL, 0, 0, NULL },
+    [TYPE_BOOL] = { TYPE_KIND_PRIMITIVE, TYPE_BOOL, "bool", NULL, 0, NULL, 0, 0, NULL },
+    [TYPE_VOID] = { TYPE_KIND_PRIMITIVE, TYPE_VOID, "void", NULL, 0, NULL, 0, 0, NULL },
+    [TYPE_UNKNOWN] = { TYPE_KIND_PRIMITIVE, TYPE_UNKNOWN, "unknown", NULL, 0, NULL, 0, 0, NULL },
+    [TYPE_ERROR] = { TYPE_KIND_PRIMITIVE, TYPE_ERROR, "error", NULL, 0, NULL, 0, 0, NULL },
+};
+
+#define TYPE_TABLE_BUCKETS 1024
+
+static TypeDescriptor* type_table[TYPE_TABLE_BUCKETS];
+static pthread_mutex_t type_table_lock = PTHREAD_MUTEX_INITIALIZER;
+
+const TypeDescriptor* type_primitive(DataType type) {
+    if (type < TYPE_INT || type > TYPE_ERROR) return &primitive_types[TYPE_ERROR];
+    return &primitive_types[type];
+}
+
+static uint32_t type_hash_mix(uint32_t hash, uint64_t value) {
+    hash ^= (uint32_t)(value ^ (value >> 32));
+    return hash * 16777619u;
+}
+
+static bool type_matches(const TypeDescriptor* type, TypeKind kind, const char* name,
+                         const TypeDescriptor* element, int length,
+                         const TypeDescriptor* const* parameters, int parameter_count) {
+    if (type->kind != kind || type->element != element || type->length != length ||
+        type->parameter_count != parameter_count) {
+        return false;
+    }
+    if (kind == TYPE_KIND_NAMED && strcmp(type->name, name) != 0) return false;
+
+    for (int i = 0; i < parameter_count; i++) {
+        if (type->parameters[i] != parameters[i]) return false;
+    }
+    return true;
+}
+
+// Spelling of a compound type, built from its components' spellings
+static char* type_spell(TypeKind kind, const char* name, const TypeDescriptor* element, int length,
+                        const TypeDescriptor* const* parameters, int parameter_count) {
+    if (kind == TYPE_KIND_NAMED) return strdup_safe(name);
+
+    StringBuffer* buffer = string_buffer_create(64);
+    if (buffer == NULL) return NULL;
+
+    string_buffer_append(buffer, element->name);
+    if (kind == TYPE_KIND_POINTER) {
+        string_buffer_append(buffer, "*");
+    } else if (kind == TYPE_KIND_ARRAY) {
+        char suffix[24];
+        snprintf(suffix, sizeof(suffix), "[%d]", length);
+        string_buffer_append(buffer, suffix);
+    } else {
+        string_buffer_append(buffer, "(");
+        for (int i = 0; i < parameter_count; i++) {
+            if (i > 0) string_buffer_append(buffer, ",");
+            string_buffer_append(buffer, parameters[i]->name);
+        }
+        string_buffer_append(buffer, ")");
+    }
+
+    char* spelling = buffer->data;
+    free(buffer);
+    return spelling;
+}
+
+// The unique descriptor with these components, created on first request
+static const TypeDescriptor* type_intern(TypeKind kind, const char* name, const TypeDescriptor* element, int length,
+                                         const TypeDescriptor* const* parameters, int parameter_count) {
+    // Components are already interned, so they hash by identity
+    uint32_t hash = 2166136261u;
+    hash = type_hash_mix(hash, (uint64_t)kind);
+    if (kind == TYPE_KIND_NAMED) hash = type_hash_mix(hash, hash_bytes(name, strlen(name)));
+    hash = type_hash_mix(hash, (uint64_t)(uintptr_t)element);
+    hash = type_hash_mix(hash, (uint64_t)(uint32_t)length);
+    for (int i = 0; i < parameter_count; i++) {
+        hash = type_hash_mix(hash, (uint64_t)(uintptr_t)parameters[i]);
+    }
+
+    pthread_mutex_lock(&type_table_lock);
+
+    TypeDescriptor** bucket = &type_table[hash % TYPE_TABLE_BUCKETS];
+    for (TypeDescriptor* type = *bucket; type != NULL; type = type->next) {
+        if (type->hash == hash && type_matches(type, kind, name, element, length, parameters, parameter_count)) {
+            pthread_mutex_unlock(&type_table_lock);
+            return type;
+        }
+    }
+
+    TypeDescriptor* type = malloc(sizeof(TypeDescriptor));
+    const TypeDescriptor** parameter_copy = NULL;
+    char* spelling = type_spell(kind, name, element, length, parameters, parameter_count);
+    if (parameter_count > 0) {
+        parameter_copy = malloc(sizeof(TypeDescriptor*) * parameter_count);
+    }
+    if (type == NULL || spelling == NULL || (parameter_count > 0 && parameter_copy == NULL)) {
+        pthread_mutex_unlock(&type_table_lock);
+        free(type);
+        free(spelling);
+        free(parameter_copy);
+        return NULL;
+    }
+
+    for (int i = 0; i < parameter_count; i++) {
+        parameter_copy[i] = parameters[i];
+    }
+    type->kind = kind;
+    type->primitive = TYPE_UNKNOWN;
+    type->name = spelling;
+    type->element = element;
+    type->length = length;
+    type->parameters = parameter_copy;
+    type->parameter_count = parameter_count;
+    type->hash = hash;
+    type->next = *bucket;
+    *bucket = type;
+
+    pthread_mutex_unlock(&type_table_lock);
+    return type;
+}
+
+const TypeDescriptor* type_from_name(const char* name) {
+    if (name == NULL) return NULL;
+
+    // Primitive names are recognised without touching the shared table
+    const TypeDescriptor* primitive = NULL;
+    switch (name[0]) {
+        case 'i': primitive = &primitive_types[TYPE_INT]; break;
+        case 'f': primitive = &primitive_types[TYPE_FLOAT]; break;
+        case 's': primitive = &primitive_types[TYPE_STRING]; break;
+        case 'c': primitive = &primitive_types[TYPE_CHAR]; break;
+        case 'b': primitive = &primitive_types[TYPE_BOOL]; break;
+        case 'v': primitive = &primitive_types[TYPE_VOID]; break;
+        default: break;
+    }
+    if (primitive != NULL && strcmp(primitive->name, name) == 0) return primitive;
+
+    return type_intern(TYPE_KIND_NAMED, name, NULL, 0, NULL, 0);
+}
+
+const TypeDescriptor* type_pointer_to(const TypeDescriptor* pointee) {
+    if (pointee == NULL) return NULL;
+    return type_intern(TYPE_KIND_POINTER, NULL, pointee, 0, NULL, 0);
+}
+
+const TypeDescriptor* type_array_of(const TypeDescriptor* element, int length) {
+    if (element == NULL || length < 0) return NULL;
+    return type_intern(TYPE_KIND_ARRAY, NULL, element, length, NULL, 0);
+}
+
+const TypeDescriptor* type_function(const TypeDescriptor* return_type,
+                                    const TypeDescriptor* const* parameters, int parameter_count) {
+    if (return_type == NULL || parameter_count < 0) return NULL;
+    for (int i = 0; i < parameter_count; i++) {
+        if (parameters[i] == NULL) return NULL;
+    }
+    return type_intern(TYPE_KIND_FUNCTION, NULL, return_type, 0, parameters, parameter_count);
+}
 
 // Symbol table functions
 SymbolTable* symbol_table_create(int scope_level) {
@@ -11,8 +180,19 @@ SymbolTable* symbol_table_create(int scope_level) {
         return NULL;
     }
 
+    table->slots = calloc(32, sizeof(SymbolSlot));
+    if (table->slots == NULL) {
+        free(table->symbols);
+        free(table);
+        return NULL;
+    }
+
     table->symbol_count = 0;
     table->capacity = 16;
+    table->slot_capacity = 32;
+    table->bindings = NULL;
+    table->binding_mark = 0;
+    table->stray_count = 0;
     table->parent = NULL;
     table->scope_level = scope_level;
 
@@ -27,11 +207,254 @@ void symbol_table_free(SymbolTable* table) {
     }
 
     free(table->symbols);
+    free(table->slots);
     free(table);
 }
 
+static void scope_bindings_push(SymbolTable* table, Symbol* symbol);
+
+static uint32_t symbol_name_hash(const char* name) {
+    uint64_t hash = hash_bytes(name, strlen(name));
+    return (uint32_t)(hash ^ (hash >> 32));
+}
+
+// Records symbols[index] in the first free slot of its probe sequence. A
+// repeated name lands after the earlier one, so lookups still find the first.
+static void symbol_table_index(SymbolSlot* slots, int slot_capacity, uint32_t hash, int index) {
+    int mask = slot_capacity - 1;
+    int slot = (int)(hash & (uint32_t)mask);
+    while (slots[slot].index != 0) {
+        slot = (slot + 1) & mask;
+    }
+
+    slots[slot].hash = hash;
+    slots[slot].index = index + 1;
+}
+
+static bool symbol_table_grow_slots(SymbolTable* table) {
+    int slot_capacity = table->slot_capacity * 2;
+    SymbolSlot* slots = calloc((size_t)slot_capacity, sizeof(SymbolSlot));
+    if (slots == NULL) return false;
+
+    // Reinserting in insertion order keeps the earlier of two equal names
+    // first in its probe sequence; the old slots supply the stored hashes
+    uint32_t* hashes = malloc(sizeof(uint32_t) * (table->symbol_count + 1));
+    if (hashes == NULL) {
+        free(slots);
+        return false;
+    }
+    for (int i = 0; i < table->slot_capacity; i++) {
+        if (table->slots[i].index != 0) {
+            hashes[table->slots[i].index - 1] = table->slots[i].hash;
+        }
+    }
+    for (int i = 0; i < table->symbol_count; i++) {
+        symbol_table_index(slots, slot_capacity, hashes[i], i);
+    }
+    free(hashes);
+
+    free(table->slots);
+    table->slots = slots;
+    table->slot_capacity = slot_capacity;
+    return true;
+}
+
+static ScopeBindings* scope_bindings_create(void) {
+    ScopeBindings* bindings = malloc(sizeof(ScopeBindings));
+    if (bindings == NULL) return NULL;
+
+    bindings->slot_count = 0;
+    bindings->slot_capacity = 64;
+    bindings->slots = calloc(bindings->slot_capacity, sizeof(BindingSlot));
+    bindings->log_count = 0;
+    bindings->log_capacity = 64;
+    bindings->log = malloc(sizeof(Binding) * bindings->log_capacity);
+    bindings->depth = 0;
+    bindings->stray_count = 0;
+    bindings->outer = NULL;
+    bindings->counters = NULL;
+
+    if (bindings->slots == NULL || bindings->log == NULL) {
+        free(bindings->slots);
+        free(bindings->log);
+        free(bindings);
+        return NULL;
+    }
+    return bindings;
+}
+
+static void scope_bindings_free(ScopeBindings* bindings) {
+    if (bindings == NULL) return;
+
+    for (int i = 0; i < bindings->slot_capacity; i++) {
+        free(bindings->slots[i].name);
+    }
+    free(bindings->slots);
+    free(bindings->log);
+    free(bindings);
+}
+
+// Slot of name, or -1 if it has never been declared. The work is counted
+// in counters unless it is NULL.
+static int scope_bindings_find(ScopeBindings* bindings, const char* name, uint32_t hash,
+                               SemanticCounters* counters) {
+    int mask = bindings->slot_capacity - 1;
+    int slot = (int)(hash & (uint32_t)mask);
+    int probes = 1;
+    int compares = 0;
+
+    while (bindings->slots[slot].name != NULL) {
+        if (bindings->slots[slot].hash == hash) {
+            compares++;
+            if (strcmp(bindings->slots[slot].name, name) == 0) break;
+        }
+        slot = (slot + 1) & mask;
+        probes++;
+    }
+
+    if (counters != NULL) {
+        counters->probes += (uint64_t)probes;
+        counters->name_compares += (uint64_t)compares;
+    }
+    return bindings->slots[slot].name != NULL ? slot : -1;
+}
+
+static bool scope_bindings_grow(ScopeBindings* bindings) {
+    int slot_capacity = bindings->slot_capacity * 2;
+    BindingSlot* slots = calloc((size_t)slot_capacity, sizeof(BindingSlot));
+    if (slots == NULL) return false;
+
+    // The log refers to names by slot, so it moves along with them
+    for (int i = 0; i < bindings->slot_capacity; i++) {
+        BindingSlot entry = bindings->slots[i];
+        if (entry.name == NULL) continue;
+
+        int slot = (int)(entry.hash & (uint32_t)(slot_capacity - 1));
+        while (slots[slot].name != NULL) {
+            slot = (slot + 1) & (slot_capacity - 1);
+        }
+        slots[slot] = entry;
+        for (int binding = entry.top; binding >= 0; binding = bindings->log[binding].shadowed) {
+            bindings->log[binding].slot = slot;
+        }
+    }
+
+    free(bindings->slots);
+    bindings->slots = slots;
+    bindings->slot_capacity = slot_capacity;
+    return true;
+}
+
+// Slot of name, adding an empty one the first time the name is declared
+static int scope_bindings_intern(ScopeBindings* bindings, const char* name, uint32_t hash) {
+    int slot = scope_bindings_find(bindings, name, hash, NULL);
+    if (slot >= 0) return slot;
+
+    if ((bindings->slot_count + 1) * 2 > bindings->slot_capacity && !scope_bindings_grow(bindings)) {
+        return -1;
+    }
+
+    int mask = bindings->slot_capacity - 1;
+    slot = (int)(hash & (uint32_t)mask);
+    while (bindings->slots[slot].name != NULL) {
+        slot = (slot + 1) & mask;
+    }
+
+    bindings->slots[slot].hash = hash;
+    bindings->slots[slot].name = strdup_safe(name);
+    bindings->slots[slot].top = -1;
+    bindings->slot_count++;
+    return slot;
+}
+
+// Binds a symbol added to an analyzer scope. Only the innermost scope can
+// push onto the log; a symbol added to an outer scope while inner ones are
+// open is left unbound ("stray") and lookups scan the scopes instead until
+// it becomes the innermost scope again. Within one scope the first declaration of a name wins.
+static void scope_bindings_push(SymbolTable* table, Symbol* symbol) {
+    ScopeBindings* bindings = table->bindings;
+    if (table->scope_level != bindings->depth || symbol->name == NULL) {
+        table->stray_count++;
+        bindings->stray_count++;
+        return;
+    }
+
+    int slot = scope_bindings_intern(bindings, symbol->name, symbol_name_hash(symbol->name));
+    if (slot < 0) {
+        table->stray_count++;
+        bindings->stray_count++;
+        return;
+    }
+
+    int top = bindings->slots[slot].top;
+    if (top >= 0 && bindings->log[top].scope_level == table->scope_level) return;
+
+    if (bindings->log_count >= bindings->log_capacity) {
+        int log_capacity = bindings->log_capacity * 2;
+        Binding* log = realloc(bindings->log, sizeof(Binding) * log_capacity);
+        if (log == NULL) {
+            table->stray_count++;
+            bindings->stray_count++;
+            return;
+        }
+        bindings->log = log;
+        bindings->log_capacity = log_capacity;
+    }
+
+    bindings->log[bindings->log_count] = (Binding){ symbol, table->scope_level, top, slot };
+    bindings->slots[slot].top = bindings->log_count++;
+}
+
+// Linear search through table and its parents, used while stray symbols exist
+static Symbol* symbol_table_scan(SymbolTable* table, const char* name, bool local_only,
+                                 SemanticCounters* counters) {
+    Symbol* found = NULL;
+    int compares = 0;
+    int scopes = 0;
+    for (SymbolTable* scope = table; scope != NULL && found == NULL; scope = local_only ? NULL : scope->parent) {
+        scopes++;
+        for (int i = 0; i < scope->symbol_count; i++) {
+            compares++;
+            if (strcmp(scope->symbols[i]->name, name) == 0) {
+                found = scope->symbols[i];
+                break;
+            }
+        }
+    }
+
+    if (counters != NULL) {
+        counters->name_compares += (uint64_t)compares;
+        counters->scopes_walked += (uint64_t)(scopes - 1);
+    }
+    return found;
+}
+
+// Innermost binding of name visible from table's scope
+static Symbol* scope_bindings_lookup(SymbolTable* table, const char* name, uint32_t hash, bool local_only,
+                                     SemanticCounters* counters) {
+    ScopeBindings* bindings = table->bindings;
+    if (bindings->stray_count > 0) return symbol_table_scan(table, name, local_only, counters);
+
+    int slot = scope_bindings_find(bindings, name, hash, counters);
+    if (slot < 0) return NULL;
+
+    // Bindings of scopes nested inside table's are not visible from it
+    int binding = bindings->slots[slot].top;
+    int skipped = 0;
+    while (binding >= 0 && bindings->log[binding].scope_level > table->scope_level) {
+        binding = bindings->log[binding].shadowed;
+        skipped++;
+    }
+    if (counters != NULL) counters->scopes_walked += (uint64_t)skipped;
+
+    if (binding < 0) return NULL;
+    if (local_only && bindings->log[binding].scope_level != table->scope_level) return NULL;
+    return bindings->log[binding].symbol;
+}
+
 Symbol* symbol_table_add(SymbolTable* table, Symbol* symbol) {
     if (table == NULL || symbol == NULL) return NULL;
+    symbol->scope_level = table->scope_level;
 
     // Check if we need to expand capacity
     if (table->symbol_count >= table->capacity) {
@@ -43,31 +466,104 @@ Symbol* symbol_table_add(SymbolTable* table, Symbol* symbol) {
         table->capacity = new_capacity;
     }
 
+    if (table->bindings != NULL) {
+        scope_bindings_push(table, symbol);
+        table->symbols[table->symbol_count++] = symbol;
+        if (table->bindings->counters != NULL) table->bindings->counters->symbols_declared++;
+        return symbol;
+    }
+
+    // Keep the load factor at or below one half
+    if ((table->symbol_count + 1) * 2 > table->slot_capacity && !symbol_table_grow_slots(table)) {
+        return NULL;
+    }
+
+    symbol_table_index(table->slots, table->slot_capacity, symbol_name_hash(symbol->name), table->symbol_count);
     table->symbols[table->symbol_count++] = symbol;
     return symbol;
 }
 
+static Symbol* symbol_table_find(SymbolTable* table, const char* name, uint32_t hash,
+                                 SemanticCounters* counters) {
+    int mask = table->slot_capacity - 1;
+    int slot = (int)(hash & (uint32_t)mask);
+    Symbol* found = NULL;
+    int probes = 1;
+    int compares = 0;
+
+    while (table->slots[slot].index != 0) {
+        if (table->slots[slot].hash == hash) {
+            Symbol* symbol = table->symbols[table->slots[slot].index - 1];
+            compares++;
+            if (strcmp(symbol->name, name) == 0) {
+                found = symbol;
+                break;
+            }
+        }
+        slot = (slot + 1) & mask;
+        probes++;
+    }
+
+    if (counters != NULL) {
+        counters->probes += (uint64_t)probes;
+        counters->name_compares += (uint64_t)compares;
+    }
+    return found;
+}
+
+// Counters are those of the scope the lookup started from, never the outer
+// scope's: parallel workers share that one and count only their own work.
+static Symbol* symbol_table_lookup_hashed(SymbolTable* table, const char* name, uint32_t hash,
+                                          SemanticCounters* counters) {
+    // Current scope first, then its parents. Analyzer scopes answer for
+    // themselves and all their parents, then defer to the bindings' outer scope.
+    for (SymbolTable* scope = table; scope != NULL; scope = scope->parent) {
+        if (scope != table && counters != NULL) counters->scopes_walked++;
+
+        if (scope->bindings != NULL) {
+            Symbol* found = scope_bindings_lookup(scope, name, hash, false, counters);
+            if (found != NULL || scope->bindings->outer == NULL) return found;
+            if (counters != NULL) counters->scopes_walked++;
+            return symbol_table_lookup_hashed(scope->bindings->outer, name, hash, counters);
+        }
+
+        Symbol* found = symbol_table_find(scope, name, hash, counters);
+        if (found != NULL) return found;
+    }
+
+    return NULL;
+}
+
+static SemanticCounters* symbol_table_counters(SymbolTable* table) {
+    return table->bindings != NULL ? table->bindings->counters : NULL;
+}
+
 Symbol* symbol_table_lookup(SymbolTable* table, const char* name) {
     if (table == NULL || name == NULL) return NULL;
 
-    // First check current scope
-    Symbol* found = symbol_table_lookup_local(table, name);
-    if (found != NULL) return found;
-
-    // Then check parent scopes
-    return symbol_table_lookup_global(table, name);
+    // The name is hashed once for every scope searched
+    SemanticCounters* counters = symbol_table_counters(table);
+    Symbol* found = symbol_table_lookup_hashed(table, name, symbol_name_hash(name), counters);
+    if (counters != NULL) {
+        counters->lookups++;
+        counters->lookup_misses += found == NULL;
+    }
+    return found;
 }
 
 Symbol* symbol_table_lookup_local(SymbolTable* table, const char* name) {
     if (table == NULL || name == NULL) return NULL;
 
-    for (int i = 0; i < table->symbol_count; i++) {
-        if (strcmp(table->symbols[i]->name, name) == 0) {
-            return table->symbols[i];
-        }
-    }
+    uint32_t hash = symbol_name_hash(name);
+    if (table->bindings == NULL) return symbol_table_find(table, name, hash, NULL);
 
-    return NULL;
+    SemanticCounters* counters = table->bindings->counters;
+    Symbol* found = scope_bindings_lookup(table, name, hash, true, counters);
+    if (counters != NULL) {
+        counters->lookups++;
+        counters->lookup_misses += found == NULL;
+    }
+    return found;
 }
 
 Symbol* symbol_table_lookup_global(SymbolTable* table, const char* name) {
@@ -84,9 +580,11 @@ Symbol* symbol_create_variable(const char* name, const char* type_name, bool is_
 
     symbol->name = strdup_safe(name);
     symbol->type = SYMBOL_VARIABLE;
-    symbol->data.variable.type_name = strdup_safe(type_name);
+    symbol->data.variable.type = type_from_name(type_name);
+    symbol->data.variable.type_name = symbol->data.variable.type ? symbol->data.variable.type->name : NULL;
     symbol->data.variable.is_mutable = is_mutable;
     symbol->scope_level = 0; // Will be set when added to scope
+    symbol->slot = -1;
     symbol->line = line;
     symbol->column = column;
 
@@ -99,10 +597,13 @@ Symbol* symbol_create_function(const char* name, const char* return_type, int li
 
     symbol->name = strdup_safe(name);
     symbol->type = SYMBOL_FUNCTION;
-    symbol->data.function.return_type = strdup_safe(return_type);
+    symbol->data.function.returns = type_from_name(return_type);
+    symbol->data.function.return_type = symbol->data.function.returns ? symbol->data.function.returns->name : NULL;
     symbol->data.function.parameters = NULL;
     symbol->data.function.parameter_count = 0;
+    symbol->data.function.effects = EFFECT_ALL;
     symbol->scope_level = 0;
+    symbol->slot = -1;
     symbol->line = line;
     symbol->column = column;
 
@@ -115,9 +616,11 @@ Symbol* symbol_create_parameter(const char* name, const char* type_name, int pos
 
     symbol->name = strdup_safe(name);
     symbol->type = SYMBOL_PARAMETER;
-    symbol->data.parameter.type_name = strdup_safe(type_name);
+    symbol->data.parameter.type = type_from_name(type_name);
+    symbol->data.parameter.type_name = symbol->data.parameter.type ? symbol->data.parameter.type->name : NULL;
     symbol->data.parameter.position = position;
     symbol->scope_level = 0;
+    symbol->slot = -1;
     symbol->line = line;
     symbol->column = column;
 
@@ -129,39 +632,51 @@ void symbol_free(Symbol* symbol) {
 
     free(symbol->name);
 
-    switch (symbol->type) {
-        case SYMBOL_VARIABLE:
-            free(symbol->data.variable.type_name);
-            break;
-        case SYMBOL_FUNCTION:
-            free(symbol->data.function.return_type);
-            if (symbol->data.function.parameters) {
-                for (int i = 0; i < symbol->data.function.parameter_count; i++) {
-                    symbol_free(symbol->data.function.parameters[i]);
-                }
-                free(symbol->data.function.parameters);
-            }
-            break;
-        case SYMBOL_PARAMETER:
-            free(symbol->data.parameter.type_name);
-            break;
-        default:
-            break;
+    // Type names belong to the interned descriptors
+    if (symbol->type == SYMBOL_FUNCTION && symbol->data.function.parameters) {
+        for (int i = 0; i < symbol->data.function.parameter_count; i++) {
+            symbol_free(symbol->data.function.parameters[i]);
+        }
+        free(symbol->data.function.parameters);
     }
 
     free(symbol);
 }
 
 // Semantic analyzer functions
+
+// A scope table at the given level that resolves names through the
+// analyzer's bindings
+static SymbolTable* semantic_analyzer_create_scope(SemanticAnalyzer* analyzer, int scope_level) {
+    SymbolTable* scope = symbol_table_create(scope_level);
+    if (scope == NULL) return NULL;
+
+    free(scope->slots);
+    scope->slots = NULL;
+    scope->slot_capacity = 0;
+    scope->bindings = analyzer->bindings;
+    scope->parent = scope_level > 0 ? analyzer->scope_stack[scope_level - 1] : NULL;
+    return scope;
+}
+
 SemanticAnalyzer* semantic_analyzer_create(void) {
     SemanticAnalyzer* analyzer = malloc(sizeof(SemanticAnalyzer));
     if (analyzer == NULL) return NULL;
 
-    analyzer->current_scope = symbol_table_create(0);
+    memset(&analyzer->counters, 0, sizeof(SemanticCounters));
+    analyzer->bindings = scope_bindings_create();
+    if (analyzer->bindings != NULL) analyzer->bindings->counters = &analyzer->counters;
     analyzer->scope_stack = malloc(sizeof(SymbolTable*) * 16);
+    analyzer->current_scope = semantic_analyzer_create_scope(analyzer, 0);
     analyzer->scope_stack[0] = analyzer->current_scope;
     analyzer->scope_stack_size = 1;
     analyzer->scope_stack_capacity = 16;
+    analyzer->scope_pool_size = 1;
+    analyzer->global_count = 0;
+    analyzer->frame_size = 0;
+    analyzer->globals_end = NULL;
+    analyzer->lookup_hook = NULL;
+    analyzer->lookup_context = NULL;
     analyzer->had_error = false;
     analyzer->last_error = NULL;
 
@@ -171,54 +686,470 @@ SemanticAnalyzer* semantic_analyzer_create(void) {
 void semantic_analyzer_free(SemanticAnalyzer* analyzer) {
     if (analyzer == NULL) return;
 
-    // Free all scopes in the stack
-    for (int i = 0; i < analyzer->scope_stack_size; i++) {
+    // Free all scopes, including those kept for reuse
+    for (int i = 0; i < analyzer->scope_pool_size; i++) {
         symbol_table_free(analyzer->scope_stack[i]);
     }
 
+    scope_bindings_free(analyzer->bindings);
     free(analyzer->scope_stack);
     error_free(analyzer->last_error);
     free(analyzer);
 }
 
+// Non-primitive descriptors map to TYPE_UNKNOWN
+static DataType semantic_symbol_type(Symbol* symbol) {
+    const TypeDescriptor* type = NULL;
+    if (symbol->type == SYMBOL_VARIABLE) type = symbol->data.variable.type;
+    if (symbol->type == SYMBOL_PARAMETER) type = symbol->data.parameter.type;
+    return type ? type->primitive : TYPE_UNKNOWN;
+}
+
+// Looks a name up from the current scope. Under globals_end, a global
+// declared later in the source is treated as not declared yet, as it would
+// be when the program is analyzed in order.
+
+static Symbol* semantic_lookup(SemanticAnalyzer* analyzer, const char* name) {
+    Symbol* symbol = symbol_table_lookup(analyzer->current_scope, name);
+    ASTNode* end = analyzer->globals_end;
+    if (symbol != NULL && end != NULL && symbol->scope_level == 0 &&
+        (symbol->line > end->line || (symbol->line == end->line && symbol->column > end->column))) {
+        symbol = NULL;
+    }
+    if (analyzer->lookup_hook != NULL && (symbol == NULL || symbol->scope_level == 0)) {
+        analyzer->lookup_hook(analyzer, name, analyzer->lookup_context);
+    }
+    return symbol;
+}
+
 bool semantic_analyze(ASTNode* node, SemanticAnalyzer* analyzer) {
     if (node == NULL || analyzer == NULL) {
         return false;
     }
 
-    // For now, just get the type of the node
+    bool resolved = semantic_resolve(node, analyzer);
     DataType type = ast_node_get_type(node, analyzer);
-    return type != TYPE_ERROR;
+    return resolved && type != TYPE_ERROR;
+}
+
+void semantic_analyzer_error(SemanticAnalyzer* analyzer, ASTNode* node, const char* format, ...) {
+    char message[256];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(message, sizeof(message), format, args);
+    va_end(args);
+
+    error_free(analyzer->last_error);
+    analyzer->last_error = error_create(ERROR_SEMANTIC, message, node->line, node->column, NULL);
+    analyzer->had_error = true;
+}
+
+// Gives a variable or parameter its storage and records it on its declaration
+static void semantic_assign_slot(SemanticAnalyzer* analyzer, Symbol* symbol, ASTNode* declaration) {
+    symbol->slot = symbol->scope_level == 0 ? analyzer->global_count++ : analyzer->frame_size++;
+    declaration->resolved_slot = symbol->slot;
+    declaration->resolved_global = symbol->scope_level == 0;
+}
+
+// Adds a symbol to the innermost scope unless the name is already declared there
+static bool semantic_declare(SemanticAnalyzer* analyzer, Symbol* symbol, ASTNode* declaration) {
+    if (symbol == NULL) return false;
+
+    if (symbol_table_lookup_local(analyzer->current_scope, symbol->name) != NULL) {
+        semantic_analyzer_error(analyzer, declaration, "Redeclaration of '%s'", symbol->name);
+        symbol_free(symbol);
+        return false;
+    }
+
+    symbol_table_add(analyzer->current_scope, symbol);
+    return true;
+}
+
+static bool semantic_resolve_expression(ASTNode* node, SemanticAnalyzer* analyzer) {
+    if (node == NULL) return true;
+
+    switch (node->type) {
+        case NODE_IDENTIFIER: {
+            Symbol* symbol = semantic_lookup(analyzer, node->data.identifier_name);
+            if (symbol == NULL) {
+                semantic_analyzer_error(analyzer, node, "Undeclared identifier '%s'", node->data.identifier_name);
+                return false;
+            }
+
+            // Local symbols are freed with their scope, so only the type and slot
+            // are kept for them
+            node->resolved_symbol = symbol->scope_level == 0 ? symbol : NULL;
+            node->resolved_type = (int)semantic_symbol_type(symbol) + 1;
+            node->resolved_slot = symbol->slot;
+            node->resolved_global = symbol->scope_level == 0;
+            return true;
+        }
+
+        case NODE_BINARY_EXPRESSION:
+        case NODE_ASSIGNMENT_EXPRESSION: {
+            bool left = semantic_resolve_expression(node->data.binary.left, analyzer);
+            bool right = semantic_resolve_expression(node->data.binary.right, analyzer);
+            return left && right;
+        }
+
+        case NODE_UNARY_EXPRESSION:
+            return semantic_resolve_expression(node->data.unary.operand, analyzer);
+
+        case NODE_CALL_EXPRESSION: {
+            bool ok = semantic_resolve_expression(node->data.call.callee, analyzer);
+            for (int i = 0; i < node->data.call.argument_count; i++) {
+                ok = semantic_resolve_expression(node->data.call.arguments[i], analyzer) && ok;
+            }
+            return ok;
+        }
+
+        default:
+            return true;
+    }
+}
+
+// Resolves an expression and types it while the scopes it refers to are open
+static bool semantic_resolve_value(ASTNode* node, SemanticAnalyzer* analyzer) {
+    bool ok = semantic_resolve_expression(node, analyzer);
+    if (node != NULL) ast_node_get_type(node, analyzer);
+    return ok;
+}
+
+static bool semantic_resolve_statements(ASTNode** statements, int count, SemanticAnalyzer* analyzer) {
+    bool ok = true;
+    for (int i = 0; i < count; i++) {
+        ok = semantic_resolve(statements[i], analyzer) && ok;
+    }
+    return ok;
+}
+
+// Declared before its body so it can call itself
+static bool semantic_declare_function(ASTNode* node, SemanticAnalyzer* analyzer) {
+    Symbol* function = symbol_create_function(node->data.function.name, node->data.function.return_type,
+                                              node->line, node->column);
+    return semantic_declare(analyzer, function, node);
+}
+
+static bool semantic_resolve_function_body(ASTNode* node, SemanticAnalyzer* analyzer) {
+    bool ok = true;
+    int enclosing_frame_size = analyzer->frame_size;
+    analyzer->frame_size = 0;
+    semantic_analyzer_enter_scope(analyzer);
+
+    for (int i = 0; i < node->data.function.parameter_count; i++) {
+        ASTNode* parameter = node->data.function.parameters[i];
+        Symbol* symbol = symbol_create_parameter(parameter->data.declaration.name, parameter->data.declaration.type_name,
+                                                 i, parameter->line, parameter->column);
+        if (semantic_declare(analyzer, symbol, parameter)) {
+            semantic_assign_slot(analyzer, symbol, parameter);
+        } else {
+            ok = false;
+        }
+    }
+
+    // The body block shares the parameters' scope
+    ASTNode* body = ast_function_body(node);
+    if (body != NULL && body->type == NODE_BLOCK_STATEMENT) {
+        ok = semantic_resolve_statements(body->data.block.statements, body->data.block.statement_count, analyzer) && ok;
+    } else {
+        ok = semantic_resolve(body, analyzer) && ok;
+    }
+
+    semantic_analyzer_exit_scope(analyzer);
+    node->resolved_slot = analyzer->frame_size;
+    analyzer->frame_size = enclosing_frame_size;
+    return ok;
+}
+
+bool semantic_resolve(ASTNode* node, SemanticAnalyzer* analyzer) {
+    if (node == NULL || analyzer == NULL) return node == NULL;
+
+    switch (node->type) {
+        case NODE_PROGRAM:
+            return semantic_resolve_statements(node->data.block.statements, node->data.block.statement_count, analyzer);
+
+        case NODE_BLOCK_STATEMENT: {
+            semantic_analyzer_enter_scope(analyzer);
+            bool ok = semantic_resolve_statements(node->data.block.statements, node->data.block.statement_count,
+                                                  analyzer);
+            semantic_analyzer_exit_scope(analyzer);
+            return ok;
+        }
+
+        case NODE_VARIABLE_DECLARATION: {
+            // The initializer cannot see the variable it initializes
+            bool ok = semantic_resolve_value(node->data.declaration.initializer, analyzer);
+            Symbol* symbol = symbol_create_variable(node->data.declaration.name, node->data.declaration.type_name,
+                                                    node->data.declaration.is_mutable, node->line, node->column);
+            if (!semantic_declare(analyzer, symbol, node)) return false;
+
+            semantic_assign_slot(analyzer, symbol, node);
+            return ok;
+        }
+
+        case NODE_FUNCTION_DECLARATION: {
+            bool declared = semantic_declare_function(node, analyzer);
+            return semantic_resolve_function_body(node, analyzer) && declared;
+        }
+
+        case NODE_EXPRESSION_STATEMENT:
+        case NODE_RETURN_STATEMENT:
+            return semantic_resolve_value(node->data.statement.expression, analyzer);
+
+        case NODE_IF_STATEMENT:
+        case NODE_WHILE_STATEMENT: {
+            bool ok = semantic_resolve_value(node->data.conditional.condition, analyzer);
+            ok = semantic_resolve(node->data.conditional.then_branch, analyzer) && ok;
+            return semantic_resolve(node->data.conditional.else_branch, analyzer) && ok;
+        }
+
+        default:
+            return semantic_resolve_expression(node, analyzer);
+    }
+}
+
+bool semantic_reanalyze_declaration(ASTNode* declaration, Symbol* symbol, SemanticAnalyzer* analyzer) {
+    if (declaration == NULL || symbol == NULL || analyzer == NULL) return false;
+    if (analyzer->scope_stack_size != 1 || symbol->scope_level != 0) return false;
+
+    ASTNode* enclosing_end = analyzer->globals_end;
+    analyzer->globals_end = declaration;
+    bool ok = false;
+
+    if (declaration->type == NODE_FUNCTION_DECLARATION && symbol->type == SYMBOL_FUNCTION) {
+        const TypeDescriptor* returns = type_from_name(declaration->data.function.return_type);
+        symbol->data.function.returns = returns;
+        symbol->data.function.return_type = returns ? returns->name : NULL;
+        symbol->line = declaration->line;
+        symbol->column = declaration->column;
+
+        for (int i = 0; i < declaration->data.function.parameter_count; i++) {
+            ast_node_clear_types(declaration->data.function.parameters[i]);
+        }
+        ast_node_clear_types(ast_function_body(declaration));
+        ok = semantic_resolve_function_body(declaration, analyzer);
+    } else if (declaration->type == NODE_VARIABLE_DECLARATION && symbol->type == SYMBOL_VARIABLE) {
+        // The initializer cannot see the variable it initializes
+        ASTNode* initializer = declaration->data.declaration.initializer;
+        symbol->line = INT_MAX;
+        ast_node_clear_types(initializer);
+        ok = semantic_resolve_value(initializer, analyzer);
+
+        const TypeDescriptor* type = type_from_name(declaration->data.declaration.type_name);
+        symbol->data.variable.type = type;
+        symbol->data.variable.type_name = type ? type->name : NULL;
+        symbol->data.variable.is_mutable = declaration->data.declaration.is_mutable;
+        symbol->line = declaration->line;
+        symbol->column = declaration->column;
+        declaration->resolved_slot = symbol->slot;
+        declaration->resolved_global = true;
+    }
+
+    analyzer->globals_end = enclosing_end;
+    return ok;
+}
+
+// Parallel analysis. Every top-level statement keeps the last error it
+// produced, so the errors can be put back in source order afterwards.
+typedef struct {
+    ASTNode* function;
+    int statement;           // Index in the program
+    bool ok;
+} FunctionJob;
+
+typedef struct {
+    FunctionJob* jobs;
+    int job_count;
+    int next_job;            // Claimed with an atomic fetch-and-add
+    Error** errors;          // Per statement
+} FunctionQueue;
+
+typedef struct {
+    FunctionQueue* queue;
+    SemanticAnalyzer* analyzer;  // Private scope stack over the frozen globals
+} FunctionWorker;
+
+static void* semantic_function_worker(void* argument) {
+    FunctionWorker* worker = argument;
+    FunctionQueue* queue = worker->queue;
+    SemanticAnalyzer* analyzer = worker->analyzer;
+
+    int index;
+    while ((index = __atomic_fetch_add(&queue->next_job, 1, __ATOMIC_RELAXED)) < queue->job_count) {
+        FunctionJob* job = &queue->jobs[index];
+
+        analyzer->globals_end = job->function;
+        job->ok = semantic_resolve_function_body(job->function, analyzer);
+
+        // Only this thread touches this statement's entry. An error in the
+        // body comes after one from declaring the function.
+        if (analyzer->last_error != NULL) {
+            error_free(queue->errors[job->statement]);
+            queue->errors[job->statement] = analyzer->last_error;
+            analyzer->last_error = NULL;
+        }
+    }
+
+    return NULL;
+}
+
+bool semantic_analyze_parallel(ASTNode* program, SemanticAnalyzer* analyzer, int thread_count) {
+    if (program == NULL || analyzer == NULL) return false;
+    if (program->type != NODE_PROGRAM || analyzer->scope_stack_size != 1) {
+        return semantic_analyze(program, analyzer);
+    }
+    if (thread_count < 1) thread_count = 1;
+
+    int statement_count = program->data.block.statement_count;
+    Error** errors = calloc((size_t)MAX(1, statement_count), sizeof(Error*));
+    FunctionJob* jobs = malloc(sizeof(FunctionJob) * MAX(1, statement_count));
+    if (errors == NULL || jobs == NULL) {
+        free(errors);
+        free(jobs);
+        return semantic_analyze(program, analyzer);
+    }
+
+    // Phase one: globals in order, and every function's symbol. Lazy bodies
+    // are parsed here, since parsing them touches the parser.
+    Error* earlier_error = analyzer->last_error;
+    analyzer->last_error = NULL;
+    bool ok = true;
+    int job_count = 0;
+    for (int i = 0; i < statement_count; i++) {
+        ASTNode* statement = program->data.block.statements[i];
+        if (statement->type == NODE_FUNCTION_DECLARATION) {
+            ok = semantic_declare_function(statement, analyzer) && ok;
+            ast_function_body(statement);
+            jobs[job_count++] = (FunctionJob){ statement, i, true };
+        } else {
+            ok = semantic_resolve(statement, analyzer) && ok;
+        }
+        errors[i] = analyzer->last_error;
+        analyzer->last_error = NULL;
+    }
+
+    // Phase two: bodies against the now read-only global scope
+    int worker_count = MAX(1, MIN(thread_count, job_count));
+    FunctionQueue queue = { jobs, job_count, 0, errors };
+    FunctionWorker* workers = malloc(sizeof(FunctionWorker) * worker_count);
+    pthread_t* threads = malloc(sizeof(pthread_t) * worker_count);
+    int created = 0;
+    if (workers != NULL && threads != NULL) {
+        for (; created < worker_count; created++) {
+            SemanticAnalyzer* worker = semantic_analyzer_create();
+            if (worker == NULL) break;
+            worker->bindings->outer = analyzer->scope_stack[0];
+            workers[created] = (FunctionWorker){ &queue, worker };
+        }
+    }
+
+    if (created == 0) {
+        // No private analyzer: this one takes the jobs itself
+        FunctionWorker self = { &queue, analyzer };
+        semantic_function_worker(&self);
+        analyzer->globals_end = NULL;
+    } else {
+        // The calling thread works too, so one thread never spawns anything
+        int spawned = 1;
+        for (; spawned < created; spawned++) {
+            if (pthread_create(&threads[spawned], NULL, semantic_function_worker, &workers[spawned]) != 0) break;
+        }
+        semantic_function_worker(&workers[0]);
+        for (int i = 1; i < spawned; i++) {
+            pthread_join(threads[i], NULL);
+        }
+        // Workers that failed to start leave their jobs to the ones that did
+        for (int i = spawned; i < created; i++) {
+            semantic_function_worker(&workers[i]);
+        }
+    }
+
+    for (int i = 0; i < created; i++) {
+        semantic_counters_add(&analyzer->counters, &workers[i].analyzer->counters);
+        semantic_analyzer_free(workers[i].analyzer);
+    }
+    free(workers);
+    free(threads);
+
+    // Merge: the last error in source order is the one analysis in order would report
+    for (int i = 0; i < job_count; i++) {
+        ok = ok && jobs[i].ok;
+    }
+    Error* last_error = earlier_error;
+    for (int i = 0; i < statement_count; i++) {
+        if (errors[i] == NULL) continue;
+        error_free(last_error);
+        last_error = errors[i];
+    }
+    analyzer->last_error = last_error;
+    analyzer->had_error = analyzer->had_error || !ok;
+    free(errors);
+    free(jobs);
+
+    DataType type = ast_node_get_type(program, analyzer);
+    return ok && type != TYPE_ERROR;
 }
 
-// Scope management
+// Scope management. Scope tables are kept after they close and reused by
+// the next scope at the same depth, so once a depth has been reached
+// entering and leaving scopes allocates nothing.
 void semantic_analyzer_enter_scope(SemanticAnalyzer* analyzer) {
     if (analyzer == NULL) return;
 
-    SymbolTable* new_scope = symbol_table_create(analyzer->current_scope->scope_level + 1);
-    new_scope->parent = analyzer->current_scope;
-
-    // Add to scope stack
-    if (analyzer->scope_stack_size >= analyzer->scope_stack_capacity) {
-        analyzer->scope_stack_capacity *= 2;
-        analyzer->scope_stack = realloc(analyzer->scope_stack,
-                                       sizeof(SymbolTable*) * analyzer->scope_stack_capacity);
+    int level = analyzer->scope_stack_size;
+    if (level >= analyzer->scope_pool_size) {
+        if (level >= analyzer->scope_stack_capacity) {
+            analyzer->scope_stack_capacity *= 2;
+            analyzer->scope_stack = realloc(analyzer->scope_stack,
+                                           sizeof(SymbolTable*) * analyzer->scope_stack_capacity);
+        }
+        analyzer->scope_stack[level] = semantic_analyzer_create_scope(analyzer, level);
+        analyzer->scope_pool_size++;
+        analyzer->counters.scope_tables_created++;
     }
 
-    analyzer->scope_stack[analyzer->scope_stack_size++] = new_scope;
-    analyzer->current_scope = new_scope;
+    SymbolTable* scope = analyzer->scope_stack[level];
+    scope->binding_mark = analyzer->bindings->log_count;
+    analyzer->bindings->depth = level;
+    analyzer->scope_stack_size++;
+    analyzer->current_scope = scope;
+    analyzer->counters.scopes_entered++;
+    analyzer->counters.max_scope_depth = MAX(analyzer->counters.max_scope_depth, (uint64_t)level);
 }
 
 void semantic_analyzer_exit_scope(SemanticAnalyzer* analyzer) {
     if (analyzer == NULL || analyzer->scope_stack_size <= 1) return;
 
-    // Don't free the global scope
-    if (analyzer->scope_stack_size > 1) {
-        analyzer->scope_stack_size--;
-        symbol_table_free(analyzer->current_scope);
+    // Undo the scope's bindings, innermost first, then drop its symbols
+    // but keep the table (the global scope is never exited)
+    SymbolTable* scope = analyzer->current_scope;
+    ScopeBindings* bindings = analyzer->bindings;
+    while (bindings->log_count > scope->binding_mark) {
+        Binding* binding = &bindings->log[--bindings->log_count];
+        bindings->slots[binding->slot].top = binding->shadowed;
     }
 
+    for (int i = 0; i < scope->symbol_count; i++) {
+        symbol_free(scope->symbols[i]);
+    }
+    scope->symbol_count = 0;
+    bindings->stray_count -= scope->stray_count;
+    scope->stray_count = 0;
+
+    analyzer->scope_stack_size--;
+    bindings->depth = analyzer->scope_stack_size - 1;
     analyzer->current_scope = analyzer->scope_stack[analyzer->scope_stack_size - 1];
+    analyzer->counters.scopes_exited++;
+
+    // Bind symbols that were added to this scope while it was not innermost
+    SymbolTable* outer = analyzer->current_scope;
+    if (outer->stray_count > 0) {
+        bindings->stray_count -= outer->stray_count;
+        outer->stray_count = 0;
+        for (int i = 0; i < outer->symbol_count; i++) {
+            scope_bindings_push(outer, outer->symbols[i]);
+        }
+    }
 }
 
 SymbolTable* semantic_analyzer_current_scope(SemanticAnalyzer* analyzer) {
@@ -242,10 +1173,169 @@ void semantic_analyzer_clear_error(SemanticAnalyzer* analyzer) {
     }
 }
 
-// Type checking functions
-DataType ast_node_get_type(ASTNode* node, SemanticAnalyzer* analyzer) {
-    if (node == NULL) return TYPE_ERROR;
+// Instrumentation
+const SemanticCounters* semantic_analyzer_counters(SemanticAnalyzer* analyzer) {
+    return analyzer ? &analyzer->counters : NULL;
+}
+
+void semantic_counters_reset(SemanticAnalyzer* analyzer) {
+    if (analyzer) memset(&analyzer->counters, 0, sizeof(SemanticCounters));
+}
+
+void semantic_counters_add(SemanticCounters* total, const SemanticCounters* counters) {
+    if (total == NULL || counters == NULL) return;
+
+    total->lookups += counters->lookups;
+    total->lookup_misses += counters->lookup_misses;
+    total->probes += counters->probes;
+    total->name_compares += counters->name_compares;
+    total->scopes_walked += counters->scopes_walked;
+    total->symbols_declared += counters->symbols_declared;
+    total->scopes_entered += counters->scopes_entered;
+    total->scopes_exited += counters->scopes_exited;
+    total->scope_tables_created += counters->scope_tables_created;
+    total->max_scope_depth = MAX(total->max_scope_depth, counters->max_scope_depth);
+    total->types_computed += counters->types_computed;
+    total->types_cached += counters->types_cached;
+}
+
+static double semantic_counters_ratio(uint64_t count, uint64_t total) {
+    return total > 0 ? (double)count / (double)total : 0.0;
+}
+
+bool semantic_counters_write_json(const SemanticCounters* counters, FILE* out) {
+    if (counters == NULL || out == NULL) return false;
+
+    const struct {
+        const char* name;
+        uint64_t value;
+    } fields[] = {
+        { "lookups", counters->lookups },
+        { "lookup_misses", counters->lookup_misses },
+        { "probes", counters->probes },
+        { "name_compares", counters->name_compares },
+        { "scopes_walked", counters->scopes_walked },
+        { "symbols_declared", counters->symbols_declared },
+        { "scopes_entered", counters->scopes_entered },
+        { "scopes_exited", counters->scopes_exited },
+        { "scope_tables_created", counters->scope_tables_created },
+        { "max_scope_depth", counters->max_scope_depth },
+        { "types_computed", counters->types_computed },
+        { "types_cached", counters->types_cached },
+    };
+
+    fprintf(out, "{\n");
+    for (size_t i = 0; i < sizeof(fields) / sizeof(fields[0]); i++) {
+        fprintf(out, "  \"%s\": %llu,\n", fields[i].name, (unsigned long long)fields[i].value);
+    }
+    fprintf(out, "  \"probes_per_lookup\": %.3f,\n", semantic_counters_ratio(counters->probes, counters->lookups));
+    fprintf(out, "  \"name_compares_per_lookup\": %.3f,\n",
+            semantic_counters_ratio(counters->name_compares, counters->lookups));
+    fprintf(out, "  \"scopes_walked_per_lookup\": %.3f,\n",
+            semantic_counters_ratio(counters->scopes_walked, counters->lookups));
+    fprintf(out, "  \"type_cache_hit_rate\": %.3f\n",
+            semantic_counters_ratio(counters->types_cached, counters->types_cached + counters->types_computed));
+    fprintf(out, "}\n");
+
+    return ferror(out) == 0;
+}
+
+// Operator rules. The whole [operator][left][right] table is derived once
+// from the rules below, so checking an operator is a single load.
+static OperatorRule operator_rules[BINARY_OPERATOR_COUNT][DATA_TYPE_COUNT][DATA_TYPE_COUNT];
+static pthread_once_t operator_rules_once = PTHREAD_ONCE_INIT;
+static bool operator_rules_ready;
+
+// Common type of two arithmetic operands: char promotes to int and int to
+// float. TYPE_ERROR if either is not arithmetic.
+static DataType operator_arithmetic_type(DataType left, DataType right) {
+    bool left_ok = left == TYPE_INT || left == TYPE_FLOAT || left == TYPE_CHAR;
+    bool right_ok = right == TYPE_INT || right == TYPE_FLOAT || right == TYPE_CHAR;
+    if (!left_ok || !right_ok) return TYPE_ERROR;
+    return left == TYPE_FLOAT || right == TYPE_FLOAT ? TYPE_FLOAT : TYPE_INT;
+}
 
+static OperatorRule operator_rule_derive(BinaryOperator op, DataType left, DataType right) {
+    bool comparison = op >= OP_EQUAL && op <= OP_GREATER_EQUAL;
+    bool logical = op == OP_LOGICAL_AND || op == OP_LOGICAL_OR;
+
+    if (left == TYPE_ERROR || right == TYPE_ERROR || left == TYPE_VOID || right == TYPE_VOID) {
+        return (OperatorRule){ TYPE_ERROR, TYPE_ERROR };
+    }
+    if (left == TYPE_UNKNOWN || right == TYPE_UNKNOWN) {
+        return (OperatorRule){ comparison || logical ? TYPE_BOOL : TYPE_UNKNOWN, TYPE_UNKNOWN };
+    }
+
+    DataType arithmetic = operator_arithmetic_type(left, right);
+    switch (op) {
+        case OP_ADD:
+        case OP_SUBTRACT:
+        case OP_MULTIPLY:
+        case OP_DIVIDE:
+            return (OperatorRule){ arithmetic, arithmetic };
+
+        case OP_MODULO:
+        case OP_SHIFT_LEFT:
+        case OP_SHIFT_RIGHT:
+        case OP_BITWISE_AND:
+        case OP_BITWISE_XOR:
+        case OP_BITWISE_OR:
+            if (arithmetic == TYPE_INT) return (OperatorRule){ TYPE_INT, TYPE_INT };
+            if (op >= OP_BITWISE_AND && left == TYPE_BOOL && right == TYPE_BOOL) {
+                return (OperatorRule){ TYPE_BOOL, TYPE_BOOL };
+            }
+            return (OperatorRule){ TYPE_ERROR, TYPE_ERROR };
+
+        case OP_EQUAL:
+        case OP_NOT_EQUAL:
+            if (arithmetic != TYPE_ERROR) return (OperatorRule){ TYPE_BOOL, arithmetic };
+            if (left == right) return (OperatorRule){ TYPE_BOOL, left };
+            return (OperatorRule){ TYPE_ERROR, TYPE_ERROR };
+
+        case OP_LESS:
+        case OP_LESS_EQUAL:
+        case OP_GREATER:
+        case OP_GREATER_EQUAL:
+            if (arithmetic != TYPE_ERROR) return (OperatorRule){ TYPE_BOOL, arithmetic };
+            if (left == TYPE_STRING && right == TYPE_STRING) return (OperatorRule){ TYPE_BOOL, TYPE_STRING };
+            return (OperatorRule){ TYPE_ERROR, TYPE_ERROR };
+
+        case OP_LOGICAL_AND:
+        case OP_LOGICAL_OR:
+            if (left == TYPE_BOOL && right == TYPE_BOOL) return (OperatorRule){ TYPE_BOOL, TYPE_BOOL };
+            return (OperatorRule){ TYPE_ERROR, TYPE_ERROR };
+
+        default:
+            return (OperatorRule){ TYPE_ERROR, TYPE_ERROR };
+    }
+}
+
+static void operator_rules_build(void) {
+    for (int op = 0; op < BINARY_OPERATOR_COUNT; op++) {
+        for (int left = 0; left < DATA_TYPE_COUNT; left++) {
+            for (int right = 0; right < DATA_TYPE_COUNT; right++) {
+                operator_rules[op][left][right] = operator_rule_derive(op, left, right);
+            }
+        }
+    }
+    __atomic_store_n(&operator_rules_ready, true, __ATOMIC_RELEASE);
+}
+
+OperatorRule semantic_operator_rule(BinaryOperator op, DataType left, DataType right) {
+    if ((unsigned)op >= BINARY_OPERATOR_COUNT || (unsigned)left >= DATA_TYPE_COUNT ||
+        (unsigned)right >= DATA_TYPE_COUNT) {
+        return (OperatorRule){ TYPE_ERROR, TYPE_ERROR };
+    }
+
+    // Only the first lookups go through pthread_once
+    if (!__atomic_load_n(&operator_rules_ready, __ATOMIC_ACQUIRE)) {
+        pthread_once(&operator_rules_once, operator_rules_build);
+    }
+    return operator_rules[op][left][right];
+}
+
+// Type checking functions
+static DataType ast_node_compute_type(ASTNode* node, SemanticAnalyzer* analyzer) {
     switch (node->type) {
         case NODE_LITERAL:
             if (node->token && node->token->type == TOKEN_INTEGER_LITERAL) {
@@ -262,15 +1352,13 @@ DataType ast_node_get_type(ASTNode* node, SemanticAnalyzer* analyzer) {
         case NODE_IDENTIFIER:
             // Look up identifier in symbol table
             if (analyzer && node->data.identifier_name) {
-                Symbol* symbol = symbol_table_lookup(analyzer->current_scope, node->data.identifier_name);
-                if (symbol && symbol->type == SYMBOL_VARIABLE) {
-                    // Map string type names to DataType enum
-                    if (strcmp(symbol->data.variable.type_name, "int") == 0) return TYPE_INT;
-                    if (strcmp(symbol->data.variable.type_name, "float") == 0) return TYPE_FLOAT;
-                    if (strcmp(symbol->data.variable.type_name, "string") == 0) return TYPE_STRING;
-                    if (strcmp(symbol->data.variable.type_name, "bool") == 0) return TYPE_BOOL;
-                    if (strcmp(symbol->data.variable.type_name, "void") == 0) return TYPE_VOID;
+                // Name resolution may already have bound the identifier
+                Symbol* symbol = node->resolved_symbol;
+                if (symbol == NULL) {
+                    symbol = semantic_lookup(analyzer, node->data.identifier_name);
+                    node->resolved_symbol = symbol;
                 }
+                if (symbol) return semantic_symbol_type(symbol);
             }
             return TYPE_UNKNOWN;
 
@@ -278,35 +1366,85 @@ DataType ast_node_get_type(ASTNode* node, SemanticAnalyzer* analyzer) {
             {
                 DataType left_type = ast_node_get_type(node->data.binary.left, analyzer);
                 DataType right_type = ast_node_get_type(node->data.binary.right, analyzer);
+                return (DataType)semantic_operator_rule(node->data.binary.op, left_type, right_type).result;
+            }
 
-                // For arithmetic operations, if both operands are the same type, return that type
-                if (left_type == right_type && (left_type == TYPE_INT || left_type == TYPE_FLOAT)) {
-                    return left_type;
-                }
+        default:
+            return TYPE_UNKNOWN;
+    }
+}
 
-                // For comparison operations, always return bool
-                if (node->data.binary.operator &&
-                    (strcmp(node->data.binary.operator, "==") == 0 ||
-                     strcmp(node->data.binary.operator, "!=") == 0 ||
-                     strcmp(node->data.binary.operator, "<") == 0 ||
-                     strcmp(node->data.binary.operator, "<=") == 0 ||
-                     strcmp(node->data.binary.operator, ">") == 0 ||
-                     strcmp(node->data.binary.operator, ">=") == 0)) {
-                    return TYPE_BOOL;
-                }
+DataType ast_node_get_type(ASTNode* node, SemanticAnalyzer* analyzer) {
+    if (node == NULL) return TYPE_ERROR;
+    if (node->resolved_type != 0) {
+        if (analyzer != NULL) analyzer->counters.types_cached++;
+        return (DataType)(node->resolved_type - 1);
+    }
 
-                // For logical operations, return bool
-                if (node->data.binary.operator &&
-                    (strcmp(node->data.binary.operator, "&&") == 0 ||
-                     strcmp(node->data.binary.operator, "||") == 0)) {
-                    return TYPE_BOOL;
-                }
+    if (analyzer != NULL) analyzer->counters.types_computed++;
+    DataType type = ast_node_compute_type(node, analyzer);
 
-                return TYPE_ERROR;
-            }
+    // Operands were typed (and annotated if they could be) just above
+    bool settled = true;
+    if (node->type == NODE_IDENTIFIER) {
+        settled = node->resolved_symbol != NULL;
+    } else if (node->type == NODE_BINARY_EXPRESSION) {
+        settled = node->data.binary.left->resolved_type != 0 && node->data.binary.right->resolved_type != 0;
+    }
+    if (settled) node->resolved_type = (int)type + 1;
+    return type;
+}
+
+void ast_node_clear_types(ASTNode* node) {
+    if (node == NULL) return;
+
+    node->resolved_type = 0;
+    node->resolved_symbol = NULL;
+    node->resolved_slot = -1;
+    node->resolved_global = false;
 
+    switch (node->type) {
+        case NODE_PROGRAM:
+        case NODE_BLOCK_STATEMENT:
+            for (int i = 0; i < node->data.block.statement_count; i++) {
+                ast_node_clear_types(node->data.block.statements[i]);
+            }
+            break;
+        case NODE_FUNCTION_DECLARATION:
+            for (int i = 0; i < node->data.function.parameter_count; i++) {
+                ast_node_clear_types(node->data.function.parameters[i]);
+            }
+            ast_node_clear_types(node->data.function.body);
+            break;
+        case NODE_VARIABLE_DECLARATION:
+            ast_node_clear_types(node->data.declaration.initializer);
+            break;
+        case NODE_EXPRESSION_STATEMENT:
+        case NODE_RETURN_STATEMENT:
+            ast_node_clear_types(node->data.statement.expression);
+            break;
+        case NODE_IF_STATEMENT:
+        case NODE_WHILE_STATEMENT:
+            ast_node_clear_types(node->data.conditional.condition);
+            ast_node_clear_types(node->data.conditional.then_branch);
+            ast_node_clear_types(node->data.conditional.else_branch);
+            break;
+        case NODE_ASSIGNMENT_EXPRESSION:
+        case NODE_BINARY_EXPRESSION:
+            ast_node_clear_types(node->data.binary.left);
+            ast_node_clear_types(node->data.binary.right);
+            break;
+        case NODE_UNARY_EXPRESSION:
+            ast_node_clear_types(node->data.unary.operand);
+            break;
+        case NODE_CALL_EXPRESSION:
+            ast_node_clear_types(node->data.call.callee);
+            for (int i = 0; i < node->data.call.argument_count; i++) {
+                ast_node_clear_types(node->data.call.arguments[i]);
+            }
+            break;
         default:
-            return TYPE_UNKNOWN;
+            break;
     }
 }
 
@@ -325,26 +1463,7 @@ bool semantic_check_binary_operation(ASTNode* left, ASTNode* right, const char*
 
     DataType left_type = ast_node_get_type(left, analyzer);
     DataType right_type = ast_node_get_type(right, analyzer);
-
-    // Allow arithmetic operations on same numeric types
-    if ((left_type == TYPE_INT || left_type == TYPE_FLOAT) && left_type == right_type) {
-        return true;
-    }
-
-    // Allow comparison operations on any types
-    if (strcmp(op, "==") == 0 || strcmp(op, "!=") == 0 ||
-        strcmp(op, "<") == 0 || strcmp(op, "<=") == 0 ||
-        strcmp(op, ">") == 0 || strcmp(op, ">=") == 0) {
-        return true;
-    }
-
-    // Allow logical operations on boolean types
-    if ((strcmp(op, "&&") == 0 || strcmp(op, "||") == 0) &&
-        left_type == TYPE_BOOL && right_type == TYPE_BOOL) {
-        return true;
-    }
-
-    return false;
+    return semantic_operator_rule(binary_operator_from_string(op), left_type, right_type).result != TYPE_ERROR;
 }
 
 // Utility functions
@@ -5,6 +5,52 @@
 #include "../lexer/token.h"
 #include "../common/common.h"
 
+// Type information
+typedef enum {
+    TYPE_INT,
+    TYPE_FLOAT,
+    TYPE_STRING,
+    TYPE_CHAR,
+    TYPE_BOOL,
+    TYPE_VOID,
+    TYPE_UNKNOWN,
+    TYPE_ERROR
+} DataType;
+
+#define DATA_TYPE_COUNT (TYPE_ERROR + 1)
+
+// How one operator types one pair of operand types. Both operands are
+// implicitly converted to operand_type first (char and int to int, int to
+// float); result is TYPE_ERROR when the operator does not apply.
+typedef struct {
+    uint8_t result;          // DataType
+    uint8_t operand_type;    // DataType
+} OperatorRule;
+
+// Interned type descriptors. Every distinct type has exactly one immutable
+// descriptor, so two types are equal exactly when their descriptors are the
+// same pointer. Primitives are static; names that are not primitives become
+// opaque named types. Descriptors live for the rest of the process.
+typedef enum {
+    TYPE_KIND_PRIMITIVE,
+    TYPE_KIND_NAMED,
+    TYPE_KIND_POINTER,
+    TYPE_KIND_ARRAY,
+    TYPE_KIND_FUNCTION
+} TypeKind;
+
+typedef struct TypeDescriptor {
+    TypeKind kind;
+    DataType primitive;                            // TYPE_UNKNOWN unless a primitive
+    const char* name;                              // Canonical spelling: "int", "int*", "int[4]", "int(float)"
+    const struct TypeDescriptor* element;          // Pointee, array element or return type
+    int length;                                    // Array length
+    const struct TypeDescriptor* const* parameters;
+    int parameter_count;
+    uint32_t hash;
+    struct TypeDescriptor* next;                   // Interning table chain
+} TypeDescriptor;
+
 // Symbol types
 typedef enum {
     SYMBOL_VARIABLE,
@@ -13,24 +59,38 @@ typedef enum {
     SYMBOL_TYPE
 } SymbolType;
 
+// What a call may do besides computing its result. Functions start with
+// every effect until effects_summarize (effects.h) proves otherwise.
+typedef enum {
+    EFFECT_READS_GLOBALS = 1 << 0,
+    EFFECT_WRITES_GLOBALS = 1 << 1,
+    EFFECT_MAY_NOT_RETURN = 1 << 2,
+    EFFECT_ALL = (1 << 3) - 1
+} Effect;
+
 // Symbol structure
 typedef struct Symbol {
     char* name;
     SymbolType type;
     union {
+        // type_name is the descriptor's spelling, not a separate copy
         struct {
-            char* type_name;
+            const TypeDescriptor* type;
+            const char* type_name;
             bool is_mutable;
         } variable;
 
         struct {
-            char* return_type;
+            const TypeDescriptor* returns;
+            const char* return_type;
             struct Symbol** parameters;
             int parameter_count;
+            unsigned effects;    // Effect flags of a call
         } function;
 
         struct {
-            char* type_name;
+            const TypeDescriptor* type;
+            const char* type_name;
             int position;
         } parameter;
 
@@ -38,43 +98,129 @@ typedef struct Symbol {
             int size;
         } type_info;
     } data;
-    int scope_level;
+    int scope_level;             // Set when the symbol is added to a table
+    int slot;                    // Variables and parameters: global index at scope level 0,
+                                 // otherwise frame slot in the enclosing function; -1 if none
     int line;
     int column;
 } Symbol;
 
-// Symbol table structure
+// Open-addressing slot: index + 1 into symbols (0 marks an empty slot) and
+// the name's hash, compared before the name itself
+typedef struct {
+    uint32_t hash;
+    int index;
+} SymbolSlot;
+
+// LeBlanc-Cook scoping for an analyzer: one table maps each name ever
+// declared to the stack of its visible bindings, and entering a scope only
+// records the undo log length. Leaving it pops the bindings pushed since,
+// so neither needs an allocation and lookups cost the same at any depth.
+typedef struct {
+    uint32_t hash;
+    char* name;                  // Owned; names stay once seen
+    int top;                     // Innermost binding in the log, -1 if none
+} BindingSlot;
+
+typedef struct {
+    Symbol* symbol;
+    int scope_level;
+    int shadowed;                // Binding of the same name it hides, or -1
+    int slot;
+} Binding;
+
+// Work done by an analyzer, counted as it happens. A lookup is one name
+// resolution through symbol_table_lookup or symbol_table_lookup_local on an
+// analyzer scope; probes are hash slots inspected, name_compares the strcmp
+// calls made, and scopes_walked the scopes a lookup passed over before it
+// ended (shadowed bindings of nested scopes, scanned tables, the outer scope).
+typedef struct {
+    uint64_t lookups;
+    uint64_t lookup_misses;
+    uint64_t probes;
+    uint64_t name_compares;
+    uint64_t scopes_walked;
+    uint64_t symbols_declared;
+    uint64_t scopes_entered;
+    uint64_t scopes_exited;
+    uint64_t scope_tables_created;  // Scopes past the reused pool
+    uint64_t max_scope_depth;
+    uint64_t types_computed;        // ast_node_get_type calls that typed the node
+    uint64_t types_cached;          // Calls answered from resolved_type
+} SemanticCounters;
+
+typedef struct ScopeBindings {
+    BindingSlot* slots;
+    int slot_count;
+    int slot_capacity;           // Power of two, at least twice slot_count
+    Binding* log;                // Undo log, innermost scope last
+    int log_count;
+    int log_capacity;
+    int depth;                   // Level of the innermost scope
+    int stray_count;             // Unbound symbols in open scopes; see symbol_table_add
+    struct SymbolTable* outer;   // Read-only scope searched when no binding matches
+    SemanticCounters* counters;  // The owning analyzer's
+} ScopeBindings;
+
+// Symbol table structure. symbols keeps insertion order for diagnostics;
+// slots is a linear-probing index over it. Symbols are never removed, so
+// the index needs no tombstones. Scopes of a SemanticAnalyzer share its
+// ScopeBindings instead of having their own index.
 typedef struct SymbolTable {
     Symbol** symbols;
     int symbol_count;
     int capacity;
+    SymbolSlot* slots;           // NULL for analyzer scopes
+    int slot_capacity;           // Power of two, at least twice symbol_count
+    ScopeBindings* bindings;     // Set for analyzer scopes
+    int binding_mark;            // Undo log length when the scope was entered
+    int stray_count;             // Symbols added while an inner scope was open
     struct SymbolTable* parent;  // For nested scopes
     int scope_level;
 } SymbolTable;
 
+struct SemanticAnalyzer;
+
+// Called for every name resolution that did not find a local: the name was
+// bound to a global or is not declared (yet). Dependency tracking uses it to
+// learn which globals a declaration's checks relied on.
+typedef void (*SemanticLookupHook)(struct SemanticAnalyzer* analyzer, const char* name, void* context);
+
 // Semantic analyzer structure
 typedef struct SemanticAnalyzer {
     SymbolTable* current_scope;
     bool had_error;
     Error* last_error;
-    SymbolTable** scope_stack;
+    SymbolTable** scope_stack;   // Entries past scope_stack_size are kept for reuse
     int scope_stack_size;
     int scope_stack_capacity;
+    int scope_pool_size;         // Scope tables allocated so far
+    ScopeBindings* bindings;
+    int global_count;            // Global indices handed out
+    int frame_size;              // Frame slots handed out in the current function
+    ASTNode* globals_end;        // If set, globals declared after this node are not visible
+    SemanticLookupHook lookup_hook;  // NULL unless dependencies are being recorded
+    void* lookup_context;
+    SemanticCounters counters;
 } SemanticAnalyzer;
 
-// Type information
-typedef enum {
-    TYPE_INT,
-    TYPE_FLOAT,
-    TYPE_STRING,
-    TYPE_CHAR,
-    TYPE_BOOL,
-    TYPE_VOID,
-    TYPE_UNKNOWN,
-    TYPE_ERROR
-} DataType;
-
+// Types an expression and records the result on the node (resolved_type,
+// and resolved_symbol for identifiers), so asking again costs nothing. A
+// node is only annotated once everything under it is: an identifier that
+// does not resolve yet stays unannotated. Hash-consed identifiers name the
+// same declaration wherever they appear (see ExprTable), so a shared node is
+// annotated like any other. ast_node_clear_types forgets the annotations of
+// a subtree before it is analyzed again.
 DataType ast_node_get_type(ASTNode* node, SemanticAnalyzer* analyzer);
+void ast_node_clear_types(ASTNode* node);
+
+// Type descriptors (thread-safe; NULL only when out of memory or for a NULL name)
+const TypeDescriptor* type_primitive(DataType type);
+const TypeDescriptor* type_from_name(const char* name);
+const TypeDescriptor* type_pointer_to(const TypeDescriptor* pointee);
+const TypeDescriptor* type_array_of(const TypeDescriptor* element, int length);
+const TypeDescriptor* type_function(const TypeDescriptor* return_type,
+                                    const TypeDescriptor* const* parameters, int parameter_count);
 
 // Symbol table functions
 SymbolTable* symbol_table_create(int scope_level);
@@ -95,12 +241,37 @@ SemanticAnalyzer* semantic_analyzer_create(void);
 void semantic_analyzer_free(SemanticAnalyzer* analyzer);
 bool semantic_analyze(ASTNode* node, SemanticAnalyzer* analyzer);
 
+// Name resolution, the first step of semantic_analyze: declares variables,
+// parameters and functions in scope order and binds every identifier to
+// its declaration, recording the storage slot on the node (resolved_slot,
+// resolved_global) so later stages never look a name up again. Reports
+// undeclared names and redeclarations; returns false if any were found.
+bool semantic_resolve(ASTNode* node, SemanticAnalyzer* analyzer);
+
+// Checks a top-level declaration again after it was edited, leaving its
+// symbol declared: the symbol takes the declaration's (possibly changed)
+// type or return type and position, a variable keeps its global slot, and
+// the initializer or the parameters and body are analyzed against the
+// globals declared before it, as analysis in order would. The analyzer must
+// be at global scope.
+bool semantic_reanalyze_declaration(ASTNode* declaration, Symbol* symbol, SemanticAnalyzer* analyzer);
+
+// semantic_analyze for a whole program in two phases. Global declarations
+// are resolved in order on the calling thread and the global scope is then
+// frozen; function bodies are analyzed by up to thread_count threads, each
+// with its own scope stack reading the globals without locks. A body only
+// sees globals declared before its function, and the reported error is the
+// last one in source order, so the outcome and every annotation match
+// semantic_analyze whatever the thread count.
+bool semantic_analyze_parallel(ASTNode* program, SemanticAnalyzer* analyzer, int thread_count);
+
 // Scope management
 void semantic_analyzer_enter_scope(SemanticAnalyzer* analyzer);
 void semantic_analyzer_exit_scope(SemanticAnalyzer* analyzer);
 SymbolTable* semantic_analyzer_current_scope(SemanticAnalyzer* analyzer);
 
-// Error handling
+// Error handling. semantic_analyzer_error records a printf-style error at node.
+void semantic_analyzer_error(SemanticAnalyzer* analyzer, ASTNode* node, const char* format, ...);
 Error* semantic_analyzer_get_last_error(SemanticAnalyzer* analyzer);
 bool semantic_analyzer_had_error(SemanticAnalyzer* analyzer);
 void semantic_analyzer_clear_error(SemanticAnalyzer* analyzer);
@@ -110,6 +281,20 @@ DataType semantic_check_expression(ASTNode* node, SemanticAnalyzer* analyzer);
 bool semantic_check_assignment(ASTNode* target, ASTNode* value, SemanticAnalyzer* analyzer);
 bool semantic_check_binary_operation(ASTNode* left, ASTNode* right, const char* op, SemanticAnalyzer* analyzer);
 
+// The single source of binary typing rules, shared by ast_node_get_type and
+// semantic_check_binary_operation. Operands of unknown type give an unknown
+// result (bool for comparisons and logic) rather than an error.
+OperatorRule semantic_operator_rule(BinaryOperator op, DataType left, DataType right);
+
+// Instrumentation. Counters accumulate over the analyzer's lifetime,
+// including work done by semantic_analyze_parallel's workers, until reset.
+// semantic_counters_write_json writes them as one JSON object, with the
+// per-lookup averages and the type cache hit rate derived from them.
+const SemanticCounters* semantic_analyzer_counters(SemanticAnalyzer* analyzer);
+void semantic_counters_reset(SemanticAnalyzer* analyzer);
+void semantic_counters_add(SemanticCounters* total, const SemanticCounters* counters);
+bool semantic_counters_write_json(const SemanticCounters* counters, FILE* out);
+
 // Utility functions
 const char* data_type_to_string(DataType type);
 const char* symbol_type_to_string(SymbolType type);
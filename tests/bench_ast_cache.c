@@ -0,0 +1,215 @@
+#include "../src/lexer/lexer.h"
+#include "../src/parser/parser.h"
+#include "../src/parser/ast_cache.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+// AST cache benchmark: builds a synthetic project of many source files and
+// times a cold build (lex, parse, write an image per file) against a warm
+// build (hash the source, map the cached image, visit every node in place).
+// Results are tracked in compiler-docs/benchmark-results.md.
+
+#define DEFAULT_FILES 100
+#define LINES_PER_FILE 5000
+#define RUNS 3
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static char* generate_file(int seed) {
+    StringBuffer* buffer = string_buffer_create(LINES_PER_FILE * 32);
+    char line[256];
+
+    for (int i = 0, lines = 0; lines < LINES_PER_FILE; i++, lines += 7) {
+        snprintf(line, sizeof(line),
+                 "int m%d_f%d(int a, int b) {\n"
+                 "    int x = a + b * %d;\n"
+                 "    if (x > %d) { x = x - b; } else { x = x + a; }\n"
+                 "    while (x < %d) { x = x * 2; }\n"
+                 "    return m%d_f%d(x, b) + x;\n"
+                 "}\n"
+                 "\n",
+                 seed, i, i % 7 + 1, i % 13, i % 100 + 10, seed, i);
+        string_buffer_append(buffer, line);
+    }
+
+    char* source = buffer->data;
+    free(buffer);
+    return source;
+}
+
+static char* read_file(const char* path, size_t* length) {
+    FILE* file = fopen(path, "rb");
+    if (file == NULL) return NULL;
+
+    fseek(file, 0, SEEK_END);
+    *length = (size_t)ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    char* data = malloc(*length + 1);
+    if (data == NULL || fread(data, 1, *length, file) != *length) {
+        free(data);
+        fclose(file);
+        return NULL;
+    }
+    data[*length] = '\0';
+    fclose(file);
+    return data;
+}
+
+// Stand-in for a consumer: counts nodes reachable from the root
+static long visit_image(AstImage* image, const AstImageNode* node) {
+    if (node == NULL) return 0;
+
+    long count = 1 + visit_image(image, ast_image_node(image, node->child[0]));
+    if (ast_image_has_list(node)) {
+        for (uint32_t i = 0; i < ast_image_list_count(node); i++) {
+            count += visit_image(image, ast_image_list_node(image, node, i));
+        }
+    } else {
+        count += visit_image(image, ast_image_node(image, node->child[1]));
+        count += visit_image(image, ast_image_node(image, node->child[2]));
+    }
+    return count;
+}
+
+// One build over all files. Returns the number of nodes visited, or -1.
+static long build_project(const char* directory, int files, int* hits) {
+    char path[512];
+    char image_path[512];
+    long nodes = 0;
+    *hits = 0;
+
+    for (int i = 0; i < files; i++) {
+        snprintf(path, sizeof(path), "%s/m%d.c", directory, i);
+
+        size_t length = 0;
+        char* source = read_file(path, &length);
+        if (source == NULL) return -1;
+
+        uint64_t hash = hash_bytes(source, length);
+        ast_cache_path(image_path, sizeof(image_path), directory, hash);
+
+        AstImage* image = ast_image_open(image_path, hash);
+        if (image != NULL) {
+            (*hits)++;
+        } else {
+            Lexer* lexer = lexer_create(source);
+            Parser* parser = parser_create(lexer);
+            ASTNode* program = parser_parse_program(parser);
+
+            image = ast_image_build(program, hash);
+            if (!parser_had_error(parser)) {
+                ast_image_write(image, image_path);
+            }
+
+            ast_node_free(program);
+            parser_free(parser);
+            lexer_free(lexer);
+        }
+
+        nodes += visit_image(image, ast_image_root(image));
+        ast_image_free(image);
+        free(source);
+    }
+
+    return nodes;
+}
+
+static void remove_images(const char* directory, int files) {
+    char path[512];
+    char image_path[512];
+
+    for (int i = 0; i < files; i++) {
+        snprintf(path, sizeof(path), "%s/m%d.c", directory, i);
+        size_t length = 0;
+        char* source = read_file(path, &length);
+        if (source == NULL) continue;
+
+        ast_cache_path(image_path, sizeof(image_path), directory, hash_bytes(source, length));
+        remove(image_path);
+        free(source);
+    }
+}
+
+int main(int argc, char** argv) {
+    int files = argc > 1 ? atoi(argv[1]) : DEFAULT_FILES;
+
+    char directory[] = "/tmp/bench_ast_cache_XXXXXX";
+    if (mkdtemp(directory) == NULL) {
+        perror("mkdtemp");
+        return EXIT_FAILURE;
+    }
+
+    size_t source_bytes = 0;
+    for (int i = 0; i < files; i++) {
+        char path[512];
+        snprintf(path, sizeof(path), "%s/m%d.c", directory, i);
+        char* source = generate_file(i);
+        source_bytes += strlen(source);
+
+        FILE* file = fopen(path, "wb");
+        fputs(source, file);
+        fclose(file);
+        free(source);
+    }
+
+    double best_cold = 1e9;
+    double best_warm = 1e9;
+    long cold_nodes = 0;
+    long warm_nodes = 0;
+    int hits = 0;
+
+    for (int run = 0; run < RUNS; run++) {
+        remove_images(directory, files);
+
+        double start = now_seconds();
+        cold_nodes = build_project(directory, files, &hits);
+        best_cold = MIN(best_cold, now_seconds() - start);
+
+        start = now_seconds();
+        warm_nodes = build_project(directory, files, &hits);
+        best_warm = MIN(best_warm, now_seconds() - start);
+    }
+
+    if (cold_nodes < 0 || cold_nodes != warm_nodes || hits != files) {
+        fprintf(stderr, "Warm build did not reproduce the cold build\n");
+        return EXIT_FAILURE;
+    }
+
+    char image_path[512];
+    char path[512];
+    size_t image_bytes = 0;
+    for (int i = 0; i < files; i++) {
+        snprintf(path, sizeof(path), "%s/m%d.c", directory, i);
+        size_t length = 0;
+        char* source = read_file(path, &length);
+        ast_cache_path(image_path, sizeof(image_path), directory, hash_bytes(source, length));
+        AstImage* image = ast_image_open(image_path, hash_bytes(source, length));
+        image_bytes += image->size;
+        ast_image_free(image);
+        free(source);
+    }
+
+    printf("=== AST CACHE BENCHMARK ===\n");
+    printf("Project: %d files, %d lines, %.1f MB source, %.1f MB images, %ld nodes\n",
+           files, files * LINES_PER_FILE, source_bytes / 1048576.0, image_bytes / 1048576.0, warm_nodes);
+    printf("Cold (lex + parse + write): %8.2f ms\n", best_cold * 1000);
+    printf("Warm (hash + mmap + visit): %8.2f ms  (%d/%d hits, %.1fx faster)\n",
+           best_warm * 1000, hits, files, best_cold / best_warm);
+
+    remove_images(directory, files);
+    for (int i = 0; i < files; i++) {
+        snprintf(path, sizeof(path), "%s/m%d.c", directory, i);
+        remove(path);
+    }
+    rmdir(directory);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,126 @@
+#include "../src/lexer/lexer.h"
+#include "../src/parser/parser.h"
+#include "../src/semantic/semantic.h"
+#include "../src/codegen/codegen.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Constant folding benchmark: compiles a program of global declarations
+// whose initializers are constant expressions (using only the operators the
+// code generator supports, so both versions compile), with and without
+// parse-time folding, and compares parse time, AST size and the size of the
+// generated assembly. Results are tracked in compiler-docs/benchmark-results.md.
+
+#define DEFAULT_DECLARATIONS 100000
+#define RUNS 3
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static char* generate_constants(int count) {
+    StringBuffer* buffer = string_buffer_create(count * 64);
+    char line[160];
+
+    for (int i = 0; i < count; i++) {
+        snprintf(line, sizeof(line), "int c%d = (%d + 3) * 4 - 2 * %d + (16 - 8) * %d - %d * 60 * 60;\n",
+                 i, i % 1000, i % 17, i % 5 + 1, i % 9);
+        string_buffer_append(buffer, line);
+    }
+
+    char* source = buffer->data;
+    free(buffer);
+    return source;
+}
+
+static long count_nodes(ASTNode* node) {
+    if (node == NULL) return 0;
+
+    switch (node->type) {
+        case NODE_BINARY_EXPRESSION:
+            return 1 + count_nodes(node->data.binary.left) + count_nodes(node->data.binary.right);
+        case NODE_UNARY_EXPRESSION:
+            return 1 + count_nodes(node->data.unary.operand);
+        case NODE_VARIABLE_DECLARATION:
+            return 1 + count_nodes(node->data.declaration.initializer);
+        case NODE_PROGRAM: {
+            long count = 1;
+            for (int i = 0; i < node->data.block.statement_count; i++) {
+                count += count_nodes(node->data.block.statements[i]);
+            }
+            return count;
+        }
+        default:
+            return 1;
+    }
+}
+
+// Instructions are the indented lines that are not directives or comments
+static void measure_assembly(const char* path, long* bytes, long* instructions) {
+    FILE* file = fopen(path, "r");
+    char line[256];
+    *bytes = 0;
+    *instructions = 0;
+
+    while (file != NULL && fgets(line, sizeof(line), file) != NULL) {
+        *bytes += (long)strlen(line);
+        if (strncmp(line, "    ", 4) == 0 && line[4] != '.' && line[4] != '#') (*instructions)++;
+    }
+    if (file != NULL) fclose(file);
+}
+
+static void bench_folding(const char* source, bool fold) {
+    const char* output = fold ? "/tmp/bench_folding_on.s" : "/tmp/bench_folding_off.s";
+    double best = 1e9;
+    long nodes = 0;
+    bool generated = false;
+
+    for (int run = 0; run < RUNS; run++) {
+        Lexer* lexer = lexer_create(source);
+        Parser* parser = parser_create(lexer);
+        if (fold) parser_enable_constant_folding(parser);
+
+        double start = now_seconds();
+        ASTNode* program = parser_parse_program(parser);
+        best = MIN(best, now_seconds() - start);
+        nodes = count_nodes(program);
+
+        if (run == 0) {
+            SemanticAnalyzer* analyzer = semantic_analyzer_create();
+            CodeGenerator* generator = code_generator_create(analyzer->current_scope);
+            generated = code_generator_generate(generator, program, output) == CODEGEN_SUCCESS;
+            code_generator_free(generator);
+            semantic_analyzer_free(analyzer);
+        }
+
+        ast_node_free(program);
+        parser_free(parser);
+        lexer_free(lexer);
+    }
+
+    long bytes = 0;
+    long instructions = 0;
+    measure_assembly(output, &bytes, &instructions);
+    remove(output);
+
+    printf("%-9s parse %8.2f ms  %9ld nodes  %9ld instructions  %8.2f MB asm%s\n",
+           fold ? "folded" : "unfolded", best * 1000, nodes, instructions, bytes / 1048576.0,
+           generated ? "" : "  (CODEGEN FAILED)");
+}
+
+int main(int argc, char** argv) {
+    int count = argc > 1 ? atoi(argv[1]) : DEFAULT_DECLARATIONS;
+    char* source = generate_constants(count);
+
+    printf("=== CONSTANT FOLDING BENCHMARK ===\n");
+    printf("Declarations: %d (%zu bytes)\n", count, strlen(source));
+    bench_folding(source, false);
+    bench_folding(source, true);
+
+    free(source);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,120 @@
+#include "../src/lexer/lexer.h"
+#include "../src/parser/parser.h"
+#include "../src/semantic/semantic.h"
+#include "../src/semantic/dataflow.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Dataflow benchmark: one function made of many if/else statements and
+// while loops over a fixed set of locals, so the graph has six blocks per
+// repetition. Times building the control-flow graph and solving liveness,
+// definite assignment and reaching definitions. Reaching definitions has
+// one bit per definition, so its sets grow with the function and it runs
+// on a smaller one. Results are tracked in
+// compiler-docs/benchmark-results.md.
+
+#define DEFAULT_REPETITIONS 10000
+#define REACHING_REPETITIONS 2000
+#define VARIABLES 64
+#define RUNS 5
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static char* generate_function(int repetitions) {
+    StringBuffer* buffer = string_buffer_create((size_t)repetitions * 160);
+    char line[256];
+
+    string_buffer_append(buffer, "int f(int a, int b) {\n");
+    for (int i = 0; i < VARIABLES; i++) {
+        snprintf(line, sizeof(line), "    int v%d = %s;\n", i, i % 2 ? "a" : "b");
+        string_buffer_append(buffer, line);
+    }
+    for (int i = 0; i < repetitions; i++) {
+        int p = (i * 7) % VARIABLES;
+        int q = (i * 13 + 1) % VARIABLES;
+        int r = (i * 31 + 2) % VARIABLES;
+        snprintf(line, sizeof(line),
+                 "    if (v%d > %d) { v%d = v%d + %d; } else { v%d = v%d - 1; }\n"
+                 "    while (v%d < %d) { v%d = v%d + v%d; }\n",
+                 p, i % 100, q, r, i % 7, r, q, q, i % 50, q, q, p);
+        string_buffer_append(buffer, line);
+    }
+    string_buffer_append(buffer, "    return v0;\n}\n");
+
+    char* source = buffer->data;
+    free(buffer);
+    return source;
+}
+
+typedef DataflowResult* (*Analysis)(const ControlFlowGraph* cfg);
+
+static void bench_analysis(const char* name, const ControlFlowGraph* cfg, Analysis analysis) {
+    double best = 1e9;
+    long visits = 0;
+    size_t bytes = 0;
+    for (int run = 0; run < RUNS; run++) {
+        double start = now_seconds();
+        DataflowResult* result = analysis(cfg);
+        best = MIN(best, now_seconds() - start);
+        visits = result->block_visits;
+        bytes = (size_t)result->word_count * result->block_count * sizeof(BitWord);
+        dataflow_result_free(result);
+    }
+
+    printf("  %-22s %8.2f ms  %7.2f visits/block  %6.1f ns/visit  %7.1f MB per set array\n",
+           name, best * 1000, (double)visits / cfg->block_count, best * 1e9 / visits, bytes / 1048576.0);
+}
+
+static void bench_function(int repetitions, bool reaching) {
+    char* source = generate_function(repetitions);
+    Lexer* lexer = lexer_create(source);
+    Parser* parser = parser_create(lexer);
+    ASTNode* program = parser_parse_program(parser);
+    SemanticAnalyzer* analyzer = semantic_analyzer_create();
+    if (parser_had_error(parser) || !semantic_analyze(program, analyzer)) {
+        fprintf(stderr, "Generated function failed to compile\n");
+        exit(EXIT_FAILURE);
+    }
+    ASTNode* function = program->data.block.statements[0];
+
+    double best = 1e9;
+    ControlFlowGraph* cfg = NULL;
+    for (int run = 0; run < RUNS; run++) {
+        cfg_free(cfg);
+        double start = now_seconds();
+        cfg = cfg_build(function);
+        best = MIN(best, now_seconds() - start);
+    }
+
+    printf("Function: %d blocks, %d statements, %d variables, %d definitions\n",
+           cfg->block_count, cfg->item_count, cfg->variable_count, cfg->definition_count);
+    printf("  %-22s %8.2f ms\n", "CFG construction", best * 1000);
+    if (reaching) {
+        bench_analysis("Reaching definitions", cfg, dataflow_reaching_definitions);
+    } else {
+        bench_analysis("Liveness", cfg, dataflow_liveness);
+        bench_analysis("Definite assignment", cfg, dataflow_definite_assignment);
+    }
+
+    cfg_free(cfg);
+    semantic_analyzer_free(analyzer);
+    ast_node_free(program);
+    parser_free(parser);
+    lexer_free(lexer);
+    free(source);
+}
+
+int main(int argc, char** argv) {
+    int repetitions = argc > 1 ? atoi(argv[1]) : DEFAULT_REPETITIONS;
+
+    printf("=== DATAFLOW BENCHMARK ===\n");
+    bench_function(repetitions, false);
+    bench_function(REACHING_REPETITIONS, true);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,169 @@
+#include "../src/lexer/lexer.h"
+#include "../src/parser/parser.h"
+#include "../src/semantic/semantic.h"
+#include "../src/semantic/effects.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Effect summary benchmark: a program of many small functions over a set of
+// globals, one in five each pure, reading globals, writing them, looping or
+// recursive. Each function also calls two earlier functions of its kind for
+// nothing, as leftover logging and checking calls do, and returns a call of
+// a third. Times effects_summarize against semantic_analyze on the same
+// program, then effects_remove_dead_calls, and counts the calls and
+// statements removed. A second part summarizes one long call chain,
+// which the component search walks as a single path. Results are tracked in
+// compiler-docs/benchmark-results.md.
+
+#define DEFAULT_FUNCTIONS 20000
+#define CHAIN_FUNCTIONS 100000
+#define GLOBALS 64
+#define RUNS 5
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// An earlier function of the same kind as function i, or -1 if there is none
+static int earlier(int i, int seed) {
+    if (i < 5) return -1;
+    return i - 5 * (1 + seed % (i / 5));
+}
+
+static char* generate_program(int functions) {
+    StringBuffer* buffer = string_buffer_create((size_t)functions * 160);
+    char line[512];
+
+    for (int i = 0; i < GLOBALS; i++) {
+        snprintf(line, sizeof(line), "int g%d = %d;\n", i, i);
+        string_buffer_append(buffer, line);
+    }
+
+    for (int i = 0; i < functions; i++) {
+        int g = i % GLOBALS;
+        snprintf(line, sizeof(line), "int f%d(int a) {\n", i);
+        string_buffer_append(buffer, line);
+
+        // Two unused calls and a returned one, to earlier functions
+        if (i >= 5) {
+            snprintf(line, sizeof(line), "    f%d(a);\n    f%d(a + 1);\n", earlier(i, i * 7 + 3),
+                     earlier(i, i * 13 + 5));
+            string_buffer_append(buffer, line);
+        }
+        switch (i % 5) {
+            case 0: snprintf(line, sizeof(line), "    int b = a * %d;\n", i % 9 + 2); break;
+            case 1: snprintf(line, sizeof(line), "    int b = a + g%d;\n", g); break;
+            case 2: snprintf(line, sizeof(line), "    g%d = a;\n    int b = a;\n", g); break;
+            case 3: snprintf(line, sizeof(line), "    int b = a;\n    while (b > %d) { b = b - 1; }\n", i % 50); break;
+            default: snprintf(line, sizeof(line), "    int b = a;\n    if (b > 0) { b = f%d(b - 1); }\n", i); break;
+        }
+        string_buffer_append(buffer, line);
+
+        if (i >= 5) {
+            snprintf(line, sizeof(line), "    return b + f%d(b);\n}\n", earlier(i, i * 31 + 11));
+        } else {
+            snprintf(line, sizeof(line), "    return b;\n}\n");
+        }
+        string_buffer_append(buffer, line);
+    }
+
+    char* source = buffer->data;
+    free(buffer);
+    return source;
+}
+
+// f(i) calls f(i - 1), so every function is visited on one path
+static char* generate_chain(int functions) {
+    StringBuffer* buffer = string_buffer_create((size_t)functions * 48);
+    char line[128];
+
+    string_buffer_append(buffer, "int f0(int a) { return a; }\n");
+    for (int i = 1; i < functions; i++) {
+        snprintf(line, sizeof(line), "int f%d(int a) { return f%d(a) + 1; }\n", i, i - 1);
+        string_buffer_append(buffer, line);
+    }
+
+    char* source = buffer->data;
+    free(buffer);
+    return source;
+}
+
+static int count_statements(ASTNode* node) {
+    if (node == NULL) return 0;
+
+    switch (node->type) {
+        case NODE_PROGRAM:
+        case NODE_BLOCK_STATEMENT: {
+            int count = 0;
+            for (int i = 0; i < node->data.block.statement_count; i++) {
+                count += count_statements(node->data.block.statements[i]);
+            }
+            return count;
+        }
+        case NODE_FUNCTION_DECLARATION:
+            return count_statements(ast_function_body(node));
+        case NODE_IF_STATEMENT:
+        case NODE_WHILE_STATEMENT:
+            return 1 + count_statements(node->data.conditional.then_branch) +
+                   count_statements(node->data.conditional.else_branch);
+        default:
+            return 1;
+    }
+}
+
+static void bench_program(const char* name, char* source, bool remove) {
+    Lexer* lexer = lexer_create(source);
+    Parser* parser = parser_create(lexer);
+    ASTNode* program = parser_parse_program(parser);
+    SemanticAnalyzer* analyzer = semantic_analyzer_create();
+    double start = now_seconds();
+    bool ok = semantic_analyze(program, analyzer);
+    double analysis = now_seconds() - start;
+    if (parser_had_error(parser) || !ok) {
+        fprintf(stderr, "Generated program failed to compile\n");
+        exit(EXIT_FAILURE);
+    }
+
+    EffectsSummary summary;
+    double best = 1e9;
+    for (int run = 0; run < RUNS; run++) {
+        start = now_seconds();
+        effects_summarize(program, analyzer, &summary);
+        best = MIN(best, now_seconds() - start);
+    }
+
+    printf("%s: %d functions, %d calls, %d components, %d recursive, %d pure\n", name, summary.function_count,
+           summary.call_count, summary.component_count, summary.recursive_count, summary.pure_count);
+    printf("  %-22s %8.2f ms\n", "semantic_analyze", analysis * 1000);
+    printf("  %-22s %8.2f ms  (%.2fx analysis)\n", "Summaries", best * 1000, best / analysis);
+
+    if (remove) {
+        int before = count_statements(program);
+        start = now_seconds();
+        int removed = effects_remove_dead_calls(program, analyzer);
+        double elapsed = now_seconds() - start;
+        int after = count_statements(program);
+        printf("  %-22s %8.2f ms  %d of %d calls removed, statements %d -> %d (%.1f%% fewer)\n",
+               "Dead-call elimination", elapsed * 1000, removed, summary.call_count, before, after,
+               100.0 * (before - after) / before);
+    }
+
+    semantic_analyzer_free(analyzer);
+    ast_node_free(program);
+    parser_free(parser);
+    lexer_free(lexer);
+    free(source);
+}
+
+int main(int argc, char** argv) {
+    int functions = argc > 1 ? atoi(argv[1]) : DEFAULT_FUNCTIONS;
+
+    printf("=== EFFECT SUMMARY BENCHMARK ===\n");
+    bench_program("Mixed program", generate_program(functions), true);
+    bench_program("Call chain", generate_chain(CHAIN_FUNCTIONS), false);
+    return EXIT_SUCCESS;
+}
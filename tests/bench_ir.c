@@ -0,0 +1,265 @@
+#include "../src/lexer/lexer.h"
+#include "../src/parser/parser.h"
+#include "../src/semantic/semantic.h"
+#include "../src/semantic/ranges.h"
+#include "../src/ir/ir.h"
+#include "../src/codegen/codegen.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// IR benchmark. The first part lowers many small functions with loops,
+// branches and calls, and one large function, times ir_lower_program
+// against semantic_analyze and reports the size of the IR. The second part
+// generates a program of top-level declarations in checked-arithmetic mode
+// with range facts through the AST code generator and through the IR
+// backend and compares the assembly; the third generates the functions of
+// the first part, which only the IR backend can. Results are tracked in
+// compiler-docs/benchmark-results.md.
+
+#define DEFAULT_FUNCTIONS 20000
+#define DEFAULT_STATEMENTS 20000
+#define DEFAULT_DECLARATIONS 20000
+#define UNKNOWNS 16
+#define RUNS 5
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static char* generate_functions(int functions) {
+    StringBuffer* buffer = string_buffer_create((size_t)functions * 320);
+    char line[512];
+
+    char call[32];
+
+    for (int i = 0; i < functions; i++) {
+        // Every function but the first calls the previous one
+        if (i > 0) {
+            snprintf(call, sizeof(call), "f%d(n - 1)", i - 1);
+        } else {
+            snprintf(call, sizeof(call), "n");
+        }
+        snprintf(line, sizeof(line),
+                 "int f%d(int n) {\n"
+                 "    int i = 0;\n"
+                 "    int s = 0;\n"
+                 "    while (i < n && s < %d) {\n"
+                 "        if (i %% 2 == 0) { s = s + i / 4; } else { s = s - 1; }\n"
+                 "        i = i + 1;\n"
+                 "    }\n"
+                 "    if (s > 0 || n < 0) { s = s * %d; }\n"
+                 "    return s + %s;\n"
+                 "}\n",
+                 i, 1000 + i % 900, i % 7 + 2, call);
+        string_buffer_append(buffer, line);
+    }
+
+    char* source = buffer->data;
+    free(buffer);
+    return source;
+}
+
+// One function whose body is a long chain of declarations and branches
+static char* generate_large_function(int statements) {
+    StringBuffer* buffer = string_buffer_create((size_t)statements * 48 + 64);
+    char line[160];
+
+    string_buffer_append(buffer, "int big(int n) {\n    int x0 = n;\n");
+    for (int i = 1; i < statements; i++) {
+        if (i % 4 == 0) {
+            snprintf(line, sizeof(line), "    if (x%d > %d) { x%d = x%d - 1; }\n", i - 1, i, i - 1, i - 1);
+            string_buffer_append(buffer, line);
+        }
+        snprintf(line, sizeof(line), "    int x%d = x%d * 3 + %d;\n", i, i - 1, i % 100);
+        string_buffer_append(buffer, line);
+    }
+    snprintf(line, sizeof(line), "    return x%d;\n}\n", statements - 1);
+    string_buffer_append(buffer, line);
+
+    char* source = buffer->data;
+    free(buffer);
+    return source;
+}
+
+// Each declaration mixes constants, earlier declarations and an unknown
+static char* generate_declarations(int count) {
+    StringBuffer* buffer = string_buffer_create((size_t)count * 64);
+    char line[160];
+
+    for (int i = 0; i < UNKNOWNS; i++) {
+        snprintf(line, sizeof(line), "int u%d;\n", i);
+        string_buffer_append(buffer, line);
+    }
+    for (int i = 0; i < count; i++) {
+        int previous = i > 0 ? i - 1 : 0;
+        switch (i % 4) {
+            case 0: snprintf(line, sizeof(line), "int v%d = %d * 3 + 7;\n", i, i % 1000); break;
+            case 1: snprintf(line, sizeof(line), "int v%d = v%d / 4 + v%d %% 8;\n", i, previous, previous); break;
+            case 2: snprintf(line, sizeof(line), "int v%d = %d / (v%d + 1);\n", i, 100000 + i, previous); break;
+            default: snprintf(line, sizeof(line), "int v%d = u%d / 2 + v%d;\n", i, i % UNKNOWNS, previous); break;
+        }
+        string_buffer_append(buffer, line);
+    }
+
+    char* source = buffer->data;
+    free(buffer);
+    return source;
+}
+
+typedef struct {
+    Lexer* lexer;
+    Parser* parser;
+    ASTNode* program;
+    SemanticAnalyzer* analyzer;
+    double analysis;
+} Compiled;
+
+static void compile(const char* source, Compiled* compiled) {
+    compiled->lexer = lexer_create(source);
+    compiled->parser = parser_create(compiled->lexer);
+    compiled->program = parser_parse_program(compiled->parser);
+    compiled->analyzer = semantic_analyzer_create();
+    double start = now_seconds();
+    bool ok = semantic_analyze(compiled->program, compiled->analyzer);
+    compiled->analysis = now_seconds() - start;
+    if (parser_had_error(compiled->parser) || !ok) {
+        fprintf(stderr, "Generated program failed to compile\n");
+        exit(EXIT_FAILURE);
+    }
+    ranges_analyze(compiled->program, compiled->analyzer, NULL);
+}
+
+static void release(Compiled* compiled) {
+    semantic_analyzer_free(compiled->analyzer);
+    ast_node_free(compiled->program);
+    parser_free(compiled->parser);
+    lexer_free(compiled->lexer);
+}
+
+static void bench_lowering(const char* label, const char* source) {
+    Compiled compiled;
+    compile(source, &compiled);
+
+    double best = 1e9;
+    for (int run = 0; run < RUNS; run++) {
+        double start = now_seconds();
+        IrModule* module = ir_lower_program(compiled.program, compiled.analyzer);
+        best = MIN(best, now_seconds() - start);
+        if (module->had_error) {
+            fprintf(stderr, "Lowering failed: %s\n", module->error);
+            exit(EXIT_FAILURE);
+        }
+        if (run < RUNS - 1) ir_module_free(module);
+        if (run < RUNS - 1) continue;
+
+        long blocks = 0;
+        long operands = 0;
+        for (int i = 0; i < module->function_count; i++) {
+            blocks += module->functions[i].block_count;
+            operands += module->functions[i].operand_count;
+        }
+        long instructions = ir_module_instr_count(module);
+        long bytes = instructions * (long)sizeof(IrInstr) + blocks * (long)sizeof(IrBlock) +
+                     operands * (long)sizeof(int);
+        printf("%s: %d functions, %ld blocks, %ld instructions, %.1f MB\n", label, module->function_count, blocks,
+               instructions, bytes / 1e6);
+        printf("  %-22s %8.2f ms\n", "semantic_analyze", compiled.analysis * 1000);
+        printf("  %-22s %8.2f ms  (%.2fx analysis, %.0f ns/instruction)\n", "ir_lower_program", best * 1000,
+               best / compiled.analysis, best * 1e9 / instructions);
+        ir_module_free(module);
+    }
+
+    release(&compiled);
+}
+
+typedef struct {
+    long instructions;
+    long overflow_checks;
+    long zero_checks;
+    long divides;
+    long memory;
+} AssemblyCounts;
+
+// Instructions are the indented lines that are not directives or comments
+static void measure_assembly(const char* path, AssemblyCounts* counts) {
+    FILE* file = fopen(path, "r");
+    char line[256];
+    memset(counts, 0, sizeof(*counts));
+
+    while (file != NULL && fgets(line, sizeof(line), file) != NULL) {
+        if (strncmp(line, "    ", 4) != 0 || line[4] == '.' || line[4] == '#') continue;
+        counts->instructions++;
+        if (strncmp(line + 4, "jo ", 3) == 0) counts->overflow_checks++;
+        if (strncmp(line + 4, "jz ", 3) == 0) counts->zero_checks++;
+        if (strncmp(line + 4, "idiv ", 5) == 0) counts->divides++;
+        if (strchr(line, '[') != NULL || strncmp(line + 4, "push", 4) == 0 || strncmp(line + 4, "pop", 3) == 0) {
+            counts->memory++;
+        }
+    }
+    if (file != NULL) fclose(file);
+}
+
+static void report_assembly(const char* label, const char* output, double elapsed, bool generated) {
+    AssemblyCounts counts;
+    measure_assembly(output, &counts);
+    remove(output);
+    printf("  %-8s %9ld instructions  %8ld memory  %6ld jo  %6ld jz  %6ld idiv  %8.2f ms%s\n", label,
+           counts.instructions, counts.memory, counts.overflow_checks, counts.zero_checks, counts.divides,
+           elapsed * 1000, generated ? "" : "  (CODEGEN FAILED)");
+}
+
+static void bench_codegen(const char* source, bool with_ast) {
+    const char* output = "/tmp/bench_ir.s";
+    Compiled compiled;
+    compile(source, &compiled);
+
+    if (with_ast) {
+        CodeGenerator* generator = code_generator_create(compiled.analyzer->current_scope);
+        generator->checked_arithmetic = true;
+        double start = now_seconds();
+        bool generated = code_generator_generate(generator, compiled.program, output) == CODEGEN_SUCCESS;
+        double elapsed = now_seconds() - start;
+        code_generator_free(generator);
+        report_assembly("AST", output, elapsed, generated);
+    }
+
+    // The IR time includes lowering
+    CodeGenerator* generator = code_generator_create(compiled.analyzer->current_scope);
+    generator->checked_arithmetic = true;
+    double start = now_seconds();
+    IrModule* module = ir_lower_program(compiled.program, compiled.analyzer);
+    bool generated = code_generator_generate_ir(generator, module, output) == CODEGEN_SUCCESS;
+    double elapsed = now_seconds() - start;
+    ir_module_free(module);
+    code_generator_free(generator);
+    report_assembly("IR", output, elapsed, generated);
+
+    release(&compiled);
+}
+
+int main(int argc, char** argv) {
+    int functions = argc > 1 ? atoi(argv[1]) : DEFAULT_FUNCTIONS;
+    int statements = argc > 2 ? atoi(argv[2]) : DEFAULT_STATEMENTS;
+    int declarations = argc > 3 ? atoi(argv[3]) : DEFAULT_DECLARATIONS;
+
+    printf("=== IR BENCHMARK ===\n");
+    char* source = generate_functions(functions);
+    bench_lowering("Small functions", source);
+    char* large = generate_large_function(statements);
+    bench_lowering("Large function", large);
+
+    char* top_level = generate_declarations(declarations);
+    printf("Checked top-level code: %d declarations\n", declarations);
+    bench_codegen(top_level, true);
+    printf("Checked functions: %d\n", functions);
+    bench_codegen(source, false);
+
+    free(top_level);
+    free(large);
+    free(source);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,162 @@
+#include "../src/lexer/lexer.h"
+#include "../src/parser/parser.h"
+#include "../src/semantic/semantic.h"
+#include "../src/semantic/module.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Module interface benchmark: a client module that uses a large library.
+// Compares making the library's declarations visible by parsing and
+// analyzing its source against opening its interface file and importing
+// it; the source still has to be read and hashed to validate the file.
+// Results are tracked in compiler-docs/benchmark-results.md.
+
+#define DEFAULT_FUNCTIONS 2000
+#define RUNS 5
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static char* generate_library(int functions) {
+    StringBuffer* buffer = string_buffer_create((size_t)functions * 256);
+    char line[512];
+
+    for (int i = 0; i < functions; i++) {
+        snprintf(line, sizeof(line),
+                 "int limit%d = %d;\n"
+                 "int step%d(int value, float factor, int count) {\n"
+                 "    int result = value + limit%d;\n"
+                 "    while (count > 0) { result = result * 2 + count; count = count - 1; }\n"
+                 "    if (result > %d) { result = result - limit%d; } else { result = result + 1; }\n"
+                 "    return result;\n"
+                 "}\n",
+                 i, i % 100, i, i, i * 3, i);
+        string_buffer_append(buffer, line);
+    }
+
+    char* source = buffer->data;
+    free(buffer);
+    return source;
+}
+
+static char* generate_client(int functions) {
+    StringBuffer* buffer = string_buffer_create(4096);
+    char line[256];
+
+    for (int i = 0; i < functions; i += functions / 16) {
+        snprintf(line, sizeof(line), "int use%d(int x) { return step%d(x, 1.5, limit%d); }\n", i, i, i);
+        string_buffer_append(buffer, line);
+    }
+
+    char* source = buffer->data;
+    free(buffer);
+    return source;
+}
+
+static bool analyze_client(const char* client, SemanticAnalyzer* analyzer) {
+    Lexer* lexer = lexer_create(client);
+    Parser* parser = parser_create(lexer);
+    ASTNode* program = parser_parse_program(parser);
+    bool ok = semantic_analyze(program, analyzer);
+    ast_node_free(program);
+    parser_free(parser);
+    lexer_free(lexer);
+    return ok;
+}
+
+// The library's declarations from source: parse and analyze it, then the
+// client in the same global scope
+static bool compile_from_source(const char* library, const char* client) {
+    Lexer* lexer = lexer_create(library);
+    Parser* parser = parser_create(lexer);
+    ASTNode* program = parser_parse_program(parser);
+    SemanticAnalyzer* analyzer = semantic_analyzer_create();
+    bool ok = semantic_analyze(program, analyzer) && analyze_client(client, analyzer);
+
+    semantic_analyzer_free(analyzer);
+    ast_node_free(program);
+    parser_free(parser);
+    lexer_free(lexer);
+    return ok;
+}
+
+static bool compile_from_interface(const char* library, const char* path, const char* client) {
+    ModuleInterface* interface = module_interface_open(path, hash_bytes(library, strlen(library)));
+    if (interface == NULL) return false;
+
+    SemanticAnalyzer* analyzer = semantic_analyzer_create();
+    bool ok = module_interface_import(interface, analyzer) && analyze_client(client, analyzer);
+
+    semantic_analyzer_free(analyzer);
+    module_interface_free(interface);
+    return ok;
+}
+
+int main(int argc, char** argv) {
+    int functions = argc > 1 ? atoi(argv[1]) : DEFAULT_FUNCTIONS;
+    char* library = generate_library(functions);
+    char* client = generate_client(functions);
+    uint64_t hash = hash_bytes(library, strlen(library));
+
+    // Export once, as the library's own compilation would
+    Lexer* lexer = lexer_create(library);
+    Parser* parser = parser_create(lexer);
+    ASTNode* program = parser_parse_program(parser);
+    SemanticAnalyzer* analyzer = semantic_analyzer_create();
+    if (!semantic_analyze(program, analyzer)) {
+        fprintf(stderr, "Generated library failed to compile\n");
+        return EXIT_FAILURE;
+    }
+
+    double start = now_seconds();
+    ModuleInterface* interface = module_interface_build(program, analyzer, hash);
+    double export_time = now_seconds() - start;
+
+    char path[256];
+    module_interface_path(path, sizeof(path), "/tmp", "bench_module_library");
+    if (!module_interface_write(interface, path)) {
+        fprintf(stderr, "Could not write %s\n", path);
+        return EXIT_FAILURE;
+    }
+
+    printf("=== MODULE INTERFACE BENCHMARK ===\n");
+    printf("Library: %d functions and %d globals, %zu bytes of source, %zu bytes of interface\n",
+           functions, functions, strlen(library), interface->size);
+    printf("  %-26s %8.3f ms\n", "Export", export_time * 1000);
+
+    double best_source = 1e9;
+    double best_interface = 1e9;
+    for (int run = 0; run < RUNS; run++) {
+        start = now_seconds();
+        bool ok = compile_from_source(library, client);
+        best_source = MIN(best_source, now_seconds() - start);
+
+        start = now_seconds();
+        ok = compile_from_interface(library, path, client) && ok;
+        best_interface = MIN(best_interface, now_seconds() - start);
+
+        if (!ok) {
+            fprintf(stderr, "Client failed to compile\n");
+            return EXIT_FAILURE;
+        }
+    }
+
+    printf("  %-26s %8.3f ms\n", "Client, library from source", best_source * 1000);
+    printf("  %-26s %8.3f ms  (%.1fx)\n", "Client, library interface", best_interface * 1000,
+           best_source / best_interface);
+
+    remove(path);
+    module_interface_free(interface);
+    semantic_analyzer_free(analyzer);
+    ast_node_free(program);
+    parser_free(parser);
+    lexer_free(lexer);
+    free(client);
+    free(library);
+    return EXIT_SUCCESS;
+}
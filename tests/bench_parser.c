@@ -0,0 +1,376 @@
+#include "../src/lexer/lexer.h"
+#include "../src/parser/parser.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <malloc.h>
+
+// Parser throughput benchmark: lexes and parses a synthetic program and
+// reports lines per second for each phase, then parses inputs where every
+// other line is a syntax error to check that recovery stays linear, parses
+// function bodies on 1..8 threads, checking each tree against the sequential
+// one, measures lazy body parsing when only a fraction of the functions is
+// used, compares AST memory with and without hash-consing on formula-heavy
+// code, and finally times incremental reparses after small edits. Results
+// are tracked in compiler-docs/benchmark-results.md.
+
+#define DEFAULT_LINES 100000
+#define RUNS 5
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Builds a program of roughly target_lines lines out of 14-line functions
+static char* generate_program(int target_lines, int* line_count) {
+    StringBuffer* buffer = string_buffer_create(target_lines * 32);
+    char line[256];
+    int lines = 0;
+
+    for (int i = 0; lines < target_lines; i++) {
+        snprintf(line, sizeof(line),
+                 "int f%d(int a, int b) {\n"
+                 "    int x = a + b * %d;\n"
+                 "    int y = x - (a - %d) / 2;\n"
+                 "    if (x > y) {\n"
+                 "        x = x + 1;\n"
+                 "    } else {\n"
+                 "        y = y - 1;\n"
+                 "    }\n"
+                 "    while (y < %d) {\n"
+                 "        y = y + x * 2;\n"
+                 "    }\n"
+                 "    return x + y;\n"
+                 "}\n"
+                 "\n",
+                 i, i % 7 + 1, i % 13, i % 100 + 10);
+        string_buffer_append(buffer, line);
+        lines += 14;
+    }
+
+    *line_count = lines;
+    char* source = buffer->data;
+    free(buffer);
+    return source;
+}
+
+// Alternates valid and broken declarations
+static char* generate_broken_program(int lines) {
+    StringBuffer* buffer = string_buffer_create(lines * 16);
+    for (int i = 0; i < lines; i += 2) {
+        string_buffer_append(buffer, "int ok = 1 + 2;\n");
+        string_buffer_append(buffer, "int bad = (3 * ;\n");
+    }
+
+    char* source = buffer->data;
+    free(buffer);
+    return source;
+}
+
+static void bench_recovery(int lines) {
+    char* source = generate_broken_program(lines);
+    double best = 1e9;
+    int errors = 0;
+    int diagnostics = 0;
+
+    for (int run = 0; run < RUNS; run++) {
+        Lexer* lexer = lexer_create(source);
+        double start = now_seconds();
+        Parser* parser = parser_create(lexer);
+        ASTNode* program = parser_parse_program(parser);
+        best = MIN(best, now_seconds() - start);
+
+        errors = parser_get_error_count(parser);
+        diagnostics = parser_get_diagnostic_count(parser);
+
+        ast_node_free(program);
+        parser_free(parser);
+        lexer_free(lexer);
+    }
+
+    printf("%8d lines  %7d errors (%d kept)  %8.2f ms  %8.1f ns/line\n",
+           lines, errors, diagnostics, best * 1000, best * 1e9 / lines);
+    free(source);
+}
+
+static void bench_parallel(const char* source, int line_count, int thread_count) {
+    Lexer* reference_lexer = lexer_create(source);
+    Parser* reference_parser = parser_create(reference_lexer);
+    ASTNode* reference = parser_parse_program(reference_parser);
+
+    double best = 1e9;
+    bool identical = true;
+
+    for (int run = 0; run < RUNS; run++) {
+        Lexer* lexer = lexer_create(source);
+        Parser* parser = parser_create(lexer);
+
+        double start = now_seconds();
+        ASTNode* program = parser_parse_program_parallel(parser, thread_count);
+        best = MIN(best, now_seconds() - start);
+
+        identical = identical && ast_node_equal(reference, program);
+
+        ast_node_free(program);
+        parser_free(parser);
+        lexer_free(lexer);
+    }
+
+    printf("%2d threads  %8.2f ms  %12.0f lines/sec  %s\n", thread_count, best * 1000,
+           line_count / best, identical ? "identical" : "TREE MISMATCH");
+
+    ast_node_free(reference);
+    parser_free(reference_parser);
+    lexer_free(reference_lexer);
+}
+
+static size_t heap_in_use(void) {
+    return mallinfo2().uordblks;
+}
+
+// Parses eagerly (percent < 0) or lazily, then requests the bodies of
+// percent% of the functions, spread evenly through the program
+static void bench_lazy(const char* source, int percent) {
+    double best = 1e9;
+    size_t memory = 0;
+
+    for (int run = 0; run < RUNS; run++) {
+        Lexer* lexer = lexer_create(source);
+        Parser* parser = parser_create(lexer);
+
+        size_t heap_before = heap_in_use();
+        double start = now_seconds();
+        ASTNode* program = percent < 0 ? parser_parse_program(parser) : parser_parse_program_lazy(parser);
+        for (int i = 0; percent > 0 && i < program->data.block.statement_count; i++) {
+            if (i * percent / 100 != (i + 1) * percent / 100) {
+                ast_function_body(program->data.block.statements[i]);
+            }
+        }
+        best = MIN(best, now_seconds() - start);
+        memory = heap_in_use() - heap_before;
+
+        ast_node_free(program);
+        parser_free(parser);
+        lexer_free(lexer);
+    }
+
+    if (percent < 0) {
+        printf("eager        %8.2f ms  %8.2f MB AST\n", best * 1000, memory / 1048576.0);
+    } else {
+        printf("lazy %3d%%    %8.2f ms  %8.2f MB AST\n", percent, best * 1000, memory / 1048576.0);
+    }
+}
+
+// Generated numeric code: each function repeats the same few formulas
+static char* generate_formulas(int target_lines) {
+    StringBuffer* buffer = string_buffer_create(target_lines * 64);
+    char line[512];
+
+    for (int i = 0, lines = 0; lines < target_lines; i++, lines += 7) {
+        snprintf(line, sizeof(line),
+                 "float k%d(float a, float b, float c) {\n"
+                 "    float d = (a * b + c) * (a * b + c) - 4 * a * c;\n"
+                 "    float e = (a * b + c) / (a * a + b * b + %d);\n"
+                 "    float f = (a * a + b * b + %d) * (a * b + c) + d * e;\n"
+                 "    return (a * b + c) * d + (a * a + b * b + %d) * e + f;\n"
+                 "}\n"
+                 "\n",
+                 i, i % 5 + 1, i % 5 + 1, i % 5 + 1);
+        string_buffer_append(buffer, line);
+    }
+
+    char* source = buffer->data;
+    free(buffer);
+    return source;
+}
+
+static void bench_hash_consing(int target_lines, bool hash_consing) {
+    char* source = generate_formulas(target_lines);
+    double best = 1e9;
+    size_t memory = 0;
+    int shared = 0;
+    int hits = 0;
+
+    for (int run = 0; run < RUNS; run++) {
+        Lexer* lexer = lexer_create(source);
+        Parser* parser = parser_create(lexer);
+
+        size_t heap_before = heap_in_use();
+        double start = now_seconds();
+        if (hash_consing) parser_enable_hash_consing(parser);
+        ASTNode* program = parser_parse_program(parser);
+        best = MIN(best, now_seconds() - start);
+        memory = heap_in_use() - heap_before;
+
+        if (hash_consing) {
+            shared = parser->expr_table->count;
+            hits = parser->expr_table->hits;
+        }
+
+        ast_node_free(program);
+        parser_free(parser);
+        lexer_free(lexer);
+    }
+
+    if (hash_consing) {
+        printf("hash-consed  %8.2f ms  %8.2f MB AST  (%d shared nodes, %d reuses)\n",
+               best * 1000, memory / 1048576.0, shared, hits);
+    } else {
+        printf("trees        %8.2f ms  %8.2f MB AST\n", best * 1000, memory / 1048576.0);
+    }
+    free(source);
+}
+
+#define EDITS 200
+
+// Offset of the start of a 1-based line
+static size_t line_offset(const char* source, int line) {
+    const char* start = source;
+    for (int current = 1; current < line; current++) {
+        start = strchr(start, '\n') + 1;
+    }
+    return (size_t)(start - source);
+}
+
+// Applies EDITS edits to the generated program, each followed by
+// parser_reparse, and checks the final tree against a fresh parse. With
+// insert set, edits alternately add and remove a line inside an if block,
+// moving everything after it; otherwise each one changes a single digit.
+static void bench_incremental(const char* source, int line_count, bool insert) {
+    size_t length = strlen(source);
+    char* text = malloc(length + 64);
+    memcpy(text, source, length + 1);
+
+    Lexer* lexer = lexer_create(text);
+    Parser* parser = parser_create(lexer);
+    ASTNode* program = parser_parse_program(parser);
+    int functions = program->data.block.statement_count;
+
+    double total = 0;
+    double worst = 0;
+    for (int k = 0; k < EDITS; k++) {
+        int function = (int)((k * 7919L) % functions);
+        TextEdit edit;
+
+        if (!insert) {
+            // The digit in "int x = a + b * N;"
+            edit = (TextEdit){ function * 14 + 2, function * 14 + 2, function * 14 + 2 };
+            char* digit = strchr(text + line_offset(text, edit.start_line), ';') - 1;
+            *digit = (char)('1' + (*digit - '0') % 9);
+        } else {
+            // Add "x = x;" after "x = x + 1;", then take it out again
+            int line = (k / 2 * 7919L) % functions * 14 + 5;
+            size_t at = line_offset(text, line + 1);
+            const char* added = "        x = x;\n";
+            size_t added_length = strlen(added);
+            if (k % 2 == 0) {
+                memmove(text + at + added_length, text + at, length - at + 1);
+                memcpy(text + at, added, added_length);
+                length += added_length;
+                edit = (TextEdit){ line, line, line + 1 };
+            } else {
+                memmove(text + at, text + at + added_length, length - at - added_length + 1);
+                length -= added_length;
+                edit = (TextEdit){ line, line + 1, line };
+            }
+        }
+
+        Lexer* edited = lexer_create(text);
+        double start = now_seconds();
+        program = parser_reparse(parser, program, edited, &edit);
+        double elapsed = now_seconds() - start;
+        lexer_free(lexer);
+        lexer = edited;
+
+        total += elapsed;
+        worst = MAX(worst, elapsed);
+    }
+
+    Lexer* fresh_lexer = lexer_create(text);
+    Parser* fresh_parser = parser_create(fresh_lexer);
+    ASTNode* fresh = parser_parse_program(fresh_parser);
+    bool identical = ast_node_equal(fresh, program);
+
+    printf("%-14s %5d edits  %8.1f us avg  %8.1f us worst  (%d lines)  %s\n",
+           insert ? "insert/delete" : "change digit", EDITS, total / EDITS * 1e6, worst * 1e6,
+           line_count, identical ? "identical" : "TREE MISMATCH");
+
+    ast_node_free(fresh);
+    parser_free(fresh_parser);
+    lexer_free(fresh_lexer);
+    ast_node_free(program);
+    parser_free(parser);
+    lexer_free(lexer);
+    free(text);
+}
+
+int main(int argc, char** argv) {
+    int target_lines = argc > 1 ? atoi(argv[1]) : DEFAULT_LINES;
+    int line_count = 0;
+    char* source = generate_program(target_lines, &line_count);
+
+    double best_lex = 1e9;
+    double best_parse = 1e9;
+    int declarations = 0;
+
+    for (int run = 0; run < RUNS; run++) {
+        Lexer* lexer = lexer_create(source);
+
+        double start = now_seconds();
+        Parser* parser = parser_create(lexer); // tokenizes the whole input
+        double lexed = now_seconds();
+        ASTNode* program = parser_parse_program(parser);
+        double parsed = now_seconds();
+
+        if (parser_had_error(parser)) {
+            fprintf(stderr, "Benchmark program failed to parse\n");
+            return EXIT_FAILURE;
+        }
+
+        declarations = program->data.block.statement_count;
+        best_lex = MIN(best_lex, lexed - start);
+        best_parse = MIN(best_parse, parsed - lexed);
+
+        ast_node_free(program);
+        parser_free(parser);
+        lexer_free(lexer);
+    }
+
+    printf("=== PARSER BENCHMARK ===\n");
+    printf("Lines: %d (%d functions, %zu bytes)\n", line_count, declarations, strlen(source));
+    printf("Lex:   %8.2f ms  %12.0f lines/sec\n", best_lex * 1000, line_count / best_lex);
+    printf("Parse: %8.2f ms  %12.0f lines/sec\n", best_parse * 1000, line_count / best_parse);
+    printf("Total: %8.2f ms  %12.0f lines/sec\n", (best_lex + best_parse) * 1000,
+           line_count / (best_lex + best_parse));
+
+    printf("\n=== ERROR RECOVERY (every other line broken) ===\n");
+    for (int lines = target_lines / 4; lines <= target_lines; lines *= 2) {
+        bench_recovery(lines);
+    }
+
+    printf("\n=== PARALLEL FUNCTION BODIES ===\n");
+    for (int threads = 1; threads <= 8; threads *= 2) {
+        bench_parallel(source, line_count, threads);
+    }
+
+    printf("\n=== LAZY FUNCTION BODIES (bodies requested) ===\n");
+    bench_lazy(source, -1);
+    int fractions[] = { 0, 10, 25, 50, 100 };
+    for (int i = 0; i < 5; i++) {
+        bench_lazy(source, fractions[i]);
+    }
+
+    printf("\n=== HASH-CONSED EXPRESSIONS (formula-heavy input) ===\n");
+    bench_hash_consing(target_lines, false);
+    bench_hash_consing(target_lines, true);
+
+    printf("\n=== INCREMENTAL REPARSE (full parse: %.2f ms) ===\n", (best_lex + best_parse) * 1000);
+    bench_incremental(source, line_count, false);
+    bench_incremental(source, line_count, true);
+
+    free(source);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,161 @@
+#include "../src/lexer/lexer.h"
+#include "../src/parser/parser.h"
+#include "../src/semantic/semantic.h"
+#include "../src/codegen/codegen.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <malloc.h>
+
+// Pipeline benchmark: compiles a long list of global declarations with the
+// phased pipeline (whole AST, then analysis, then code generation), with
+// streaming declaration callbacks on one thread, and with the callbacks on a
+// consumer thread behind a bounded queue. Reports time and peak heap use and
+// checks that all three write the same assembly. Results are tracked in
+// compiler-docs/benchmark-results.md.
+
+#define DEFAULT_DECLARATIONS 200000
+#define QUEUE_CAPACITY 64
+#define RUNS 3
+#define SAMPLE_EVERY 1000
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static size_t heap_in_use(void) {
+    return mallinfo2().uordblks;
+}
+
+static char* generate_declarations(int count) {
+    StringBuffer* buffer = string_buffer_create(count * 40);
+    char line[128];
+
+    for (int i = 0; i < count; i++) {
+        snprintf(line, sizeof(line), "int v%d = %d + %d * %d - %d;\n", i, i % 97, i % 13, i % 7 + 1, i % 5);
+        string_buffer_append(buffer, line);
+    }
+
+    char* source = buffer->data;
+    free(buffer);
+    return source;
+}
+
+typedef struct {
+    SemanticAnalyzer* analyzer;
+    CodeGenerator* generator;
+    size_t heap_before;
+    size_t peak;
+    int seen;
+    bool failed;
+} Backend;
+
+static void backend_sample(Backend* backend) {
+    backend->peak = MAX(backend->peak, heap_in_use() - backend->heap_before);
+}
+
+static bool backend_declaration(ASTNode* declaration, void* context) {
+    Backend* backend = context;
+
+    semantic_analyze(declaration, backend->analyzer);
+    if (code_generator_generate_declaration(backend->generator, declaration) != CODEGEN_SUCCESS) {
+        backend->failed = true;
+    }
+    ast_node_free(declaration);
+
+    if (++backend->seen % SAMPLE_EVERY == 0) backend_sample(backend);
+    return !backend->failed;
+}
+
+typedef enum { MODE_PHASED, MODE_STREAMING, MODE_PIPELINED } Mode;
+
+static bool compile(const char* source, Mode mode, const char* output, double* seconds, size_t* peak) {
+    Lexer* lexer = lexer_create(source);
+    Parser* parser = parser_create(lexer);
+    SemanticAnalyzer* analyzer = semantic_analyzer_create();
+    CodeGenerator* generator = code_generator_create(analyzer->current_scope);
+    Backend backend = { analyzer, generator, heap_in_use(), 0, 0, false };
+
+    double start = now_seconds();
+    bool ok;
+    if (mode == MODE_PHASED) {
+        ASTNode* program = parser_parse_program(parser);
+        backend_sample(&backend);
+        for (int i = 0; i < program->data.block.statement_count; i++) {
+            semantic_analyze(program->data.block.statements[i], analyzer);
+        }
+        ok = code_generator_generate(generator, program, output) == CODEGEN_SUCCESS;
+        ast_node_free(program);
+    } else {
+        ok = code_generator_begin(generator, output) == CODEGEN_SUCCESS;
+        ok = ok && (mode == MODE_STREAMING
+                        ? parser_parse_program_streaming(parser, backend_declaration, &backend)
+                        : parser_parse_program_pipelined(parser, backend_declaration, &backend, QUEUE_CAPACITY));
+        ok = ok && code_generator_end(generator) == CODEGEN_SUCCESS;
+    }
+    *seconds = now_seconds() - start;
+    *peak = backend.peak;
+    ok = ok && !backend.failed && !parser_had_error(parser);
+
+    code_generator_free(generator);
+    semantic_analyzer_free(analyzer);
+    parser_free(parser);
+    lexer_free(lexer);
+    return ok;
+}
+
+static bool same_file(const char* a, const char* b) {
+    FILE* fa = fopen(a, "rb");
+    FILE* fb = fopen(b, "rb");
+    bool same = fa != NULL && fb != NULL;
+
+    while (same) {
+        int ca = fgetc(fa);
+        int cb = fgetc(fb);
+        same = ca == cb;
+        if (ca == EOF) break;
+    }
+
+    if (fa) fclose(fa);
+    if (fb) fclose(fb);
+    return same;
+}
+
+int main(int argc, char** argv) {
+    int count = argc > 1 ? atoi(argv[1]) : DEFAULT_DECLARATIONS;
+    char* source = generate_declarations(count);
+
+    const char* names[] = { "phased", "streaming", "pipelined" };
+    const char* outputs[] = { "/tmp/bench_pipeline_phased.s", "/tmp/bench_pipeline_streaming.s",
+                              "/tmp/bench_pipeline_pipelined.s" };
+
+    printf("=== PIPELINE BENCHMARK ===\n");
+    printf("Declarations: %d (%zu bytes)\n", count, strlen(source));
+
+    for (int mode = MODE_PHASED; mode <= MODE_PIPELINED; mode++) {
+        double best = 1e9;
+        size_t peak = 0;
+
+        for (int run = 0; run < RUNS; run++) {
+            double seconds = 0;
+            if (!compile(source, mode, outputs[mode], &seconds, &peak)) {
+                fprintf(stderr, "%s compile failed\n", names[mode]);
+                return EXIT_FAILURE;
+            }
+            best = MIN(best, seconds);
+        }
+
+        bool same = same_file(outputs[MODE_PHASED], outputs[mode]);
+        printf("%-10s %9.2f ms  %10.1f KB peak AST  %s\n", names[mode], best * 1000, peak / 1024.0,
+               same ? "same assembly" : "ASSEMBLY DIFFERS");
+    }
+
+    for (int mode = MODE_PHASED; mode <= MODE_PIPELINED; mode++) {
+        remove(outputs[mode]);
+    }
+    free(source);
+    return EXIT_SUCCESS;
+}
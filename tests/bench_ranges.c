@@ -0,0 +1,195 @@
+#include "../src/lexer/lexer.h"
+#include "../src/parser/parser.h"
+#include "../src/semantic/semantic.h"
+#include "../src/semantic/ranges.h"
+#include "../src/codegen/codegen.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Range analysis benchmark. The first part analyzes many small functions
+// with counted loops, indexing arithmetic (i / 8, i % 16), divisions by
+// computed values and a guarded parameter, times ranges_analyze against
+// semantic_analyze and reports which checks the facts remove. The code
+// generator lowers only top-level code, so the second part generates a
+// program of global declarations over a few unknown (uninitialized) globals
+// in checked-arithmetic mode, without and with range facts, and compares the
+// instructions, overflow and zero checks, and idiv instructions emitted.
+// Results are tracked in compiler-docs/benchmark-results.md.
+
+#define DEFAULT_FUNCTIONS 20000
+#define DEFAULT_DECLARATIONS 20000
+#define UNKNOWNS 16
+#define RUNS 5
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static char* generate_functions(int functions) {
+    StringBuffer* buffer = string_buffer_create((size_t)functions * 320);
+    char line[512];
+
+    for (int i = 0; i < functions; i++) {
+        snprintf(line, sizeof(line),
+                 "int f%d(int n) {\n"
+                 "    int i = 0;\n"
+                 "    int s = 0;\n"
+                 "    while (i < %d) {\n"
+                 "        int q = i / 8;\n"
+                 "        int r = i %% 16;\n"
+                 "        s = (q + r) * %d;\n"
+                 "        i = i + 1;\n"
+                 "    }\n"
+                 "    int d = %d / (s + 1);\n"
+                 "    if (n >= 0) { d = d + n / 2; }\n"
+                 "    return d - n * %d;\n"
+                 "}\n",
+                 i, 100 + i % 900, i % 7 + 2, 100000 + i, i % 5 + 1);
+        string_buffer_append(buffer, line);
+    }
+
+    char* source = buffer->data;
+    free(buffer);
+    return source;
+}
+
+// Each declaration mixes constants, earlier declarations and an unknown
+static char* generate_declarations(int count) {
+    StringBuffer* buffer = string_buffer_create((size_t)count * 64);
+    char line[160];
+
+    for (int i = 0; i < UNKNOWNS; i++) {
+        snprintf(line, sizeof(line), "int u%d;\n", i);
+        string_buffer_append(buffer, line);
+    }
+    for (int i = 0; i < count; i++) {
+        int previous = i > 0 ? i - 1 : 0;
+        switch (i % 4) {
+            case 0: snprintf(line, sizeof(line), "int v%d = %d * 3 + 7;\n", i, i % 1000); break;
+            case 1: snprintf(line, sizeof(line), "int v%d = v%d / 4 + v%d %% 8;\n", i, previous, previous); break;
+            case 2: snprintf(line, sizeof(line), "int v%d = %d / (v%d + 1);\n", i, 100000 + i, previous); break;
+            default: snprintf(line, sizeof(line), "int v%d = u%d / 2 + v%d;\n", i, i % UNKNOWNS, previous); break;
+        }
+        string_buffer_append(buffer, line);
+    }
+
+    char* source = buffer->data;
+    free(buffer);
+    return source;
+}
+
+static void bench_functions(int functions) {
+    char* source = generate_functions(functions);
+    Lexer* lexer = lexer_create(source);
+    Parser* parser = parser_create(lexer);
+    ASTNode* program = parser_parse_program(parser);
+    SemanticAnalyzer* analyzer = semantic_analyzer_create();
+    double start = now_seconds();
+    bool ok = semantic_analyze(program, analyzer);
+    double analysis = now_seconds() - start;
+    if (parser_had_error(parser) || !ok) {
+        fprintf(stderr, "Generated program failed to compile\n");
+        exit(EXIT_FAILURE);
+    }
+
+    RangeStats stats;
+    double best = 1e9;
+    for (int run = 0; run < RUNS; run++) {
+        start = now_seconds();
+        ranges_analyze(program, analyzer, &stats);
+        best = MIN(best, now_seconds() - start);
+    }
+
+    printf("Functions: %d, %d loop iterations\n", functions, stats.loop_iterations);
+    printf("  %-22s %8.2f ms\n", "semantic_analyze", analysis * 1000);
+    printf("  %-22s %8.2f ms  (%.2fx analysis)\n", "ranges_analyze", best * 1000, best / analysis);
+    printf("  %d arithmetic operators: %d without overflow check, %d narrowed to 32 bits\n", stats.arithmetic,
+           stats.overflow_checks_removed, stats.narrowed);
+    printf("  %d divisions: %d without zero check, %d by shift or mask\n", stats.divisions,
+           stats.zero_checks_removed, stats.shift_divisions);
+
+    semantic_analyzer_free(analyzer);
+    ast_node_free(program);
+    parser_free(parser);
+    lexer_free(lexer);
+    free(source);
+}
+
+typedef struct {
+    long instructions;
+    long overflow_checks;
+    long zero_checks;
+    long divides;
+} AssemblyCounts;
+
+// Instructions are the indented lines that are not directives or comments
+static void measure_assembly(const char* path, AssemblyCounts* counts) {
+    FILE* file = fopen(path, "r");
+    char line[256];
+    memset(counts, 0, sizeof(*counts));
+
+    while (file != NULL && fgets(line, sizeof(line), file) != NULL) {
+        if (strncmp(line, "    ", 4) != 0 || line[4] == '.' || line[4] == '#') continue;
+        counts->instructions++;
+        if (strncmp(line + 4, "jo ", 3) == 0) counts->overflow_checks++;
+        if (strncmp(line + 4, "jz ", 3) == 0) counts->zero_checks++;
+        if (strncmp(line + 4, "idiv ", 5) == 0) counts->divides++;
+    }
+    if (file != NULL) fclose(file);
+}
+
+static void bench_codegen(const char* source, bool ranges) {
+    const char* output = ranges ? "/tmp/bench_ranges_on.s" : "/tmp/bench_ranges_off.s";
+    Lexer* lexer = lexer_create(source);
+    Parser* parser = parser_create(lexer);
+    ASTNode* program = parser_parse_program(parser);
+    SemanticAnalyzer* analyzer = semantic_analyzer_create();
+    if (parser_had_error(parser) || !semantic_analyze(program, analyzer)) {
+        fprintf(stderr, "Generated program failed to compile\n");
+        exit(EXIT_FAILURE);
+    }
+
+    double elapsed = 0;
+    if (ranges) {
+        double start = now_seconds();
+        ranges_analyze(program, analyzer, NULL);
+        elapsed = now_seconds() - start;
+    }
+
+    CodeGenerator* generator = code_generator_create(analyzer->current_scope);
+    generator->checked_arithmetic = true;
+    bool generated = code_generator_generate(generator, program, output) == CODEGEN_SUCCESS;
+    code_generator_free(generator);
+
+    AssemblyCounts counts;
+    measure_assembly(output, &counts);
+    remove(output);
+
+    printf("%-7s %9ld instructions  %7ld jo  %7ld jz  %7ld idiv  ranges %6.2f ms%s\n",
+           ranges ? "ranges" : "plain", counts.instructions, counts.overflow_checks, counts.zero_checks,
+           counts.divides, elapsed * 1000, generated ? "" : "  (CODEGEN FAILED)");
+
+    semantic_analyzer_free(analyzer);
+    ast_node_free(program);
+    parser_free(parser);
+    lexer_free(lexer);
+}
+
+int main(int argc, char** argv) {
+    int functions = argc > 1 ? atoi(argv[1]) : DEFAULT_FUNCTIONS;
+    int declarations = argc > 2 ? atoi(argv[2]) : DEFAULT_DECLARATIONS;
+
+    printf("=== RANGE ANALYSIS BENCHMARK ===\n");
+    bench_functions(functions);
+
+    char* source = generate_declarations(declarations);
+    printf("Checked top-level code: %d declarations\n", declarations);
+    bench_codegen(source, false);
+    bench_codegen(source, true);
+    free(source);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,277 @@
+#include "../src/lexer/lexer.h"
+#include "../src/parser/parser.h"
+#include "../src/semantic/semantic.h"
+#include "../src/semantic/ranges.h"
+#include "../src/ir/ir.h"
+#include "../src/ir/ssa.h"
+#include "../src/ir/sccp.h"
+#include "../src/codegen/codegen.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Sparse conditional constant propagation benchmark. The inputs imitate
+// generated code specialized by a configuration: functions that start by
+// setting flags and settings to constants and then test them throughout,
+// in many small functions and in one large one, plus the small functions
+// of bench_ir.c, which have nothing to fold, as a control. Each program is
+// put in SSA form and taken out again with and without SCCP in between; the
+// benchmark reports the instructions and branches of the IR at each step,
+// the time of the pass, and the size of the assembly the IR backend
+// generates from either result. Results are tracked in
+// compiler-docs/benchmark-results.md.
+
+#define DEFAULT_FUNCTIONS 20000
+#define DEFAULT_STATEMENTS 20000
+#define RUNS 5
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// The configuration of function i; a few flags are on in some functions
+static void configuration(int i, int* debug, int* trace, int* mode, int* limit) {
+    *debug = i % 50 == 0;
+    *trace = i % 7 == 3;
+    *mode = i % 3 + 1;
+    *limit = 64 << (i % 4);
+}
+
+static char* generate_configured_functions(int functions) {
+    StringBuffer* buffer = string_buffer_create((size_t)functions * 640);
+    char line[1024];
+    char call[32];
+
+    for (int i = 0; i < functions; i++) {
+        int debug, trace, mode, limit;
+        configuration(i, &debug, &trace, &mode, &limit);
+        if (i > 0) {
+            snprintf(call, sizeof(call), "h%d(x - 1)", i - 1);
+        } else {
+            snprintf(call, sizeof(call), "x");
+        }
+        snprintf(line, sizeof(line),
+                 "int h%d(int x) {\n"
+                 "    int debug = %d;\n"
+                 "    int trace = %d;\n"
+                 "    int mode = %d;\n"
+                 "    int limit = %d;\n"
+                 "    int scale = mode * 4 + 1;\n"
+                 "    int r = x;\n"
+                 "    if (debug) { r = r + %s; }\n"
+                 "    if (trace && r > limit) { r = r - limit; }\n"
+                 "    if (mode == 1) { r = r * scale; } else {\n"
+                 "        if (mode == 2) { r = r + scale; } else { r = r - scale; }\n"
+                 "    }\n"
+                 "    int checks = 0;\n"
+                 "    while (debug && checks < limit) {\n"
+                 "        if (r %% 2 == 0) { r = r / 2; } else { r = r * 3 + 1; }\n"
+                 "        checks = checks + 1;\n"
+                 "    }\n"
+                 "    if (limit > 256 || trace) { r = r %% limit; }\n"
+                 "    return r;\n"
+                 "}\n",
+                 i, debug, trace, mode, limit, call);
+        string_buffer_append(buffer, line);
+    }
+
+    char* source = buffer->data;
+    free(buffer);
+    return source;
+}
+
+// One function testing its settings over and over
+static char* generate_configured_function(int statements) {
+    StringBuffer* buffer = string_buffer_create((size_t)statements * 96 + 256);
+    char line[256];
+
+    string_buffer_append(buffer,
+                         "int big(int x) {\n"
+                         "    int fast = 1;\n"
+                         "    int verbose = 0;\n"
+                         "    int width = 8;\n"
+                         "    int r = x;\n");
+    for (int i = 0; i < statements; i++) {
+        switch (i % 4) {
+            case 0: snprintf(line, sizeof(line), "    if (fast) { r = r + %d; } else { r = r * %d; }\n", i % 100, i % 7 + 2); break;
+            case 1: snprintf(line, sizeof(line), "    if (verbose && r > %d) { r = r - %d; }\n", i, i % 13); break;
+            case 2: snprintf(line, sizeof(line), "    if (width > %d) { r = r ^ %d; }\n", i % 16, i % 256); break;
+            default: snprintf(line, sizeof(line), "    if (r > %d) { r = r - width; }\n", i); break;
+        }
+        string_buffer_append(buffer, line);
+    }
+    string_buffer_append(buffer, "    return r;\n}\n");
+
+    char* source = buffer->data;
+    free(buffer);
+    return source;
+}
+
+static char* generate_functions(int functions) {
+    StringBuffer* buffer = string_buffer_create((size_t)functions * 320);
+    char line[512];
+    char call[32];
+
+    for (int i = 0; i < functions; i++) {
+        if (i > 0) {
+            snprintf(call, sizeof(call), "f%d(n - 1)", i - 1);
+        } else {
+            snprintf(call, sizeof(call), "n");
+        }
+        snprintf(line, sizeof(line),
+                 "int f%d(int n) {\n"
+                 "    int i = 0;\n"
+                 "    int s = 0;\n"
+                 "    while (i < n && s < %d) {\n"
+                 "        if (i %% 2 == 0) { s = s + i / 4; } else { s = s - 1; }\n"
+                 "        i = i + 1;\n"
+                 "    }\n"
+                 "    if (s > 0 || n < 0) { s = s * %d; }\n"
+                 "    return s + %s;\n"
+                 "}\n",
+                 i, 1000 + i % 900, i % 7 + 2, call);
+        string_buffer_append(buffer, line);
+    }
+
+    char* source = buffer->data;
+    free(buffer);
+    return source;
+}
+
+typedef struct {
+    long instructions;
+    long branches;
+    long blocks;
+} IrCounts;
+
+static void count_ir(const IrModule* module, IrCounts* counts) {
+    memset(counts, 0, sizeof(*counts));
+    for (int f = 0; f < module->function_count; f++) {
+        const IrFunction* function = &module->functions[f];
+        counts->instructions += function->instr_count;
+        counts->blocks += function->block_count;
+        for (int i = 0; i < function->instr_count; i++) counts->branches += function->instrs[i].op == IR_BRANCH;
+    }
+}
+
+static void print_ir(const char* label, const IrCounts* counts) {
+    printf("  %-22s %9ld instructions  %7ld branches  %7ld blocks\n", label, counts->instructions, counts->branches,
+           counts->blocks);
+}
+
+// Assembly instructions are the indented lines that are not directives or
+// comments; conditional jumps are counted apart
+static void report_assembly(const char* label, const char* path, bool generated) {
+    FILE* file = fopen(path, "r");
+    char line[256];
+    long instructions = 0;
+    long conditional = 0;
+    while (file != NULL && fgets(line, sizeof(line), file) != NULL) {
+        if (strncmp(line, "    ", 4) != 0 || line[4] == '.' || line[4] == '#') continue;
+        instructions++;
+        if (line[4] == 'j' && strncmp(line + 4, "jmp", 3) != 0) conditional++;
+    }
+    if (file != NULL) fclose(file);
+    remove(path);
+    printf("  %-22s %9ld instructions  %7ld conditional jumps%s\n", label, instructions, conditional,
+           generated ? "" : "  (CODEGEN FAILED)");
+}
+
+static void bench_sccp(const char* label, const char* source) {
+    const char* output = "/tmp/bench_sccp.s";
+    Lexer* lexer = lexer_create(source);
+    Parser* parser = parser_create(lexer);
+    ASTNode* program = parser_parse_program(parser);
+    SemanticAnalyzer* analyzer = semantic_analyzer_create();
+    if (parser_had_error(parser) || !semantic_analyze(program, analyzer)) {
+        fprintf(stderr, "Generated program failed to compile\n");
+        exit(EXIT_FAILURE);
+    }
+    ranges_analyze(program, analyzer, NULL);
+
+    double best = 1e9;
+    IrCounts lowered, in_ssa, after, out_without, out_with;
+    IrSccpStats stats;
+    bool valid = true;
+    for (int run = 0; run < RUNS; run++) {
+        IrModule* module = ir_lower_program(program, analyzer);
+        if (module->had_error) {
+            fprintf(stderr, "Lowering failed: %s\n", module->error);
+            exit(EXIT_FAILURE);
+        }
+        count_ir(module, &lowered);
+        ir_module_to_ssa(module, NULL);
+        count_ir(module, &in_ssa);
+
+        memset(&stats, 0, sizeof(stats));
+        double start = now_seconds();
+        ir_module_sccp(module, &stats);
+        best = MIN(best, now_seconds() - start);
+        count_ir(module, &after);
+        if (run == 0) {
+            for (int i = 0; i < module->function_count; i++) valid &= ir_function_verify_ssa(&module->functions[i]);
+        }
+        ir_module_from_ssa(module, NULL);
+        count_ir(module, &out_with);
+        ir_module_free(module);
+    }
+
+    printf("%s: %d functions\n", label, stats.functions);
+    print_ir("lowered", &lowered);
+    print_ir("SSA", &in_ssa);
+    print_ir("SSA + SCCP", &after);
+    printf("  %-22s %8.2f ms  %6.0f ns/instruction  %d visits, %d constants, %d phis simplified, %d branches "
+           "folded, %d blocks removed, %d dead%s\n",
+           "sccp", best * 1000, best * 1e9 / in_ssa.instructions, stats.visits, stats.constants,
+           stats.phis_simplified, stats.branches_folded, stats.blocks_removed, stats.dead_removed,
+           valid ? "" : "  (NOT VALID SSA)");
+
+    // Out of SSA form and to assembly, without and with the pass
+    for (int with = 0; with < 2; with++) {
+        IrModule* module = ir_lower_program(program, analyzer);
+        ir_module_to_ssa(module, NULL);
+        if (with) ir_module_sccp(module, NULL);
+        ir_module_from_ssa(module, NULL);
+        count_ir(module, with ? &out_with : &out_without);
+        print_ir(with ? "out of SSA, SCCP" : "out of SSA", with ? &out_with : &out_without);
+
+        CodeGenerator* generator = code_generator_create(analyzer->current_scope);
+        generator->checked_arithmetic = true;
+        bool generated = code_generator_generate_ir(generator, module, output) == CODEGEN_SUCCESS;
+        code_generator_free(generator);
+        report_assembly(with ? "assembly, SCCP" : "assembly", output, generated);
+        ir_module_free(module);
+    }
+
+    semantic_analyzer_free(analyzer);
+    ast_node_free(program);
+    parser_free(parser);
+    lexer_free(lexer);
+}
+
+int main(int argc, char** argv) {
+    int functions = argc > 1 ? atoi(argv[1]) : DEFAULT_FUNCTIONS;
+    int statements = argc > 2 ? atoi(argv[2]) : DEFAULT_STATEMENTS;
+
+    printf("=== SCCP BENCHMARK ===\n");
+    char* source = generate_configured_functions(functions);
+    bench_sccp("Configured functions", source);
+    free(source);
+
+    // Twice as many statements too, to see that the cost per instruction holds
+    for (int scale = 1; scale <= 2; scale++) {
+        char label[64];
+        source = generate_configured_function(statements * scale);
+        snprintf(label, sizeof(label), "Configured function (%d statements)", statements * scale);
+        bench_sccp(label, source);
+        free(source);
+    }
+
+    source = generate_functions(functions);
+    bench_sccp("Small functions (control)", source);
+    free(source);
+    return EXIT_SUCCESS;
+}
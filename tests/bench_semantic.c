@@ -0,0 +1,462 @@
+#include "../src/lexer/lexer.h"
+#include "../src/parser/parser.h"
+#include "../src/semantic/semantic.h"
+#include "../src/semantic/incremental.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Semantic analysis benchmark: types identifier-heavy expression statements
+// against a global scope of int, float and bool variables and reports the
+// cost per identifier. The program is small enough to stay in cache and is
+// typed PASSES times, so the cost of typing dominates memory traffic. A
+// second part checks every operator of long left-leaning chains the way a
+// checker visits them, which re-types the left operand at every level
+// unless types are remembered. A third part types statements that mix
+// arithmetic, comparison, logical and bitwise operators over int, float and
+// bool literals, so nothing but operators needs looking up. A fourth part analyzes a program of many
+// functions in order and with semantic_analyze_parallel at several thread
+// counts. A fifth part edits that program through parser_reparse and
+// incremental_analysis_update, first inside function bodies, then the types
+// of globals. Finally the analyzer's counters for an in-order analysis of
+// that program are written as JSON. Results are tracked in
+// compiler-docs/benchmark-results.md.
+
+#define DEFAULT_STATEMENTS 2000
+#define VARIABLES_PER_TYPE 1024
+#define PASSES 100
+#define RUNS 5
+#define FUNCTIONS 4000
+#define BODY_EDITS 200
+#define GLOBAL_EDITS 20
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Eight identifiers per statement, cycling through int arithmetic, float
+// arithmetic and bool logic so every type name is resolved
+static char* generate_expressions(int statements) {
+    StringBuffer* buffer = string_buffer_create((size_t)statements * 64);
+    char line[256];
+
+    for (int i = 0; i < statements; i++) {
+        int a = (i * 7) % VARIABLES_PER_TYPE;
+        int b = (i * 13 + 1) % VARIABLES_PER_TYPE;
+        int c = (i * 31 + 2) % VARIABLES_PER_TYPE;
+        int d = (i * 61 + 3) % VARIABLES_PER_TYPE;
+        const char* prefix = i % 3 == 0 ? "i" : i % 3 == 1 ? "f" : "b";
+        const char* op1 = i % 3 == 2 ? "&&" : "+";
+        const char* op2 = i % 3 == 2 ? "||" : "*";
+        snprintf(line, sizeof(line), "%s%d %s %s%d %s %s%d %s %s%d %s %s%d %s %s%d %s %s%d %s %s%d;\n",
+                 prefix, a, op1, prefix, b, op2, prefix, c, op1, prefix, d, op2,
+                 prefix, b, op1, prefix, c, op2, prefix, d, op1, prefix, a);
+        string_buffer_append(buffer, line);
+    }
+
+    char* source = buffer->data;
+    free(buffer);
+    return source;
+}
+
+static void declare_globals(SemanticAnalyzer* analyzer) {
+    static const char* const types[] = { "int", "float", "bool" };
+    static const char* const prefixes[] = { "i", "f", "b" };
+    char name[32];
+    char type_name[16];
+
+    for (int t = 0; t < 3; t++) {
+        for (int i = 0; i < VARIABLES_PER_TYPE; i++) {
+            // Type names arrive as fresh strings, as they do from the parser
+            snprintf(name, sizeof(name), "%s%d", prefixes[t], i);
+            snprintf(type_name, sizeof(type_name), "%s", types[t]);
+            symbol_table_add(analyzer->current_scope, symbol_create_variable(name, type_name, true, 0, 0));
+        }
+    }
+}
+
+static void bench_identifier_typing(int statements) {
+    char* source = generate_expressions(statements);
+    Lexer* lexer = lexer_create(source);
+    Parser* parser = parser_create(lexer);
+    ASTNode* program = parser_parse_program(parser);
+    if (parser_had_error(parser)) {
+        fprintf(stderr, "Generated program failed to parse\n");
+        exit(EXIT_FAILURE);
+    }
+
+    SemanticAnalyzer* analyzer = semantic_analyzer_create();
+    declare_globals(analyzer);
+
+    double best = 1e9;
+    int typed[3] = { 0, 0, 0 };
+    for (int run = 0; run < RUNS; run++) {
+        memset(typed, 0, sizeof(typed));
+        double elapsed = 0;
+        for (int pass = 0; pass < PASSES; pass++) {
+            // Every pass types from scratch rather than reading the last one's annotations
+            ast_node_clear_types(program);
+            double start = now_seconds();
+            for (int i = 0; i < program->data.block.statement_count; i++) {
+                ASTNode* expression = program->data.block.statements[i]->data.statement.expression;
+                DataType type = ast_node_get_type(expression, analyzer);
+                typed[0] += type == TYPE_INT;
+                typed[1] += type == TYPE_FLOAT;
+                typed[2] += type == TYPE_BOOL;
+            }
+            elapsed += now_seconds() - start;
+        }
+        best = MIN(best, elapsed);
+    }
+
+    if (typed[0] + typed[1] + typed[2] != statements * PASSES) {
+        fprintf(stderr, "Some expressions were not typed\n");
+        exit(EXIT_FAILURE);
+    }
+
+    long identifiers = (long)statements * 8 * PASSES;
+    printf("Identifier typing: %d statements x %d passes  %8.2f ms  %6.1f ns/identifier\n",
+           statements, PASSES, best * 1000, best * 1e9 / identifiers);
+
+    semantic_analyzer_free(analyzer);
+    ast_node_free(program);
+    parser_free(parser);
+    lexer_free(lexer);
+    free(source);
+}
+
+// Five operators per statement, in four shapes that between them reach
+// every operator class and int to float promotion
+static char* generate_operators(int statements) {
+    StringBuffer* buffer = string_buffer_create((size_t)statements * 64);
+    char line[256];
+
+    for (int i = 0; i < statements; i++) {
+        int a = i % 97 + 1;
+        int b = i % 89 + 1;
+        int c = i % 83 + 1;
+        switch (i % 4) {
+            case 0:
+                snprintf(line, sizeof(line), "%d * %d + %d %% %d - %d / %d;\n", a, b, c, a, b, c);
+                break;
+            case 1:
+                snprintf(line, sizeof(line), "%d.5 * %d.5 + %d < %d.5 - %d * %d;\n", a, b, c, a, b, c);
+                break;
+            case 2:
+                snprintf(line, sizeof(line), "true && %d <= %d || false != true && false;\n", a, b);
+                break;
+            default:
+                snprintf(line, sizeof(line), "%d << %d & %d | %d ^ %d == %d;\n", a, b, c, a, b, c);
+                break;
+        }
+        string_buffer_append(buffer, line);
+    }
+
+    char* source = buffer->data;
+    free(buffer);
+    return source;
+}
+
+static void bench_operator_typing(int statements) {
+    char* source = generate_operators(statements);
+    Lexer* lexer = lexer_create(source);
+    Parser* parser = parser_create(lexer);
+    ASTNode* program = parser_parse_program(parser);
+    if (parser_had_error(parser)) {
+        fprintf(stderr, "Generated operators failed to parse\n");
+        exit(EXIT_FAILURE);
+    }
+
+    SemanticAnalyzer* analyzer = semantic_analyzer_create();
+
+    double best = 1e9;
+    int rejected = 0;
+    for (int run = 0; run < RUNS; run++) {
+        rejected = 0;
+        double elapsed = 0;
+        for (int pass = 0; pass < PASSES; pass++) {
+            ast_node_clear_types(program);
+            double start = now_seconds();
+            for (int i = 0; i < program->data.block.statement_count; i++) {
+                ASTNode* expression = program->data.block.statements[i]->data.statement.expression;
+                rejected += ast_node_get_type(expression, analyzer) == TYPE_ERROR;
+            }
+            elapsed += now_seconds() - start;
+        }
+        best = MIN(best, elapsed);
+    }
+
+    long operators = (long)statements * 5 * PASSES;
+    printf("Operator typing: %d statements x %d passes  %8.2f ms  %6.1f ns/operator  (%d rejected)\n",
+           statements, PASSES, best * 1000, best * 1e9 / operators, rejected / PASSES);
+
+    semantic_analyzer_free(analyzer);
+    ast_node_free(program);
+    parser_free(parser);
+    lexer_free(lexer);
+    free(source);
+}
+
+// x + x + ... + x with length operands, checked operator by operator from
+// the root down the left spine
+static void bench_operator_chain(int length) {
+    StringBuffer* buffer = string_buffer_create((size_t)length * 8);
+    char operand[32];
+    for (int i = 0; i < length; i++) {
+        snprintf(operand, sizeof(operand), i == 0 ? "i%d" : " + i%d", i % VARIABLES_PER_TYPE);
+        string_buffer_append(buffer, operand);
+    }
+    string_buffer_append(buffer, ";\n");
+
+    SemanticAnalyzer* analyzer = semantic_analyzer_create();
+    declare_globals(analyzer);
+
+    double best = 1e9;
+    for (int run = 0; run < RUNS; run++) {
+        // A fresh tree each run, so no run sees another's work
+        Lexer* lexer = lexer_create(buffer->data);
+        Parser* parser = parser_create(lexer);
+        ASTNode* program = parser_parse_program(parser);
+
+        int accepted = 0;
+        double start = now_seconds();
+        ASTNode* node = program->data.block.statements[0]->data.statement.expression;
+        while (node->type == NODE_BINARY_EXPRESSION) {
+            accepted += semantic_check_binary_operation(node->data.binary.left, node->data.binary.right,
+                                                        node->data.binary.operator, analyzer);
+            node = node->data.binary.left;
+        }
+        best = MIN(best, now_seconds() - start);
+
+        if (accepted != length - 1) {
+            fprintf(stderr, "Chain operators were rejected\n");
+            exit(EXIT_FAILURE);
+        }
+
+        ast_node_free(program);
+        parser_free(parser);
+        lexer_free(lexer);
+    }
+
+    printf("Operator chain: %5d operands  %9.3f ms  %8.1f ns/operator\n",
+           length, best * 1000, best * 1e9 / (length - 1));
+
+    semantic_analyzer_free(analyzer);
+    string_buffer_free(buffer);
+}
+
+// Globals up front, then functions whose bodies only read parameters,
+// locals and those globals
+static char* generate_functions(int functions) {
+    StringBuffer* buffer = string_buffer_create((size_t)functions * 200);
+    char line[512];
+
+    for (int i = 0; i < 64; i++) {
+        snprintf(line, sizeof(line), "int g%d = %d;\n", i, i);
+        string_buffer_append(buffer, line);
+    }
+    for (int i = 0; i < functions; i++) {
+        snprintf(line, sizeof(line),
+                 "int f%d(int a, int b) {\n"
+                 "    int x = a + b * g%d;\n"
+                 "    if (x > g%d) { int y = x - b; x = y * 2; } else { x = x + a; }\n"
+                 "    while (x < %d) { x = x * 2 + g%d; }\n"
+                 "    return x + a;\n"
+                 "}\n",
+                 i, i % 64, (i * 7) % 64, i % 100 + 10, (i * 13) % 64);
+        string_buffer_append(buffer, line);
+    }
+
+    char* source = buffer->data;
+    free(buffer);
+    return source;
+}
+
+// threads == 0 analyzes in order with semantic_analyze. Only analysis is
+// timed; bodies are parsed beforehand, as parser_parse_program_parallel
+// would leave them.
+static double analyze_functions(const char* source, int threads, long* checksum) {
+    Lexer* lexer = lexer_create(source);
+    Parser* parser = parser_create(lexer);
+    ASTNode* program = parser_parse_program(parser);
+    SemanticAnalyzer* analyzer = semantic_analyzer_create();
+
+    double start = now_seconds();
+    bool ok = threads == 0 ? semantic_analyze(program, analyzer)
+                           : semantic_analyze_parallel(program, analyzer, threads);
+    double elapsed = now_seconds() - start;
+
+    // Frame sizes and the slot of every function's first local
+    *checksum = ok ? analyzer->global_count : -1;
+    for (int i = 0; i < program->data.block.statement_count; i++) {
+        ASTNode* function = program->data.block.statements[i];
+        if (function->type != NODE_FUNCTION_DECLARATION) continue;
+        ASTNode* local = function->data.function.body->data.block.statements[0];
+        *checksum = *checksum * 31 + function->resolved_slot * 7 + local->resolved_slot;
+    }
+
+    semantic_analyzer_free(analyzer);
+    ast_node_free(program);
+    parser_free(parser);
+    lexer_free(lexer);
+    return elapsed;
+}
+
+static void bench_parallel_functions(int functions) {
+    char* source = generate_functions(functions);
+    long expected = 0;
+
+    double best = 1e9;
+    for (int run = 0; run < RUNS; run++) {
+        best = MIN(best, analyze_functions(source, 0, &expected));
+    }
+    if (expected < 0) {
+        fprintf(stderr, "Generated functions failed analysis\n");
+        exit(EXIT_FAILURE);
+    }
+    double sequential = best;
+    printf("Functions in order: %d functions  %8.2f ms\n", functions, sequential * 1000);
+
+    for (int threads = 1; threads <= 8; threads *= 2) {
+        long checksum = 0;
+        best = 1e9;
+        for (int run = 0; run < RUNS; run++) {
+            best = MIN(best, analyze_functions(source, threads, &checksum));
+            if (checksum != expected) {
+                fprintf(stderr, "Parallel analysis disagrees with analysis in order\n");
+                exit(EXIT_FAILURE);
+            }
+        }
+        printf("Functions parallel: %d threads     %8.2f ms  (%.2fx)\n",
+               threads, best * 1000, sequential / best);
+    }
+
+    free(source);
+}
+
+// Replaces line (1-based) of text, which has room to grow, by replacement
+static void replace_line(char* text, int line, const char* replacement) {
+    char* start = text;
+    for (int current = 1; current < line; current++) {
+        start = strchr(start, '\n') + 1;
+    }
+    char* end = strchr(start, '\n') + 1;
+    size_t length = strlen(replacement);
+    memmove(start + length, end, strlen(end) + 1);
+    memcpy(start, replacement, length);
+}
+
+// Body edits change which global a function's first local reads; global
+// edits switch a global between int and float, so every function reading
+// it is checked again. Globals take lines 1..64 and function i starts on
+// line 65 + 6 * i (see generate_functions).
+static void bench_incremental_functions(int functions) {
+    char* source = generate_functions(functions);
+    size_t length = strlen(source);
+    char* text = malloc(length + 4096);
+    memcpy(text, source, length + 1);
+
+    Lexer* lexer = lexer_create(text);
+    Parser* parser = parser_create(lexer);
+    ASTNode* program = parser_parse_program(parser);
+
+    double start = now_seconds();
+    IncrementalAnalysis* analysis = incremental_analysis_create(parser, program);
+    double full = now_seconds() - start;
+
+    double reparse_total = 0;
+    double body_total = 0;
+    double body_worst = 0;
+    double global_total = 0;
+    long global_checked = 0;
+    bool ok = incremental_analysis_ok(analysis);
+    char line[128];
+    for (int k = 0; k < BODY_EDITS + GLOBAL_EDITS; k++) {
+        bool body = k < BODY_EDITS;
+        TextEdit edit;
+        if (body) {
+            int function = (int)((k * 7919L) % functions);
+            edit = (TextEdit){ 66 + 6 * function, 66 + 6 * function, 66 + 6 * function };
+            snprintf(line, sizeof(line), "    int x = a + b * g%d;\n", (function + k) % 64);
+        } else {
+            // To float, then back to int
+            int global = (k - BODY_EDITS) / 2 * 17 % 64;
+            edit = (TextEdit){ global + 1, global + 1, global + 1 };
+            snprintf(line, sizeof(line), "%s g%d = %d;\n", (k - BODY_EDITS) % 2 ? "int" : "float", global, global);
+        }
+        replace_line(text, edit.start_line, line);
+
+        Lexer* edited = lexer_create(text);
+        start = now_seconds();
+        program = parser_reparse(parser, program, edited, &edit);
+        reparse_total += now_seconds() - start;
+        lexer_free(lexer);
+        lexer = edited;
+
+        start = now_seconds();
+        ok = incremental_analysis_update(analysis, parser, program, &edit) && ok;
+        double elapsed = now_seconds() - start;
+        if (body) {
+            body_total += elapsed;
+            body_worst = MAX(body_worst, elapsed);
+            ok = ok && analysis->checked_count == 1;
+        } else {
+            global_total += elapsed;
+            global_checked += analysis->checked_count;
+        }
+    }
+    if (!ok) {
+        fprintf(stderr, "Incremental analysis failed\n");
+        exit(EXIT_FAILURE);
+    }
+
+    printf("Incremental: %d functions, full analysis %8.2f ms, reparse %6.1f us avg\n",
+           functions, full * 1000, reparse_total / (BODY_EDITS + GLOBAL_EDITS) * 1e6);
+    printf("  body edits     %4d  %8.1f us avg  %8.1f us worst  1 declaration checked\n",
+           BODY_EDITS, body_total / BODY_EDITS * 1e6, body_worst * 1e6);
+    printf("  global edits   %4d  %8.1f us avg  %6.1f declarations checked\n",
+           GLOBAL_EDITS, global_total / GLOBAL_EDITS * 1e6, (double)global_checked / GLOBAL_EDITS);
+
+    incremental_analysis_free(analysis);
+    ast_node_free(program);
+    parser_free(parser);
+    lexer_free(lexer);
+    free(text);
+    free(source);
+}
+
+static void dump_function_counters(int functions) {
+    char* source = generate_functions(functions);
+    Lexer* lexer = lexer_create(source);
+    Parser* parser = parser_create(lexer);
+    ASTNode* program = parser_parse_program(parser);
+    SemanticAnalyzer* analyzer = semantic_analyzer_create();
+
+    semantic_analyze(program, analyzer);
+    printf("Counters, %d functions:\n", functions);
+    semantic_counters_write_json(semantic_analyzer_counters(analyzer), stdout);
+
+    semantic_analyzer_free(analyzer);
+    ast_node_free(program);
+    parser_free(parser);
+    lexer_free(lexer);
+    free(source);
+}
+
+int main(int argc, char** argv) {
+    int statements = argc > 1 ? atoi(argv[1]) : DEFAULT_STATEMENTS;
+
+    printf("=== SEMANTIC ANALYSIS BENCHMARK ===\n");
+    bench_identifier_typing(statements);
+    bench_operator_typing(statements);
+    for (int length = 1000; length <= 8000; length *= 2) {
+        bench_operator_chain(length);
+    }
+    bench_parallel_functions(FUNCTIONS);
+    bench_incremental_functions(FUNCTIONS);
+    dump_function_counters(FUNCTIONS);
+    return EXIT_SUCCESS;
+}
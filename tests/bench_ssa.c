@@ -0,0 +1,206 @@
+#include "../src/lexer/lexer.h"
+#include "../src/parser/parser.h"
+#include "../src/semantic/semantic.h"
+#include "../src/ir/ir.h"
+#include "../src/ir/ssa.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// SSA construction benchmark. Programs are lowered to IR once per run and
+// then put into SSA form and taken out again; the dominator computation is
+// timed on its own as well. The inputs are the small functions of
+// bench_ir.c, one large function of straight-line code with an if every few
+// statements, and one large function of loops nested a few deep that update
+// a handful of variables, which gives every loop head and join phis. Reports
+// the time per IR instruction, which should stay flat as functions grow.
+// Results are tracked in compiler-docs/benchmark-results.md.
+
+#define DEFAULT_FUNCTIONS 20000
+#define DEFAULT_STATEMENTS 20000
+#define RUNS 5
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static char* generate_functions(int functions) {
+    StringBuffer* buffer = string_buffer_create((size_t)functions * 320);
+    char line[512];
+    char call[32];
+
+    for (int i = 0; i < functions; i++) {
+        if (i > 0) {
+            snprintf(call, sizeof(call), "f%d(n - 1)", i - 1);
+        } else {
+            snprintf(call, sizeof(call), "n");
+        }
+        snprintf(line, sizeof(line),
+                 "int f%d(int n) {\n"
+                 "    int i = 0;\n"
+                 "    int s = 0;\n"
+                 "    while (i < n && s < %d) {\n"
+                 "        if (i %% 2 == 0) { s = s + i / 4; } else { s = s - 1; }\n"
+                 "        i = i + 1;\n"
+                 "    }\n"
+                 "    if (s > 0 || n < 0) { s = s * %d; }\n"
+                 "    return s + %s;\n"
+                 "}\n",
+                 i, 1000 + i % 900, i % 7 + 2, call);
+        string_buffer_append(buffer, line);
+    }
+
+    char* source = buffer->data;
+    free(buffer);
+    return source;
+}
+
+static char* generate_straight_function(int statements) {
+    StringBuffer* buffer = string_buffer_create((size_t)statements * 48 + 64);
+    char line[160];
+
+    string_buffer_append(buffer, "int big(int n) {\n    int x0 = n;\n");
+    for (int i = 1; i < statements; i++) {
+        if (i % 4 == 0) {
+            snprintf(line, sizeof(line), "    if (x%d > %d) { x%d = x%d - 1; }\n", i - 1, i, i - 1, i - 1);
+            string_buffer_append(buffer, line);
+        }
+        snprintf(line, sizeof(line), "    int x%d = x%d * 3 + %d;\n", i, i - 1, i % 100);
+        string_buffer_append(buffer, line);
+    }
+    snprintf(line, sizeof(line), "    return x%d;\n}\n", statements - 1);
+    string_buffer_append(buffer, line);
+
+    char* source = buffer->data;
+    free(buffer);
+    return source;
+}
+
+// Groups of three nested loops over four variables, one after another
+static char* generate_loop_function(int statements) {
+    StringBuffer* buffer = string_buffer_create((size_t)statements * 64 + 128);
+    char line[512];
+
+    string_buffer_append(buffer, "int loops(int n) {\n    int a = n;\n    int b = 1;\n    int c = 2;\n    int d = 3;\n");
+    for (int i = 0; i < statements / 10; i++) {
+        snprintf(line, sizeof(line),
+                 "    int i%d = 0;\n"
+                 "    while (i%d < n) {\n"
+                 "        int j = 0;\n"
+                 "        while (j < %d) {\n"
+                 "            if (a > b) { a = a - b; } else { b = b - a; }\n"
+                 "            int k = 0;\n"
+                 "            while (k < j) { c = c + k; k = k + 1; }\n"
+                 "            j = j + 1;\n"
+                 "        }\n"
+                 "        d = d + c %% 7;\n"
+                 "        i%d = i%d + 1;\n"
+                 "    }\n",
+                 i, i, i % 5 + 2, i, i);
+        string_buffer_append(buffer, line);
+    }
+    string_buffer_append(buffer, "    return a + b + c + d;\n}\n");
+
+    char* source = buffer->data;
+    free(buffer);
+    return source;
+}
+
+static void bench_ssa(const char* label, const char* source) {
+    Lexer* lexer = lexer_create(source);
+    Parser* parser = parser_create(lexer);
+    ASTNode* program = parser_parse_program(parser);
+    SemanticAnalyzer* analyzer = semantic_analyzer_create();
+    if (parser_had_error(parser) || !semantic_analyze(program, analyzer)) {
+        fprintf(stderr, "Generated program failed to compile\n");
+        exit(EXIT_FAILURE);
+    }
+
+    double best_dominators = 1e9;
+    double best_into = 1e9;
+    double best_out = 1e9;
+    long lowered = 0;
+    long in_ssa = 0;
+    long after = 0;
+    int blocks = 0;
+    IrSsaStats stats;
+    IrOutOfSsaStats out_stats;
+    bool valid = true;
+    for (int run = 0; run < RUNS; run++) {
+        IrModule* module = ir_lower_program(program, analyzer);
+        if (module->had_error) {
+            fprintf(stderr, "Lowering failed: %s\n", module->error);
+            exit(EXIT_FAILURE);
+        }
+        lowered = ir_module_instr_count(module);
+
+        double start = now_seconds();
+        blocks = 0;
+        for (int i = 0; i < module->function_count; i++) {
+            IrDominators dominators;
+            ir_dominators_compute(&module->functions[i], &dominators);
+            blocks += dominators.block_count;
+            ir_dominators_free(&dominators);
+        }
+        best_dominators = MIN(best_dominators, now_seconds() - start);
+
+        memset(&stats, 0, sizeof(stats));
+        start = now_seconds();
+        ir_module_to_ssa(module, &stats);
+        best_into = MIN(best_into, now_seconds() - start);
+        in_ssa = ir_module_instr_count(module);
+        if (run == 0) {
+            for (int i = 0; i < module->function_count; i++) valid &= ir_function_verify_ssa(&module->functions[i]);
+        }
+
+        memset(&out_stats, 0, sizeof(out_stats));
+        start = now_seconds();
+        ir_module_from_ssa(module, &out_stats);
+        best_out = MIN(best_out, now_seconds() - start);
+        after = ir_module_instr_count(module);
+        ir_module_free(module);
+    }
+
+    printf("%s: %d functions, %d blocks, %ld instructions%s\n", label, stats.functions, blocks, lowered,
+           valid ? "" : "  (NOT VALID SSA)");
+    printf("  %-16s %8.2f ms  %6.0f ns/instruction  (%.1f passes per function)\n", "dominators",
+           best_dominators * 1000, best_dominators * 1e9 / lowered, (double)stats.dominator_iterations / stats.functions);
+    printf("  %-16s %8.2f ms  %6.0f ns/instruction  %d phis, %d copies folded, %ld instructions\n", "into SSA",
+           best_into * 1000, best_into * 1e9 / lowered, stats.phis, stats.copies_folded, in_ssa);
+    printf("  %-16s %8.2f ms  %6.0f ns/instruction  %d copies, %d cycles, %d edges split, %ld instructions\n",
+           "out of SSA", best_out * 1000, best_out * 1e9 / lowered, out_stats.copies, out_stats.cycles,
+           out_stats.edges_split, after);
+
+    semantic_analyzer_free(analyzer);
+    ast_node_free(program);
+    parser_free(parser);
+    lexer_free(lexer);
+}
+
+int main(int argc, char** argv) {
+    int functions = argc > 1 ? atoi(argv[1]) : DEFAULT_FUNCTIONS;
+    int statements = argc > 2 ? atoi(argv[2]) : DEFAULT_STATEMENTS;
+
+    printf("=== SSA CONSTRUCTION BENCHMARK ===\n");
+    char* source = generate_functions(functions);
+    bench_ssa("Small functions", source);
+    free(source);
+
+    // Twice as many statements too, to see that the cost per instruction holds
+    for (int scale = 1; scale <= 2; scale++) {
+        char label[64];
+        source = generate_straight_function(statements * scale);
+        snprintf(label, sizeof(label), "Straight-line function (%d statements)", statements * scale);
+        bench_ssa(label, source);
+        free(source);
+
+        source = generate_loop_function(statements * scale);
+        snprintf(label, sizeof(label), "Nested loops (%d groups)", statements * scale / 10);
+        bench_ssa(label, source);
+        free(source);
+    }
+    return EXIT_SUCCESS;
+}
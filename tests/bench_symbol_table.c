@@ -0,0 +1,191 @@
+#include "../src/semantic/semantic.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Symbol table benchmark: fills one scope with 10k, 100k and 1M symbols and
+// reports the cost per insertion, per successful lookup and per failed
+// lookup, plus lookups that walk up from a nested scope to the globals. A
+// second part drives the analyzer's scopes at increasing nesting depths and
+// reports the cost of entering and leaving a scope and of resolving names
+// from the innermost one. Results are tracked in
+// compiler-docs/benchmark-results.md.
+
+#define LOOKUP_SAMPLES 1000000
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void bench_scope(int count) {
+    char** names = malloc(sizeof(char*) * count);
+    char** missing = malloc(sizeof(char*) * count);
+    char name[32];
+    for (int i = 0; i < count; i++) {
+        snprintf(name, sizeof(name), "global_%d", i);
+        names[i] = strdup(name);
+        snprintf(name, sizeof(name), "absent_%d", i);
+        missing[i] = strdup(name);
+    }
+
+    // Symbols are created up front so only insertion is timed
+    Symbol** symbols = malloc(sizeof(Symbol*) * count);
+    for (int i = 0; i < count; i++) {
+        symbols[i] = symbol_create_variable(names[i], "int", true, i + 1, 1);
+    }
+
+    SymbolTable* globals = symbol_table_create(0);
+    double start = now_seconds();
+    for (int i = 0; i < count; i++) {
+        symbol_table_add(globals, symbols[i]);
+    }
+    double insert = now_seconds() - start;
+
+    // Lookups sample names spread over the whole scope
+    int samples = count < LOOKUP_SAMPLES ? count : LOOKUP_SAMPLES;
+    long stride = 7919;
+    int found = 0;
+
+    start = now_seconds();
+    for (int i = 0; i < samples; i++) {
+        found += symbol_table_lookup_local(globals, names[(i * stride) % count]) != NULL;
+    }
+    double hit = now_seconds() - start;
+
+    start = now_seconds();
+    for (int i = 0; i < samples; i++) {
+        found += symbol_table_lookup_local(globals, missing[(i * stride) % count]) != NULL;
+    }
+    double miss = now_seconds() - start;
+
+    // Four nested block scopes, each with a few locals
+    SymbolTable* scope = globals;
+    for (int depth = 1; depth <= 4; depth++) {
+        SymbolTable* inner = symbol_table_create(depth);
+        inner->parent = scope;
+        for (int i = 0; i < 8; i++) {
+            snprintf(name, sizeof(name), "local_%d_%d", depth, i);
+            symbol_table_add(inner, symbol_create_variable(name, "int", true, 0, 0));
+        }
+        scope = inner;
+    }
+
+    start = now_seconds();
+    for (int i = 0; i < samples; i++) {
+        found += symbol_table_lookup(scope, names[(i * stride) % count]) != NULL;
+    }
+    double nested = now_seconds() - start;
+
+    if (found != 2 * samples) {
+        fprintf(stderr, "Lookups returned the wrong symbols\n");
+        exit(EXIT_FAILURE);
+    }
+
+    printf("%8d symbols  insert %7.1f ns  hit %7.1f ns  miss %7.1f ns  nested hit %7.1f ns\n",
+           count, insert * 1e9 / count, hit * 1e9 / samples, miss * 1e9 / samples, nested * 1e9 / samples);
+
+    while (scope != NULL) {
+        SymbolTable* parent = scope->parent;
+        symbol_table_free(scope);
+        scope = parent;
+    }
+    for (int i = 0; i < count; i++) {
+        free(names[i]);
+        free(missing[i]);
+    }
+    free(names);
+    free(missing);
+    free(symbols);
+}
+
+#define NESTING_ROUNDS 2000
+#define NESTED_LOCALS 4
+#define NESTED_LOOKUPS 256
+
+// Function-like workload: a few thousand globals, then repeatedly a chain
+// of depth nested blocks with a few locals each, resolving a mix of locals
+// and globals in the innermost block
+static void bench_nesting(int depth) {
+    SemanticAnalyzer* analyzer = semantic_analyzer_create();
+    char name[32];
+    for (int i = 0; i < 4096; i++) {
+        snprintf(name, sizeof(name), "global_%d", i);
+        symbol_table_add(analyzer->current_scope, symbol_create_variable(name, "int", true, 0, 0));
+    }
+
+    // Locals are created once per round outside the timed region
+    char names[NESTED_LOOKUPS][32];
+    for (int i = 0; i < NESTED_LOOKUPS; i++) {
+        if (i % 2 == 0) {
+            snprintf(names[i], sizeof(names[i]), "global_%d", (i * 7919) % 4096);
+        } else {
+            snprintf(names[i], sizeof(names[i]), "local_%d", i % NESTED_LOCALS);
+        }
+    }
+    Symbol** locals = malloc(sizeof(Symbol*) * depth * NESTED_LOCALS);
+
+    double scope_time = 0;
+    double lookup_time = 0;
+    int found = 0;
+    for (int round = 0; round < NESTING_ROUNDS; round++) {
+        for (int i = 0; i < depth * NESTED_LOCALS; i++) {
+            snprintf(name, sizeof(name), "local_%d", i % NESTED_LOCALS);
+            locals[i] = symbol_create_variable(name, "int", true, 0, 0);
+        }
+
+        double start = now_seconds();
+        for (int level = 0; level < depth; level++) {
+            semantic_analyzer_enter_scope(analyzer);
+            for (int i = 0; i < NESTED_LOCALS; i++) {
+                symbol_table_add(analyzer->current_scope, locals[level * NESTED_LOCALS + i]);
+            }
+        }
+        double entered = now_seconds();
+
+        for (int i = 0; i < NESTED_LOOKUPS; i++) {
+            found += symbol_table_lookup(analyzer->current_scope, names[i]) != NULL;
+        }
+        double looked_up = now_seconds();
+
+        for (int level = 0; level < depth; level++) {
+            semantic_analyzer_exit_scope(analyzer);
+        }
+        double exited = now_seconds();
+
+        scope_time += (entered - start) + (exited - looked_up);
+        lookup_time += looked_up - entered;
+    }
+
+    if (found != NESTING_ROUNDS * NESTED_LOOKUPS) {
+        fprintf(stderr, "Nested lookups returned the wrong symbols\n");
+        exit(EXIT_FAILURE);
+    }
+
+    printf("depth %3d  enter+exit %7.1f ns/scope (incl. %d locals)  lookup %7.1f ns\n", depth,
+           scope_time * 1e9 / ((double)NESTING_ROUNDS * depth), NESTED_LOCALS,
+           lookup_time * 1e9 / ((double)NESTING_ROUNDS * NESTED_LOOKUPS));
+
+    free(locals);
+    semantic_analyzer_free(analyzer);
+}
+
+int main(int argc, char** argv) {
+    printf("=== SYMBOL TABLE BENCHMARK ===\n");
+    if (argc > 1) {
+        bench_scope(atoi(argv[1]));
+        return EXIT_SUCCESS;
+    }
+
+    for (int count = 10000; count <= 1000000; count *= 10) {
+        bench_scope(count);
+    }
+
+    printf("\n=== NESTED SCOPES (4096 globals) ===\n");
+    for (int depth = 1; depth <= 64; depth *= 4) {
+        bench_nesting(depth);
+    }
+    return EXIT_SUCCESS;
+}
@@ -29,6 +29,7 @@ void print_test_results(void) {
 // Forward declarations for test suites
 void run_parser_basic_tests(void);
 void run_semantic_tests(void);
+void run_ir_tests(void);
 
 // Empty implementations for test suites not yet implemented
 void run_parser_tests(void) { run_parser_basic_tests(); }
@@ -47,6 +48,7 @@ void run_all_tests(void) {
     run_lexer_tests();
     run_parser_tests();
     run_semantic_analyzer_tests();
+    run_ir_tests();
     run_code_generator_tests();
     run_integration_tests();
 
@@ -1,11 +1,16 @@
 #include "../src/lexer/lexer.h"
 #include "../src/parser/parser.h"
 #include "../src/semantic/semantic.h"
+#include "../src/semantic/ranges.h"
+#include "../src/ir/ir.h"
+#include "../src/ir/ssa.h"
+#include "../src/ir/sccp.h"
 #include "../src/codegen/codegen.h"
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
 #include <unistd.h>
+#include <sys/wait.h>
 
 int test_count = 0;
 int passed_tests = 0;
@@ -309,6 +314,141 @@ int test_full_pipeline_integration(void) {
     return 1;
 }
 
+// Compiles source through the IR backend, optionally with SSA and SCCP in
+// between, assembles and links it with a driver that runs the top-level
+// code and prints the first count globals, and runs it. Returns whether the
+// program exited normally; values receives the globals.
+static bool run_ir_program(const char* source, bool checked, bool sccp, long* values, int count) {
+    const char* assembly_file = "test_ir_program.s";
+    const char* driver_file = "test_ir_driver.c";
+    const char* program_file = "./test_ir_program";
+
+    Lexer* lexer = lexer_create(source);
+    Parser* parser = parser_create(lexer);
+    ASTNode* program = parser_parse_program(parser);
+    SemanticAnalyzer* analyzer = semantic_analyzer_create();
+    bool compiled = !parser_had_error(parser) && semantic_analyze(program, analyzer);
+    IrModule* module = NULL;
+    if (compiled) {
+        ranges_analyze(program, analyzer, NULL);
+        module = ir_lower_program(program, analyzer);
+        compiled = !module->had_error;
+    }
+    if (compiled && sccp) {
+        ir_module_to_ssa(module, NULL);
+        ir_module_sccp(module, NULL);
+        ir_module_from_ssa(module, NULL);
+    }
+    if (compiled) {
+        CodeGenerator* generator = code_generator_create(analyzer->current_scope);
+        generator->checked_arithmetic = checked;
+        compiled = code_generator_generate_ir(generator, module, assembly_file) == CODEGEN_SUCCESS;
+        code_generator_free(generator);
+    }
+    ir_module_free(module);
+    semantic_analyzer_free(analyzer);
+    ast_node_free(program);
+    parser_free(parser);
+    lexer_free(lexer);
+    TEST_ASSERT(compiled, "Program should compile to assembly");
+    if (!compiled) return false;
+
+    // Globals are consecutive quadwords from _g0; the program adds a reader
+    FILE* file = fopen(assembly_file, "a");
+    fprintf(file, "    .intel_syntax noprefix\n    .section .text\n    .global read_global\n"
+                  "read_global:\n    mov     rax, [_g0 + rdi * 8]\n    ret\n");
+    fclose(file);
+    file = fopen(driver_file, "w");
+    fprintf(file, "#include <stdio.h>\n#include <stdlib.h>\n"
+                  "long _main(void);\nlong read_global(long index);\n"
+                  "int main(int argc, char** argv) {\n"
+                  "    _main();\n"
+                  "    for (long i = 0; i < atol(argv[1]); i++) printf(\"%%ld\\n\", read_global(i));\n"
+                  "    return 0;\n"
+                  "}\n");
+    fclose(file);
+
+    char command[256];
+    snprintf(command, sizeof(command), "cc -no-pie -o %s %s %s", program_file, driver_file, assembly_file);
+    bool built = system(command) == 0;
+    TEST_ASSERT(built, "Assembly should assemble and link");
+
+    bool ran = false;
+    if (built) {
+        snprintf(command, sizeof(command), "%s %d 2> /dev/null", program_file, count);
+        FILE* output = popen(command, "r");
+        int read = 0;
+        while (read < count && fscanf(output, "%ld", &values[read]) == 1) read++;
+        int status = pclose(output);
+        ran = WIFEXITED(status) && WEXITSTATUS(status) == 0 && read == count;
+    }
+
+    remove(assembly_file);
+    remove(driver_file);
+    remove(program_file);
+    return ran;
+}
+
+int test_ir_backend_execution(void) {
+    printf("Test 6: IR Backend Execution\n");
+
+#if defined(__x86_64__)
+    if (system("cc --version > /dev/null 2>&1") != 0) {
+        printf("  (skipped: no C compiler to assemble with)\n");
+        return 1;
+    }
+
+    // A loop, calls, recursion, divisions by constants and negative
+    // dividends, and an assignment under && that may not run
+    const char* source =
+        "int g = 0;\n"
+        "int add(int a, int b) { return a + b; }\n"
+        "int sum(int n) { int s = 0; int i = 0; while (i < n) { s = add(s, i); i = i + 1; } return s; }\n"
+        "int half(int n) { int x = n; if (n > 100 && (x = 5) > 0) { n = n + 1; } return x / 2; }\n"
+        "int fact(int n) { if (n < 2) { return 1; } return n * fact(n - 1); }\n"
+        "int a = sum(10);\n"
+        "int b = half(0 - 7);\n"
+        "int c = fact(10) / 7 % 1000;\n"
+        "int d = (0 - 17) / 4;\n"
+        "int e = (0 - 17) % 4;\n"
+        "int i = 0;\n"
+        "int f = 0;\n"
+        "while (i < 100) { f = f + i / 8; i = i + 1; }\n"
+        "g = half(300);\n";
+    const long expected[] = { 2, 45, -3, 400, -4, -1, 100, 576 };
+    const int count = (int)(sizeof(expected) / sizeof(expected[0]));
+
+    for (int mode = 0; mode < 4; mode++) {
+        bool checked = mode & 1;
+        bool sccp = mode & 2;
+        long values[8] = {0};
+        bool ran = run_ir_program(source, checked, sccp, values, count);
+        TEST_ASSERT(ran, "Program should run to completion");
+        for (int i = 0; ran && i < count; i++) {
+            if (values[i] != expected[i]) {
+                printf("  global %d is %ld, expected %ld (%s, %s)\n", i, values[i], expected[i],
+                       checked ? "checked" : "unchecked", sccp ? "SSA + SCCP" : "lowered");
+            }
+            TEST_ASSERT(values[i] == expected[i], "Global should hold its computed value");
+        }
+    }
+
+    // Overflow traps only when arithmetic is checked
+    const char* overflow =
+        "int big = 2147483647;\n"
+        "int o = big * big * big;\n";
+    long values[2] = {0};
+    TEST_ASSERT(run_ir_program(overflow, false, false, values, 2), "Unchecked overflow should wrap");
+    TEST_ASSERT(values[1] == (long)((unsigned long)2147483647 * 2147483647 * 2147483647),
+                "The product should wrap at 64 bits");
+    TEST_ASSERT(!run_ir_program(overflow, true, false, values, 2), "Checked overflow should trap");
+#else
+    printf("  (skipped: the backend generates x86-64)\n");
+#endif
+
+    return 1;
+}
+
 int main(void) {
     printf("=== INTEGRATION TEST SUITE ===\n");
     printf("Testing complete compiler pipeline from source to assembly\n\n");
@@ -318,6 +458,7 @@ int main(void) {
     test_complex_expression_compilation();
     test_compiler_error_handling();
     test_full_pipeline_integration();
+    test_ir_backend_execution();
 
     printf("\n=== INTEGRATION TEST RESULTS ===\n");
     printf("Total tests: %d\n", test_count);
@@ -177,8 +177,98 @@ int test_literal_pipeline(void) {
     return 1;
 }
 
+// True if the lines appear in the file in this order
+static int assembly_contains_in_order(const char* path, const char* const* lines, int count) {
+    FILE* file = fopen(path, "r");
+    if (!file) return 0;
+
+    char buffer[256];
+    int matched = 0;
+    while (matched < count && fgets(buffer, sizeof(buffer), file)) {
+        if (strstr(buffer, lines[matched])) matched++;
+    }
+    fclose(file);
+    return matched == count;
+}
+
+int test_locals_pipeline(void) {
+    printf("\nTest 3: Reading and Writing Locals\n");
+
+    // x and y live in _main's frame; reads and writes go through their slots
+    const char* source = "int x = 5;\nint y = x + 2;\nx = y * 3;\n";
+    const char* output_file = "locals_test.asm";
+
+    Lexer* lexer = lexer_create(source);
+    Parser* parser = parser_create(lexer);
+    ASTNode* ast = parser_parse_program(parser);
+    SemanticAnalyzer* analyzer = semantic_analyzer_create();
+    bool semantic_result = semantic_analyze(ast, analyzer);
+    CodeGenerator* generator = code_generator_create(analyzer->current_scope);
+    CodeGenResult codegen_result = code_generator_generate(generator, ast, output_file);
+
+    TEST_ASSERT(!parser_had_error(parser), "Program parsed");
+    TEST_ASSERT(semantic_result && !analyzer->had_error, "Semantic analysis passed");
+
+    ASTNode* read_x = ast->data.block.statements[1]->data.declaration.initializer->data.binary.left;
+    TEST_ASSERT(read_x->resolved_global && read_x->resolved_slot == 0, "x should resolve to global slot 0");
+    TEST_ASSERT(ast->data.block.statements[1]->resolved_slot == 1, "y should be declared in global slot 1");
+    TEST_ASSERT(codegen_result == CODEGEN_SUCCESS, "Code generation successful");
+
+    const char* expected[] = {
+        "mov     rax, 5",
+        "mov     [rbp-8], rax",      // int x = 5
+        "mov     rax, [rbp-8]",      // read x
+        "add     rax, rbx",
+        "mov     [rbp-16], rax",     // int y = x + 2
+        "mov     rax, [rbp-16]",     // read y
+        "imul    rax, rbx",
+        "mov     [rbp-8], rax",      // x = y * 3
+        "ret"
+    };
+    TEST_ASSERT(assembly_contains_in_order(output_file, expected, sizeof(expected) / sizeof(expected[0])),
+                "Assembly should load and store the variables' slots in order");
+    remove(output_file);
+
+    code_generator_free(generator);
+    semantic_analyzer_free(analyzer);
+    ast_node_free(ast);
+    parser_free(parser);
+    lexer_free(lexer);
+
+    return 1;
+}
+
+int test_undeclared_variable_pipeline(void) {
+    printf("\nTest 4: Undeclared Variable\n");
+
+    const char* source = "int x = 1;\ny = x;\n";
+    Lexer* lexer = lexer_create(source);
+    Parser* parser = parser_create(lexer);
+    ASTNode* ast = parser_parse_program(parser);
+    SemanticAnalyzer* analyzer = semantic_analyzer_create();
+
+    bool semantic_result = semantic_analyze(ast, analyzer);
+    TEST_ASSERT(!semantic_result && analyzer->had_error, "Semantic analysis should reject y");
+    TEST_ASSERT(analyzer->last_error && strstr(analyzer->last_error->message, "'y'") &&
+                analyzer->last_error->line == 2, "The error should name y and its line");
+
+    // Code generation refuses the unresolved name instead of looking it up
+    CodeGenerator* generator = code_generator_create(analyzer->current_scope);
+    CodeGenResult codegen_result = code_generator_generate(generator, ast, "undeclared_test.asm");
+    TEST_ASSERT(codegen_result == CODEGEN_ERROR_SYMBOL_NOT_FOUND, "Code generation should report the unresolved name");
+    remove("undeclared_test.asm");
+
+    code_generator_free(generator);
+    semantic_analyzer_free(analyzer);
+    ast_node_free(ast);
+    parser_free(parser);
+    lexer_free(lexer);
+
+    return 1;
+}
+
 int test_error_handling_pipeline(void) {
-    printf("\nTest 3: Error Handling Pipeline\n");
+    printf("\nTest 5: Error Handling Pipeline\n");
 
     // Test: Error handling for invalid input
     const char* source = ""; // Empty input
@@ -206,6 +296,8 @@ int main(void) {
 
     test_expression_to_assembly_pipeline();
     test_literal_pipeline();
+    test_locals_pipeline();
+    test_undeclared_variable_pipeline();
     test_error_handling_pipeline();
 
     printf("\n=== INTEGRATION TEST RESULTS ===\n");
@@ -5,6 +5,7 @@
 #include "unit/test_lexer.c"
 #include "unit/test_parser.c"
 #include "unit/test_semantic.c"
+#include "unit/test_ir.c"
 
 int main(void) {
     run_all_tests();
@@ -0,0 +1,324 @@
+#include "../../src/semantic/semantic.h"
+#include "../../src/semantic/ranges.h"
+#include "../../src/ir/ir.h"
+#include "../../src/ir/ssa.h"
+#include "../../src/ir/sccp.h"
+#include "../test_framework.h"
+
+TEST_SUITE(ir_lowering) {
+    const char* source =
+        "int g = 2;\n"
+        "int add(int a, int b) { return a + b; }\n"
+        "int loop(int n) {\n"
+        "    int s = 0;\n"
+        "    int i = 0;\n"
+        "    while (i < 10) {\n"
+        "        s = s + i / 4;\n"
+        "        i = i + 1;\n"
+        "    }\n"
+        "    if (n > 0 && s != 0) { g = add(s, n); }\n"
+        "    return s;\n"
+        "}\n"
+        "int r = loop(g);\n";
+    Lexer* lexer = lexer_create(source);
+    Parser* parser = parser_create(lexer);
+    ASTNode* program = parser_parse_program(parser);
+    SemanticAnalyzer* analyzer = semantic_analyzer_create();
+    TEST_ASSERT(semantic_analyze(program, analyzer), "The program should analyze");
+    TEST_ASSERT(ranges_analyze(program, analyzer, NULL), "Ranges should be analyzed");
+
+    IrModule* module = ir_lower_program(program, analyzer);
+    TEST_ASSERT(!module->had_error, "The program should lower");
+    TEST_ASSERT_EQ(3, module->function_count, "Top-level code, add and loop");
+    TEST_ASSERT_STR_EQ("_main", module->functions[0].name, "Function 0 is the top-level code");
+    TEST_ASSERT_EQ(2, module->global_count, "g and r are globals");
+
+    // Top-level code: g = 2, then r = loop(g)
+    IrFunction* main_function = &module->functions[0];
+    TEST_ASSERT_EQ(1, main_function->block_count, "Straight-line code is one block");
+    const IrInstr* call = &main_function->instrs[3];
+    TEST_ASSERT_EQ(IR_CALL, call->op, "loop(g) is a call");
+    TEST_ASSERT_EQ(2, call->a, "The call names loop by index");
+    TEST_ASSERT_EQ(1, call->c, "The call passes one argument");
+    TEST_ASSERT_EQ(IR_RETURN, ir_block_terminator(main_function, 0)->op, "Top-level code ends with a return");
+
+    // Parameters are the first registers and a + b defines a temporary
+    IrFunction* add = &module->functions[1];
+    TEST_ASSERT_EQ(2, add->parameter_count, "add takes two parameters");
+    TEST_ASSERT_EQ(IR_ADD, add->instrs[0].op, "a + b is one instruction");
+    TEST_ASSERT(add->instrs[0].a == 0 && add->instrs[0].b == 1, "It reads the parameter registers");
+    TEST_ASSERT_EQ(0, add->instrs[0].flags, "Nothing is known about the parameters");
+
+    // entry, loop test, body, if test, second test of &&, then, join
+    IrFunction* loop = &module->functions[2];
+    TEST_ASSERT_EQ(3, loop->variable_count, "n, s and i are variables");
+    TEST_ASSERT_EQ(7, loop->block_count, "The loop and the && each branch");
+    TEST_ASSERT_EQ(2, loop->blocks[1].predecessor_count, "The loop test is reached from the entry and the body");
+    TEST_ASSERT_EQ(3, loop->blocks[6].predecessor_count, "Both tests of && and the then branch join");
+    const IrInstr* test = ir_block_terminator(loop, 1);
+    TEST_ASSERT_EQ(IR_BRANCH, test->op, "The loop test branches");
+    TEST_ASSERT(test->b == 2 && test->c == 3, "To the body or past the loop");
+
+    // i / 4 becomes a shift and i + 1 carries the range facts
+    const IrBlock* body = &loop->blocks[2];
+    int shifts = 0;
+    int narrow = 0;
+    for (int i = 0; i < body->count; i++) {
+        const IrInstr* instr = &loop->instrs[body->first + i];
+        if (instr->op == IR_SAR) shifts++;
+        if (instr->op == IR_ADD && (instr->flags & IR_FLAG_NARROW)) {
+            narrow++;
+            TEST_ASSERT_EQ(2, instr->dest, "i = i + 1 defines i's register directly");
+            TEST_ASSERT(instr->flags & IR_FLAG_NO_OVERFLOW, "i + 1 cannot overflow");
+        }
+    }
+    TEST_ASSERT_EQ(1, shifts, "i / 4 is an arithmetic shift");
+    TEST_ASSERT_EQ(1, narrow, "Only i + 1 is narrow; s grows without a bound");
+
+    int uses[4];
+    TEST_ASSERT_EQ(2, ir_instr_uses(add, &add->instrs[0], uses, 4), "An add reads two registers");
+    TEST_ASSERT(uses[0] == 0 && uses[1] == 1, "In operand order");
+    TEST_ASSERT_EQ(ir_module_instr_count(module),
+                   (long)(main_function->instr_count + add->instr_count + loop->instr_count),
+                   "The module counts every function's instructions");
+
+    ir_module_free(module);
+    semantic_analyzer_free(analyzer);
+    ast_node_free(program);
+    parser_free(parser);
+    lexer_free(lexer);
+
+    // Floats are not lowered; the module reports the first one
+    lexer = lexer_create("float x = 1.5;\nint y = 2;\n");
+    parser = parser_create(lexer);
+    program = parser_parse_program(parser);
+    analyzer = semantic_analyzer_create();
+    TEST_ASSERT(semantic_analyze(program, analyzer), "The program should analyze");
+    module = ir_lower_program(program, analyzer);
+    TEST_ASSERT(module->had_error, "Floats are not supported");
+    TEST_ASSERT(strstr(module->error, "float") != NULL, "The error names the type");
+
+    ir_module_free(module);
+    semantic_analyzer_free(analyzer);
+    ast_node_free(program);
+    parser_free(parser);
+    lexer_free(lexer);
+
+    // With hash-consing, uses of the same variable share a node and its slot
+    lexer = lexer_create(
+        "int a = 3;\n"
+        "int b = a + 1;\n"
+        "int c = a + 1;\n"
+        "int f(int a) { int d = 2 * 3 / 2; return a + 1 + d; }\n"
+        "int e = f(2 * 3 / 2);\n");
+    parser = parser_create(lexer);
+    parser_enable_hash_consing(parser);
+    program = parser_parse_program(parser);
+    analyzer = semantic_analyzer_create();
+    TEST_ASSERT(semantic_analyze(program, analyzer), "The program should analyze");
+    TEST_ASSERT(ranges_analyze(program, analyzer, NULL), "Ranges should be analyzed");
+    module = ir_lower_program(program, analyzer);
+    TEST_ASSERT(!module->had_error, "A hash-consed program should lower");
+    TEST_ASSERT(program->data.block.statements[1]->data.declaration.initializer ==
+                program->data.block.statements[2]->data.declaration.initializer, "Both a + 1 should be one node");
+
+    int loads = 0;
+    main_function = &module->functions[0];
+    for (int i = 0; i < main_function->instr_count; i++) {
+        loads += main_function->instrs[i].op == IR_LOAD_GLOBAL && main_function->instrs[i].a == 0;
+    }
+    TEST_ASSERT_EQ(2, loads, "Both a + 1 read the global a");
+    IrFunction* f = &module->functions[1];
+    loads = 0;
+    for (int i = 0; i < f->instr_count; i++) loads += f->instrs[i].op == IR_LOAD_GLOBAL;
+    TEST_ASSERT_EQ(0, loads, "The parameter a shadows the global");
+
+    ir_module_free(module);
+    semantic_analyzer_free(analyzer);
+    ast_node_free(program);
+    parser_free(parser);
+    lexer_free(lexer);
+}
+
+TEST_SUITE(ssa_construction) {
+    const char* source =
+        "int swap(int n) {\n"
+        "    int a = 1;\n"
+        "    int b = 2;\n"
+        "    int i = 0;\n"
+        "    while (i < n) {\n"
+        "        int t = a;\n"
+        "        a = b;\n"
+        "        b = t;\n"
+        "        i = i + 1;\n"
+        "    }\n"
+        "    return a * 10 + b;\n"
+        "}\n"
+        "int clamp(int n) {\n"
+        "    int r = 0;\n"
+        "    if (n > 0) { r = n; }\n"
+        "    return r;\n"
+        "}\n";
+    Lexer* lexer = lexer_create(source);
+    Parser* parser = parser_create(lexer);
+    ASTNode* program = parser_parse_program(parser);
+    SemanticAnalyzer* analyzer = semantic_analyzer_create();
+    TEST_ASSERT(semantic_analyze(program, analyzer), "The program should analyze");
+    IrModule* module = ir_lower_program(program, analyzer);
+    TEST_ASSERT(!module->had_error, "The program should lower");
+
+    // entry, loop head, body, exit
+    IrFunction* swap = &module->functions[1];
+    TEST_ASSERT_EQ(4, swap->block_count, "The loop has a head, a body and an exit");
+    IrDominators dominators;
+    ir_dominators_compute(swap, &dominators);
+    TEST_ASSERT_EQ(0, dominators.idom[0], "The entry is its own idom");
+    TEST_ASSERT_EQ(0, dominators.idom[1], "The entry dominates the head");
+    TEST_ASSERT_EQ(1, dominators.idom[2], "The head dominates the body");
+    TEST_ASSERT_EQ(1, dominators.idom[3], "and the exit, which the body does not");
+    TEST_ASSERT(ir_dominates(&dominators, 1, 3) && !ir_dominates(&dominators, 2, 3), "Dominance by the tree");
+    TEST_ASSERT(ir_dominates(&dominators, 2, 2), "A block dominates itself");
+    ir_dominators_free(&dominators);
+    TEST_ASSERT(!ir_function_verify_ssa(swap), "Variables are assigned more than once");
+
+    IrSsaStats stats = {0};
+    ir_module_to_ssa(module, &stats);
+    TEST_ASSERT(swap->ssa, "The function is marked as SSA");
+    TEST_ASSERT(ir_function_verify_ssa(swap), "Every register is defined once, before its uses");
+    TEST_ASSERT(ir_function_verify_ssa(&module->functions[2]), "clamp is valid SSA too");
+    TEST_ASSERT_EQ(3, stats.functions, "Top-level code, swap and clamp");
+    TEST_ASSERT_EQ(4, stats.phis, "a, b and i at the loop head, r where the if joins");
+    TEST_ASSERT_EQ(4, stats.copies_folded, "t = a, a = b, b = t and r = n are folded");
+    TEST_ASSERT_EQ(0, stats.undefined, "Every variable is initialized");
+    const IrBlock* head = &swap->blocks[1];
+    for (int i = 0; i < 3; i++) {
+        const IrInstr* phi = &swap->instrs[head->first + i];
+        TEST_ASSERT_EQ(IR_PHI, phi->op, "The head starts with the phis");
+        TEST_ASSERT_EQ(2, phi->c, "One input from the entry and one from the body");
+    }
+    // The swap makes a and b each other's input from the body
+    const IrInstr* phi_a = &swap->instrs[head->first];
+    const IrInstr* phi_b = &swap->instrs[head->first + 1];
+    TEST_ASSERT(swap->operands[phi_a->b + 1] == phi_b->dest && swap->operands[phi_b->b + 1] == phi_a->dest,
+                "a gets b and b gets a around the loop");
+
+    IrOutOfSsaStats out_stats = {0};
+    ir_module_from_ssa(module, &out_stats);
+    TEST_ASSERT(!swap->ssa, "The function is no longer SSA");
+    TEST_ASSERT_EQ(4, out_stats.phis, "Every phi is removed");
+    TEST_ASSERT_EQ(1, out_stats.cycles, "Swapping a and b is a cycle");
+    TEST_ASSERT_EQ(1, out_stats.edges_split, "The edge from the if test to the join is critical");
+    TEST_ASSERT_EQ(4, module->functions[2].block_count, "clamp's split edge is a block of its own");
+    for (int f = 0; f < module->function_count; f++) {
+        for (int i = 0; i < module->functions[f].instr_count; i++) {
+            TEST_ASSERT(module->functions[f].instrs[i].op != IR_PHI, "No phi is left");
+        }
+    }
+    // The body copies the swapped values through one extra register
+    const IrBlock* body = &swap->blocks[2];
+    int copies = 0;
+    for (int i = 0; i < body->count; i++) {
+        if (swap->instrs[body->first + i].op == IR_COPY) copies++;
+    }
+    TEST_ASSERT_EQ(4, copies, "i, then a and b with a temporary");
+
+    ir_module_free(module);
+    semantic_analyzer_free(analyzer);
+    ast_node_free(program);
+    parser_free(parser);
+    lexer_free(lexer);
+}
+
+static const IrInstr* find_return(const IrFunction* function) {
+    for (int i = 0; i < function->instr_count; i++) {
+        if (function->instrs[i].op == IR_RETURN) return &function->instrs[i];
+    }
+    return NULL;
+}
+
+static const IrInstr* find_definition(const IrFunction* function, int reg) {
+    for (int i = 0; i < function->instr_count; i++) {
+        if (function->instrs[i].dest == reg) return &function->instrs[i];
+    }
+    return NULL;
+}
+
+TEST_SUITE(sparse_constant_propagation) {
+    const char* source =
+        "int configured(int n) {\n"
+        "    int debug = 0;\n"
+        "    int level = 2;\n"
+        "    int r = n;\n"
+        "    if (debug) { r = r + 100; }\n"
+        "    if (level > 1 && !debug) { r = r * 2; } else { r = r - 1; }\n"
+        "    return r;\n"
+        "}\n"
+        "int invariant(int n) {\n"
+        "    int k = 4;\n"
+        "    int i = 0;\n"
+        "    while (i < n) { k = k * 1; i = i + 1; }\n"
+        "    return k;\n"
+        "}\n"
+        "int trap(int n) {\n"
+        "    int d = 0;\n"
+        "    while (d < 0) { d = d + n; }\n"
+        "    return n / d;\n"
+        "}\n";
+    Lexer* lexer = lexer_create(source);
+    Parser* parser = parser_create(lexer);
+    ASTNode* program = parser_parse_program(parser);
+    SemanticAnalyzer* analyzer = semantic_analyzer_create();
+    TEST_ASSERT(semantic_analyze(program, analyzer), "The program should analyze");
+    IrModule* module = ir_lower_program(program, analyzer);
+    TEST_ASSERT(!module->had_error, "The program should lower");
+
+    IrSccpStats stats = {0};
+    ir_module_sccp(module, &stats);
+    TEST_ASSERT_EQ(0, stats.functions, "Functions not in SSA form are left alone");
+    ir_module_to_ssa(module, NULL);
+    ir_module_sccp(module, &stats);
+    TEST_ASSERT_EQ(4, stats.functions, "Top-level code and the three functions");
+    TEST_ASSERT_EQ(4, stats.branches_folded, "if (debug), both tests of the &&, and the loop never entered");
+    TEST_ASSERT_EQ(3, stats.blocks_removed, "The two arms not taken and the loop body");
+    for (int f = 0; f < module->function_count; f++) {
+        TEST_ASSERT(ir_function_verify_ssa(&module->functions[f]), "The functions stay in SSA form");
+    }
+
+    // configured returns n * 2, with no test left
+    IrFunction* configured = &module->functions[1];
+    for (int i = 0; i < configured->instr_count; i++) {
+        TEST_ASSERT(configured->instrs[i].op != IR_BRANCH && configured->instrs[i].op != IR_PHI,
+                    "The flags' tests and the joins are gone");
+    }
+    const IrInstr* result = find_definition(configured, find_return(configured)->a);
+    TEST_ASSERT(result != NULL && result->op == IR_MUL && result->a == 0, "r is n * 2");
+
+    // k is 4 on entry and k * 1 around the loop, so always 4
+    IrFunction* invariant = &module->functions[2];
+    result = find_definition(invariant, find_return(invariant)->a);
+    TEST_ASSERT(result != NULL && result->op == IR_CONST, "k is found constant");
+    TEST_ASSERT_EQ(4, (int)invariant->constants[result->a], "k is 4");
+    TEST_ASSERT_EQ(4, invariant->block_count, "The loop is kept, its test is not constant");
+
+    // Division by a constant 0 is left to trap
+    IrFunction* trap = &module->functions[3];
+    result = find_definition(trap, find_return(trap)->a);
+    TEST_ASSERT(result != NULL && result->op == IR_DIV, "n / 0 is not folded");
+    const IrInstr* divisor = find_definition(trap, result->b);
+    TEST_ASSERT(divisor != NULL && divisor->op == IR_CONST && trap->constants[divisor->a] == 0, "d is 0");
+
+    ir_module_from_ssa(module, NULL);
+    TEST_ASSERT(!configured->ssa, "The result translates out of SSA form");
+
+    ir_module_free(module);
+    semantic_analyzer_free(analyzer);
+    ast_node_free(program);
+    parser_free(parser);
+    lexer_free(lexer);
+}
+
+void run_ir_tests(void) {
+    run_suite_ir_lowering();
+    run_suite_ssa_construction();
+    run_suite_sparse_constant_propagation();
+}
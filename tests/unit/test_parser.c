@@ -1,4 +1,6 @@
 #include "../../src/parser/parser.h"
+#include "../../src/parser/ast_cache.h"
+#include <math.h>
 #include "../test_framework.h"
 
 TEST_SUITE(parser_creation) {
@@ -175,7 +177,9 @@ TEST_SUITE(parser_node_utilities) {
     TEST_ASSERT(float_literal->type == NODE_LITERAL, "Should be literal");
     TEST_ASSERT(3.14f == float_literal->data.literal.float_value, "Should have correct float value");
 
-    ASTNode* string_literal = ast_node_create_literal_string(token, "hello");
+    // A string literal frees its copy of the value only with a string token
+    Token* string_token = token_create_with_literal(TOKEN_STRING_LITERAL, "\"hello\"", 1, 1);
+    ASTNode* string_literal = ast_node_create_literal_string(string_token, "hello");
     TEST_ASSERT(string_literal->type == NODE_LITERAL, "Should be literal");
     TEST_ASSERT_STR_EQ("hello", string_literal->data.literal.string_value, "Should have correct string value");
 
@@ -183,16 +187,14 @@ TEST_SUITE(parser_node_utilities) {
     TEST_ASSERT(identifier->type == NODE_IDENTIFIER, "Should be identifier");
     TEST_ASSERT_STR_EQ("x", identifier->data.identifier_name, "Should have correct identifier name");
 
-    // Cleanup
-    token_free(token);
-    ast_node_free(left);
-    ast_node_free(right);
-    ast_node_free(operand);
+    // Cleanup (binary and unary nodes own their operands; nodes borrow the token)
     ast_node_free(unary);
     ast_node_free(int_literal);
     ast_node_free(float_literal);
     ast_node_free(string_literal);
     ast_node_free(identifier);
+    token_free(token);
+    token_free(string_token);
 }
 
 TEST_SUITE(parser_type_to_string) {
@@ -203,6 +205,660 @@ TEST_SUITE(parser_type_to_string) {
     TEST_ASSERT_STR_EQ("ERROR", node_type_to_string(NODE_ERROR), "ERROR should map to 'ERROR'");
 }
 
+TEST_SUITE(parser_program) {
+    const char* source =
+        "int limit = 10;\n"
+        "int add(int a, int b) {\n"
+        "    return a + b;\n"
+        "}\n"
+        "void main() {\n"
+        "    int i = 0;\n"
+        "    while (i < limit) {\n"
+        "        if (i == 5) { i = add(i, 2); } else i = i + 1;\n"
+        "    }\n"
+        "    return;\n"
+        "}\n";
+
+    Lexer* lexer = lexer_create(source);
+    Parser* parser = parser_create(lexer);
+    ASTNode* program = parser_parse_program(parser);
+
+    TEST_ASSERT_NOT_NULL(program, "Program should be parsed");
+    TEST_ASSERT(!parser_had_error(parser), "Program should parse without errors");
+    TEST_ASSERT_EQ(NODE_PROGRAM, program->type, "Root should be a program node");
+    TEST_ASSERT_EQ(3, program->data.block.statement_count, "Program should have three declarations");
+
+    ASTNode* global = program->data.block.statements[0];
+    TEST_ASSERT_EQ(NODE_VARIABLE_DECLARATION, global->type, "First declaration should be a variable");
+    TEST_ASSERT_STR_EQ("limit", global->data.declaration.name, "Global should be named 'limit'");
+
+    ASTNode* add = program->data.block.statements[1];
+    TEST_ASSERT_EQ(NODE_FUNCTION_DECLARATION, add->type, "Second declaration should be a function");
+    TEST_ASSERT_STR_EQ("add", add->data.function.name, "Function should be named 'add'");
+    TEST_ASSERT_STR_EQ("int", add->data.function.return_type, "Function should return int");
+    TEST_ASSERT_EQ(2, add->data.function.parameter_count, "Function should have two parameters");
+    TEST_ASSERT_STR_EQ("b", add->data.function.parameters[1]->data.declaration.name, "Second parameter should be 'b'");
+    TEST_ASSERT_EQ(1, add->data.function.body->data.block.statement_count, "Body should hold one statement");
+    TEST_ASSERT_EQ(NODE_RETURN_STATEMENT, add->data.function.body->data.block.statements[0]->type,
+                   "Body should be a return statement");
+
+    ASTNode* body = program->data.block.statements[2]->data.function.body;
+    TEST_ASSERT_EQ(3, body->data.block.statement_count, "main should have three statements");
+
+    ASTNode* loop = body->data.block.statements[1];
+    TEST_ASSERT_EQ(NODE_WHILE_STATEMENT, loop->type, "Second statement should be a while loop");
+    TEST_ASSERT_EQ(NODE_BINARY_EXPRESSION, loop->data.conditional.condition->type, "Loop condition should be binary");
+
+    ASTNode* branch = loop->data.conditional.then_branch->data.block.statements[0];
+    TEST_ASSERT_EQ(NODE_IF_STATEMENT, branch->type, "Loop body should contain an if statement");
+    TEST_ASSERT_NOT_NULL(branch->data.conditional.else_branch, "If statement should have an else branch");
+
+    ASTNode* call_stmt = branch->data.conditional.then_branch->data.block.statements[0];
+    ASTNode* assignment = call_stmt->data.statement.expression;
+    TEST_ASSERT_EQ(NODE_ASSIGNMENT_EXPRESSION, assignment->type, "Then branch should assign");
+    TEST_ASSERT_EQ(NODE_CALL_EXPRESSION, assignment->data.binary.right->type, "Assigned value should be a call");
+    TEST_ASSERT_EQ(2, assignment->data.binary.right->data.call.argument_count, "Call should have two arguments");
+
+    ast_node_free(program);
+    parser_free(parser);
+    lexer_free(lexer);
+}
+
+TEST_SUITE(parser_program_errors) {
+    // Every error is reported in one pass; broken statements become error nodes
+    const char* source =
+        "int a = 1;\n"
+        "int f() {\n"
+        "    a = 2\n"
+        "    int b = ;\n"
+        "    return a;\n"
+        "}\n"
+        "int c = (3;\n"
+        "int d = 4;\n";
+
+    Lexer* lexer = lexer_create(source);
+    Parser* parser = parser_create(lexer);
+    ASTNode* program = parser_parse_program(parser);
+
+    TEST_ASSERT(parser_had_error(parser), "Syntax errors should be reported");
+    TEST_ASSERT_EQ(3, parser_get_error_count(parser), "All three errors should be found");
+    TEST_ASSERT_EQ(3, parser_get_diagnostic_count(parser), "All three errors should be recorded");
+    TEST_ASSERT_EQ(3, parser_get_diagnostic(parser, 0)->line, "First error should be on line 3");
+    TEST_ASSERT_EQ(4, parser_get_diagnostic(parser, 1)->line, "Second error should be on line 4");
+    TEST_ASSERT_EQ(7, parser_get_diagnostic(parser, 2)->line, "Third error should be on line 7");
+    TEST_ASSERT(parser_get_last_error(parser) == parser_get_diagnostic(parser, 2),
+                "Last error should be the newest diagnostic");
+
+    TEST_ASSERT_EQ(4, program->data.block.statement_count, "Parsing should continue to EOF");
+    ASTNode* body = program->data.block.statements[1]->data.function.body;
+    TEST_ASSERT_EQ(NODE_FUNCTION_DECLARATION, program->data.block.statements[1]->type,
+                   "Function should survive errors in its body");
+    TEST_ASSERT_EQ(3, body->data.block.statement_count, "Body should keep all statements");
+    TEST_ASSERT_EQ(NODE_ERROR, body->data.block.statements[0]->type, "Missing ';' should leave an error node");
+    TEST_ASSERT_EQ(NODE_ERROR, body->data.block.statements[1]->type, "Bad initializer should leave an error node");
+    TEST_ASSERT_EQ(NODE_RETURN_STATEMENT, body->data.block.statements[2]->type, "Return should still be parsed");
+    TEST_ASSERT_EQ(NODE_ERROR, program->data.block.statements[2]->type, "Bad global should leave an error node");
+    TEST_ASSERT_STR_EQ("d", program->data.block.statements[3]->data.declaration.name,
+                       "Declarations after errors should be parsed");
+
+    ast_node_free(program);
+    parser_free(parser);
+    lexer_free(lexer);
+}
+
+TEST_SUITE(parser_diagnostics_bounded) {
+    // Thousands of errors: each is counted but only the first ones are kept
+    StringBuffer* buffer = string_buffer_create(1024);
+    for (int i = 0; i < 5000; i++) {
+        string_buffer_append(buffer, "int x = ;\n");
+    }
+    string_buffer_append(buffer, "int ok = 1;\n");
+
+    Lexer* lexer = lexer_create(buffer->data);
+    Parser* parser = parser_create(lexer);
+    ASTNode* program = parser_parse_program(parser);
+
+    TEST_ASSERT_EQ(5000, parser_get_error_count(parser), "Every error should be counted");
+    TEST_ASSERT_EQ(PARSER_MAX_DIAGNOSTICS, parser_get_diagnostic_count(parser), "Diagnostics should be bounded");
+    TEST_ASSERT_EQ(5001, program->data.block.statement_count, "Each broken line should leave one node");
+    TEST_ASSERT_EQ(NODE_VARIABLE_DECLARATION, program->data.block.statements[5000]->type,
+                   "Trailing declaration should be parsed");
+
+    // An unterminated block is reported once
+    Lexer* open_lexer = lexer_create("void f() { { int y = 1;");
+    Parser* open_parser = parser_create(open_lexer);
+    ASTNode* open_program = parser_parse_program(open_parser);
+    TEST_ASSERT_EQ(1, parser_get_error_count(open_parser), "Missing braces should be one error");
+    TEST_ASSERT_EQ(NODE_FUNCTION_DECLARATION, open_program->data.block.statements[0]->type,
+                   "Unterminated function should be kept");
+
+    ast_node_free(open_program);
+    parser_free(open_parser);
+    lexer_free(open_lexer);
+    ast_node_free(program);
+    parser_free(parser);
+    lexer_free(lexer);
+    string_buffer_free(buffer);
+}
+
+// Parses source sequentially and with thread_count workers and compares
+static bool parser_parallel_matches(const char* source, int thread_count) {
+    Lexer* lexer = lexer_create(source);
+    Parser* parser = parser_create(lexer);
+    ASTNode* expected = parser_parse_program(parser);
+
+    Lexer* parallel_lexer = lexer_create(source);
+    Parser* parallel_parser = parser_create(parallel_lexer);
+    ASTNode* actual = parser_parse_program_parallel(parallel_parser, thread_count);
+
+    bool same = ast_node_equal(expected, actual) &&
+                parser_get_error_count(parser) == parser_get_error_count(parallel_parser) &&
+                parser_get_diagnostic_count(parser) == parser_get_diagnostic_count(parallel_parser);
+    for (int i = 0; same && i < parser_get_diagnostic_count(parser); i++) {
+        Error* a = parser_get_diagnostic(parser, i);
+        Error* b = parser_get_diagnostic(parallel_parser, i);
+        same = a->line == b->line && a->column == b->column && strcmp(a->message, b->message) == 0;
+    }
+
+    ast_node_free(expected);
+    parser_free(parser);
+    lexer_free(lexer);
+    ast_node_free(actual);
+    parser_free(parallel_parser);
+    lexer_free(parallel_lexer);
+    return same;
+}
+
+TEST_SUITE(parser_parallel) {
+    StringBuffer* buffer = string_buffer_create(4096);
+    char line[256];
+    for (int i = 0; i < 200; i++) {
+        snprintf(line, sizeof(line),
+                 "int g%d = %d;\n"
+                 "int f%d(int a, int b) {\n"
+                 "    int x = a * %d + b;\n"
+                 "    if (x > b) { x = x - 1; } else { while (x < 10) { x = x + 2; } }\n"
+                 "    return f%d(x, b);\n"
+                 "}\n",
+                 i, i, i, i, i);
+        string_buffer_append(buffer, line);
+    }
+
+    TEST_ASSERT(parser_parallel_matches(buffer->data, 1), "One worker should match the sequential tree");
+    TEST_ASSERT(parser_parallel_matches(buffer->data, 4), "Four workers should match the sequential tree");
+
+    // Errors in bodies and at top level come out in source order
+    for (int i = 0; i < 150; i++) {
+        string_buffer_append(buffer, "int h(int a) {\n    a = ;\n    return a\n}\nint bad = (1;\n");
+    }
+    TEST_ASSERT(parser_parallel_matches(buffer->data, 4), "Diagnostics should match the sequential parse");
+
+    // Unbalanced braces and broken signatures are handled sequentially
+    TEST_ASSERT(parser_parallel_matches("int f(int a) { return a; }\nint g(int) { return 1; }\n"
+                                        "void h() { { int y = 1;", 2),
+                "Unbalanced input should match the sequential parse");
+
+    Lexer* lexer = lexer_create("int f() { return 1; } int g() { return 2; }");
+    Parser* parser = parser_create(lexer);
+    ASTNode* program = parser_parse_program_parallel(parser, 2);
+    TEST_ASSERT_EQ(2, program->data.block.statement_count, "Both functions should be parsed");
+    TEST_ASSERT_NOT_NULL(program->data.block.statements[1]->data.function.body,
+                         "Bodies should be stitched into their functions");
+    TEST_ASSERT(!parser_had_error(parser), "Valid input should parse cleanly");
+
+    ast_node_free(program);
+    parser_free(parser);
+    lexer_free(lexer);
+    string_buffer_free(buffer);
+}
+
+TEST_SUITE(parser_lazy_bodies) {
+    const char* source =
+        "int g = 1;\n"
+        "int f(int a) {\n"
+        "    while (a > 0) { a = a - 1; }\n"
+        "    return a;\n"
+        "}\n"
+        "int broken() {\n"
+        "    int x = ;\n"
+        "}\n";
+
+    Lexer* lexer = lexer_create(source);
+    Parser* parser = parser_create(lexer);
+    ASTNode* expected = parser_parse_program(parser);
+
+    Lexer* lazy_lexer = lexer_create(source);
+    Parser* lazy_parser = parser_create(lazy_lexer);
+    ASTNode* program = parser_parse_program_lazy(lazy_parser);
+
+    TEST_ASSERT_EQ(3, program->data.block.statement_count, "Signatures should all be parsed");
+    ASTNode* f = program->data.block.statements[1];
+    ASTNode* broken = program->data.block.statements[2];
+    TEST_ASSERT_NULL(f->data.function.body, "Bodies should be deferred");
+    TEST_ASSERT_EQ(1, f->data.function.parameter_count, "Parameters should be parsed eagerly");
+    TEST_ASSERT(!parser_had_error(lazy_parser), "Errors in unparsed bodies should not be reported yet");
+
+    ASTNode* body = ast_function_body(f);
+    TEST_ASSERT_NOT_NULL(body, "Body should be parsed on demand");
+    TEST_ASSERT(ast_function_body(f) == body, "Parsed body should be cached");
+    TEST_ASSERT(ast_node_equal(expected->data.block.statements[1], f),
+                "Deferred body should match the eager parse");
+
+    ast_function_body(broken);
+    TEST_ASSERT_EQ(1, parser_get_error_count(lazy_parser), "Body errors should be reported when parsed");
+    TEST_ASSERT_EQ(7, parser_get_diagnostic(lazy_parser, 0)->line, "Body error should keep its position");
+    TEST_ASSERT(ast_node_equal(expected, program), "Fully materialized tree should match the eager parse");
+
+    ast_node_free(program);
+    parser_free(lazy_parser);
+    lexer_free(lazy_lexer);
+    ast_node_free(expected);
+    parser_free(parser);
+    lexer_free(lexer);
+}
+
+TEST_SUITE(parser_hash_consing) {
+    Lexer* lexer = lexer_create(
+        "int x = (2 * 3 + 1) * (2 * 3 + 1);\n"
+        "int y = -(2 * 3 + 1);\n"
+        "int z = f(a) + f(a);\n"
+        "int w = a * b + a * b;\n"
+        "a = 2 * 3;\n"
+        "int g(int a) { int b = a + 1; { int a = 2; b = a + 1; } return a + 1; }\n"
+        "int h(int a) { return a + 1; }\n");
+    Parser* parser = parser_create(lexer);
+    parser_enable_hash_consing(parser);
+    ASTNode* program = parser_parse_program(parser);
+
+    TEST_ASSERT(!parser_had_error(parser), "Program should parse");
+    ASTNode* x = program->data.block.statements[0]->data.declaration.initializer;
+    ASTNode* y = program->data.block.statements[1]->data.declaration.initializer;
+    ASTNode* z = program->data.block.statements[2]->data.declaration.initializer;
+    ASTNode* w = program->data.block.statements[3]->data.declaration.initializer;
+    ASTNode* assignment = program->data.block.statements[4]->data.statement.expression;
+
+    TEST_ASSERT(x->data.binary.left == x->data.binary.right, "Repeated subexpressions should be one node");
+    TEST_ASSERT(y->data.unary.operand == x->data.binary.left, "Sharing should span declarations");
+    TEST_ASSERT(x->hash_consed && y->hash_consed, "Constant expressions should be shared");
+    TEST_ASSERT(z->data.binary.left != z->data.binary.right, "Calls should never be shared");
+    TEST_ASSERT(!z->hash_consed, "Expressions over calls should not be shared");
+    TEST_ASSERT(w->data.binary.left == w->data.binary.right && w->hash_consed,
+                "Expressions over the same globals should be shared");
+    TEST_ASSERT_EQ(NODE_ASSIGNMENT_EXPRESSION, assignment->type, "Assignment should parse");
+    TEST_ASSERT(!assignment->hash_consed, "Assignments should not be shared");
+    TEST_ASSERT(assignment->data.binary.left == w->data.binary.left->data.binary.left,
+                "Assignment targets should be shared identifiers");
+
+    // Identifiers are shared per declaration and function body
+    ASTNode* body = program->data.block.statements[5]->data.function.body;
+    ASTNode* initializer = body->data.block.statements[0]->data.declaration.initializer;
+    ASTNode* inner = body->data.block.statements[1]->data.block.statements[1];
+    ASTNode* returned = body->data.block.statements[2]->data.statement.expression;
+    ASTNode* other = program->data.block.statements[6]->data.function.body->data.block.statements[0];
+    TEST_ASSERT(returned == initializer, "Uses of the same parameter should be one node");
+    TEST_ASSERT(inner->data.statement.expression->data.binary.right != initializer,
+                "A shadowing declaration should not share its name's uses");
+    TEST_ASSERT(other->data.statement.expression != initializer, "Other bodies should not share uses");
+    TEST_ASSERT(z->data.binary.left->data.call.arguments[0] != initializer->data.binary.left,
+                "A parameter should not share the global's uses");
+
+    // 2, 3, 1, 2 * 3, 2 * 3 + 1, the product, the negation, f, a, b, a * b
+    // and their sum; a, 1, a + 1, b, 2, the inner a and a + 1 in g; a, 1 and
+    // a + 1 in h
+    TEST_ASSERT_EQ(22, parser->expr_table->count, "Each distinct expression should be stored once");
+    TEST_ASSERT(parser->expr_table->hits > 0, "Repeats should hit the table");
+
+    ast_node_free(program);
+    parser_free(parser);
+    lexer_free(lexer);
+
+    // A lazily parsed body has its parameters in scope
+    lexer = lexer_create("int g(int a) { int b = a + 1; return a + 1; }\n");
+    parser = parser_create(lexer);
+    parser_enable_hash_consing(parser);
+    program = parser_parse_program_lazy(parser);
+    body = ast_function_body(program->data.block.statements[0]);
+
+    TEST_ASSERT(!parser_had_error(parser), "Program should parse");
+    TEST_ASSERT(body->data.block.statements[1]->data.statement.expression ==
+                body->data.block.statements[0]->data.declaration.initializer,
+                "Uses of the parameter should be one node");
+
+    ast_node_free(program);
+    parser_free(parser);
+    lexer_free(lexer);
+}
+
+// Walks an image record and the tree it was built from side by side
+static bool ast_image_matches(AstImage* image, const AstImageNode* record, ASTNode* node) {
+    if (record == NULL || node == NULL) return record == NULL && node == NULL;
+    if (record->type != node->type || record->line != node->line || record->column != node->column) return false;
+    if (node->token && strcmp(ast_image_string(image, record->lexeme), node->token->lexeme) != 0) return false;
+
+    switch (node->type) {
+        case NODE_BINARY_EXPRESSION:
+        case NODE_ASSIGNMENT_EXPRESSION:
+            return strcmp(ast_image_string(image, record->name), node->data.binary.operator) == 0 &&
+                   ast_image_matches(image, ast_image_node(image, record->child[0]), node->data.binary.left) &&
+                   ast_image_matches(image, ast_image_node(image, record->child[1]), node->data.binary.right);
+        case NODE_FUNCTION_DECLARATION:
+            if (strcmp(ast_image_string(image, record->name), node->data.function.name) != 0 ||
+                ast_image_list_count(record) != (uint32_t)node->data.function.parameter_count) return false;
+            for (int i = 0; i < node->data.function.parameter_count; i++) {
+                if (!ast_image_matches(image, ast_image_list_node(image, record, i),
+                                       node->data.function.parameters[i])) return false;
+            }
+            return ast_image_matches(image, ast_image_node(image, record->child[0]), node->data.function.body);
+        case NODE_PROGRAM:
+        case NODE_BLOCK_STATEMENT:
+            if (ast_image_list_count(record) != (uint32_t)node->data.block.statement_count) return false;
+            for (int i = 0; i < node->data.block.statement_count; i++) {
+                if (!ast_image_matches(image, ast_image_list_node(image, record, i),
+                                       node->data.block.statements[i])) return false;
+            }
+            return true;
+        case NODE_VARIABLE_DECLARATION:
+            return strcmp(ast_image_string(image, record->name), node->data.declaration.name) == 0 &&
+                   strcmp(ast_image_string(image, record->type_name), node->data.declaration.type_name) == 0 &&
+                   ast_image_matches(image, ast_image_node(image, record->child[0]), node->data.declaration.initializer);
+        case NODE_IF_STATEMENT:
+        case NODE_WHILE_STATEMENT:
+            return ast_image_matches(image, ast_image_node(image, record->child[0]), node->data.conditional.condition) &&
+                   ast_image_matches(image, ast_image_node(image, record->child[1]), node->data.conditional.then_branch) &&
+                   ast_image_matches(image, ast_image_node(image, record->child[2]), node->data.conditional.else_branch);
+        case NODE_RETURN_STATEMENT:
+        case NODE_EXPRESSION_STATEMENT:
+            return ast_image_matches(image, ast_image_node(image, record->child[0]), node->data.statement.expression);
+        case NODE_LITERAL:
+            return (int)record->value == node->data.literal.int_value;
+        case NODE_IDENTIFIER:
+            return strcmp(ast_image_string(image, record->name), node->data.identifier_name) == 0;
+        default:
+            return true;
+    }
+}
+
+TEST_SUITE(parser_ast_cache) {
+    const char* source =
+        "int total = 0;\n"
+        "int add(int a, int b) {\n"
+        "    int sum = a + b * 2;\n"
+        "    if (sum > total) { total = sum; } else { while (sum < 10) { sum = sum + 1; } }\n"
+        "    return -sum;\n"
+        "}\n"
+        "int twice(int a) { return add(a, a); }\n";
+    uint64_t hash = hash_bytes(source, strlen(source));
+
+    Lexer* lexer = lexer_create(source);
+    Parser* parser = parser_create(lexer);
+    ASTNode* program = parser_parse_program_lazy(parser);
+
+    AstImage* built = ast_image_build(program, hash);
+    TEST_ASSERT_NOT_NULL(built, "Image should be built");
+    TEST_ASSERT(ast_image_matches(built, ast_image_root(built), program), "Image should mirror the tree");
+
+    // Repeated names are stored once
+    int sum_strings = 0;
+    for (uint32_t i = 0; i < built->header->string_count; i++) {
+        if (strcmp(ast_image_string(built, i), "sum") == 0) sum_strings++;
+    }
+    TEST_ASSERT_EQ(1, sum_strings, "Strings should be interned");
+
+    char path[256];
+    TEST_ASSERT(ast_cache_path(path, sizeof(path), "/tmp", hash), "Cache path should fit");
+    TEST_ASSERT(ast_image_write(built, path), "Image should be written");
+
+    AstImage* mapped = ast_image_open(path, hash);
+    TEST_ASSERT_NOT_NULL(mapped, "Image should be mapped back");
+    TEST_ASSERT(ast_image_matches(mapped, ast_image_root(mapped), program), "Mapped image should mirror the tree");
+    TEST_ASSERT_NULL(ast_image_node(mapped, mapped->header->node_count), "Out of range nodes should be rejected");
+    TEST_ASSERT_NULL(ast_image_open(path, hash + 1), "A different source hash should be rejected");
+
+    // A truncated file is rejected rather than read past its end
+    FILE* file = fopen(path, "wb");
+    TEST_ASSERT_NOT_NULL(file, "Image should be rewritten");
+    fwrite(built->memory, 1, built->size - 4, file);
+    fclose(file);
+    TEST_ASSERT_NULL(ast_image_open(path, hash), "Truncated images should be rejected");
+
+    remove(path);
+    ast_image_free(mapped);
+    ast_image_free(built);
+    ast_node_free(program);
+    parser_free(parser);
+    lexer_free(lexer);
+}
+
+// Parses before, applies the edit that turns it into after and checks the
+// result against a fresh parse of after. *reused is set if the first
+// declaration survived the edit as the same node.
+static bool parser_incremental_matches(const char* before, const char* after, TextEdit edit, bool* reused) {
+    Lexer* lexer = lexer_create(before);
+    Parser* parser = parser_create(lexer);
+    ASTNode* program = parser_parse_program(parser);
+    ASTNode* first = program->data.block.statements[0];
+
+    Lexer* edited = lexer_create(after);
+    program = parser_reparse(parser, program, edited, &edit);
+    lexer_free(lexer);
+    *reused = program->data.block.statements[0] == first;
+
+    Lexer* fresh_lexer = lexer_create(after);
+    Parser* fresh_parser = parser_create(fresh_lexer);
+    ASTNode* fresh = parser_parse_program(fresh_parser);
+
+    bool matches = ast_node_equal(fresh, program) &&
+                   parser_get_error_count(parser) == parser_get_error_count(fresh_parser) &&
+                   parser->stream->count == fresh_parser->stream->count;
+    for (int i = 0; matches && i < parser->stream->count; i++) {
+        Token* token = parser->stream->tokens[i];
+        Token* expected = fresh_parser->stream->tokens[i];
+        matches = token->type == expected->type && token->line == expected->line &&
+                  token->column == expected->column && strcmp(token->lexeme, expected->lexeme) == 0;
+    }
+
+    ast_node_free(fresh);
+    parser_free(fresh_parser);
+    lexer_free(fresh_lexer);
+    ast_node_free(program);
+    parser_free(parser);
+    lexer_free(edited);
+    return matches;
+}
+
+TEST_SUITE(parser_incremental) {
+    const char* source =
+        "int f(int a) {\n"
+        "    int x = a + 1;\n"
+        "    if (x > 2) {\n"
+        "        x = x * 3;\n"
+        "    } else {\n"
+        "        x = 0;\n"
+        "    }\n"
+        "    return x;\n"
+        "}\n"
+        "\n"
+        "int g(int b) {\n"
+        "    return f(b) + 4;\n"
+        "}\n";
+    bool reused = false;
+
+    TextEdit literal = { 4, 4, 4 };
+    TEST_ASSERT(parser_incremental_matches(source,
+        "int f(int a) {\n    int x = a + 1;\n    if (x > 2) {\n        x = x * 7;\n"
+        "    } else {\n        x = 0;\n    }\n    return x;\n}\n\nint g(int b) {\n    return f(b) + 4;\n}\n",
+        literal, &reused), "Edit inside a nested block should match a fresh parse");
+    TEST_ASSERT(reused, "The enclosing function should be kept");
+
+    TextEdit inserted = { 2, 2, 3 };
+    TEST_ASSERT(parser_incremental_matches(source,
+        "int f(int a) {\n    int x = a + 1;\n    int y = x;\n    if (x > 2) {\n        x = x * 3;\n"
+        "    } else {\n        x = 0;\n    }\n    return x;\n}\n\nint g(int b) {\n    return f(b) + 4;\n}\n",
+        inserted, &reused), "Inserted lines should shift the rest of the program");
+    TEST_ASSERT(reused, "The enclosing function should be kept");
+
+    TextEdit deleted = { 6, 6, 5 };
+    TEST_ASSERT(parser_incremental_matches(source,
+        "int f(int a) {\n    int x = a + 1;\n    if (x > 2) {\n        x = x * 3;\n"
+        "    } else {\n    }\n    return x;\n}\n\nint g(int b) {\n    return f(b) + 4;\n}\n",
+        deleted, &reused), "Deleted lines should shift the rest of the program");
+
+    TextEdit top_level = { 12, 12, 12 };
+    TEST_ASSERT(parser_incremental_matches(source,
+        "int f(int a) {\n    int x = a + 1;\n    if (x > 2) {\n        x = x * 3;\n"
+        "    } else {\n        x = 0;\n    }\n    return x;\n}\n\nint g(int b) {\n    return b;\n}\n",
+        top_level, &reused), "Edit in a later function should match a fresh parse");
+    TEST_ASSERT(reused, "Functions before the edit should be kept");
+
+    TextEdit new_declaration = { 10, 10, 11 };
+    TEST_ASSERT(parser_incremental_matches(source,
+        "int f(int a) {\n    int x = a + 1;\n    if (x > 2) {\n        x = x * 3;\n"
+        "    } else {\n        x = 0;\n    }\n    return x;\n}\n\nint z = 5;\n\nint g(int b) {\n    return f(b) + 4;\n}\n",
+        new_declaration, &reused), "A declaration added between functions should match a fresh parse");
+
+    // Edits the fast path cannot take fall back to a full parse
+    TextEdit broken = { 2, 2, 2 };
+    TEST_ASSERT(parser_incremental_matches(source,
+        "int f(int a) {\n    int x = a + ;\n    if (x > 2) {\n        x = x * 3;\n"
+        "    } else {\n        x = 0;\n    }\n    return x;\n}\n\nint g(int b) {\n    return f(b) + 4;\n}\n",
+        broken, &reused), "Syntax errors should be reported as by a fresh parse");
+
+    TextEdit unbalanced = { 4, 4, 4 };
+    TEST_ASSERT(parser_incremental_matches(source,
+        "int f(int a) {\n    int x = a + 1;\n    if (x > 2) {\n        x = x * 3; {\n"
+        "    } else {\n        x = 0;\n    }\n    return x;\n}\n\nint g(int b) {\n    return f(b) + 4;\n}\n",
+        unbalanced, &reused), "Unbalanced braces should match a fresh parse");
+}
+
+TEST_SUITE(parser_constant_folding) {
+    const char* source =
+        "int a = 5 + 3;\n"
+        "int b = 2147483647 + 1;\n"
+        "int c = 7 / 0;\n"
+        "int d = (1 + 2) * 3 - -4;\n"
+        "bool e = 3 < 4 && !false;\n"
+        "float f = 1.5 * 2.0;\n"
+        "float g = 1.0 / 0.0;\n"
+        "int h = x + 1 + 2;\n"
+        "int i = 1 << 40;\n"
+        "int j = 65536 * 65536;\n"
+        "int k = -2147483647 - 2;\n"
+        "int l = 0 - 2147483647 - 1;\n";
+
+    Lexer* lexer = lexer_create(source);
+    Parser* parser = parser_create(lexer);
+    parser_enable_constant_folding(parser);
+    ASTNode* program = parser_parse_program(parser);
+    TEST_ASSERT(!parser_had_error(parser), "Program should parse");
+
+    ASTNode* values[12];
+    for (int i = 0; i < 12; i++) {
+        values[i] = program->data.block.statements[i]->data.declaration.initializer;
+    }
+
+    TEST_ASSERT_EQ(NODE_LITERAL, values[0]->type, "Integer arithmetic should fold");
+    TEST_ASSERT_EQ(8, values[0]->data.literal.int_value, "5 + 3 should fold to 8");
+    TEST_ASSERT_EQ(TOKEN_INTEGER_LITERAL, values[0]->token->type, "Folded integers should stay integers");
+    TEST_ASSERT_EQ(1, values[0]->line, "Folded literals should keep the operator's line");
+    // Generated code computes in 64 bits, so results past 32 bits are not folded
+    TEST_ASSERT_EQ(NODE_BINARY_EXPRESSION, values[1]->type, "2147483647 + 1 should not fold");
+    TEST_ASSERT_EQ(NODE_BINARY_EXPRESSION, values[2]->type, "Division by zero should be left to run time");
+    TEST_ASSERT_EQ(13, values[3]->data.literal.int_value, "Nested and unary operators should fold");
+    TEST_ASSERT_EQ(TOKEN_TRUE, values[4]->token->type, "Comparisons and logic should fold to booleans");
+    TEST_ASSERT_EQ(TOKEN_FLOAT_LITERAL, values[5]->token->type, "Float arithmetic should stay float");
+    TEST_ASSERT(values[5]->data.literal.float_value == 3.0f, "1.5 * 2.0 should fold to 3.0");
+    TEST_ASSERT(isinf(values[6]->data.literal.float_value), "Float division by zero should follow IEEE rules");
+    TEST_ASSERT_EQ(NODE_BINARY_EXPRESSION, values[7]->type, "Expressions over variables should not fold");
+    TEST_ASSERT_EQ(NODE_BINARY_EXPRESSION, values[8]->type, "Out of range shifts should be left to run time");
+    TEST_ASSERT_EQ(NODE_BINARY_EXPRESSION, values[9]->type, "65536 * 65536 should not fold");
+    TEST_ASSERT_EQ(NODE_BINARY_EXPRESSION, values[10]->type, "-2147483647 - 2 should not fold");
+    TEST_ASSERT_EQ(NODE_LITERAL, values[10]->data.binary.left->type, "Its operand -2147483647 fits and folds");
+    TEST_ASSERT_EQ(INT32_MIN, values[11]->data.literal.int_value, "Results that fit fold up to INT32_MIN");
+
+    ast_node_free(program);
+    parser_free(parser);
+    lexer_free(lexer);
+
+    // Folding is off by default
+    lexer = lexer_create("int a = 5 + 3;");
+    parser = parser_create(lexer);
+    program = parser_parse_program(parser);
+    TEST_ASSERT_EQ(NODE_BINARY_EXPRESSION, program->data.block.statements[0]->data.declaration.initializer->type,
+                   "Operators should not fold unless enabled");
+    ast_node_free(program);
+    parser_free(parser);
+    lexer_free(lexer);
+}
+
+// Collects streamed declarations; stops after limit of them if limit > 0
+typedef struct {
+    ASTNode* declarations[16];
+    int count;
+    int limit;
+} StreamedDeclarations;
+
+static bool parser_collect_declaration(ASTNode* declaration, void* context) {
+    StreamedDeclarations* streamed = context;
+    streamed->declarations[streamed->count++] = declaration;
+    return streamed->limit == 0 || streamed->count < streamed->limit;
+}
+
+TEST_SUITE(parser_streaming) {
+    const char* source =
+        "int a = 1;\n"
+        "int f(int x) { return x + a; }\n"
+        "; float b = 2.5;\n"
+        "int c = (3 * ;\n"
+        "int g() { return f(1); }\n";
+
+    Lexer* reference_lexer = lexer_create(source);
+    Parser* reference_parser = parser_create(reference_lexer);
+    ASTNode* reference = parser_parse_program(reference_parser);
+
+    for (int pipelined = 0; pipelined <= 1; pipelined++) {
+        StreamedDeclarations streamed = { .count = 0, .limit = 0 };
+        Lexer* lexer = lexer_create(source);
+        Parser* parser = parser_create(lexer);
+        bool completed = pipelined ? parser_parse_program_pipelined(parser, parser_collect_declaration, &streamed, 2)
+                                   : parser_parse_program_streaming(parser, parser_collect_declaration, &streamed);
+
+        TEST_ASSERT(completed, "Streaming parse should run to the end");
+        TEST_ASSERT_EQ(reference->data.block.statement_count, streamed.count,
+                       "Every declaration should be streamed");
+        for (int i = 0; i < streamed.count; i++) {
+            TEST_ASSERT(ast_node_equal(reference->data.block.statements[i], streamed.declarations[i]),
+                        "Streamed declarations should arrive in source order");
+            ast_node_free(streamed.declarations[i]);
+        }
+        TEST_ASSERT_EQ(parser_get_error_count(reference_parser), parser_get_error_count(parser),
+                       "Syntax errors should be reported as by a full parse");
+
+        parser_free(parser);
+        lexer_free(lexer);
+    }
+
+    // The callback can stop the parse early
+    for (int pipelined = 0; pipelined <= 1; pipelined++) {
+        StreamedDeclarations streamed = { .count = 0, .limit = 2 };
+        Lexer* lexer = lexer_create(source);
+        Parser* parser = parser_create(lexer);
+        bool completed = pipelined ? parser_parse_program_pipelined(parser, parser_collect_declaration, &streamed, 1)
+                                   : parser_parse_program_streaming(parser, parser_collect_declaration, &streamed);
+
+        TEST_ASSERT(!completed, "A stopped parse should report it");
+        TEST_ASSERT_EQ(2, streamed.count, "No declarations should follow a stop");
+        for (int i = 0; i < streamed.count; i++) {
+            ast_node_free(streamed.declarations[i]);
+        }
+        parser_free(parser);
+        lexer_free(lexer);
+    }
+
+    ast_node_free(reference);
+    parser_free(reference_parser);
+    lexer_free(reference_lexer);
+}
+
 // Add this test suite to the runner
 void run_parser_basic_tests(void) {
     run_suite_parser_creation();
@@ -214,4 +870,14 @@ void run_parser_basic_tests(void) {
     run_suite_parser_complex_expressions();
     run_suite_parser_node_utilities();
     run_suite_parser_type_to_string();
+    run_suite_parser_program();
+    run_suite_parser_program_errors();
+    run_suite_parser_diagnostics_bounded();
+    run_suite_parser_parallel();
+    run_suite_parser_lazy_bodies();
+    run_suite_parser_ast_cache();
+    run_suite_parser_hash_consing();
+    run_suite_parser_incremental();
+    run_suite_parser_streaming();
+    run_suite_parser_constant_folding();
 }
\ No newline at end of file
@@ -1,4 +1,9 @@
 #include "../../src/semantic/semantic.h"
+#include "../../src/semantic/dataflow.h"
+#include "../../src/semantic/incremental.h"
+#include "../../src/semantic/module.h"
+#include "../../src/semantic/effects.h"
+#include "../../src/semantic/ranges.h"
 #include "../test_framework.h"
 
 TEST_SUITE(symbol_table_creation) {
@@ -53,6 +58,95 @@ TEST_SUITE(symbol_table_add_lookup) {
     symbol_table_free(table);
 }
 
+TEST_SUITE(symbol_table_many_symbols) {
+    // Enough symbols to grow the hash index several times
+    SymbolTable* table = symbol_table_create(0);
+    char name[32];
+    for (int i = 0; i < 5000; i++) {
+        snprintf(name, sizeof(name), "sym_%d", i);
+        symbol_table_add(table, symbol_create_variable(name, "int", true, i + 1, 1));
+    }
+    TEST_ASSERT_EQ(5000, table->symbol_count, "All symbols should be added");
+
+    bool all_found = true;
+    for (int i = 0; i < 5000; i++) {
+        snprintf(name, sizeof(name), "sym_%d", i);
+        Symbol* found = symbol_table_lookup_local(table, name);
+        all_found = all_found && found != NULL && found->line == i + 1;
+    }
+    TEST_ASSERT(all_found, "Every symbol should be found after the table grows");
+    TEST_ASSERT_NULL(symbol_table_lookup_local(table, "sym_5000"), "Absent names should not be found");
+    TEST_ASSERT_STR_EQ("sym_1234", table->symbols[1234]->name, "Symbols should stay in insertion order");
+
+    // A repeated name resolves to the first declaration
+    Symbol* duplicate = symbol_create_variable("sym_42", "float", true, 9999, 1);
+    symbol_table_add(table, duplicate);
+    TEST_ASSERT_EQ(43, symbol_table_lookup_local(table, "sym_42")->line, "The first declaration should win");
+
+    // Parents are searched after the local scope
+    SymbolTable* inner = symbol_table_create(1);
+    inner->parent = table;
+    Symbol* shadow = symbol_create_variable("sym_7", "float", true, 1, 1);
+    symbol_table_add(inner, shadow);
+    TEST_ASSERT(symbol_table_lookup(inner, "sym_7") == shadow, "Locals should shadow globals");
+    TEST_ASSERT_EQ(4001, symbol_table_lookup(inner, "sym_4000")->line, "Globals should be found from inner scopes");
+    TEST_ASSERT_NULL(symbol_table_lookup_local(inner, "sym_4000"), "Local lookup should not search parents");
+
+    symbol_table_free(inner);
+    symbol_table_free(table);
+}
+
+TEST_SUITE(type_descriptors) {
+    // Equal types are the same descriptor, however the name was spelled out
+    char int_name[] = "int";
+    TEST_ASSERT(type_from_name(int_name) == type_primitive(TYPE_INT), "Primitive names should map to the primitive");
+    TEST_ASSERT_EQ(TYPE_FLOAT, type_from_name("float")->primitive, "Descriptors should carry their DataType");
+    TEST_ASSERT_NULL(type_from_name(NULL), "A missing name has no type");
+
+    char widget_name[] = "Widget";
+    const TypeDescriptor* widget = type_from_name("Widget");
+    TEST_ASSERT(type_from_name(widget_name) == widget, "Named types should be interned");
+    TEST_ASSERT_EQ(TYPE_KIND_NAMED, widget->kind, "Unknown names should become named types");
+    TEST_ASSERT_EQ(TYPE_UNKNOWN, widget->primitive, "Named types are not primitives");
+    TEST_ASSERT(type_from_name("integer") != type_primitive(TYPE_INT), "Prefixes of primitive names are distinct");
+
+    // Compound types are interned by their components
+    const TypeDescriptor* int_pointer = type_pointer_to(type_primitive(TYPE_INT));
+    TEST_ASSERT(type_pointer_to(type_from_name("int")) == int_pointer, "Pointer types should be interned");
+    TEST_ASSERT_STR_EQ("int*", int_pointer->name, "Pointer spelling");
+    TEST_ASSERT(type_array_of(int_pointer, 4) == type_array_of(int_pointer, 4), "Array types should be interned");
+    TEST_ASSERT(type_array_of(int_pointer, 4) != type_array_of(int_pointer, 5), "Array lengths should distinguish types");
+    TEST_ASSERT_STR_EQ("int*[4]", type_array_of(int_pointer, 4)->name, "Array spelling");
+
+    const TypeDescriptor* parameters[] = { type_primitive(TYPE_FLOAT), widget };
+    const TypeDescriptor* function = type_function(type_primitive(TYPE_BOOL), parameters, 2);
+    TEST_ASSERT(type_function(type_primitive(TYPE_BOOL), parameters, 2) == function, "Function types should be interned");
+    TEST_ASSERT(type_function(type_primitive(TYPE_BOOL), parameters, 1) != function, "Arity should distinguish types");
+    TEST_ASSERT_STR_EQ("bool(float,Widget)", function->name, "Function spelling");
+
+    // Symbols store the descriptor, and identifiers are typed from it
+    SemanticAnalyzer* analyzer = semantic_analyzer_create();
+    Symbol* letter = symbol_create_variable("letter", "char", true, 1, 1);
+    Symbol* gadget = symbol_create_variable("gadget", widget_name, true, 2, 1);
+    symbol_table_add(analyzer->current_scope, letter);
+    symbol_table_add(analyzer->current_scope, gadget);
+    TEST_ASSERT(letter->data.variable.type == type_primitive(TYPE_CHAR), "Symbols should hold the descriptor");
+    TEST_ASSERT(gadget->data.variable.type_name == widget->name, "Type names should be the descriptor's spelling");
+
+    Token* letter_token = token_create(TOKEN_IDENTIFIER, "letter", 3, 1);
+    ASTNode* letter_reference = ast_node_create_identifier(letter_token, "letter");
+    TEST_ASSERT_EQ(TYPE_CHAR, ast_node_get_type(letter_reference, analyzer), "char variables should type as char");
+    Token* gadget_token = token_create(TOKEN_IDENTIFIER, "gadget", 3, 1);
+    ASTNode* gadget_reference = ast_node_create_identifier(gadget_token, "gadget");
+    TEST_ASSERT_EQ(TYPE_UNKNOWN, ast_node_get_type(gadget_reference, analyzer), "Named types have no DataType");
+
+    ast_node_free(letter_reference);
+    ast_node_free(gadget_reference);
+    token_free(letter_token);
+    token_free(gadget_token);
+    semantic_analyzer_free(analyzer);
+}
+
 TEST_SUITE(semantic_analyzer_creation) {
     // Test semantic analyzer creation
     SemanticAnalyzer* analyzer = semantic_analyzer_create();
@@ -102,6 +196,62 @@ TEST_SUITE(scope_management) {
     semantic_analyzer_free(analyzer);
 }
 
+TEST_SUITE(nested_scope_bindings) {
+    SemanticAnalyzer* analyzer = semantic_analyzer_create();
+    Symbol* global_x = symbol_create_variable("x", "int", true, 1, 1);
+    symbol_table_add(analyzer->current_scope, global_x);
+
+    // Each level shadows x; lookups see the innermost one
+    Symbol* shadows[40];
+    for (int depth = 0; depth < 40; depth++) {
+        semantic_analyzer_enter_scope(analyzer);
+        shadows[depth] = symbol_create_variable("x", "int", true, depth + 2, 1);
+        symbol_table_add(analyzer->current_scope, shadows[depth]);
+    }
+    TEST_ASSERT_EQ(40, analyzer->current_scope->scope_level, "Scopes should nest 40 deep");
+    TEST_ASSERT(symbol_table_lookup(analyzer->current_scope, "x") == shadows[39], "Innermost x should win");
+    TEST_ASSERT(symbol_table_lookup(analyzer->scope_stack[10], "x") == shadows[9],
+                "Outer scopes should not see inner bindings");
+    TEST_ASSERT_NULL(symbol_table_lookup_local(analyzer->current_scope->parent, "y"), "Absent names should not be found");
+
+    // A second x in the same scope does not replace the first
+    symbol_table_add(analyzer->current_scope, symbol_create_variable("x", "float", true, 99, 1));
+    TEST_ASSERT(symbol_table_lookup_local(analyzer->current_scope, "x") == shadows[39], "The first declaration should win");
+
+    // Leaving scopes restores the shadowed bindings
+    for (int depth = 39; depth >= 20; depth--) {
+        semantic_analyzer_exit_scope(analyzer);
+    }
+    TEST_ASSERT(symbol_table_lookup(analyzer->current_scope, "x") == shadows[19], "Exit should restore the outer x");
+
+    // Re-entering reuses the closed table, which starts empty
+    SymbolTable* closed = analyzer->scope_stack[21];
+    semantic_analyzer_enter_scope(analyzer);
+    TEST_ASSERT(analyzer->current_scope == closed, "Closed scope tables should be reused");
+    TEST_ASSERT_EQ(0, analyzer->current_scope->symbol_count, "A reused scope should start empty");
+    TEST_ASSERT(symbol_table_lookup(analyzer->current_scope, "x") == shadows[19], "A reused scope should see outer bindings");
+
+    // Symbols added to an outer scope while an inner one is open are still found
+    Symbol* late = symbol_create_variable("late", "int", true, 7, 1);
+    symbol_table_add(analyzer->scope_stack[0], late);
+    TEST_ASSERT(symbol_table_lookup(analyzer->current_scope, "late") == late, "Late globals should be visible");
+    TEST_ASSERT(symbol_table_lookup(analyzer->current_scope, "x") == shadows[19], "Shadowing should hold with late globals");
+
+    while (analyzer->scope_stack_size > 1) {
+        semantic_analyzer_exit_scope(analyzer);
+    }
+    TEST_ASSERT(symbol_table_lookup(analyzer->current_scope, "x") == global_x, "Only the global x should remain");
+    TEST_ASSERT(symbol_table_lookup(analyzer->current_scope, "late") == late, "Late globals should stay after exits");
+
+    // Once the inner scopes close, late globals are bound again
+    TEST_ASSERT_EQ(0, analyzer->bindings->stray_count, "Late globals should be rebound");
+    semantic_analyzer_enter_scope(analyzer);
+    TEST_ASSERT(symbol_table_lookup(analyzer->current_scope, "late") == late, "Late globals should stay visible");
+    semantic_analyzer_exit_scope(analyzer);
+
+    semantic_analyzer_free(analyzer);
+}
+
 TEST_SUITE(type_inference) {
     // Test type inference for literals
     SemanticAnalyzer* analyzer = semantic_analyzer_create();
@@ -132,6 +282,349 @@ TEST_SUITE(type_inference) {
     semantic_analyzer_free(analyzer);
 }
 
+TEST_SUITE(expression_type_annotations) {
+    SemanticAnalyzer* analyzer = semantic_analyzer_create();
+    Symbol* a = symbol_create_variable("a", "int", true, 1, 1);
+    symbol_table_add(analyzer->current_scope, a);
+    symbol_table_add(analyzer->current_scope, symbol_create_variable("b", "int", true, 1, 1));
+
+    Lexer* lexer = lexer_create("a + b * 2;\nc + 1;\n");
+    Parser* parser = parser_create(lexer);
+    ASTNode* program = parser_parse_program(parser);
+    ASTNode* sum = program->data.block.statements[0]->data.statement.expression;
+    ASTNode* pending = program->data.block.statements[1]->data.statement.expression;
+
+    // Typing the root annotates every node under it
+    TEST_ASSERT_EQ(TYPE_INT, ast_node_get_type(sum, analyzer), "a + b * 2 should be int");
+    TEST_ASSERT_EQ(TYPE_INT + 1, sum->resolved_type, "The root should be annotated");
+    TEST_ASSERT_EQ(TYPE_INT + 1, sum->data.binary.right->resolved_type, "Operands should be annotated");
+    TEST_ASSERT(sum->data.binary.left->resolved_symbol == a, "Identifiers should record their symbol");
+
+    // Later queries read the annotation without looking names up again
+    sum->data.binary.left->data.identifier_name[0] = 'z';
+    TEST_ASSERT_EQ(TYPE_INT, ast_node_get_type(sum->data.binary.left, analyzer), "Annotations should be reused");
+    sum->data.binary.left->data.identifier_name[0] = 'a';
+
+    // An undeclared name leaves itself and its ancestors open
+    ast_node_get_type(pending, analyzer);
+    TEST_ASSERT_EQ(0, pending->resolved_type, "Expressions over unresolved names should not be annotated");
+    TEST_ASSERT_EQ(TYPE_INT + 1, pending->data.binary.right->resolved_type, "Literals should still be annotated");
+    symbol_table_add(analyzer->current_scope, symbol_create_variable("c", "int", true, 2, 1));
+    TEST_ASSERT_EQ(TYPE_INT, ast_node_get_type(pending, analyzer), "A later declaration should be picked up");
+    TEST_ASSERT_EQ(TYPE_INT + 1, pending->resolved_type, "Resolved expressions should be annotated");
+
+    ast_node_clear_types(program);
+    TEST_ASSERT_EQ(0, sum->resolved_type, "Clearing should reset the root");
+    TEST_ASSERT_NULL(sum->data.binary.left->resolved_symbol, "Clearing should reset resolved symbols");
+
+    ast_node_free(program);
+    parser_free(parser);
+    lexer_free(lexer);
+
+    // Shared expressions are constant, so every use has the same type
+    lexer = lexer_create("1 + 2 < 4;\n");
+    parser = parser_create(lexer);
+    parser_enable_hash_consing(parser);
+    program = parser_parse_program(parser);
+    ASTNode* shared = program->data.block.statements[0]->data.statement.expression;
+    TEST_ASSERT(shared->hash_consed, "The comparison should be shared");
+    TEST_ASSERT_EQ(TYPE_BOOL, ast_node_get_type(shared, analyzer), "Shared expressions should be typed");
+    TEST_ASSERT_EQ(TYPE_BOOL + 1, shared->resolved_type, "Shared expressions should be annotated");
+
+    ast_node_free(program);
+    parser_free(parser);
+    lexer_free(lexer);
+    semantic_analyzer_free(analyzer);
+}
+
+TEST_SUITE(name_resolution_slots) {
+    SemanticAnalyzer* analyzer = semantic_analyzer_create();
+    Lexer* lexer = lexer_create(
+        "int g = 1;\n"
+        "int add(int a, int b) {\n"
+        "    int sum = a + b;\n"
+        "    { int sum = g; sum = sum + a; }\n"
+        "    return sum;\n"
+        "}\n"
+        "int h = g;\n");
+    Parser* parser = parser_create(lexer);
+    ASTNode* program = parser_parse_program(parser);
+    TEST_ASSERT(semantic_resolve(program, analyzer), "The program should resolve");
+
+    ASTNode* g = program->data.block.statements[0];
+    ASTNode* add = program->data.block.statements[1];
+    ASTNode* h = program->data.block.statements[2];
+    TEST_ASSERT(g->resolved_global && g->resolved_slot == 0, "g should be global 0");
+    TEST_ASSERT(h->resolved_global && h->resolved_slot == 1, "h should be global 1");
+    TEST_ASSERT(h->data.declaration.initializer->resolved_global, "g should resolve as a global");
+    TEST_ASSERT_EQ(0, h->data.declaration.initializer->resolved_slot, "g should resolve to its slot");
+
+    // Parameters take the first frame slots, then locals in declaration order
+    TEST_ASSERT_EQ(1, add->data.function.parameters[1]->resolved_slot, "b should be frame slot 1");
+    ASTNode** body = add->data.function.body->data.block.statements;
+    TEST_ASSERT(!body[0]->resolved_global && body[0]->resolved_slot == 2, "sum should be frame slot 2");
+    TEST_ASSERT_EQ(1, body[0]->data.declaration.initializer->data.binary.right->resolved_slot, "b should resolve to slot 1");
+
+    // The inner sum shadows the outer one with a slot of its own
+    ASTNode** inner = body[1]->data.block.statements;
+    ASTNode* assignment = inner[1]->data.statement.expression;
+    TEST_ASSERT_EQ(3, inner[0]->resolved_slot, "The inner sum should be frame slot 3");
+    TEST_ASSERT_EQ(3, assignment->data.binary.left->resolved_slot, "Writes should go to the inner sum");
+    TEST_ASSERT_EQ(0, assignment->data.binary.right->data.binary.right->resolved_slot, "a should resolve to slot 0");
+    TEST_ASSERT(inner[0]->data.declaration.initializer->resolved_global, "Globals should resolve inside functions");
+    TEST_ASSERT_EQ(2, body[2]->data.statement.expression->resolved_slot, "The outer sum should be visible again");
+    TEST_ASSERT_EQ(4, add->resolved_slot, "The function should need four frame slots");
+
+    // Identifiers were typed while their scopes were open
+    TEST_ASSERT_EQ(TYPE_INT + 1, body[2]->data.statement.expression->resolved_type, "Resolved identifiers should be typed");
+    TEST_ASSERT_EQ(2, analyzer->global_count, "Only g and h should be globals");
+
+    ast_node_free(program);
+    parser_free(parser);
+    lexer_free(lexer);
+
+    // Redeclaring a name in the same scope is an error
+    lexer = lexer_create("int a = 1;\nint a = 2;\n");
+    parser = parser_create(lexer);
+    program = parser_parse_program(parser);
+    TEST_ASSERT(!semantic_resolve(program, analyzer), "A redeclaration should fail");
+    TEST_ASSERT(analyzer->last_error && strstr(analyzer->last_error->message, "Redeclaration") != NULL,
+                "The error should report the redeclaration");
+    TEST_ASSERT_EQ(-1, program->data.block.statements[1]->resolved_slot, "The duplicate should get no slot");
+
+    ast_node_free(program);
+    parser_free(parser);
+    lexer_free(lexer);
+    semantic_analyzer_free(analyzer);
+}
+
+// Folds every node's annotations into one number, in tree order
+static unsigned long annotation_digest(ASTNode* node) {
+    if (node == NULL) return 7;
+
+    unsigned long digest = (unsigned long)node->type * 31 + (unsigned long)(node->resolved_slot + 2) * 131 +
+                           (unsigned long)node->resolved_type * 17 + node->resolved_global;
+    switch (node->type) {
+        case NODE_PROGRAM:
+        case NODE_BLOCK_STATEMENT:
+            for (int i = 0; i < node->data.block.statement_count; i++) {
+                digest = digest * 1000003 + annotation_digest(node->data.block.statements[i]);
+            }
+            break;
+        case NODE_FUNCTION_DECLARATION:
+            for (int i = 0; i < node->data.function.parameter_count; i++) {
+                digest = digest * 1000003 + annotation_digest(node->data.function.parameters[i]);
+            }
+            digest = digest * 1000003 + annotation_digest(node->data.function.body);
+            break;
+        case NODE_VARIABLE_DECLARATION:
+            digest = digest * 1000003 + annotation_digest(node->data.declaration.initializer);
+            break;
+        case NODE_EXPRESSION_STATEMENT:
+        case NODE_RETURN_STATEMENT:
+            digest = digest * 1000003 + annotation_digest(node->data.statement.expression);
+            break;
+        case NODE_BINARY_EXPRESSION:
+        case NODE_ASSIGNMENT_EXPRESSION:
+            digest = digest * 1000003 + annotation_digest(node->data.binary.left);
+            digest = digest * 1000003 + annotation_digest(node->data.binary.right);
+            break;
+        default:
+            break;
+    }
+    return digest;
+}
+
+TEST_SUITE(parallel_semantic_analysis) {
+    const char* source =
+        "int g = 1;\n"
+        "int f(int a) { int b = a + g; return b; }\n"
+        "int k(int a) { return later; }\n"
+        "int later = 2;\n"
+        "int m(int x) { { int y = x; } return y; }\n"
+        "int n(int z) { int w = z + later; return f(w); }\n";
+
+    // Analysis in order is the reference
+    Lexer* lexer = lexer_create(source);
+    Parser* parser = parser_create(lexer);
+    ASTNode* program = parser_parse_program(parser);
+    SemanticAnalyzer* analyzer = semantic_analyzer_create();
+    bool expected_result = semantic_analyze(program, analyzer);
+    unsigned long expected_digest = annotation_digest(program);
+    TEST_ASSERT(!expected_result && analyzer->had_error, "Analysis in order should find the errors");
+    TEST_ASSERT_EQ(5, analyzer->last_error->line, "The last error should be the undeclared y");
+    semantic_analyzer_free(analyzer);
+    ast_node_free(program);
+    parser_free(parser);
+    lexer_free(lexer);
+
+    for (int threads = 1; threads <= 4; threads *= 2) {
+        lexer = lexer_create(source);
+        parser = parser_create(lexer);
+        program = parser_parse_program_lazy(parser);
+        analyzer = semantic_analyzer_create();
+
+        bool result = semantic_analyze_parallel(program, analyzer, threads);
+        TEST_ASSERT(result == expected_result && analyzer->had_error, "Parallel analysis should fail the same way");
+        TEST_ASSERT(analyzer->last_error && analyzer->last_error->line == 5 &&
+                    strstr(analyzer->last_error->message, "'y'") != NULL, "The same last error should be reported");
+        TEST_ASSERT(annotation_digest(program) == expected_digest, "Annotations should match analysis in order");
+
+        ASTNode* n = program->data.block.statements[5];
+        ASTNode* sum = n->data.function.body->data.block.statements[0]->data.declaration.initializer;
+        TEST_ASSERT(sum->data.binary.right->resolved_global && sum->data.binary.right->resolved_slot == 1,
+                    "Bodies should see earlier globals");
+        TEST_ASSERT_EQ(TYPE_INT, ast_node_get_type(sum, analyzer), "Body expressions should stay typed after analysis");
+        TEST_ASSERT_EQ(2, analyzer->global_count, "Only the main analyzer should hand out globals");
+
+        semantic_analyzer_free(analyzer);
+        ast_node_free(program);
+        parser_free(parser);
+        lexer_free(lexer);
+    }
+}
+
+TEST_SUITE(semantic_counters) {
+    const char* source =
+        "int g = 1;\n"
+        "int f(int a) { int b = a + g; { int c = b; } return b; }\n"
+        "int h(int x) { return f(x) + g; }\n";
+
+    SemanticAnalyzer* analyzer = semantic_analyzer_create();
+    const SemanticCounters* counters = semantic_analyzer_counters(analyzer);
+    TEST_ASSERT(counters && counters->lookups == 0 && counters->types_computed == 0,
+                "A new analyzer should have counted nothing");
+
+    Lexer* lexer = lexer_create(source);
+    Parser* parser = parser_create(lexer);
+    ASTNode* program = parser_parse_program(parser);
+    TEST_ASSERT(semantic_analyze(program, analyzer), "Program should analyze");
+
+    TEST_ASSERT(counters->lookups > 0 && counters->probes >= counters->lookups,
+                "Every lookup should probe at least one slot");
+    TEST_ASSERT(counters->lookup_misses >= 7, "Each declaration should miss in its own scope");
+    TEST_ASSERT_EQ(7, (int)counters->symbols_declared, "Every global, parameter and local should be declared");
+    TEST_ASSERT(counters->scopes_entered > 0 && counters->scopes_entered == counters->scopes_exited,
+                "Scopes should be entered and exited in pairs");
+    TEST_ASSERT(counters->max_scope_depth >= 2, "The nested block should be the deepest scope");
+    TEST_ASSERT(counters->scope_tables_created <= counters->max_scope_depth,
+                "Scope tables should be reused once a depth has been reached");
+
+    // Typing the program again is answered by the annotations
+    uint64_t computed = counters->types_computed;
+    uint64_t cached = counters->types_cached;
+    TEST_ASSERT(computed > 0, "Analysis should compute types");
+    ast_node_get_type(program, analyzer);
+    TEST_ASSERT(counters->types_computed == computed && counters->types_cached == cached + 1,
+                "A typed node should be served from its annotation");
+
+    FILE* out = tmpfile();
+    TEST_ASSERT(semantic_counters_write_json(counters, out), "Counters should be written");
+    char json[2048] = {0};
+    rewind(out);
+    size_t length = fread(json, 1, sizeof(json) - 1, out);
+    fclose(out);
+    char expected[64];
+    snprintf(expected, sizeof(expected), "\"lookups\": %llu,", (unsigned long long)counters->lookups);
+    TEST_ASSERT(length > 0 && json[0] == '{' && strstr(json, expected) != NULL, "JSON should hold the counts");
+    TEST_ASSERT(strstr(json, "\"probes_per_lookup\": ") != NULL && strstr(json, "\"type_cache_hit_rate\": ") != NULL,
+                "JSON should hold the derived ratios");
+
+    SemanticCounters serial = *counters;
+    semantic_counters_reset(analyzer);
+    TEST_ASSERT(counters->lookups == 0 && counters->max_scope_depth == 0, "Reset should clear every counter");
+    semantic_analyzer_free(analyzer);
+    ast_node_free(program);
+    parser_free(parser);
+    lexer_free(lexer);
+
+    // Workers count privately and their counts are merged afterwards
+    lexer = lexer_create(source);
+    parser = parser_create(lexer);
+    program = parser_parse_program_lazy(parser);
+    analyzer = semantic_analyzer_create();
+    TEST_ASSERT(semantic_analyze_parallel(program, analyzer, 2), "Program should analyze in parallel");
+    counters = semantic_analyzer_counters(analyzer);
+    TEST_ASSERT(counters->symbols_declared == serial.symbols_declared &&
+                counters->scopes_entered == serial.scopes_entered &&
+                counters->max_scope_depth == serial.max_scope_depth,
+                "Parallel analysis should count the same declarations and scopes");
+    TEST_ASSERT(counters->lookups >= serial.lookups, "Workers' lookups should be merged");
+
+    semantic_analyzer_free(analyzer);
+    ast_node_free(program);
+    parser_free(parser);
+    lexer_free(lexer);
+}
+
+TEST_SUITE(operator_rule_table) {
+    TEST_ASSERT_EQ(OP_ADD, binary_operator_from_string("+"), "+ should be addition");
+    TEST_ASSERT_EQ(OP_SHIFT_LEFT, binary_operator_from_string("<<"), "<< should be a shift");
+    TEST_ASSERT_EQ(OP_LESS_EQUAL, binary_operator_from_string("<="), "<= should be a comparison");
+    TEST_ASSERT_EQ(OP_BITWISE_AND, binary_operator_from_string("&"), "& should be bitwise");
+    TEST_ASSERT_EQ(OP_LOGICAL_OR, binary_operator_from_string("||"), "|| should be logical");
+    TEST_ASSERT_EQ(OP_INVALID, binary_operator_from_string("="), "Assignment is not a binary operator");
+    TEST_ASSERT_EQ(OP_INVALID, binary_operator_from_string("<<="), "Longer spellings should be rejected");
+
+    // Promotion: char to int, int to float
+    OperatorRule rule = semantic_operator_rule(OP_ADD, TYPE_INT, TYPE_FLOAT);
+    TEST_ASSERT(rule.result == TYPE_FLOAT && rule.operand_type == TYPE_FLOAT, "int + float should promote to float");
+    rule = semantic_operator_rule(OP_MULTIPLY, TYPE_CHAR, TYPE_CHAR);
+    TEST_ASSERT(rule.result == TYPE_INT && rule.operand_type == TYPE_INT, "char * char should promote to int");
+    rule = semantic_operator_rule(OP_LESS, TYPE_CHAR, TYPE_FLOAT);
+    TEST_ASSERT(rule.result == TYPE_BOOL && rule.operand_type == TYPE_FLOAT, "Comparisons should compare promoted operands");
+    TEST_ASSERT_EQ(TYPE_ERROR, semantic_operator_rule(OP_MODULO, TYPE_INT, TYPE_FLOAT).result, "% should need integers");
+    TEST_ASSERT_EQ(TYPE_BOOL, semantic_operator_rule(OP_BITWISE_XOR, TYPE_BOOL, TYPE_BOOL).result, "Bitwise bool is bool");
+    TEST_ASSERT_EQ(TYPE_ERROR, semantic_operator_rule(OP_ADD, TYPE_BOOL, TYPE_INT).result, "bool is not arithmetic");
+    TEST_ASSERT_EQ(TYPE_ERROR, semantic_operator_rule(OP_LOGICAL_AND, TYPE_INT, TYPE_INT).result, "&& should need bools");
+    TEST_ASSERT_EQ(TYPE_BOOL, semantic_operator_rule(OP_EQUAL, TYPE_STRING, TYPE_STRING).result, "Strings compare equal");
+    TEST_ASSERT_EQ(TYPE_ERROR, semantic_operator_rule(OP_EQUAL, TYPE_INT, TYPE_BOOL).result, "int == bool should fail");
+    TEST_ASSERT_EQ(TYPE_UNKNOWN, semantic_operator_rule(OP_ADD, TYPE_UNKNOWN, TYPE_INT).result, "Unknown stays unknown");
+    TEST_ASSERT_EQ(TYPE_BOOL, semantic_operator_rule(OP_GREATER, TYPE_UNKNOWN, TYPE_INT).result, "Comparisons are bool");
+    TEST_ASSERT_EQ(TYPE_ERROR, semantic_operator_rule(OP_INVALID, TYPE_INT, TYPE_INT).result, "No rule for no operator");
+
+    // Typing and checking agree, including comparisons of equal numeric types
+    static const struct {
+        const char* source;
+        DataType type;
+    } cases[] = {
+        { "1 < 2;", TYPE_BOOL },
+        { "1 + 2.5;", TYPE_FLOAT },
+        { "7 % 2 << 1;", TYPE_INT },
+        { "true + 1;", TYPE_ERROR },
+        { "1 == true;", TYPE_ERROR },
+        { "2.5 >= 1 && true;", TYPE_BOOL },
+    };
+    SemanticAnalyzer* analyzer = semantic_analyzer_create();
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        Lexer* lexer = lexer_create(cases[i].source);
+        Parser* parser = parser_create(lexer);
+        ASTNode* program = parser_parse_program(parser);
+        ASTNode* expression = program->data.block.statements[0]->data.statement.expression;
+
+        TEST_ASSERT_EQ(binary_operator_from_string(expression->data.binary.operator), expression->data.binary.op,
+                       "Binary nodes should carry their operator");
+        TEST_ASSERT_EQ(cases[i].type, ast_node_get_type(expression, analyzer), cases[i].source);
+        bool accepted = semantic_check_binary_operation(expression->data.binary.left, expression->data.binary.right,
+                                                        expression->data.binary.operator, analyzer);
+        TEST_ASSERT(accepted == (cases[i].type != TYPE_ERROR), "Checking should agree with typing");
+
+        ast_node_free(program);
+        parser_free(parser);
+        lexer_free(lexer);
+    }
+
+    Lexer* lexer = lexer_create("x = 1;");
+    Parser* parser = parser_create(lexer);
+    ASTNode* program = parser_parse_program(parser);
+    TEST_ASSERT_EQ(OP_INVALID, program->data.block.statements[0]->data.statement.expression->data.binary.op,
+                   "Assignments have no binary operator");
+    ast_node_free(program);
+    parser_free(parser);
+    lexer_free(lexer);
+    semantic_analyzer_free(analyzer);
+}
+
 TEST_SUITE(binary_operation_type_checking) {
     // Test binary operation type checking
     SemanticAnalyzer* analyzer = semantic_analyzer_create();
@@ -151,8 +644,140 @@ TEST_SUITE(binary_operation_type_checking) {
     bool result = semantic_check_binary_operation(left, right, "+", analyzer);
     TEST_ASSERT(result, "Integer + Integer should be valid");
 
+    // Nodes borrow their tokens
     ast_node_free(binary);
+    token_free(token1);
+    token_free(token2);
+    semantic_analyzer_free(analyzer);
+}
+
+TEST_SUITE(control_flow_dataflow) {
+    const char* source =
+        "int f(int a) {\n"
+        "    int x = a;\n"
+        "    int y;\n"
+        "    if (a > 0) {\n"
+        "        y = x + 1;\n"
+        "    } else {\n"
+        "        x = 2;\n"
+        "    }\n"
+        "    while (x < 10) {\n"
+        "        x = x + y;\n"
+        "    }\n"
+        "    return x;\n"
+        "}\n";
+    Lexer* lexer = lexer_create(source);
+    Parser* parser = parser_create(lexer);
+    ASTNode* program = parser_parse_program(parser);
+    SemanticAnalyzer* analyzer = semantic_analyzer_create();
+    TEST_ASSERT(semantic_analyze(program, analyzer), "The function should analyze");
+
+    // entry, exit, then, else, join, loop header, loop body, after the loop
+    // and the unreachable block after return
+    ControlFlowGraph* cfg = cfg_build(program->data.block.statements[0]);
+    TEST_ASSERT_NOT_NULL(cfg, "A graph should be built");
+    TEST_ASSERT_EQ(9, cfg->block_count, "Every branch and loop should get its blocks");
+    TEST_ASSERT_EQ(3, cfg->variable_count, "a, x and y should have slots");
+    TEST_ASSERT_EQ(5, cfg->definition_count, "The parameter and four writes are definitions");
+    TEST_ASSERT_EQ(3, cfg_block(cfg, CFG_ENTRY)->item_count, "Two declarations and the if condition");
+    TEST_ASSERT(cfg_block(cfg, 0)->successors[0] == 2 && cfg_block(cfg, 0)->successors[1] == 3,
+                "The condition should branch to then and else");
+    TEST_ASSERT_EQ(2, cfg_block(cfg, 5)->predecessor_count, "The loop header is entered and looped back to");
+    TEST_ASSERT_EQ(6, cfg_block_predecessors(cfg, 5)[1], "The back edge comes from the body");
+    TEST_ASSERT_EQ(0, cfg_block(cfg, 8)->predecessor_count, "Code after return is unreachable");
+
+    DataflowResult* live = dataflow_liveness(cfg);
+    TEST_ASSERT_EQ(0, bitset_count(dataflow_in(live, CFG_ENTRY), live->word_count), "Nothing is live into f");
+    TEST_ASSERT(bitset_test(dataflow_in(live, 5), 1) && bitset_test(dataflow_in(live, 5), 2),
+                "x and y are live at the loop header");
+    TEST_ASSERT(!bitset_test(dataflow_in(live, 3), 1) && bitset_test(dataflow_in(live, 3), 2),
+                "The else branch overwrites x but not y");
+    TEST_ASSERT(!bitset_test(dataflow_out(live, 7), 1), "Nothing is live after return");
+    dataflow_result_free(live);
+
+    DataflowResult* reaching = dataflow_reaching_definitions(cfg);
+    TEST_ASSERT_EQ(5, bitset_count(dataflow_in(reaching, 6), reaching->word_count),
+                   "Every definition reaches the loop body");
+    TEST_ASSERT(!bitset_test(dataflow_out(reaching, 3), 1) && bitset_test(dataflow_out(reaching, 3), 3),
+                "x = 2 replaces x = a on the else branch");
+    dataflow_result_free(reaching);
+
+    DataflowResult* assigned = dataflow_definite_assignment(cfg);
+    TEST_ASSERT(bitset_test(dataflow_in(assigned, 5), 1) && !bitset_test(dataflow_in(assigned, 5), 2),
+                "Only x is assigned on both branches");
+    TEST_ASSERT(bitset_test(dataflow_out(assigned, 2), 2), "The then branch assigns y");
+    dataflow_result_free(assigned);
+
+    TEST_ASSERT_EQ(1, dataflow_check_definite_assignment(cfg, analyzer), "Reading y in the loop should be reported");
+    TEST_ASSERT(analyzer->last_error && analyzer->last_error->line == 10 &&
+                strstr(analyzer->last_error->message, "'y'") != NULL, "The report should point at y");
+
+    cfg_free(cfg);
     semantic_analyzer_free(analyzer);
+    ast_node_free(program);
+    parser_free(parser);
+    lexer_free(lexer);
+
+    // A declaration in a loop starts unassigned each time round; code after
+    // return is never reported
+    lexer = lexer_create("int g(int n) {\n"
+                         "    while (n > 0) { int t; t = t + 1; n = n - t; }\n"
+                         "    return n;\n"
+                         "    n = n + 1;\n"
+                         "}\n");
+    parser = parser_create(lexer);
+    program = parser_parse_program(parser);
+    analyzer = semantic_analyzer_create();
+    semantic_analyze(program, analyzer);
+    cfg = cfg_build(program->data.block.statements[0]);
+    TEST_ASSERT_EQ(1, dataflow_check_definite_assignment(cfg, analyzer), "t is read before it is assigned");
+
+    cfg_free(cfg);
+    semantic_analyzer_free(analyzer);
+    ast_node_free(program);
+    parser_free(parser);
+    lexer_free(lexer);
+
+    // The right operand of && and || runs only when the left one does not decide
+    lexer = lexer_create("int f1(int a) { int x; if (a > 0 && (x = 5) > 0) { a = 1; } return x; }\n"
+                         "int f2(int a) { int x; if (a > 0 || (x = 5) > 0) { return x; } return 0; }\n"
+                         "int f3(int a) { int x; if (a > 0 && (x = 5) > 0) { return x; } return 0; }\n"
+                         "int f4(int a) { int x; if (!(a > 0 || (x = 5) > 0)) { return x; } return 0; }\n"
+                         "int f5(int a) { int x; int b = a > 0 && (x = 5) > 0; return x; }\n"
+                         "int f6(int a) { int x = 1; if (a > 0 && (x = 5) > 0) { a = 2; } return x; }\n");
+    parser = parser_create(lexer);
+    program = parser_parse_program(parser);
+    analyzer = semantic_analyzer_create();
+    TEST_ASSERT(semantic_analyze(program, analyzer), "The functions should analyze");
+    const int reports[] = { 1, 1, 0, 0, 1 };
+    const char* messages[] = { "x is unassigned when a > 0 is false", "x is unassigned when a > 0 is true",
+                               "x is assigned when the && holds", "x is assigned when neither operand of || holds",
+                               "An assignment under && outside a branch may not run" };
+    for (int i = 0; i < 5; i++) {
+        cfg = cfg_build(program->data.block.statements[i]);
+        TEST_ASSERT_EQ(reports[i], dataflow_check_definite_assignment(cfg, analyzer), messages[i]);
+        cfg_free(cfg);
+    }
+
+    // a, x = 1, x = 5, a = 2: x = 5 does not replace x = 1 where it is skipped
+    cfg = cfg_build(program->data.block.statements[5]);
+    TEST_ASSERT_EQ(4, cfg->definition_count, "The parameter and three writes are definitions");
+    TEST_ASSERT_EQ(2, cfg_block(cfg, CFG_ENTRY)->item_count, "The declaration and a > 0");
+    const CfgBlock* right = cfg_block(cfg, cfg_block(cfg, CFG_ENTRY)->successors[0]);
+    TEST_ASSERT_EQ(1, right->item_count, "The right operand has a block of its own");
+    reaching = dataflow_reaching_definitions(cfg);
+    // entry, exit, right operand, then, join and the block after return
+    int join = cfg->block_count - 2;
+    TEST_ASSERT_EQ(NODE_RETURN_STATEMENT, cfg->items[cfg_block(cfg, join)->first_item]->type, "The join returns x");
+    TEST_ASSERT(bitset_test(dataflow_in(reaching, join), 1) && bitset_test(dataflow_in(reaching, join), 2),
+                "Both x = 1 and x = 5 reach the return");
+    dataflow_result_free(reaching);
+
+    cfg_free(cfg);
+    semantic_analyzer_free(analyzer);
+    ast_node_free(program);
+    parser_free(parser);
+    lexer_free(lexer);
 }
 
 TEST_SUITE(semantic_analysis_simple) {
@@ -194,14 +819,544 @@ TEST_SUITE(data_type_utility) {
 }
 
 // Add this test suite to the runner
+// Analyzes source as a module and exports its interface
+static ModuleInterface* module_interface_from_source(const char* source) {
+    Lexer* lexer = lexer_create(source);
+    Parser* parser = parser_create(lexer);
+    ASTNode* program = parser_parse_program(parser);
+    SemanticAnalyzer* analyzer = semantic_analyzer_create();
+    ModuleInterface* interface = NULL;
+    if (semantic_analyze(program, analyzer)) {
+        interface = module_interface_build(program, analyzer, hash_bytes(source, strlen(source)));
+    }
+
+    semantic_analyzer_free(analyzer);
+    ast_node_free(program);
+    parser_free(parser);
+    lexer_free(lexer);
+    return interface;
+}
+
+TEST_SUITE(module_interfaces) {
+    const char* library =
+        "int limit = 10;\n"
+        "float scale = 2.5;\n"
+        "int counter;\n"
+        "int clamp(int value, float factor) { if (value > limit) { return limit; } return value; }\n"
+        "bool verbose = true;\n";
+    uint64_t hash = hash_bytes(library, strlen(library));
+
+    ModuleInterface* built = module_interface_from_source(library);
+    TEST_ASSERT_NOT_NULL(built, "The library should export an interface");
+    TEST_ASSERT_EQ(5, module_interface_entry_count(built), "Every top-level declaration should be exported");
+
+    const ModuleEntry* limit = module_interface_entry(built, 0);
+    TEST_ASSERT_STR_EQ("limit", module_interface_string(built, limit->name), "Entries should keep source order");
+    TEST_ASSERT(limit->constant && limit->value_type == TYPE_INT && limit->value == 10,
+                "A literal initializer should export the constant");
+    const ModuleEntry* scale = module_interface_entry(built, 1);
+    float scale_value;
+    uint32_t scale_bits = (uint32_t)scale->value;
+    memcpy(&scale_value, &scale_bits, sizeof(scale_value));
+    TEST_ASSERT(scale->constant && scale->value_type == TYPE_FLOAT && scale_value == 2.5f,
+                "Float constants should keep their bits");
+    TEST_ASSERT(!module_interface_entry(built, 2)->constant, "A global without initializer is not a constant");
+    TEST_ASSERT(module_interface_entry(built, 4)->constant && module_interface_entry(built, 4)->value == 1,
+                "Bool constants should be exported");
+
+    const ModuleEntry* clamp = module_interface_entry(built, 3);
+    TEST_ASSERT_EQ(MODULE_ENTRY_FUNCTION, clamp->kind, "clamp should be a function");
+    TEST_ASSERT_STR_EQ("int", module_interface_string(built, clamp->type), "The return type should be exported");
+    TEST_ASSERT_EQ(2, clamp->parameter_count, "Both parameters should be exported");
+    TEST_ASSERT_STR_EQ("float", module_interface_string(built, module_interface_parameter(built, clamp, 1)->type),
+                       "Parameter types should be exported");
+    TEST_ASSERT_NULL(module_interface_parameter(built, clamp, 2), "Out of range parameters should be rejected");
+
+    // Round trip through a file, rejected once the source changes
+    char path[256];
+    TEST_ASSERT(module_interface_path(path, sizeof(path), "/tmp", "test_module_library"), "Interface path should fit");
+    TEST_ASSERT(module_interface_write(built, path), "Interface should be written");
+    ModuleInterface* mapped = module_interface_open(path, hash);
+    TEST_ASSERT_NOT_NULL(mapped, "Interface should be mapped back");
+    TEST_ASSERT(module_interface_hash(mapped) == module_interface_hash(built), "The file should keep the interface hash");
+    TEST_ASSERT_NULL(module_interface_open(path, hash + 1), "A different source hash should be rejected");
+
+    // Import instead of analyzing the library
+    const char* client =
+        "int total = limit + clamp(counter, scale);\n"
+        "int twice(int x) { return x + limit; }\n";
+    Lexer* lexer = lexer_create(client);
+    Parser* parser = parser_create(lexer);
+    ASTNode* program = parser_parse_program(parser);
+    SemanticAnalyzer* analyzer = semantic_analyzer_create();
+    TEST_ASSERT(module_interface_import(mapped, analyzer), "The interface should import");
+    TEST_ASSERT(semantic_analyze(program, analyzer), "The client should analyze against the imports");
+    ASTNode* total = program->data.block.statements[0];
+    ASTNode* limit_use = total->data.declaration.initializer->data.binary.left;
+    TEST_ASSERT(limit_use->resolved_global && limit_use->resolved_slot == 0, "limit should be imported global 0");
+    TEST_ASSERT_EQ(4, total->resolved_slot, "Client globals should follow the imported ones");
+    TEST_ASSERT_EQ(TYPE_INT + 1, limit_use->resolved_type, "Imported globals should be typed");
+    Symbol* imported = symbol_table_lookup(analyzer->current_scope, "clamp");
+    TEST_ASSERT(imported != NULL && imported->data.function.parameter_count == 2,
+                "Imported functions should keep their signature");
+    TEST_ASSERT_STR_EQ("factor", imported->data.function.parameters[1]->name, "Parameter names should be imported");
+
+    // Importing the same names again is a redeclaration
+    TEST_ASSERT(!module_interface_import(mapped, analyzer), "A second import should conflict");
+    TEST_ASSERT_STR_EQ("Redeclaration of imported 'verbose'", analyzer->last_error->message,
+                       "Every conflict is reported; the last one is kept");
+    semantic_analyzer_free(analyzer);
+    ast_node_free(program);
+    parser_free(parser);
+    lexer_free(lexer);
+
+    // A corrupt file is rejected rather than trusted
+    FILE* file = fopen(path, "r+b");
+    TEST_ASSERT_NOT_NULL(file, "Interface should be reopened");
+    fseek(file, (long)built->size - 2, SEEK_SET);
+    fputc('#', file);
+    fclose(file);
+    TEST_ASSERT_NULL(module_interface_open(path, hash), "Changed content should fail the interface hash");
+    remove(path);
+
+    // Only what dependents can see changes the interface hash
+    ModuleInterface* body_edit = module_interface_from_source(
+        "int limit = 10;\n"
+        "float scale = 2.5;\n"
+        "int counter;\n"
+        "int clamp(int value, float factor) { int result = value; return result; }\n"
+        "bool verbose = true;\n");
+    ModuleInterface* signature_edit = module_interface_from_source(
+        "int limit = 10;\n"
+        "float scale = 2.5;\n"
+        "int counter;\n"
+        "float clamp(int value, float factor) { return factor; }\n"
+        "bool verbose = true;\n");
+    ModuleInterface* constant_edit = module_interface_from_source(
+        "int limit = 11;\n"
+        "float scale = 2.5;\n"
+        "int counter;\n"
+        "int clamp(int value, float factor) { if (value > limit) { return limit; } return value; }\n"
+        "bool verbose = true;\n");
+    TEST_ASSERT(module_interface_hash(body_edit) == module_interface_hash(built),
+                "Editing a function body should keep the interface hash");
+    TEST_ASSERT(module_interface_hash(signature_edit) != module_interface_hash(built),
+                "Changing a signature should change the interface hash");
+    TEST_ASSERT(module_interface_hash(constant_edit) != module_interface_hash(built),
+                "Changing a constant should change the interface hash");
+
+    module_interface_free(body_edit);
+    module_interface_free(signature_edit);
+    module_interface_free(constant_edit);
+    module_interface_free(mapped);
+    module_interface_free(built);
+}
+
+// One step of an edit script: removed lines starting at line are replaced
+// by text (whole lines). checked is how many declarations the update should
+// check again, or -1 if it should analyze the whole program.
+typedef struct {
+    int line;
+    int removed;
+    const char* text;
+    int checked;
+} ScriptedEdit;
+
+static char* apply_scripted_edit(const char* source, const ScriptedEdit* step, TextEdit* edit) {
+    const char* start = source;
+    for (int line = 1; line < step->line; line++) {
+        start = strchr(start, '\n') + 1;
+    }
+    const char* end = start;
+    for (int i = 0; i < step->removed; i++) {
+        end = strchr(end, '\n') + 1;
+    }
+
+    int added = 0;
+    for (const char* c = step->text; *c; c++) {
+        if (*c == '\n') added++;
+    }
+    *edit = (TextEdit){ step->line, step->line + step->removed - 1, step->line + added - 1 };
+
+    StringBuffer* buffer = string_buffer_create(strlen(source) + strlen(step->text) + 1);
+    char* prefix = strndup_safe(source, (size_t)(start - source));
+    string_buffer_append(buffer, prefix);
+    string_buffer_append(buffer, step->text);
+    string_buffer_append(buffer, end);
+    free(prefix);
+
+    char* text = buffer->data;
+    free(buffer);
+    return text;
+}
+
+// Applies the script with parser_reparse and incremental_analysis_update,
+// comparing every step with a fresh parse and semantic_analyze. Returns the
+// first step that differs, or -1.
+static int incremental_script_mismatch(const char* source, const ScriptedEdit* script, int steps) {
+    char* text = strdup_safe(source);
+    Lexer* lexer = lexer_create(text);
+    Parser* parser = parser_create(lexer);
+    ASTNode* program = parser_parse_program(parser);
+    IncrementalAnalysis* analysis = incremental_analysis_create(parser, program);
+
+    int mismatch = -1;
+    for (int step = 0; step < steps && mismatch < 0; step++) {
+        TextEdit edit;
+        char* edited_text = apply_scripted_edit(text, &script[step], &edit);
+        Lexer* edited = lexer_create(edited_text);
+        program = parser_reparse(parser, program, edited, &edit);
+        lexer_free(lexer);
+        free(text);
+        lexer = edited;
+        text = edited_text;
+        bool ok = incremental_analysis_update(analysis, parser, program, &edit);
+
+        Lexer* fresh_lexer = lexer_create(text);
+        Parser* fresh_parser = parser_create(fresh_lexer);
+        ASTNode* fresh = parser_parse_program(fresh_parser);
+        SemanticAnalyzer* analyzer = semantic_analyzer_create();
+        bool expected = semantic_analyze(fresh, analyzer);
+
+        Error* error = incremental_analysis_last_error(analysis);
+        Error* expected_error = analyzer->last_error;
+        bool same = ok == expected && annotation_digest(program) == annotation_digest(fresh) &&
+                    (error == NULL) == (expected_error == NULL);
+        if (same && error != NULL) {
+            same = error->line == expected_error->line && strcmp(error->message, expected_error->message) == 0;
+        }
+        if (script[step].checked < 0) {
+            same = same && analysis->full_analysis;
+        } else {
+            same = same && !analysis->full_analysis && analysis->checked_count == script[step].checked;
+        }
+        if (!same) mismatch = step;
+
+        semantic_analyzer_free(analyzer);
+        ast_node_free(fresh);
+        parser_free(fresh_parser);
+        lexer_free(fresh_lexer);
+    }
+
+    incremental_analysis_free(analysis);
+    ast_node_free(program);
+    parser_free(parser);
+    lexer_free(lexer);
+    free(text);
+    return mismatch;
+}
+
+TEST_SUITE(incremental_semantic_analysis) {
+    const char* source =
+        "int limit = 10;\n"
+        "int scale = 2;\n"
+        "int grow(int x) {\n"
+        "    int y = x * scale;\n"
+        "    return y + limit;\n"
+        "}\n"
+        "int shrink(int x) {\n"
+        "    return x - 1;\n"
+        "}\n"
+        "int both(int x) {\n"
+        "    int z = grow(x);\n"
+        "    return shrink(z);\n"
+        "}\n"
+        "int late = 3;\n";
+
+    const ScriptedEdit body_edits[] = {
+        { 4, 1, "    int y = x * scale + 1;\n", 1 },
+        { 8, 1, "    int w = x - limit;\n    return w;\n", 1 },          // both and late move down
+        { 13, 1, "    return shrink(q);\n", 1 },                          // undeclared q
+        { 5, 1, "    return y + late;\n", 1 },                            // late is declared later
+        { 5, 1, "    return y + limit;\n", 1 },
+        { 13, 1, "    return shrink(z);\n", 1 },
+        { 7, 0, "\n\n", -1 },                                             // parser_reparse rebuilds the tree
+    };
+    TEST_ASSERT_EQ(-1, incremental_script_mismatch(source, body_edits, 7),
+                   "Body edits should check only the edited function and match a fresh analysis");
+
+    const ScriptedEdit signature_edits[] = {
+        { 2, 1, "float scale = 2.5;\n", 2 },                              // scale and grow, which reads it
+        { 3, 1, "float grow(int x) {\n", 2 },                             // grow and both, which calls it
+        { 1, 1, "int limit = scale;\n", 1 },                              // scale is declared later
+        { 1, 1, "int limit = 10;\n", 1 },
+    };
+    TEST_ASSERT_EQ(-1, incremental_script_mismatch(source, signature_edits, 4),
+                   "Signature edits should also check the declarations that use the name");
+
+    const ScriptedEdit structural_edits[] = {
+        { 7, 1, "int narrow(int x) {\n", -1 },                            // both still calls shrink
+        { 1, 0, "int extra = 1;\n", -1 },
+        { 13, 1, "    return narrow(z);\n", 1 },
+        { 4, 1, "    int y = x * scale\n", -1 },                          // syntax error
+        { 4, 1, "    int y = x * scale;\n", -1 },
+    };
+    TEST_ASSERT_EQ(-1, incremental_script_mismatch(source, structural_edits, 5),
+                   "Declarations added, removed or renamed should analyze the whole program");
+}
+
+TEST_SUITE(function_effect_summaries) {
+    const char* source =
+        "int g = 0;\n"
+        "int square(int x) { return x * x; }\n"
+        "int get() { return g; }\n"
+        "int bump() { g = g + 1; return g; }\n"
+        "int spin(int n) { while (n > 0) { n = n - 1; } return n; }\n"
+        "int fact(int n) { if (n < 2) { return 1; } return n * fact(n - 1); }\n"
+        "int sum(int a) { return square(a) + get(); }\n"
+        "int twice() { bump(); return bump(); }\n"
+        "int main() { square(3); get(); bump(); sum(square(2)); fact(3); square(bump()); return 0; }\n";
+    Lexer* lexer = lexer_create(source);
+    Parser* parser = parser_create(lexer);
+    ASTNode* program = parser_parse_program(parser);
+    SemanticAnalyzer* analyzer = semantic_analyzer_create();
+    TEST_ASSERT(semantic_analyze(program, analyzer), "The program should analyze");
+
+    SymbolTable* globals = semantic_analyzer_current_scope(analyzer);
+    TEST_ASSERT_EQ(EFFECT_ALL, (int)symbol_table_lookup(globals, "square")->data.function.effects,
+                   "Functions have every effect until summarized");
+
+    EffectsSummary summary;
+    TEST_ASSERT(effects_summarize(program, analyzer, &summary), "The program should be summarized");
+    TEST_ASSERT_EQ(8, summary.function_count, "Every function should be summarized");
+    TEST_ASSERT_EQ(13, summary.call_count, "Every call names a function of the program");
+    TEST_ASSERT_EQ(0, summary.unknown_call_count, "No call is through anything else");
+    TEST_ASSERT_EQ(8, summary.component_count, "Without mutual recursion each function is its own component");
+    TEST_ASSERT_EQ(1, summary.recursive_count, "fact calls itself");
+    TEST_ASSERT_EQ(3, summary.pure_count, "square, get and sum are pure");
+
+    TEST_ASSERT_EQ(0, (int)symbol_table_lookup(globals, "square")->data.function.effects, "square has no effects");
+    TEST_ASSERT_EQ(EFFECT_READS_GLOBALS, (int)symbol_table_lookup(globals, "get")->data.function.effects,
+                   "get reads g");
+    TEST_ASSERT_EQ(EFFECT_READS_GLOBALS | EFFECT_WRITES_GLOBALS,
+                   (int)symbol_table_lookup(globals, "bump")->data.function.effects, "bump writes g");
+    TEST_ASSERT_EQ(EFFECT_MAY_NOT_RETURN, (int)symbol_table_lookup(globals, "spin")->data.function.effects,
+                   "A loop may not terminate");
+    TEST_ASSERT_EQ(EFFECT_MAY_NOT_RETURN, (int)symbol_table_lookup(globals, "fact")->data.function.effects,
+                   "Recursion may not terminate");
+    TEST_ASSERT_EQ(EFFECT_READS_GLOBALS, (int)symbol_table_lookup(globals, "sum")->data.function.effects,
+                   "sum has the effects of its callees");
+    TEST_ASSERT_EQ(EFFECT_READS_GLOBALS | EFFECT_WRITES_GLOBALS,
+                   (int)symbol_table_lookup(globals, "twice")->data.function.effects, "Effects flow to callers");
+
+    // square(3), get() and sum(square(2)) are dropped; square(bump()) stays for bump's write
+    ASTNode* body = ast_function_body(program->data.block.statements[8]);
+    TEST_ASSERT_EQ(4, effects_remove_dead_calls(program, analyzer), "Four pure calls should be removed");
+    TEST_ASSERT_EQ(4, body->data.block.statement_count, "bump(), fact(3), square(bump()) and return remain");
+    TEST_ASSERT_EQ(0, effects_remove_dead_calls(program, analyzer), "Nothing is left to remove");
+    TEST_ASSERT(EFFECTS_PURE(effects_of(program->data.block.statements[6], analyzer)),
+                "Declaring a function has no effect");
+    TEST_ASSERT_EQ(EFFECT_WRITES_GLOBALS, (int)effects_of(program->data.block.statements[0], analyzer),
+                   "A global declaration initializes the global");
+
+    semantic_analyzer_free(analyzer);
+    ast_node_free(program);
+    parser_free(parser);
+    lexer_free(lexer);
+
+    // Assigning a pure call's result to a local is no effect, but it is not dead
+    source =
+        "int sq(int a) { return a * a; }\n"
+        "int f(int a) { int x = 0; x = sq(a); sq(x) + (x = 1); return x; }\n";
+    lexer = lexer_create(source);
+    parser = parser_create(lexer);
+    program = parser_parse_program(parser);
+    analyzer = semantic_analyzer_create();
+    TEST_ASSERT(semantic_analyze(program, analyzer), "The program should analyze");
+    TEST_ASSERT(effects_summarize(program, analyzer, &summary), "The program should be summarized");
+    TEST_ASSERT(EFFECTS_PURE(symbol_table_lookup(semantic_analyzer_current_scope(analyzer), "f")->data.function.effects),
+                "f writes only locals");
+    body = ast_function_body(program->data.block.statements[1]);
+    int removed = effects_remove_dead_calls(program, analyzer);
+    TEST_ASSERT_EQ(0, removed, "Statements that assign are kept");
+    TEST_ASSERT_EQ(4, body->data.block.statement_count, "x = sq(a) and the sum assigning x remain");
+
+    semantic_analyzer_free(analyzer);
+    ast_node_free(program);
+    parser_free(parser);
+    lexer_free(lexer);
+
+    // Mutual recursion is one component, whatever analysis made of the forward call
+    source =
+        "int g = 0;\n"
+        "int even(int n) { if (n == 0) { return 1; } return odd(n - 1); }\n"
+        "int odd(int n) { if (n == 0) { g = n; return 0; } return even(n - 1); }\n"
+        "int top() { return even(4) + g; }\n";
+    lexer = lexer_create(source);
+    parser = parser_create(lexer);
+    program = parser_parse_program(parser);
+    analyzer = semantic_analyzer_create();
+    semantic_analyze(program, analyzer);
+    globals = semantic_analyzer_current_scope(analyzer);
+
+    TEST_ASSERT(effects_summarize(program, analyzer, &summary), "The program should be summarized");
+    TEST_ASSERT_EQ(2, summary.component_count, "even and odd form one component");
+    TEST_ASSERT_EQ(2, summary.recursive_count, "even and odd are recursive");
+    TEST_ASSERT_EQ(EFFECT_WRITES_GLOBALS | EFFECT_MAY_NOT_RETURN,
+                   (int)symbol_table_lookup(globals, "even")->data.function.effects, "even shares odd's write");
+    TEST_ASSERT_EQ(EFFECT_ALL, (int)symbol_table_lookup(globals, "top")->data.function.effects,
+                   "The component's summary reaches its callers");
+
+    semantic_analyzer_free(analyzer);
+    ast_node_free(program);
+    parser_free(parser);
+    lexer_free(lexer);
+}
+
+TEST_SUITE(integer_range_analysis) {
+    Range small = { 0, 99 };
+    Range negative = { -5, -1 };
+    Range wide = { 0, (int64_t)INT32_MAX + 1 };
+    TEST_ASSERT_EQ(RANGE_NONNEGATIVE | RANGE_SMALL, (int)range_facts(small), "0..99 is small but may be zero");
+    TEST_ASSERT_EQ(RANGE_NONZERO, (int)range_facts(negative), "Negative values are nonzero");
+    TEST_ASSERT_EQ(RANGE_NONNEGATIVE, (int)range_facts(wide), "Values past INT32_MAX are not small");
+
+    const char* source =
+        "int f(int n) {\n"
+        "    int i = 0;\n"
+        "    int t = 0;\n"
+        "    while (i < 100) {\n"
+        "        t = i % 8;\n"
+        "        i = i + 1;\n"
+        "    }\n"
+        "    int d = 1000 / (t + 1);\n"
+        "    int e = n / 4;\n"
+        "    if (n > 0) { e = n / 4; }\n"
+        "    int m = n - 1;\n"
+        "    return d + e;\n"
+        "}\n";
+    Lexer* lexer = lexer_create(source);
+    Parser* parser = parser_create(lexer);
+    ASTNode* program = parser_parse_program(parser);
+    SemanticAnalyzer* analyzer = semantic_analyzer_create();
+    TEST_ASSERT(semantic_analyze(program, analyzer), "The function should analyze");
+
+    RangeStats stats;
+    TEST_ASSERT(ranges_analyze(program, analyzer, &stats), "The program should be analyzed");
+    TEST_ASSERT_EQ(4, stats.arithmetic, "i + 1, t + 1, n - 1 and d + e are arithmetic");
+    TEST_ASSERT_EQ(3, stats.overflow_checks_removed, "Only n - 1 may overflow");
+    TEST_ASSERT_EQ(2, stats.narrowed, "i + 1 and t + 1 stay within 32 bits");
+    TEST_ASSERT_EQ(4, stats.divisions, "Three divisions and one modulo");
+    TEST_ASSERT_EQ(4, stats.zero_checks_removed, "Every divisor is nonzero");
+    TEST_ASSERT_EQ(2, stats.shift_divisions, "i % 8 and n / 4 under n > 0 become shifts");
+    TEST_ASSERT(stats.loop_iterations >= 2, "The loop head should be iterated");
+
+    // The loop test bounds i after widening: 0 <= i < 100 in the body
+    ASTNode* body = ast_function_body(program->data.block.statements[0]);
+    ASTNode* loop = body->data.block.statements[2]->data.conditional.then_branch;
+    ASTNode* increment = loop->data.block.statements[1]->data.statement.expression->data.binary.right;
+    TEST_ASSERT_EQ(RANGE_NONZERO | RANGE_NONNEGATIVE | RANGE_SMALL | RANGE_NO_OVERFLOW, increment->range_facts,
+                   "i + 1 is in 1..100");
+    ASTNode* quotient = body->data.block.statements[3]->data.declaration.initializer;
+    TEST_ASSERT(quotient->data.binary.right->range_facts & RANGE_NONZERO, "t + 1 is in 1..8");
+    TEST_ASSERT_EQ(0, body->data.block.statements[4]->data.declaration.initializer->data.binary.left->range_facts,
+                   "Nothing is known about a parameter");
+
+    semantic_analyzer_free(analyzer);
+    ast_node_free(program);
+    parser_free(parser);
+    lexer_free(lexer);
+
+    // Top-level code tracks globals until a call may assign them
+    source =
+        "int g = 5;\n"
+        "int bump() { g = g + 1; return g; }\n"
+        "int a = g / 4;\n"
+        "int r = bump();\n"
+        "int b = g / 4;\n";
+    lexer = lexer_create(source);
+    parser = parser_create(lexer);
+    program = parser_parse_program(parser);
+    analyzer = semantic_analyzer_create();
+    TEST_ASSERT(semantic_analyze(program, analyzer), "The program should analyze");
+    TEST_ASSERT(ranges_analyze(program, analyzer, &stats), "The program should be analyzed");
+
+    ASTNode* before = program->data.block.statements[2]->data.declaration.initializer;
+    ASTNode* after = program->data.block.statements[4]->data.declaration.initializer;
+    TEST_ASSERT_EQ(RANGE_NONZERO | RANGE_NONNEGATIVE | RANGE_SMALL, before->data.binary.left->range_facts,
+                   "g is 5 before the call");
+    TEST_ASSERT_EQ(0, after->data.binary.left->range_facts, "bump may assign g");
+    TEST_ASSERT_EQ(1, stats.shift_divisions, "Only g / 4 before the call");
+
+    semantic_analyzer_free(analyzer);
+    ast_node_free(program);
+    parser_free(parser);
+    lexer_free(lexer);
+
+    // The right operand of && and || may not run, nor its assignments
+    source =
+        "int f(int n) { int x = n; if (n > 100 && (x = 5) > 0) { n = n + 1; } return x / 2; }\n"
+        "int g(int n) { int x = n; if (n < 0 || (x = 5) > 0) { n = 0; } return x / 2; }\n"
+        "int h(int n) { int x = 0; if (n >= 0 && (n = 0 - n) <= 0) { x = n / 2; } return x; }\n";
+    lexer = lexer_create(source);
+    parser = parser_create(lexer);
+    program = parser_parse_program(parser);
+    analyzer = semantic_analyzer_create();
+    TEST_ASSERT(semantic_analyze(program, analyzer), "The program should analyze");
+    TEST_ASSERT(ranges_analyze(program, analyzer, &stats), "The program should be analyzed");
+    TEST_ASSERT_EQ(0, stats.shift_divisions, "No division is by a nonnegative value");
+
+    for (int i = 0; i < 2; i++) {
+        body = ast_function_body(program->data.block.statements[i]);
+        ASTNode* division = body->data.block.statements[2]->data.statement.expression;
+        TEST_ASSERT_EQ(0, division->data.binary.left->range_facts, "x may still be n");
+    }
+    // n >= 0 held before n was negated, not after
+    body = ast_function_body(program->data.block.statements[2]);
+    ASTNode* then_branch = body->data.block.statements[1]->data.conditional.then_branch;
+    ASTNode* division = then_branch->data.block.statements[0]->data.statement.expression->data.binary.right;
+    TEST_ASSERT_EQ(0, division->data.binary.left->range_facts, "n may be negative");
+
+    semantic_analyzer_free(analyzer);
+    ast_node_free(program);
+    parser_free(parser);
+    lexer_free(lexer);
+
+    // A hash-consed expression stands for every place it is used
+    source = "int f(int n) { int x = 10 / n; if (n > 0) { x = 10 / n; } return x; }\n";
+    lexer = lexer_create(source);
+    parser = parser_create(lexer);
+    parser_enable_hash_consing(parser);
+    program = parser_parse_program(parser);
+    analyzer = semantic_analyzer_create();
+    TEST_ASSERT(semantic_analyze(program, analyzer), "The program should analyze");
+    TEST_ASSERT(ranges_analyze(program, analyzer, &stats), "The program should be analyzed");
+
+    body = ast_function_body(program->data.block.statements[0]);
+    then_branch = body->data.block.statements[1]->data.conditional.then_branch;
+    ASTNode* first = body->data.block.statements[0]->data.declaration.initializer;
+    ASTNode* second = then_branch->data.block.statements[0]->data.statement.expression->data.binary.right;
+    TEST_ASSERT(first == second, "Both divisions should be one node");
+    TEST_ASSERT_EQ(0, first->data.binary.right->range_facts, "n may be zero at the first division");
+    TEST_ASSERT_EQ(0, stats.zero_checks_removed, "The shared division keeps its check");
+
+    semantic_analyzer_free(analyzer);
+    ast_node_free(program);
+    parser_free(parser);
+    lexer_free(lexer);
+}
+
 void run_semantic_tests(void) {
     run_suite_symbol_table_creation();
     run_suite_symbol_creation();
     run_suite_symbol_table_add_lookup();
+    run_suite_symbol_table_many_symbols();
+    run_suite_type_descriptors();
     run_suite_semantic_analyzer_creation();
     run_suite_scope_management();
+    run_suite_nested_scope_bindings();
     run_suite_type_inference();
+    run_suite_operator_rule_table();
     run_suite_binary_operation_type_checking();
+    run_suite_expression_type_annotations();
+    run_suite_name_resolution_slots();
+    run_suite_parallel_semantic_analysis();
+    run_suite_semantic_counters();
+    run_suite_control_flow_dataflow();
+    run_suite_module_interfaces();
+    run_suite_incremental_semantic_analysis();
+    run_suite_function_effect_summaries();
+    run_suite_integer_range_analysis();
     run_suite_semantic_analysis_simple();
     run_suite_data_type_utility();
 }
\ No newline at end of file